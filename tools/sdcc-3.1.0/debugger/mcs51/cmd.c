@@ -487,40 +487,56 @@ static void clearBPatModLine (module *mod, int line)
 }
 
 /*-----------------------------------------------------------------*/
-/* moduleLineWithAddr - finds and returns a line  with a given address */
+/* moduleWithAddr - finds the module having an asm line at address */
+/*                  with binary search in the cdb index            */
 /*-----------------------------------------------------------------*/
-DEFSETFUNC(moduleLineWithAddr)
+static module *moduleWithAddr (unsigned int addr, int *line)
 {
-  module *mod = item;
-  int i;
+  module *mod;
+  char mname[128], *s, *bp;
+  unsigned int i;
+  int aline;
 
-  V_ARG(unsigned int,addr);
-  V_ARG(module **,rmod);
-  V_ARG(int *,line);
-
-  if (*rmod)
-      return 0;
+  if (!cdbIdx)
+      return NULL;
 
-  for (i=0; i < mod->nasmLines; i++ )
+  for (i = cdbIndexLineAt(cdbIdx, addr);
+       i < cdbIdx->nlines && cdbIndexLineAddr(cdbIdx, i) == addr;
+       i++)
     {
-      if ( mod->asmLines[i]->addr == addr)
+      /* L:A$<module>$<line>:<address> */
+      s = cdbIndexRecord(cdbIdx, cdbIndexLineRec(cdbIdx, i));
+      if (s[2] != 'A')
+          continue;
+      s += 4;
+      for ( bp = mname; *s && *s != '$' && *s != '.' &&
+                bp < mname + sizeof(mname) - 1; )
+          *bp++ = *s++;
+      *bp = '\0';
+      while (*s && *s != '$')
+          s++;
+
+      mod = NULL;
+      if (!applyToSet(modules, moduleWithName, mname, &mod) ||
+          sscanf(s, "$%d", &aline) != 1 ||
+          aline < 1 || aline > mod->nasmLines ||
+          mod->asmLines[aline-1]->addr != addr)
+          continue;
+
+      if (line)
         {
-          *rmod = mod ;
-          if (line )
+          *line = 0;
+          for ( aline=0; aline < mod->ncLines; aline++ )
             {
-              *line = 0;
-              for ( i=0; i < mod->ncLines; i++ )
-                {
-                  if ( mod->cLines[i]->addr > addr)
-                      break;
-                  *line = i;
-                }
-              return 1;
+              if ( mod->cLines[aline]->addr > addr)
+                  break;
+              *line = aline;
             }
         }
+      return mod;
     }
 
-  return 0;
+  return NULL;
 }
 
 /*-----------------------------------------------------------------*/
@@ -675,7 +691,7 @@ context *discoverContext (unsigned addr, function *func)
   if (!func && !applyToSet(functions,funcInAddr,addr,&func))
     {
       if (!applyToSet(functions,funcWithName,"_main",&func) ||
-          !applyToSet(modules,moduleLineWithAddr,addr,&mod,NULL))
+          !(mod = moduleWithAddr(addr,NULL)))
         {
           fprintf(stderr, "addr 0x%x in no module/function (runtime env?)\n",addr);
           return NULL;
@@ -910,7 +926,7 @@ static int cmdDisasm (char *s, context *cctxt, int args)
         }
       else
         {
-          if (applyToSet(modules,moduleLineWithAddr,saddr,&modul,NULL))
+          if ((modul = moduleWithAddr(saddr,NULL)))
             {
               eaddr = saddr + 5;
               printf("Dump of assembler code:\n");
@@ -937,7 +953,7 @@ static int cmdDisasm (char *s, context *cctxt, int args)
             {
               if ( found )
                   break;
-              if (!applyToSet(modules,moduleLineWithAddr,saddr,&modul,NULL))
+              if (!(modul = moduleWithAddr(saddr,NULL)))
                   break;
             }
           saddr = printAsmLine(func,modul,saddr,eaddr) + 1;
@@ -1035,7 +1051,7 @@ static int commonSetUserBp(char *s, context *cctxt, char bpType)
       if (!applyToSet (functions, funcInAddr, braddr, &func))
         {
           module *modul;
-          if (!applyToSet (modules, moduleLineWithAddr, braddr, &modul, &line))
+          if (!(modul = moduleWithAddr (braddr, &line)))
             {
               fprintf (stderr, "Address 0x%08lx not exists in code.\n", braddr);
             }
@@ -53,6 +53,7 @@ int   sdcdbDebug = 0;
 
 char *currModName = NULL;
 cdbrecs *recsRoot = NULL;
+cdbIndex *cdbIdx = NULL;
 set  *modules = NULL;    /* set of all modules */
 set  *functions = NULL;  /* set of functions */
 set  *symbols = NULL;    /* set of symbols */
@@ -371,23 +372,30 @@ void **resize (void **array, int newSize)
 }
 
 /*-----------------------------------------------------------------*/
-/* readCdb - reads the cdb files & puts the records into cdbLine   */
-/*           linked list                                           */
+/* readCdb - maps the index of the cdb file & puts the records     */
+/*           into cdbLine linked list                              */
 /*-----------------------------------------------------------------*/
-static int readCdb (FILE *file)
+static int readCdb (char *name)
 {
   cdbrecs *currl;
-  char buffer[1024];
+  unsigned int i;
   char *bp;
 
-  if (!(bp = fgets(buffer, sizeof(buffer), file)))
+  /* the index is made again if the cdb file changed */
+  if (!(cdbIdx = cdbIndexOpen(name, NULL)) || !cdbIdx->nrecs)
       return 0;
 
-  currl = Safe_calloc(1, sizeof(cdbrecs));
-  recsRoot = currl;
+  /* records are allocated together, so recsRoot[i] is record i of
+     the index; lines point into the index */
+  recsRoot = Safe_calloc(cdbIdx->nrecs, sizeof(cdbrecs));
 
-  while (1)
+  for ( i = 0 ; i < cdbIdx->nrecs ; i++ )
     {
+      currl = recsRoot + i;
+      if ( i )
+          currl[-1].next = currl;
+      bp = cdbIndexRecord(cdbIdx, i);
+
       /* make sure this is a cdb record */
       if (strchr("STLFM",*bp) && *(bp+1) == ':')
         {
@@ -413,20 +421,8 @@ static int readCdb (FILE *file)
                 break;
             }
 
-          bp += 2;
-          currl->line = Safe_malloc(strlen(bp));
-          strncpy(currl->line, bp, strlen(bp)-1);
-          currl->line[strlen(bp)-1] = '\0';
+          currl->line = bp + 2;
         }
-
-      if (!(bp = fgets(buffer, sizeof(buffer), file)))
-          break;
-
-      if (feof(file))
-          break;
-
-      currl->next = Safe_calloc(1, sizeof(cdbrecs));
-      currl = currl->next;
     }
 
   return (recsRoot->line ? 1 : 0);
@@ -588,7 +584,7 @@ static void loadModules (void)
 
           /* if this is a function record */
           case FUNC_REC:
-            parseFunc(loop->line);
+            loop->item = parseFunc(loop->line);
             break;
 
           /* if this is a structure record */
@@ -598,11 +594,11 @@ static void loadModules (void)
 
           /* if symbol then parse the symbol */
           case  SYM_REC:
-            parseSymbol(loop->line, &rs, 2);
+            loop->item = parseSymbol(loop->line, &rs, 2);
             break;
 
           case LNK_REC:
-            parseLnkRec(loop->line);
+            loop->item = parseLnkRec(loop->line);
             break;
         }
     }
@@ -789,7 +785,7 @@ int cmdFile (char *s,context *cctxt)
 {
   FILE *cdbFile;
   char buffer[128];
-  char *bp;
+  char *bp, *cdbName;
 
   s = trim_left(s);
 
@@ -801,7 +797,8 @@ int cmdFile (char *s,context *cctxt)
 
   sprintf(buffer, "%s.cdb", s);
   /* try creating the cdbfile */
-  if (!(cdbFile = searchDirsFopen(buffer)))
+  cdbName = searchDirsFname(buffer);
+  if (!(cdbFile = fopen(cdbName, "r")))
     {
       fprintf(stdout, "Cannot open file\"%s\", no symbolic information loaded\n", buffer);
       // return 0;
@@ -812,13 +809,15 @@ int cmdFile (char *s,context *cctxt)
 
   if (cdbFile)
     {
+      fclose(cdbFile);
       /* read in the debug information */
-      if (!readCdb (cdbFile))
+      if (!readCdb (cdbName))
         {
           fprintf(stdout,"No symbolic information found in file %s.cdb\n",s);
           //return 0;
         }
     }
+  free(cdbName);
 
   /* parse and load the modules required */
   loadModules();
@@ -2063,7 +2062,7 @@ sigintr(int sig)
   /* may be interrupt from user: stop debugger and also simulator */
   userinterrupt = 1;
   if ( !nointerrupt )
-      sendSim("stop\n");
+      simStop();
 }
 
 #ifndef _WIN32
@@ -2107,7 +2106,7 @@ int main ( int argc, char **argv)
 {
   simArgs[nsimArgs++] = "s51";
   simArgs[nsimArgs++] = "-P";
-  simArgs[nsimArgs++] = "-r";
+  simArgs[nsimArgs++] = "-B";
   simArgs[nsimArgs++] = "9756";
 
   /* parse command line */
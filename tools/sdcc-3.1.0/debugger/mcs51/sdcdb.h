@@ -56,6 +56,7 @@ extern int sdcdbDebug;
 #endif
 #include "src/SDCCset.h"
 #include "src/SDCChasht.h"
+#include "src/cdbIndex.h"
 
 #define TRUE 1
 #define FALSE !TRUE
@@ -174,6 +175,7 @@ typedef struct srcLine
 typedef struct  cdbrecs {
     char type ;               /* type of line */
     char *line;               /* contents of line */
+    void *item;               /* symbol or function (FUNC_REC) of it */
     struct cdbrecs *next;     /* next in chain */
 } cdbrecs ;
 
@@ -257,6 +259,7 @@ typedef struct _dsymbol
 
 
 extern cdbrecs *recsRoot ;
+extern cdbIndex *cdbIdx ;
 extern context *currCtxt ;
 extern set *modules  ; /* set of modules   */
 extern set *functions; /* set of functions */
@@ -30,27 +30,20 @@
 # include <winsock2.h>
 # include <io.h>
 #else
-# ifdef __sun
-#   define BSD_COMP
-#   include <sys/file.h>
-# endif
 # ifdef HAVE_SYS_SOCKET_H
 #   include <sys/types.h>
 #   include <sys/socket.h>
 #   include <netinet/in.h>
 #   include <arpa/inet.h>
 #   include <unistd.h>
-#   include <sys/ioctl.h>
+#   include <sys/time.h>
 # else
 #   error "Cannot build debugger without socket support"
 # endif
 #endif
-#include <fcntl.h>
 #include <signal.h>
 #include <time.h>
-
-FILE *simin ; /* stream for simulator input */
-FILE *simout; /* stream for simulator output */
+#include <errno.h>
 
 #ifdef _WIN32
 SOCKET sock = INVALID_SOCKET;
@@ -65,68 +58,245 @@ char simactive = 0;
 
 static memcache_t memCache[NMEM_CACHE];
 
+#ifdef _WIN32
+#define SIM_SOCK_OK (INVALID_SOCKET != sock)
+#else
+#define SIM_SOCK_OK (sock != -1)
+#endif
+
+/* frames received from the simulator */
+static unsigned char simrbuff[SIM_HEADER + SIM_MAX_PAYLOAD];
+static int simrlen = 0;
+static unsigned char simTag = 0;       /* tag of the last request */
+static int cmdTag = -1;                /* tag of the last text command */
+static int simRunning = 0;             /* waiting for the stop event */
+static unsigned int simStopPC = 0;    /* PC after the last command */
+
+/*-----------------------------------------------------------------*/
+/* simSendFrame - send a request, returns its tag                  */
+/*-----------------------------------------------------------------*/
+static int simSendFrame(int type, const unsigned char *data, int len)
+{
+  unsigned char hdr[SIM_HEADER];
+  int n;
+
+  if ( ! SIM_SOCK_OK )
+    return -1;
+
+  simTag = (simTag + 1) & 0xff;
+  hdr[0] = type;
+  hdr[1] = simTag;
+  hdr[2] = len & 0xff;
+  hdr[3] = (len >> 8) & 0xff;
+  if (send(sock, (const char *)hdr, SIM_HEADER, 0) != SIM_HEADER)
+    return -1;
+  while (len > 0)
+    {
+      if ((n = send(sock, (const char *)data, len, 0)) <= 0)
+        return -1;
+      data += n;
+      len -= n;
+    }
+  return simTag;
+}
+
+/*-----------------------------------------------------------------*/
+/* simRecvFrame - read next frame from the simulator, returns its  */
+/* type, 0 on timeout and -1 if the connection is lost             */
+/*-----------------------------------------------------------------*/
+static int simRecvFrame(int *tag, unsigned char **data, int *len,
+                        int timeout_ms)
+{
+  static int done = 0;
+  fd_set set;
+  struct timeval tv;
+  int n;
+
+  /* drop the frame returned last time */
+  if (done)
+    {
+      memmove(simrbuff, simrbuff + done, simrlen - done);
+      simrlen -= done;
+      done = 0;
+    }
+  while (simrlen < SIM_HEADER ||
+         simrlen < SIM_HEADER + (simrbuff[2] | (simrbuff[3] << 8)))
+    {
+      if ( ! SIM_SOCK_OK )
+        return -1;
+      FD_ZERO(&set);
+      FD_SET(sock, &set);
+      tv.tv_sec = timeout_ms / 1000;
+      tv.tv_usec = (timeout_ms % 1000) * 1000;
+      n = select(sock + 1, &set, NULL, NULL, (timeout_ms < 0) ? NULL : &tv);
+      if (n < 0)
+        {
+          if (errno == EINTR)
+            continue;
+          return -1;
+        }
+      if (n == 0)
+        return 0;
+      n = recv(sock, (char *)simrbuff + simrlen, sizeof(simrbuff) - simrlen, 0);
+      if (n <= 0)
+        return -1;
+      simrlen += n;
+    }
+  *tag = simrbuff[1];
+  *len = simrbuff[2] | (simrbuff[3] << 8);
+  *data = simrbuff + SIM_HEADER;
+  done = SIM_HEADER + *len;
+  return simrbuff[0];
+}
+
+/*-----------------------------------------------------------------*/
+/* simAppendText - add text of an answer to the response buffer    */
+/*-----------------------------------------------------------------*/
+static void simAppendText(unsigned char *text, int len)
+{
+  if (len > simibuff + MAX_SIM_BUFF - 1 - sbp)
+    len = simibuff + MAX_SIM_BUFF - 1 - sbp;
+  memcpy(sbp, text, len);
+  sbp += len;
+  *sbp = 0;
+}
+
+/*-----------------------------------------------------------------*/
+/* simWaitReply - wait for the answer of a request, events and     */
+/* answers of other requests arriving in the meantime are eaten    */
+/*-----------------------------------------------------------------*/
+static int simWaitReply(int tag, unsigned char **data, int *len,
+                        int timeout_ms)
+{
+  int type, rtag;
+
+  while ((type = simRecvFrame(&rtag, data, len, timeout_ms)) > 0)
+    {
+      if (type == SIM_EV_STOP && *len >= 6)
+        {
+          simRunning = 0;
+          simStopPC = (*data)[2] | ((*data)[3] << 8) |
+              ((*data)[4] << 16) | ((*data)[5] << 24);
+          simAppendText(*data + 6, *len - 6);
+          if (tag < 0)
+            return type;
+        }
+      else if ((type & SIM_REPLY) && rtag == tag)
+        return type & ~SIM_REPLY;
+    }
+  return type;
+}
+
+/*-----------------------------------------------------------------*/
+/* simWaitStop - wait until the simulation stops                   */
+/*-----------------------------------------------------------------*/
+static void simWaitStop(int timeout_ms)
+{
+  unsigned char *data;
+  int len;
+
+  while (simRunning)
+    if (simWaitReply(-1, &data, &len, timeout_ms) <= 0)
+      break;
+}
+
+/*-----------------------------------------------------------------*/
+/* simPutRange - add a memory range to a read or write request     */
+/*-----------------------------------------------------------------*/
+static int simPutRange(unsigned char *buf, const char *space,
+                       unsigned int addr, unsigned int count)
+{
+  int n = strlen(space);
+
+  buf[0] = n;
+  memcpy(buf + 1, space, n);
+  buf += n + 1;
+  buf[0] = addr & 0xff;
+  buf[1] = (addr >> 8) & 0xff;
+  buf[2] = (addr >> 16) & 0xff;
+  buf[3] = (addr >> 24) & 0xff;
+  buf[4] = count & 0xff;
+  buf[5] = (count >> 8) & 0xff;
+  return n + 7;
+}
+
+/*-----------------------------------------------------------------*/
+/* simReadMem - read ranges of memories in one request, returns    */
+/* number of ranges read successfully                              */
+/*-----------------------------------------------------------------*/
+static int simReadMem(int n, const char **spaces, unsigned int *addrs,
+                      unsigned int *counts, unsigned char **bufs)
+{
+  unsigned char req[256], *data;
+  int i, len, pos = 0, width, ok = 0;
+
+  for (i = 0; i < n; i++)
+    pos += simPutRange(req + pos, spaces[i], addrs[i], counts[i]);
+  if (simWaitReply(simSendFrame(SIM_READ, req, pos), &data, &len, -1) !=
+      SIM_READ)
+      return 0;
+  for (i = 0, pos = 0; i < n && pos + 2 <= len; i++)
+    {
+      width = data[pos + 1];
+      if (data[pos] == 0 && width == 1 &&
+          pos + 2 + (int)counts[i] <= len)
+        {
+          memcpy(bufs[i], data + pos + 2, counts[i]);
+          ok++;
+        }
+      else
+        counts[i] = 0;
+      pos += 2 + counts[i] * width;
+    }
+  return ok;
+}
+
 /*-----------------------------------------------------------------*/
 /* get data from  memory cache/ load cache from simulator          */
 /*-----------------------------------------------------------------*/
-static char *getMemCache(unsigned int addr,int cachenum, unsigned int size)
+static unsigned char *getMemCache(unsigned int addr,int cachenum, unsigned int size)
 {
-  char *resp, *buf;
-  unsigned int laddr;
+  const char *spaces[2];
+  unsigned int addrs[2], counts[2];
+  unsigned char *bufs[2];
   memcache_t *cache = &memCache[cachenum];
 
   if ( cache->size <=   0 ||
        cache->addr > addr ||
        cache->addr + cache->size < addr + size )
     {
-      if ( cachenum == IMEM_CACHE )
+      if ( cachenum == IMEM_CACHE || cachenum == SREG_CACHE )
         {
-          sendSim("di 0x0 0xff\n");
-        }
-      else if ( cachenum == SREG_CACHE )
-        {
-          sendSim("ds 0x80 0xff\n");
+          /* internal ram and sfrs are loaded together */
+          spaces[0] = "iram";
+          addrs[0] = 0;
+          counts[0] = 0x100;
+          bufs[0] = memCache[IMEM_CACHE].buffer;
+          spaces[1] = "sfr";
+          addrs[1] = 0x80;
+          counts[1] = 0x80;
+          bufs[1] = memCache[SREG_CACHE].buffer;
+          simReadMem(2, spaces, addrs, counts, bufs);
+          memCache[IMEM_CACHE].addr = addrs[0];
+          memCache[IMEM_CACHE].size = counts[0];
+          memCache[SREG_CACHE].addr = addrs[1];
+          memCache[SREG_CACHE].size = counts[1];
         }
       else
         {
-          laddr = addr & 0xffffffc0;
-          sprintf(cache->buffer,"dx 0x%x 0x%x\n",laddr,laddr+0xff );
-          sendSim(cache->buffer);
-        }
-      waitForSim(100,NULL);
-      resp = simResponse();
-      cache->addr = strtol(resp,0,0);
-      buf = cache->buffer;
-      cache->size = 0;
-      while ( *resp && *(resp+1) && *(resp+2))
-        {
-          /* cache is a stringbuffer with ascii data like
-             " 00 00 00 00 00 00 00 00"
-          */
-          resp += 2;
-          laddr = 0;
-          /* skip thru the address part */
-          while (isxdigit(*resp))
-              resp++;
-          while ( *resp && *resp != '\n')
-            {
-              if ( laddr < 24 )
-                {
-                  laddr++ ;
-                  *buf++ = *resp ;
-                }
-              resp++;
-            }
-          resp++ ;
-          cache->size += 8;
+          spaces[0] = "xram";
+          addrs[0] = addr & 0xffffffc0;
+          counts[0] = 0x100;
+          bufs[0] = cache->buffer;
+          simReadMem(1, spaces, addrs, counts, bufs);
+          cache->addr = addrs[0];
+          cache->size = counts[0];
         }
-      *buf = '\0';
       if ( cache->addr > addr ||
            cache->addr + cache->size < addr + size )
-        {
           return NULL;
-        }
     }
-  return cache->buffer + (addr - cache->addr)*3;
+  return cache->buffer + (addr - cache->addr);
 }
 
 /*-----------------------------------------------------------------*/
@@ -135,6 +305,11 @@ static char *getMemCache(unsigned int addr,int cachenum, unsigned int size)
 static void invalidateCache( int cachenum )
 {
   memCache[cachenum].size = 0;
+  /* they are loaded together */
+  if ( cachenum == IMEM_CACHE )
+    memCache[SREG_CACHE].size = 0;
+  else if ( cachenum == SREG_CACHE )
+    memCache[IMEM_CACHE].size = 0;
 }
 
 /*-----------------------------------------------------------------*/
@@ -142,21 +317,49 @@ static void invalidateCache( int cachenum )
 /*-----------------------------------------------------------------*/
 void waitForSim(int timeout_ms, char *expect)
 {
-  int ch;
-  clock_t timeout;
+  unsigned char *data;
+  int len, type;
 
   Dprintf(D_simi, ("simi: waitForSim start(%d)\n", timeout_ms));
   sbp = simibuff;
+  *sbp = 0;
 
-  timeout = clock() + ((timeout_ms * CLOCKS_PER_SEC) / 1000);
-  while (((ch = fgetc(simin)) > 0 ) && (clock() <= timeout))
+  type = simWaitReply(cmdTag, &data, &len, -1);
+  if (type == SIM_CMD && len >= 5)
     {
-      *sbp++ = ch;
-    }
-  *sbp = 0;
+      if (data[0] & SIM_RUNNING)
+        simRunning = 1;
+      simStopPC = data[1] | (data[2] << 8) | (data[3] << 16) | (data[4] << 24);
+      simAppendText(data + 5, len - 5);
+      /* give a short run the chance to finish */
+      simWaitStop(timeout_ms);
+    }
+  else if (type == SIM_ERROR)
+    simAppendText(data, len);
   Dprintf(D_simi, ("waitForSim(%d) got[%s]\n", timeout_ms, simibuff));
 }
 
+/*-----------------------------------------------------------------*/
+/* simHello - greet the simulator, the answer brings the welcome   */
+/*-----------------------------------------------------------------*/
+static void simHello(void)
+{
+  unsigned char *data;
+  int len;
+
+  sbp = simibuff;
+  *sbp = 0;
+  if (simWaitReply(simSendFrame(SIM_HELLO, NULL, 0), &data, &len, 2000) !=
+      SIM_HELLO)
+    {
+      fprintf(stderr, "simulator does not answer\n");
+      exit(1);
+    }
+  if (len > 1)
+    simAppendText(data + 1, len - 1);
+  simactive = 1;
+}
+
 /*-----------------------------------------------------------------*/
 /* openSimulator - create a pipe to talk to simulator              */
 /*-----------------------------------------------------------------*/
@@ -216,9 +419,6 @@ void openSimulator (char **args, int nargs)
     struct sockaddr_in sin;
     int retry = 0;
     int i;
-    int iResult;
-    int fh;
-    u_long iMode;
 
   init_winsock();
 
@@ -267,43 +467,7 @@ void openSimulator (char **args, int nargs)
       exit(1);
     }
 
-  iMode = 1; /* set non-blocking mode */
-  iResult = ioctlsocket(sock, FIONBIO, &iMode);
-  if (iResult != NO_ERROR)
-    {
-      perror("ioctlsocket failed");
-      exit(1);
-    }
-
-  fh = _open_osfhandle(sock, _O_TEXT);
-  if (-1 == fh)
-    {
-      perror("cannot _open_osfhandle");
-      exit(1);
-    }
-
-  /* got the socket now turn it into a file handle */
-  if (!(simin = fdopen(fh, "r")))
-    {
-      perror("cannot open socket for read");
-      exit(1);
-    }
-
-  fh = _open_osfhandle(sock, _O_TEXT);
-  if (-1 == fh)
-    {
-      perror("cannot _open_osfhandle");
-      exit(1);
-    }
-
-  if (!(simout = fdopen(fh, "w")))
-    {
-      perror("cannot open socket for write");
-      exit(1);
-    }
-  /* now that we have opened, wait for the prompt */
-  waitForSim(200, NULL);
-  simactive = 1;
+  simHello();
 }
 #else
 static int execSimulator(char **args, int nargs)
@@ -334,10 +498,6 @@ void openSimulator (char **args, int nargs)
     struct sockaddr_in sin;
     int retry = 0;
     int i;
-    int iResult;
-#if defined(__sun) || defined(__CYGWIN__)
-    u_long iMode;
-#endif
 
     Dprintf(D_simi, ("simi: openSimulator\n"));
 #ifdef SDCDB_DEBUG
@@ -386,33 +546,7 @@ void openSimulator (char **args, int nargs)
       exit(1);
     }
 
-#if defined(__sun) || defined(__CYGWIN__)
-  iMode = 1; /* set non-blocking mode */
-  iResult = ioctl(sock, FIONBIO, &iMode);
-#else
-  iResult = fcntl(sock, F_SETFL, O_NONBLOCK | O_ASYNC);
-#endif
-  if (iResult != 0)
-    {
-      perror("ioctl failed");
-      exit(1);
-    }
-
-  /* got the socket now turn it into a file handle */
-  if (!(simin = fdopen(sock, "r")))
-    {
-      fprintf(stderr,"cannot open socket for read\n");
-      exit(1);
-    }
-
-  if (!(simout = fdopen(sock, "w")))
-    {
-      fprintf(stderr,"cannot open socket for write\n");
-      exit(1);
-    }
-  /* now that we have opened, wait for the prompt */
-  waitForSim(200,NULL);
-  simactive = 1;
+  simHello();
 }
 #endif
 
@@ -429,60 +563,58 @@ char *simResponse(void)
 /*-----------------------------------------------------------------*/
 void sendSim(char *s)
 {
-  if ( ! simout )
+  int len = strlen(s);
+
+  if ( ! SIM_SOCK_OK )
       return;
 
   Dprintf(D_simi, ("simi: sendSim-->%s", s));  // s has LF at end already
-  fputs(s,simout);
-  fflush(simout);
+  if (len > 0 && s[len-1] == '\n')
+      len--;
+  cmdTag = simSendFrame(SIM_CMD, (unsigned char *)s, len);
+}
+
+/*-----------------------------------------------------------------*/
+/* simStop - stop the running simulation, answer is not waited for */
+/*-----------------------------------------------------------------*/
+void simStop(void)
+{
+  simSendFrame(SIM_STOP, NULL, 0);
 }
 
 
-static int getMemString(char *buffer, char wrflag,
-                        unsigned int *addr, char mem, unsigned int size )
+static int getMemSpace(const char **space, unsigned int *addr, char mem)
 {
   int cachenr = NMEM_CACHE;
-  char *prefix;
-  char *cmd ;
-
-  if ( wrflag )
-      cmd = "set mem";
-  else
-      cmd = "dump";
-  buffer[0] = '\0' ;
 
+  *space = NULL;
   switch (mem)
     {
       case 'A': /* External stack */
       case 'F': /* External ram */
-          prefix = "xram";
+          *space = "xram";
           cachenr = XMEM_CACHE;
           break;
       case 'C': /* Code */
       case 'D': /* Code / static segment */
-          prefix = "rom";
+          *space = "rom";
           break;
       case 'B': /* Internal stack */
       case 'E': /* Internal ram (lower 128) bytes */
       case 'G': /* Internal ram */
-          prefix = "iram";
+          *space = "iram";
           cachenr = IMEM_CACHE;
           break;
       case 'H': /* Bit addressable */
       case 'J': /* SBIT space */
           cachenr = BIT_CACHE;
-          if ( wrflag )
-            {
-              cmd = "set bit";
-            }
-          sprintf(buffer,"%s 0x%x\n",cmd,*addr);
-          return cachenr;
+          break;
       case 'I': /* SFR space */
-          prefix = "sfr" ;
+          *space = "sfr" ;
           cachenr = SREG_CACHE;
           break;
       case 'R': /* Register space */
-          prefix = "iram";
+          *space = "iram";
           /* get register bank */
           cachenr = simGetValue (0xd0,'I',1);
           *addr  += cachenr & 0x18 ;
@@ -490,50 +622,58 @@ static int getMemString(char *buffer, char wrflag,
           break;
       default:
       case 'Z': /* undefined space code */
-          return cachenr;
+          break;
     }
-  if ( wrflag )
-      sprintf(buffer,"%s %s 0x%x\n",cmd,prefix,*addr);
-  else
-      sprintf(buffer,"%s %s 0x%x 0x%x\n",cmd,prefix,*addr,*addr+size-1);
   return cachenr;
 }
 
 void simSetPC( unsigned int addr )
 {
-  char buffer[40];
-  sprintf(buffer,"pc %d\n", addr);
-  sendSim(buffer);
-  waitForSim(100,NULL);
-  simResponse();
+  unsigned char buf[4];
+
+  buf[0] = addr & 0xff;
+  buf[1] = (addr >> 8) & 0xff;
+  buf[2] = (addr >> 16) & 0xff;
+  buf[3] = (addr >> 24) & 0xff;
+  simSendFrame(SIM_PC, buf, 4);
 }
 
 int simSetValue (unsigned int addr,char mem, unsigned int size, unsigned long val)
 {
   unsigned int i;
-  char cachenr;
+  int cachenr, len;
   char buffer[40];
-  char *s;
+  unsigned char req[64];
+  const char *space;
 
   if ( size <= 0 )
       return 0;
 
-  cachenr = getMemString(buffer, 1, &addr, mem, size);
+  cachenr = getMemSpace(&space, &addr, mem);
+  if ( cachenr == BIT_CACHE )
+    {
+      invalidateCache(IMEM_CACHE);
+      sprintf(buffer, "set bit 0x%x 0x%lx\n", addr, val & 1);
+      sendSim(buffer);
+      waitForSim(100, NULL);
+      return 0;
+    }
+  if ( ! space )
+      return 0;
   if ( cachenr < NMEM_CACHE )
     {
       invalidateCache(cachenr);
     }
-  s = buffer + strlen(buffer) -1;
+  if ( size > 4 )
+      size = 4;
+  len = simPutRange(req, space, addr, size);
   for ( i = 0 ; i < size ; i++ )
     {
-      sprintf(s," 0x%lx", val & 0xff);
-      s += strlen(s);
+      req[len++] = val & 0xff;
       val >>= 8;
     }
-  sprintf(s,"\n");
-  sendSim(buffer);
-  waitForSim(100,NULL);
-  simResponse();
+  /* answer is not needed, following requests are served in order */
+  simSendFrame(SIM_WRITE, req, len);
   return 0;
 }
 
@@ -542,66 +682,47 @@ int simSetValue (unsigned int addr,char mem, unsigned int size, unsigned long va
 /*-----------------------------------------------------------------*/
 unsigned long simGetValue (unsigned int addr,char mem, unsigned int size)
 {
-  unsigned int b[4] = {0,0,0,0}; /* can be a max of four bytes long */
-  char cachenr;
-  char buffer[40];
-  char *resp;
+  unsigned char b[4] = {0,0,0,0}; /* can be a max of four bytes long */
+  unsigned char *bufs[1];
+  unsigned int counts[1];
+  int cachenr;
+  const char *space;
+  unsigned char *resp;
 
   if ( size <= 0 )
       return 0;
+  if ( size > 4 )
+      size = 4;
+
+  cachenr = getMemSpace(&space, &addr, mem);
 
-  cachenr = getMemString(buffer, 0, &addr, mem, size);
+  /* make the branch for bit variables */
+  if ( cachenr == BIT_CACHE)
+    {
+      if ( addr < 0x80 )
+          resp = getMemCache(0x20 + (addr >> 3), IMEM_CACHE, 1);
+      else
+          resp = getMemCache(addr & 0xf8, SREG_CACHE, 1);
+      return resp ? (*resp >> (addr & 7)) & 1 : 0;
+    }
 
   resp = NULL;
   if ( cachenr < NMEM_CACHE )
     {
       resp = getMemCache(addr,cachenr,size);
     }
-  if ( !resp )
+  if ( resp )
     {
-      /* create the simulator command */
-      sendSim(buffer);
-      waitForSim(100,NULL);
-      resp = simResponse();
-
-      /* got the response we need to parse it the response
-         is of the form
-         [address] [v] [v] [v] ... special case in
-         case of bit variables which case it becomes
-         [address] [assembler bit address] [v] */
-      /* first skip thru white space */
-      resp = trim_left(resp);
-
-      if (strncmp(resp, "0x",2) == 0)
-          resp += 2;
-
-      /* skip thru the address part */
-      while (isxdigit(*resp))
-          resp++;
+      memcpy(b, resp, size);
     }
-  /* make the branch for bit variables */
-  if ( cachenr == BIT_CACHE)
+  else if ( space )
     {
-      /* skip until newline */
-      while (*resp && *resp != '\n' )
-          resp++ ;
-      if ( *--resp != '0' )
-          b[0] = 1;
+      counts[0] = size;
+      bufs[0] = b;
+      simReadMem(1, &space, &addr, counts, bufs);
     }
-  else
-    {
-      unsigned int i;
 
-      for (i = 0 ; i < size ; i++ )
-        {
-          /* skip white space */
-          resp = trim_left(resp);
-
-          b[i] = strtol(resp,&resp,16);
-        }
-    }
-
-  return b[0] | b[1] << 8 | b[2] << 16 | b[3] << 24 ;
+  return b[0] | b[1] << 8 | b[2] << 16 | (unsigned long)b[3] << 24 ;
 }
 
 /*-----------------------------------------------------------------*/
@@ -613,7 +734,6 @@ void simSetBP (unsigned int addr)
 
   sprintf(buff, "break 0x%x\n", addr);
   sendSim(buff);
-  waitForSim(100, NULL);
 }
 
 /*-----------------------------------------------------------------*/
@@ -625,7 +745,6 @@ void simClearBP (unsigned int addr)
 
   sprintf(buff, "clear 0x%x\n", addr);
   sendSim(buff);
-  waitForSim(100, NULL);
 }
 
 /*-----------------------------------------------------------------*/
@@ -647,7 +766,6 @@ void simLoadFile (char *s)
 unsigned int simGoTillBp ( unsigned int gaddr)
 {
   char *sr;
-  int wait_ms = 1000;
 
   invalidateCache(XMEM_CACHE);
   invalidateCache(IMEM_CACHE);
@@ -655,33 +773,25 @@ unsigned int simGoTillBp ( unsigned int gaddr)
   if (gaddr == 0)
     {
       /* initial start, start & stop from address 0 */
-      //char buf[20];
 
       // this program is setting up a bunch of breakpoints automatically
       // at key places.  Like at startup & main() and other function
       // entry points.  So we don't need to setup one here..
-      //sendSim("break 0x0\n");
-      //sleep(1);
-      //waitForSim();
 
       sendSim("reset\n");
-      waitForSim(wait_ms, NULL);
       sendSim("run 0x0\n");
     }
   else if (gaddr == -1)
     { /* resume */
       sendSim ("run\n");
-      wait_ms = 100;
     }
   else if (gaddr == 1 )
     { /* nexti or next */
       sendSim ("next\n");
-      wait_ms = 100;
     }
   else if (gaddr == 2 )
     { /* stepi or step */
       sendSim ("step\n");
-      wait_ms = 100;
     }
   else
     {
@@ -689,7 +799,10 @@ unsigned int simGoTillBp ( unsigned int gaddr)
       exit(1);
     }
 
-  waitForSim(wait_ms, NULL);
+  /* the answer comes at once, the stop event when the simulation
+     stops (at a breakpoint or because of simStop) */
+  waitForSim(0, NULL);
+  simWaitStop(-1);
 
   /* get the simulator response */
   sr = simResponse();
@@ -709,18 +822,12 @@ unsigned int simGoTillBp ( unsigned int gaddr)
     }
 
   nointerrupt = 1;
-  /* get answer of stop command */
-  if ( userinterrupt )
-      waitForSim(wait_ms, NULL);
-
-  /* better solution: ask pc */
+  /* disassembled instruction at pc is the response */
   sendSim ("pc\n");
-  waitForSim(100, NULL);
-  sr = simResponse();
+  waitForSim(0, NULL);
   nointerrupt = 0;
 
-  gaddr = strtol(sr+3, 0, 0);
-  return gaddr;
+  return simStopPC;
 }
 
 /*-----------------------------------------------------------------*/
@@ -740,19 +847,13 @@ void simReset (void)
 /*-----------------------------------------------------------------*/
 void closeSimulator (void)
 {
-#ifdef _WIN32
-  if ( ! simin || ! simout || INVALID_SOCKET == sock )
-#else
-  if ( ! simin || ! simout || sock == -1 )
-#endif
+  if ( ! SIM_SOCK_OK )
     {
       simactive = 0;
       return;
     }
   simactive = 0;
   sendSim("quit\n");
-  fclose (simin);
-  fclose (simout);
   shutdown(sock, 2);
 #ifdef _WIN32
   closesocket(sock);
@@ -36,6 +36,20 @@
 
 #define MAX_SIM_BUFF 8*1024
 
+/* binary protocol of ucsim (-B port), see sim/ucsim/cmd.src/newcmdbincl.h */
+#define SIM_HEADER      4
+#define SIM_MAX_PAYLOAD 0xffff
+#define SIM_HELLO       0x01
+#define SIM_CMD         0x02
+#define SIM_READ        0x03
+#define SIM_WRITE       0x04
+#define SIM_PC          0x05
+#define SIM_STOP        0x06
+#define SIM_EV_STOP     0x40
+#define SIM_ERROR       0x7f
+#define SIM_REPLY       0x80
+#define SIM_RUNNING     0x01
+
 #define MAX_CACHE_SIZE 2048
 /* number of cache */
 #define IMEM_CACHE     0
@@ -49,7 +63,7 @@ typedef struct _memcache
 {
     unsigned int addr;
     unsigned int size;
-    char buffer[MAX_CACHE_SIZE];
+    unsigned char buffer[MAX_CACHE_SIZE];
 } memcache_t;
 
 //#define SIMNAME "s51"
@@ -63,6 +77,7 @@ void  openSimulator (char **,int);
 void waitForSim(int timeout_ms, char *expect);
 void  closeSimulator ();
 void  sendSim(char *);
+void  simStop(void);
 char *simResponse();
 void  simSetPC (unsigned int);
 void  simSetBP (unsigned int);
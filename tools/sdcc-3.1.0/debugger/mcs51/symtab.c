@@ -26,7 +26,7 @@
 #include "newalloc.h"
 
 structdef *structWithName (char *);
-DEFSETFUNC(symWithRName);
+static symbol *symWithRName (char *, char *);
 
 /*-----------------------------------------------------------------*/
 /* gc_strcat - allocate and return concatenated strings            */
@@ -97,7 +97,7 @@ unsigned int   getSize ( st_link *p )
 /*-----------------------------------------------------------------*/
 /* parseFunc - creates a function record entry                     */
 /*-----------------------------------------------------------------*/
-void parseFunc (char *line)
+function *parseFunc (char *line)
 {
   function *func;
   char *rs = line;
@@ -105,11 +105,10 @@ void parseFunc (char *line)
 
   while (*rs && *rs != '(')
       rs++;
-  *--rs = '\0';
 
   func = Safe_calloc(1, sizeof(function));
-  func->sym = NULL;
-  applyToSetFTrue(symbols, symWithRName, line, &func->sym);
+  func->sym = symWithRName(line, rs);
+  *--rs = '\0';
   *rs++ = '0';
   if (! func->sym)
       func->sym = parseSymbol(line, &rs, 1);
@@ -123,6 +122,7 @@ void parseFunc (char *line)
          &(SPEC_BANK(func->sym->etype)));
   SPEC_INTRTN(func->sym->etype) = i;
   addSet(&functions, func);
+  return func;
 }
 
 /*-----------------------------------------------------------------*/
@@ -272,19 +272,19 @@ symbol *parseSymbol (char *s, char **rs, int doadd)
   /* go the mangled name */
   for ( bp = s; *bp && *bp != '('; bp++ )
     ;
-  save_ch = *--bp;
-  *bp = '\0';
   nsym = NULL;
   if ( doadd == 2 )
     {
       /* add only if not present and if linkrecord before symbol record */
-      if ( applyToSetFTrue(symbols, symWithRName, s, &nsym))
+      if ((nsym = symWithRName(s, bp)))
         {
           if ( nsym->rname != nsym->name )
               return NULL;
           doadd = 0;
         }
     }
+  save_ch = *--bp;
+  *bp = '\0';
   if ( ! nsym )
     {
       nsym = Safe_calloc(1, sizeof(symbol));
@@ -518,45 +518,45 @@ structdef *structWithName (char *s)
 }
 
 /*-----------------------------------------------------------------*/
-/* symWithRName - look for symbol with mangled name = parm         */
+/* recWithRName - parsed cdb record with mangled name from s to    */
+/*                end, looked up in the hash of the cdb index      */
 /*-----------------------------------------------------------------*/
-DEFSETFUNC(symWithRName)
+static cdbrecs *recWithRName (char *s, char *end, int funcOnly)
 {
-  symbol *sym = item;
-  V_ARG(char *, s);
-  V_ARG(symbol **, rsym);
+  cdbrecs *rec = NULL;
+  char save_ch = *end;
+  int i;
 
-  if (*rsym)
-      return 0;
+  if (!cdbIdx)
+      return NULL;
 
-  if (strcmp(sym->rname, s) == 0)
+  *end = '\0';
+  for (i = cdbIndexFind(cdbIdx, s, -1); i >= 0; i = cdbIndexFind(cdbIdx, s, i))
     {
-      *rsym = sym;
-      return 1;
+      if (recsRoot[i].item &&
+          (!funcOnly || recsRoot[i].type == FUNC_REC))
+        {
+          rec = recsRoot + i;
+          break;
+        }
     }
+  *end = save_ch;
 
-  return 0;
+  return rec;
 }
 
 /*-----------------------------------------------------------------*/
-/* funcWithRName - look for function with name                     */
+/* symWithRName - look for symbol with mangled name from s to end  */
 /*-----------------------------------------------------------------*/
-DEFSETFUNC(funcWithRName)
+static symbol *symWithRName (char *s, char *end)
 {
-  function *func = item;
-  V_ARG(char *,s);
-  V_ARG(function **,rfunc);
-
-  if (*rfunc)
-      return 0;
-
-  if (strcmp(func->sym->rname,s) == 0)
-    {
-      *rfunc = func;
-      return 1;
-    }
+  cdbrecs *rec = recWithRName(s, end, 0);
 
-  return 0;
+  if (!rec)
+      return NULL;
+  if (rec->type == FUNC_REC)
+      return ((function *)rec->item)->sym;
+  return rec->item;
 }
 
 /*-----------------------------------------------------------------*/
@@ -669,21 +669,17 @@ symbol *symLookup (char *name, context *ctxt)
 /*-----------------------------------------------------------------*/
 static void lnkFuncEnd (char *s)
 {
-  char sname[128], *bp = sname;
+  char *bp;
+  cdbrecs *rec;
   function *func;
 
-  /* copy till we get to a ':' */
-  while ( *s != ':' )
-      *bp++ = *s++;
-  bp -= 1;
-  *bp = '\0';
-
-  func = NULL;
-  if (!applyToSet(functions,funcWithRName,sname,&func))
+  /* search to a ':' */
+  for ( bp = s; *bp && *bp != ':'; bp++ );
+  if (!*bp || !(rec = recWithRName(s, bp, 1)))
       return ;
+  func = rec->item;
 
-  s++;
-  sscanf(s,"%x",&func->sym->eaddr);
+  sscanf(bp+1,"%x",&func->sym->eaddr);
 
   Dprintf(D_symtab, ("symtab: ead %s(0x%x)\n",func->sym->name,func->sym->eaddr));
 }
@@ -691,18 +687,17 @@ static void lnkFuncEnd (char *s)
 /*-----------------------------------------------------------------*/
 /* lnkSymRec - record for a symbol                                 */
 /*-----------------------------------------------------------------*/
-static void lnkSymRec (char *s)
+static symbol *lnkSymRec (char *s)
 {
   char *bp, save_ch ;
   symbol *sym;
 
   /* search  to a ':' */
   for ( bp = s; *bp && *bp != ':'; bp++ );
+  sym = symWithRName(s, bp);
   save_ch = *--bp;
   *bp = '\0';
 
-  sym = NULL;
-  applyToSetFTrue(symbols,symWithRName,s,&sym);
   if (! sym)
     {
       sym = Safe_calloc(1,sizeof(symbol));
@@ -717,6 +712,7 @@ static void lnkSymRec (char *s)
       sscanf(bp+2,"%x",&sym->addr);
     }
   Dprintf(D_symtab, ("symtab: lnk %s(0x%x)\n",sym->name,sym->addr));
+  return sym;
 }
 
 /*-----------------------------------------------------------------*/
@@ -813,9 +809,10 @@ static void lnkCSrc (char *s)
 }
 
 /*-----------------------------------------------------------------*/
-/* parseLnkRec - parses a linker generated record                  */
+/* parseLnkRec - parses a linker generated record, returns the     */
+/*               symbol of symbol records                          */
 /*-----------------------------------------------------------------*/
-void parseLnkRec (char *s)
+symbol *parseLnkRec (char *s)
 {
   /* link records can be several types
      dpeneding on the type do */
@@ -836,7 +833,7 @@ void parseLnkRec (char *s)
         break;
 
       default :
-        lnkSymRec(s);
-        break;
+        return lnkSymRec(s);
     }
+  return NULL;
 }
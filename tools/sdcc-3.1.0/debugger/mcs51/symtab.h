@@ -235,9 +235,9 @@ typedef struct symbol {
 
 symbol *parseSymbol (char *, char **, int);
 structdef *parseStruct (char *);
-void parseFunc (char *);
+function *parseFunc (char *);
 module *parseModule (char *, bool);
-void parseLnkRec (char *);
+symbol *parseLnkRec (char *);
 symbol *symLookup (char *,context *);
 DEFSETFUNC(moduleWithName);
 DEFSETFUNC(moduleWithCName);
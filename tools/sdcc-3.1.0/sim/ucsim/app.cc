@@ -48,6 +48,7 @@ Software Foundation, 59 Temple Place - Suite 330, Boston, MA
 #include "appcl.h"
 #include "optioncl.h"
 #include "globals.h"
+#include "batchcl.h"
 
 // sim.src
 #include "simcl.h"
@@ -154,6 +155,16 @@ cl_app::run(void)
 {
   int done= 0;
 
+  if (sim &&
+      batch_mode())
+    {
+      class cl_batch *batch= new cl_batch(this);
+      if (!(done= batch->init()))
+        done= batch->run();
+      delete batch;
+      return(done);
+    }
+
   while (!done &&
          going)
     {
@@ -198,7 +209,10 @@ print_help(const char *name)
   printf("Usage: %s [-hHVvP] [-p prompt] [-t CPU] [-X freq[k|M]]\n"
          "       [-c file] [-s file] [-S optionlist]"
 #ifdef SOCKET_AVAIL
-         " [-Z portnum] [-k portnum]"
+         " [-Z portnum] [-B portnum] [-G portnum]\n       [-k portnum]"
+#endif
+#ifndef _WIN32
+         "\n       [-b file [-j jobs]]"
 #endif
          "\n"
          "       [files...]\n", name);
@@ -210,6 +224,8 @@ print_help(const char *name)
      "  -c file      Open command console on `file'\n"
 #ifdef SOCKET_AVAIL
      "  -Z portnum   Use localhost:portnumber for command console\n"
+     "  -B portnum   Use localhost:portnum for binary debugger protocol\n"
+     "  -G portnum   Use localhost:portnum for gdb remote protocol\n"
      "  -k portnum   Use localhost:portnum for serial I/O\n"
 #endif
      "  -s file      Connect serial interface to `file'\n"
@@ -217,6 +233,16 @@ print_help(const char *name)
      "               serial interface. Know options are:\n"
      "                  in=file   serial input will be read from file named `file'\n"
      "                  out=file  serial output will be written to `file'\n"
+#ifndef _WIN32
+     "                  unix=path serial line on a unix socket listening on `path'\n"
+     "                  pty[=link] serial line on a pseudo terminal (linked to `link')\n"
+#endif
+     "                  fast      no baud rate timing of characters\n"
+     "                  flow      receiver waits until RI is cleared\n"
+#ifndef _WIN32
+     "  -b file      Run the tests listed in `file' without consoles\n"
+     "  -j jobs      Number of tests of -b run in parallel\n"
+#endif
      "  -p prompt    Specify string for prompt\n"
      "  -P           Prompt is a null ('\\0') character\n"
      "  -V           Verbose mode\n"
@@ -228,12 +254,20 @@ print_help(const char *name)
 
 enum {
   SOPT_IN= 0,
-  SOPT_OUT
+  SOPT_OUT,
+  SOPT_UNIX,
+  SOPT_PTY,
+  SOPT_FAST,
+  SOPT_FLOW
 };
 
 static const char *S_opts[]= {
   /*[SOPT_IN]=*/ "in",
   /*[SOPT_OUT]=*/ "out",
+  /*[SOPT_UNIX]=*/ "unix",
+  /*[SOPT_PTY]=*/ "pty",
+  /*[SOPT_FAST]=*/ "fast",
+  /*[SOPT_FLOW]=*/ "flow",
   NULL
 };
 
@@ -248,7 +282,10 @@ cl_app::proc_arguments(int argc, char *argv[])
 
   strcpy(opts, "c:C:p:PX:vVt:s:S:hHk:");
 #ifdef SOCKET_AVAIL
-  strcat(opts, "Z:r:");
+  strcat(opts, "Z:r:B:G:");
+#endif
+#ifndef _WIN32
+  strcat(opts, "b:j:");
 #endif
 
   while((c= getopt(argc, argv, opts)) != -1)
@@ -279,6 +316,30 @@ cl_app::proc_arguments(int argc, char *argv[])
                     " to set parameter of -Z as pot number to listen on\n");
           break;
         }
+      case 'B':
+        {
+          class cl_option *o;
+          options->new_option(o= new cl_number_option(this, "bin_port_number",
+                                                      "Listen on port for debugger (-B)"));
+          o->init();
+          o->hide();
+          if (!options->set_value("bin_port_number", this, strtol(optarg, NULL, 0)))
+            fprintf(stderr, "Warning: No \"bin_port_number\" option found"
+                    " to set parameter of -B as port number to listen on\n");
+          break;
+        }
+      case 'G':
+        {
+          class cl_option *o;
+          options->new_option(o= new cl_number_option(this, "gdb_port_number",
+                                                      "Listen on port for gdb (-G)"));
+          o->init();
+          o->hide();
+          if (!options->set_value("gdb_port_number", this, strtol(optarg, NULL, 0)))
+            fprintf(stderr, "Warning: No \"gdb_port_number\" option found"
+                    " to set parameter of -G as port number to listen on\n");
+          break;
+        }
 #endif
       case 'p': {
         if (!options->set_value("prompt", this, optarg))
@@ -512,6 +573,26 @@ cl_app::proc_arguments(int argc, char *argv[])
                 fprintf(stderr, "Warning: No \"serial_out_file\" option found "
                         "to set parameter of -s as serial output file\n");
               break;
+            case SOPT_UNIX:
+              if (value == NULL) {
+                fprintf(stderr, "No value for -S unix\n");
+                exit(1);
+              }
+              if (!options->set_value("serial_unix", this, value))
+                fprintf(stderr, "Warning: No \"serial_unix\" option found\n");
+              break;
+            case SOPT_PTY:
+              if (!options->set_value("serial_pty", this, value?value:(char*)""))
+                fprintf(stderr, "Warning: No \"serial_pty\" option found\n");
+              break;
+            case SOPT_FAST:
+              if (!options->set_value("serial_fast", this, bool(DD_TRUE)))
+                fprintf(stderr, "Warning: No \"serial_fast\" option found\n");
+              break;
+            case SOPT_FLOW:
+              if (!options->set_value("serial_flow", this, bool(DD_TRUE)))
+                fprintf(stderr, "Warning: No \"serial_flow\" option found\n");
+              break;
             default:
               /* Unknown suboption. */
               fprintf(stderr, "Unknown suboption `%s' for -S\n", value);
@@ -519,6 +600,18 @@ cl_app::proc_arguments(int argc, char *argv[])
               break;
             }
         break;
+#ifndef _WIN32
+      case 'b':
+        if (!options->set_value("batch_file", this, optarg))
+          fprintf(stderr, "Warning: No \"batch_file\" option found "
+                  "to set by -b\n");
+        break;
+      case 'j':
+        if (!options->set_value("batch_jobs", this, strtol(optarg, NULL, 0)))
+          fprintf(stderr, "Warning: No \"batch_jobs\" option found "
+                  "to set by -j\n");
+        break;
+#endif
       case 'h':
         print_help("s51");
         exit(0);
@@ -565,6 +658,19 @@ cl_app::get_uc(void)
   return(sim->get_uc());
 }
 
+/* Tests of a list are run instead of serving consoles (-b) */
+
+bool
+cl_app::batch_mode(void)
+{
+  class cl_option *o= options->get_option("batch_file");
+  char *s= 0;
+
+  if (o)
+    o->get_value(&s);
+  return(s && *s);
+}
+
 
 /* Command handling */
 
@@ -762,6 +868,24 @@ cl_app::mk_options(void)
   o->init();
   o->hide();
 
+  options->new_option(o= new cl_string_option(this, "serial_unix",
+                                              "Unix socket of serial line (-S unix)"));
+  o->init();
+  o->hide();
+
+  options->new_option(o= new cl_string_option(this, "serial_pty",
+                                              "Link to pty of serial line (-S pty)"));
+  o->init();
+  o->hide();
+
+  options->new_option(o= new cl_bool_option(this, "serial_fast",
+                                            "No baud rate timing on serial line (-S fast)"));
+  o->init();
+
+  options->new_option(o= new cl_bool_option(this, "serial_flow",
+                                            "Serial receiver waits for cleared RI (-S flow)"));
+  o->init();
+
   options->new_option(o= new cl_string_option(this, "prompt",
                                               "String of prompt (-p)"));
   o->init();
@@ -780,11 +904,31 @@ cl_app::mk_options(void)
   o->init();
   o->hide();
 
+  options->new_option(o= new cl_string_option(this, "batch_file",
+                                              "Run tests listed in this file (-b)"));
+  o->init();
+  o->hide();
+
+  options->new_option(o= new cl_number_option(this, "batch_jobs",
+                                              "Number of parallel tests (-j)"));
+  o->init();
+  o->hide();
+
   options->new_option(o= new cl_float_option(this, "xtal",
                                              "Frequency of XTAL in Hz"));
   o->init();
   o->set_value(11059200.0);
 
+  options->new_option(o= new cl_bool_option(this, "idle_skip",
+                                            "Fast-forward idle loops"));
+  o->init();
+  o->set_value(bool(DD_TRUE));
+
+  options->new_option(o= new cl_number_option(this, "quantum",
+                                              "Cycles of a slice of co-simulated controllers"));
+  o->init();
+  o->set_value((long)1000);
+
   options->new_option(o= new cl_string_option(this, "cpu_type",
                                               "Type of controller (-t)"));
   o->init();
@@ -102,6 +102,7 @@ public:
   class cl_sim *get_sim(void) { return(sim); }
   class cl_uc *get_uc(void);
   class cl_commander_base *get_commander(void) { return(commander); }
+  virtual bool batch_mode(void);
   virtual class cl_cmd *get_cmd(class cl_cmdline *cmdline);
 
 public: // messages to broadcast
@@ -34,6 +34,7 @@ Software Foundation, 59 Temple Place - Suite 330, Boston, MA
 
 // prj
 #include "pobjcl.h"
+#include "utils.h"
 
 // sim
 #include "simcl.h"
@@ -308,6 +309,21 @@ cl_avr::disass(t_addr addr, const char *sep)
 }
 
 
+bool
+cl_avr::save_state(FILE *f)
+{
+  return(cl_uc::save_state(f) &&
+         SAVE_VAR(f, sleep_executed));
+}
+
+bool
+cl_avr::load_state(FILE *f)
+{
+  return(cl_uc::load_state(f) &&
+         LOAD_VAR(f, sleep_executed));
+}
+
+
 void
 cl_avr::print_regs(class cl_console_base *con)
 {
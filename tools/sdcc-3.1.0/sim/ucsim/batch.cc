@@ -0,0 +1,424 @@
+/*
+ * Simulator of microcontrollers (batch.cc)
+ */
+
+/* This file is part of microcontroller simulator: ucsim.
+
+UCSIM is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+UCSIM is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with UCSIM; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA. */
+/*@1@*/
+
+#include "ddconfig.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <ctype.h>
+#include "i_string.h"
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#endif
+
+// prj
+#include "utils.h"
+#include "globals.h"
+#include "appcl.h"
+#include "batchcl.h"
+
+// sim.src
+#include "simcl.h"
+
+// cmd.src
+#ifndef _WIN32
+#include "newcmdposixcl.h"
+#endif
+
+
+/*
+ * A test of the list
+ */
+
+cl_batch_test::cl_batch_test(const char *aname):
+  cl_base()
+{
+  set_name(aname);
+  hex_file= cmd_file= in_file= log_file= 0;
+  cycles= 0;
+  pid= -1;
+  status= 0;
+  done= DD_FALSE;
+  result= 0;
+}
+
+cl_batch_test::~cl_batch_test(void)
+{
+  if (hex_file)
+    free(hex_file);
+  if (cmd_file)
+    free(cmd_file);
+  if (in_file)
+    free(in_file);
+  if (log_file)
+    free(log_file);
+  if (result)
+    fclose(result);
+}
+
+
+/*
+ * Batch run of tests
+ */
+
+cl_batch::cl_batch(class cl_app *the_app):
+  cl_base()
+{
+  app= the_app;
+  tests= new cl_list(16, 16, "tests");
+  jobs= 1;
+  failed= 0;
+}
+
+cl_batch::~cl_batch(void)
+{
+  tests->free_all();
+  delete tests;
+}
+
+int
+cl_batch::init(void)
+{
+  class cl_optref file_option(this);
+  class cl_optref jobs_option(this);
+  char *fn;
+
+  cl_base::init();
+  set_name("batch");
+  file_option.init();
+  file_option.use("batch_file");
+  jobs_option.init();
+  jobs_option.use("batch_jobs");
+
+  jobs= jobs_option.get_value((long)0);
+#if !defined _WIN32 && defined _SC_NPROCESSORS_ONLN
+  if (jobs <= 0)
+    jobs= sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+  if (jobs <= 0)
+    jobs= 1;
+
+  fn= file_option.get_value("");
+  if (!fn ||
+      !*fn)
+    return(1);
+  return(read_list(fn));
+}
+
+/* Reads the list of tests. Every line is a test:
+
+   name [hex=file] [cmd=file] [in=file] [log=file] [cycles=n]
+
+   Empty lines and lines starting with # are skipped. */
+
+int
+cl_batch::read_list(const char *file_name)
+{
+  FILE *f;
+  char line[1024], *s, *v;
+  int ln= 0, ret= 0;
+
+  if ((f= fopen(file_name, "r")) == NULL)
+    {
+      fprintf(stderr, "Can't open `%s': %s\n", file_name, strerror(errno));
+      return(1);
+    }
+  while (fgets(line, sizeof(line), f))
+    {
+      ln++;
+      if ((s= strtok(line, " \t\r\n")) == NULL ||
+          *s == '#')
+        continue;
+      class cl_batch_test *t= new cl_batch_test(s);
+      tests->add(t);
+      while ((s= strtok(NULL, " \t\r\n")) != NULL)
+        {
+          if ((v= strchr(s, '=')) == NULL)
+            {
+              fprintf(stderr, "%s:%d: `%s' is not a key=value pair\n",
+                      file_name, ln, s);
+              ret= 1;
+              continue;
+            }
+          *v++= '\0';
+          if (strcmp(s, "hex") == 0)
+            t->hex_file= strdup(v);
+          else if (strcmp(s, "cmd") == 0)
+            t->cmd_file= strdup(v);
+          else if (strcmp(s, "in") == 0)
+            t->in_file= strdup(v);
+          else if (strcmp(s, "log") == 0)
+            t->log_file= strdup(v);
+          else if (strcmp(s, "cycles") == 0)
+            t->cycles= strtoul(v, NULL, 0);
+          else
+            {
+              fprintf(stderr, "%s:%d: unknown key `%s'\n", file_name, ln, s);
+              ret= 1;
+            }
+        }
+    }
+  fclose(f);
+  return(ret);
+}
+
+#ifndef _WIN32
+
+/* Runs workers, at most `jobs' of them at the same time, and prints the
+   reports in the order of the list */
+
+int
+cl_batch::run(void)
+{
+  int next= 0, running= 0, printed= 0, i, status;
+  pid_t pid;
+
+  fflush(stdout);
+  fflush(stderr);
+  while (printed < tests->count)
+    {
+      while (running < jobs &&
+             next < tests->count)
+        {
+          class cl_batch_test *t= (class cl_batch_test *)(tests->at(next++));
+          if (start(t))
+            running++;
+          else
+            t->done= DD_TRUE;
+        }
+      if (running)
+        {
+          if ((pid= wait(&status)) < 0)
+            {
+              if (errno == EINTR)
+                continue;
+              perror("wait");
+              return(1);
+            }
+          for (i= 0; i < tests->count; i++)
+            {
+              class cl_batch_test *t= (class cl_batch_test *)(tests->at(i));
+              if (t->pid == pid)
+                {
+                  t->status= status;
+                  t->done= DD_TRUE;
+                  running--;
+                  break;
+                }
+            }
+        }
+      while (printed < tests->count &&
+             ((class cl_batch_test *)(tests->at(printed)))->done)
+        report((class cl_batch_test *)(tests->at(printed++)));
+    }
+  return(failed?1:0);
+}
+
+bool
+cl_batch::start(class cl_batch_test *t)
+{
+  if ((t->result= tmpfile()) == NULL)
+    {
+      perror("tmpfile");
+      t->status= -1;
+      return(DD_FALSE);
+    }
+  if ((t->pid= fork()) < 0)
+    {
+      perror("fork");
+      t->status= -1;
+      return(DD_FALSE);
+    }
+  if (t->pid == 0)
+    {
+      int ret= run_test(t);
+      fflush(t->result);
+      fflush(stdout);
+      fflush(stderr);
+      _exit(ret);
+    }
+  return(DD_TRUE);
+}
+
+/* Executed by the worker process */
+
+int
+cl_batch::run_test(class cl_batch_test *t)
+{
+  class cl_sim *sim= app->get_sim();
+  class cl_uc *uc= sim->get_uc();
+  class cl_commander_base *cmd= app->get_commander();
+  FILE *fi, *fo, *si= NULL, *so;
+  unsigned long limit;
+  int c, done= 0;
+
+  if ((fi= fopen(t->cmd_file?t->cmd_file:"/dev/null", "r")) == NULL)
+    {
+      fprintf(t->result, "%s: can't open `%s': %s\n",
+              t->get_name(), t->cmd_file, strerror(errno));
+      return(2);
+    }
+  if ((fo= fopen(t->log_file?t->log_file:"/dev/null", "w")) == NULL)
+    {
+      fprintf(t->result, "%s: can't open `%s': %s\n",
+              t->get_name(), t->log_file, strerror(errno));
+      return(2);
+    }
+  if (t->in_file &&
+      (si= fopen(t->in_file, "r")) == NULL)
+    {
+      fprintf(t->result, "%s: can't open `%s': %s\n",
+              t->get_name(), t->in_file, strerror(errno));
+      return(2);
+    }
+  if ((so= tmpfile()) == NULL)
+    {
+      fprintf(t->result, "%s: can't create serial output: %s\n",
+              t->get_name(), strerror(errno));
+      return(2);
+    }
+  app->options->set_value("serial_in_file", app, (void*)si);
+  app->options->set_value("serial_out_file", app, (void*)so);
+
+  class cl_console *con= new cl_console(fi, fo, app);
+  con->flags|= CONS_NOWELCOME;
+  cmd->add_console(con);
+
+  if (t->hex_file &&
+      uc->read_hex_file(t->hex_file) < 0)
+    {
+      fprintf(t->result, "%s: can't load `%s'\n",
+              t->get_name(), t->hex_file);
+      return(2);
+    }
+
+  // Without commands the program simply runs until it stops
+  limit= t->cycles?(uc->hw_cycles + t->cycles):HW_NEVER;
+  if (!t->cmd_file)
+    sim->start(con);
+  while (!done)
+    {
+      while (sim->state & SIM_GO)
+        {
+          if (sim->run_until > limit)
+            sim->run_until= limit;
+          sim->step();
+        }
+      if (!t->cmd_file ||
+          uc->hw_cycles >= limit)
+        break;
+      done= con->proc_input(cmd->cmdset);
+    }
+  fflush(fo);
+
+  fprintf(t->result, "%s: %s (%d) at 0x%06x, %lu cycles, serial \"",
+          t->get_name(),
+          get_id_string(stop_reasons, sim->stop_reason, "unknown"),
+          sim->stop_reason, (int)uc->PC, uc->hw_cycles);
+  fflush(so);
+  rewind(so);
+  while ((c= getc(so)) != EOF)
+    switch (c)
+      {
+      case '\n': fprintf(t->result, "\\n"); break;
+      case '\r': fprintf(t->result, "\\r"); break;
+      case '\t': fprintf(t->result, "\\t"); break;
+      case '\\': fprintf(t->result, "\\\\"); break;
+      case '"': fprintf(t->result, "\\\""); break;
+      default:
+        if (isprint(c))
+          putc(c, t->result);
+        else
+          fprintf(t->result, "\\x%02x", c);
+        break;
+      }
+  fprintf(t->result, "\"\n");
+  return(0);
+}
+
+void
+cl_batch::report(class cl_batch_test *t)
+{
+  int c;
+
+  if (t->result &&
+      t->status >= 0 &&
+      WIFEXITED(t->status))
+    {
+      rewind(t->result);
+      while ((c= getc(t->result)) != EOF)
+        putchar(c);
+      if (WEXITSTATUS(t->status) != 0)
+        failed++;
+    }
+  else
+    {
+      if (t->status >= 0 &&
+          WIFSIGNALED(t->status))
+        printf("%s: worker killed by signal %d\n",
+               t->get_name(), WTERMSIG(t->status));
+      else
+        printf("%s: not run\n", t->get_name());
+      failed++;
+    }
+  fflush(stdout);
+  if (t->result)
+    {
+      fclose(t->result);
+      t->result= 0;
+    }
+}
+
+#else
+
+int
+cl_batch::run(void)
+{
+  fprintf(stderr, "Batch run is not supported on this platform\n");
+  return(1);
+}
+
+bool
+cl_batch::start(class cl_batch_test *t)
+{
+  return(DD_FALSE);
+}
+
+int
+cl_batch::run_test(class cl_batch_test *t)
+{
+  return(1);
+}
+
+void
+cl_batch::report(class cl_batch_test *t)
+{
+}
+
+#endif
+
+
+/* End of batch.cc */
@@ -0,0 +1,81 @@
+/*
+ * Simulator of microcontrollers (batchcl.h)
+ */
+
+/* This file is part of microcontroller simulator: ucsim.
+
+UCSIM is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+UCSIM is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with UCSIM; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA. */
+/*@1@*/
+
+#ifndef BATCHCL_HEADER
+#define BATCHCL_HEADER
+
+#include <stdio.h>
+
+// prj
+#include "pobjcl.h"
+
+
+/* One line of the test list */
+
+class cl_batch_test: public cl_base
+{
+public:
+  char *hex_file;       // Firmware, files of command line are used if 0
+  char *cmd_file;       // Commands to execute instead of a simple run
+  char *in_file;        // Serial input
+  char *log_file;       // Console output of the test
+  unsigned long cycles; // Machine cycles to run at most, 0 means no limit
+  int pid;              // Worker process of the test
+  int status;           // Exit status of the worker
+  bool done;
+  FILE *result;         // Report written by the worker
+
+public:
+  cl_batch_test(const char *aname);
+  virtual ~cl_batch_test(void);
+};
+
+
+/* Runs the tests of a list in worker processes. Workers are forked from
+   the initialized simulator so every test starts from the same state. */
+
+class cl_batch: public cl_base
+{
+protected:
+  class cl_app *app;
+  class cl_list *tests;
+  int jobs;     // Max number of workers running at the same time
+  int failed;   // Tests which could not be run
+
+public:
+  cl_batch(class cl_app *the_app);
+  virtual ~cl_batch(void);
+  virtual int init(void);
+
+  virtual int read_list(const char *file_name);
+  virtual int run(void);
+
+protected:
+  virtual bool start(class cl_batch_test *t);
+  virtual int run_test(class cl_batch_test *t);
+  virtual void report(class cl_batch_test *t);
+};
+
+
+#endif
+
+/* End of batchcl.h */
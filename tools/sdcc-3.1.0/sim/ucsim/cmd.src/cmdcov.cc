@@ -0,0 +1,198 @@
+/*
+ * Simulator of microcontrollers (cmd.src/cmdcov.cc)
+ */
+
+/* This file is part of microcontroller simulator: ucsim.
+
+UCSIM is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+UCSIM is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with UCSIM; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA. */
+/*@1@*/
+
+
+#include "ddconfig.h"
+
+#include <stdio.h>
+#include <errno.h>
+#include "i_string.h"
+
+// sim
+#include "simcl.h"
+#include "coveragecl.h"
+
+// local
+#include "cmdcovcl.h"
+
+
+/*
+ * Command: coverage on
+ *----------------------------------------------------------------------------
+ */
+
+COMMAND_DO_WORK_UC(cl_coverage_on_cmd)
+{
+  if (uc->coverage)
+    {
+      con->dd_printf("Coverage is already on\n");
+      return(DD_FALSE);
+    }
+  uc->coverage= new cl_coverage(uc);
+  uc->coverage->init();
+  return(DD_FALSE);
+}
+
+
+/*
+ * Command: coverage off
+ *----------------------------------------------------------------------------
+ */
+
+COMMAND_DO_WORK_UC(cl_coverage_off_cmd)
+{
+  if (uc->coverage)
+    {
+      delete uc->coverage;
+      uc->coverage= 0;
+    }
+  return(DD_FALSE);
+}
+
+
+/*
+ * Command: coverage clear
+ *----------------------------------------------------------------------------
+ */
+
+COMMAND_DO_WORK_UC(cl_coverage_clear_cmd)
+{
+  if (!uc->coverage)
+    con->dd_printf("Coverage is off\n");
+  else
+    uc->coverage->clear();
+  return(DD_FALSE);
+}
+
+
+/*
+ * Command: coverage info
+ *----------------------------------------------------------------------------
+ */
+
+COMMAND_DO_WORK_UC(cl_coverage_info_cmd)
+{
+  if (!uc->coverage)
+    con->dd_printf("Coverage is off\n");
+  else
+    uc->coverage->print_info(con);
+  return(DD_FALSE);
+}
+
+
+/*
+ * Command: coverage save
+ *----------------------------------------------------------------------------
+ */
+
+COMMAND_DO_WORK_UC(cl_coverage_save_cmd)
+{
+  char *fname= 0;
+
+  if (!uc->coverage)
+    {
+      con->dd_printf("Coverage is off\n");
+      return(DD_FALSE);
+    }
+  if ((cmdline->param(0) == 0) ||
+      ((fname= cmdline->param(0)->get_svalue()) == NULL))
+    {
+      con->dd_printf("File name is missing.\n");
+      return(DD_FALSE);
+    }
+  if (!uc->coverage->save(fname))
+    con->dd_printf("Error writing `%s': %s\n", fname, strerror(errno));
+  return(DD_FALSE);
+}
+
+
+/*
+ * Command: coverage load
+ *----------------------------------------------------------------------------
+ */
+
+COMMAND_DO_WORK_UC(cl_coverage_load_cmd)
+{
+  char *fname= 0;
+  int n;
+
+  if (!uc->coverage)
+    {
+      con->dd_printf("Coverage is off\n");
+      return(DD_FALSE);
+    }
+  if ((cmdline->param(0) == 0) ||
+      ((fname= cmdline->param(0)->get_svalue()) == NULL))
+    {
+      con->dd_printf("File name is missing.\n");
+      return(DD_FALSE);
+    }
+  if ((n= uc->coverage->load(fname)) < 0)
+    con->dd_printf("Can't open `%s': %s\n", fname, strerror(errno));
+  else
+    con->dd_printf("%d addresses merged from %s\n", n, fname);
+  return(DD_FALSE);
+}
+
+
+/*
+ * Command: coverage lcov
+ *----------------------------------------------------------------------------
+ */
+
+COMMAND_DO_WORK_UC(cl_coverage_lcov_cmd)
+{
+  class cl_cmd_arg *params[2]= { cmdline->param(0),
+                                 cmdline->param(1) };
+  char *cdb, *fname;
+  FILE *f;
+  int n;
+
+  if (!uc->coverage)
+    {
+      con->dd_printf("Coverage is off\n");
+      return(DD_FALSE);
+    }
+  if (!cmdline->syntax_match(uc, STRING STRING))
+    {
+      con->dd_printf("%s\n", short_help?short_help:"Error: wrong syntax\n");
+      return(DD_FALSE);
+    }
+  cdb= params[0]->value.string.string;
+  fname= params[1]->value.string.string;
+  if ((f= fopen(fname, "w")) == NULL)
+    {
+      con->dd_printf("Can't open `%s': %s\n", fname, strerror(errno));
+      return(DD_FALSE);
+    }
+  if ((n= uc->coverage->write_lcov(cdb, f)) < 0)
+    con->dd_printf("Can't open `%s': %s\n", cdb, strerror(errno));
+  else if (ferror(f))
+    con->dd_printf("Error writing `%s'\n", fname);
+  else
+    con->dd_printf("%d source files written into %s\n", n, fname);
+  fclose(f);
+  return(DD_FALSE);
+}
+
+
+/* End of cmd.src/cmdcov.cc */
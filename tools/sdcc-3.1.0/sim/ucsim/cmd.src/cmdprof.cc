@@ -0,0 +1,218 @@
+/*
+ * Simulator of microcontrollers (cmd.src/cmdprof.cc)
+ */
+
+/* This file is part of microcontroller simulator: ucsim.
+
+UCSIM is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+UCSIM is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with UCSIM; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA. */
+/*@1@*/
+
+#include "ddconfig.h"
+
+#include <stdio.h>
+#include <errno.h>
+#include "i_string.h"
+
+// sim
+#include "simcl.h"
+#include "profilecl.h"
+
+// local
+#include "cmdprofcl.h"
+
+
+/*
+ * Command: profile on
+ *----------------------------------------------------------------------------
+ */
+
+COMMAND_DO_WORK_UC(cl_profile_on_cmd)
+{
+  if (uc->profiler)
+    {
+      con->dd_printf("Profiling is already on\n");
+      return(DD_FALSE);
+    }
+  uc->profiler= new cl_profiler(uc);
+  uc->profiler->init();
+  return(DD_FALSE);
+}
+
+
+/*
+ * Command: profile off
+ *----------------------------------------------------------------------------
+ */
+
+COMMAND_DO_WORK_UC(cl_profile_off_cmd)
+{
+  if (uc->profiler)
+    {
+      delete uc->profiler;
+      uc->profiler= 0;
+    }
+  return(DD_FALSE);
+}
+
+
+/*
+ * Command: profile clear
+ *----------------------------------------------------------------------------
+ */
+
+COMMAND_DO_WORK_UC(cl_profile_clear_cmd)
+{
+  if (!uc->profiler)
+    con->dd_printf("Profiling is off\n");
+  else
+    uc->profiler->clear();
+  return(DD_FALSE);
+}
+
+
+/*
+ * Command: profile symbols
+ *----------------------------------------------------------------------------
+ */
+
+COMMAND_DO_WORK_UC(cl_profile_symbols_cmd)
+{
+  char *fname= 0;
+  int n;
+
+  if (!uc->profiler)
+    {
+      con->dd_printf("Profiling is off\n");
+      return(DD_FALSE);
+    }
+  if ((cmdline->param(0) == 0) ||
+      ((fname= cmdline->param(0)->get_svalue()) == NULL))
+    {
+      con->dd_printf("File name is missing.\n");
+      return(DD_FALSE);
+    }
+  if ((n= uc->profiler->read_symbols(fname)) < 0)
+    con->dd_printf("Can't open `%s': %s\n", fname, strerror(errno));
+  else
+    con->dd_printf("%d functions read from %s\n", n, fname);
+  return(DD_FALSE);
+}
+
+
+/*
+ * Command: profile functions
+ *----------------------------------------------------------------------------
+ */
+
+COMMAND_DO_WORK_UC(cl_profile_functions_cmd)
+{
+  class cl_cmd_arg *params[1]= { cmdline->param(0) };
+  int max= 0;
+
+  if (!uc->profiler)
+    {
+      con->dd_printf("Profiling is off\n");
+      return(DD_FALSE);
+    }
+  if (cmdline->syntax_match(uc, NUMBER))
+    max= params[0]->value.number;
+  else if (params[0])
+    {
+      con->dd_printf("%s\n", short_help?short_help:"Error: wrong syntax\n");
+      return(DD_FALSE);
+    }
+  uc->profiler->print_functions(con, max);
+  return(DD_FALSE);
+}
+
+
+/*
+ * Command: profile memory
+ *----------------------------------------------------------------------------
+ */
+
+COMMAND_DO_WORK_UC(cl_profile_memory_cmd)
+{
+  class cl_address_space *mem= 0;
+  t_addr start= 0, end= 0;
+  class cl_cmd_arg *params[3]= { cmdline->param(0),
+                                 cmdline->param(1),
+                                 cmdline->param(2) };
+
+  if (!uc->profiler)
+    {
+      con->dd_printf("Profiling is off\n");
+      return(DD_FALSE);
+    }
+  if (cmdline->syntax_match(uc, MEMORY)) {
+    mem= params[0]->value.memory.address_space;
+    start= mem->start_address;
+    end= mem->highest_valid_address();
+  }
+  else if (cmdline->syntax_match(uc, MEMORY ADDRESS)) {
+    mem= params[0]->value.memory.address_space;
+    start= params[1]->value.address;
+    end= mem->highest_valid_address();
+  }
+  else if (cmdline->syntax_match(uc, MEMORY ADDRESS ADDRESS)) {
+    mem= params[0]->value.memory.address_space;
+    start= params[1]->value.address;
+    end= params[2]->value.address;
+  }
+  if (!mem)
+    {
+      con->dd_printf("%s\n", short_help?short_help:"Error: wrong syntax\n");
+      return(DD_FALSE);
+    }
+  uc->profiler->print_memory(con, mem, start, end);
+  return(DD_FALSE);
+}
+
+
+/*
+ * Command: profile callgrind
+ *----------------------------------------------------------------------------
+ */
+
+COMMAND_DO_WORK_UC(cl_profile_callgrind_cmd)
+{
+  char *fname= 0;
+  FILE *f;
+
+  if (!uc->profiler)
+    {
+      con->dd_printf("Profiling is off\n");
+      return(DD_FALSE);
+    }
+  if ((cmdline->param(0) == 0) ||
+      ((fname= cmdline->param(0)->get_svalue()) == NULL))
+    {
+      con->dd_printf("File name is missing.\n");
+      return(DD_FALSE);
+    }
+  if ((f= fopen(fname, "w")) == NULL)
+    {
+      con->dd_printf("Can't open `%s': %s\n", fname, strerror(errno));
+      return(DD_FALSE);
+    }
+  if (!uc->profiler->write_callgrind(f))
+    con->dd_printf("Error writing `%s'\n", fname);
+  fclose(f);
+  return(DD_FALSE);
+}
+
+
+/* End of cmd.src/cmdprof.cc */
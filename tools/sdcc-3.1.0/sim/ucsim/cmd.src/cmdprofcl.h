@@ -0,0 +1,41 @@
+/*
+ * Simulator of microcontrollers (cmd.src/cmdprofcl.h)
+ */
+
+/* This file is part of microcontroller simulator: ucsim.
+
+UCSIM is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+UCSIM is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with UCSIM; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA. */
+/*@1@*/
+
+#ifndef CMD_CMDPROFCL_HEADER
+#define CMD_CMDPROFCL_HEADER
+
+#include "newcmdcl.h"
+
+
+// PROFILE
+COMMAND_ON(uc,cl_profile_on_cmd);
+COMMAND_ON(uc,cl_profile_off_cmd);
+COMMAND_ON(uc,cl_profile_clear_cmd);
+COMMAND_ON(uc,cl_profile_symbols_cmd);
+COMMAND_ON(uc,cl_profile_functions_cmd);
+COMMAND_ON(uc,cl_profile_memory_cmd);
+COMMAND_ON(uc,cl_profile_callgrind_cmd);
+
+
+#endif
+
+/* End of cmd.src/cmdprofcl.h */
@@ -104,6 +104,35 @@ COMMAND_DO_WORK_SIM(cl_run_cmd)
 }
 
 
+/*
+ * Command: runfor
+ *----------------------------------------------------------------------------
+ */
+
+//int
+//cl_run_for_cmd::do_work(class cl_sim *sim,
+//                      class cl_cmdline *cmdline, class cl_console_base *con)
+COMMAND_DO_WORK_SIM(cl_run_for_cmd)
+{
+  class cl_cmd_arg *params[1]= { cmdline->param(0) };
+  long cycles;
+
+  if (!params[0] ||
+      !params[0]->get_ivalue(&cycles) ||
+      cycles <= 0)
+    {
+      con->dd_printf("Error: number of cycles expected\n");
+      return(DD_FALSE);
+    }
+  con->dd_printf("Simulation started, PC=0x%06x\n", sim->uc->PC);
+  if (sim->uc->fbrk_at(sim->uc->PC))
+    sim->uc->do_inst(1);
+
+  sim->start_for(con, cycles);
+  return(DD_FALSE);
+}
+
+
 /*
  * Command: stop
  *----------------------------------------------------------------------------
@@ -133,6 +162,7 @@ COMMAND_DO_WORK_UC(cl_step_cmd)
   //printf("step %x\n",uc->PC);
   uc->do_inst(1);
   //printf("step done %x\n",uc->PC);
+  uc->sync_hw();
   uc->print_regs(con);
   return(0);
 }
@@ -191,12 +221,123 @@ COMMAND_DO_WORK_SIM(cl_next_cmd)
     }
   else {
     sim->uc->do_inst(1);
+    sim->uc->sync_hw();
     sim->uc->print_regs(con);
   }
   return(DD_FALSE);
 }
 
 
+/*
+ * Command: core list
+ *----------------------------------------------------------------------------
+ */
+
+COMMAND_DO_WORK_SIM(cl_core_list_cmd)
+{
+  int i;
+
+  for (i= 0; i < sim->cores->count; i++)
+    {
+      class cl_uc *c= (class cl_uc *)(sim->cores->at(i));
+      con->dd_printf("%c%2d %s PC=0x%06x %lu cycles\n",
+                     (c == sim->uc)?'*':' ', i, c->id_string(),
+                     c->PC, c->hw_cycles);
+    }
+  if (sim->cores->count > 1)
+    con->dd_printf("%lu slices of %ld cycles done\n",
+                   sim->quanta, sim->quantum);
+  return(DD_FALSE);
+}
+
+
+/*
+ * Command: core add
+ *----------------------------------------------------------------------------
+ */
+
+COMMAND_DO_WORK_SIM(cl_core_add_cmd)
+{
+  class cl_cmd_arg *params[1]= { cmdline->param(0) };
+  char *type= 0;
+  class cl_uc *c;
+
+  if (params[0] &&
+      (type= params[0]->get_svalue()) == NULL)
+    {
+      con->dd_printf("Error: type of controller expected\n");
+      return(DD_FALSE);
+    }
+  if ((c= sim->add_core(type)) == NULL)
+    con->dd_printf("Can not make controller of type %s\n", type);
+  else
+    con->dd_printf("Controller %d is %s\n", c->core_id, c->id_string());
+  return(DD_FALSE);
+}
+
+
+/*
+ * Command: core select
+ *----------------------------------------------------------------------------
+ */
+
+COMMAND_DO_WORK_SIM(cl_core_select_cmd)
+{
+  class cl_cmd_arg *params[1]= { cmdline->param(0) };
+  long nr;
+
+  if (!params[0] ||
+      !params[0]->get_ivalue(&nr) ||
+      nr < 0 ||
+      nr >= sim->cores->count)
+    {
+      con->dd_printf("Error: number of a controller expected\n");
+      return(DD_FALSE);
+    }
+  sim->uc= (class cl_uc *)(sim->cores->at(nr));
+  sim->uc->sync_hw();
+  return(DD_FALSE);
+}
+
+
+/*
+ * Command: core link
+ *----------------------------------------------------------------------------
+ */
+
+COMMAND_DO_WORK_SIM(cl_core_link_cmd)
+{
+  class cl_cmd_arg *params[2]= { cmdline->param(0),
+                                 cmdline->param(1) };
+  long nr[2];
+  class cl_hw *hw[2];
+  int i;
+
+  for (i= 0; i < 2; i++)
+    {
+      if (!params[i] ||
+          !params[i]->get_ivalue(&nr[i]) ||
+          nr[i] < 0 ||
+          nr[i] >= sim->cores->count)
+        {
+          con->dd_printf("Error: numbers of two controllers expected\n");
+          return(DD_FALSE);
+        }
+      hw[i]= ((class cl_uc *)(sim->cores->at(nr[i])))->get_hw(HW_UART, 0, 0);
+      if (!hw[i])
+        {
+          con->dd_printf("Controller %ld has no uart\n", nr[i]);
+          return(DD_FALSE);
+        }
+    }
+  if (nr[0] == nr[1] ||
+      !hw[0]->connect(hw[1]))
+    con->dd_printf("Uarts of controllers %ld and %ld can not be linked\n",
+                   nr[0], nr[1]);
+  return(DD_FALSE);
+}
+
+
 /*
  * Command: help
  *----------------------------------------------------------------------------
@@ -35,10 +35,17 @@ Software Foundation, 59 Temple Place - Suite 330, Boston, MA
 
 // STATE
 COMMAND_ON(sim,cl_run_cmd);
+COMMAND_ON(sim,cl_run_for_cmd);
 COMMAND_ON(sim,cl_stop_cmd);
 COMMAND_ON(uc,cl_step_cmd);
 COMMAND_ON(sim,cl_next_cmd);
 
+// CO-SIMULATION
+COMMAND_ON(sim,cl_core_list_cmd);
+COMMAND_ON(sim,cl_core_add_cmd);
+COMMAND_ON(sim,cl_core_select_cmd);
+COMMAND_ON(sim,cl_core_link_cmd);
+
 //COMMAND_ON(app,cl_help_cmd);
 COMMAND_HEAD(cl_help_cmd)
 COMMAND_METHODS_ON(app,cl_help_cmd)
@@ -0,0 +1,206 @@
+/*
+ * Simulator of microcontrollers (cmd.src/cmdtrace.cc)
+ */
+
+/* This file is part of microcontroller simulator: ucsim.
+
+UCSIM is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+UCSIM is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with UCSIM; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA. */
+/*@1@*/
+
+#include "ddconfig.h"
+
+#include <stdio.h>
+#include <errno.h>
+#include "i_string.h"
+
+// sim
+#include "simcl.h"
+#include "tracecl.h"
+
+// local
+#include "cmdtracecl.h"
+
+
+/*
+ * Command: trace on
+ *----------------------------------------------------------------------------
+ */
+
+COMMAND_DO_WORK_UC(cl_trace_on_cmd)
+{
+  class cl_cmd_arg *params[1]= { cmdline->param(0) };
+  long size= 16*1024;
+
+  if (uc->tracer)
+    {
+      con->dd_printf("Tracing is already on\n");
+      return(DD_FALSE);
+    }
+  if (cmdline->syntax_match(uc, NUMBER))
+    size= params[0]->value.number;
+  else if (params[0])
+    {
+      con->dd_printf("%s\n", short_help?short_help:"Error: wrong syntax\n");
+      return(DD_FALSE);
+    }
+  if (size <= 0)
+    {
+      con->dd_printf("Error: size must be greater than zero\n");
+      return(DD_FALSE);
+    }
+  uc->tracer= new cl_tracer(uc, (unsigned long)size*1024);
+  uc->tracer->init();
+  return(DD_FALSE);
+}
+
+
+/*
+ * Command: trace off
+ *----------------------------------------------------------------------------
+ */
+
+COMMAND_DO_WORK_UC(cl_trace_off_cmd)
+{
+  if (uc->tracer)
+    {
+      delete uc->tracer;
+      uc->tracer= 0;
+    }
+  return(DD_FALSE);
+}
+
+
+/*
+ * Command: trace file
+ *----------------------------------------------------------------------------
+ */
+
+COMMAND_DO_WORK_UC(cl_trace_file_cmd)
+{
+  char *fname= 0;
+
+  if (!uc->tracer)
+    {
+      con->dd_printf("Tracing is off\n");
+      return(DD_FALSE);
+    }
+  if ((cmdline->param(0) == 0) ||
+      ((fname= cmdline->param(0)->get_svalue()) == NULL))
+    {
+      uc->tracer->stop_file();
+      return(DD_FALSE);
+    }
+  if (!uc->tracer->start_file(fname))
+    con->dd_printf("Can't open `%s': %s\n", fname, strerror(errno));
+  return(DD_FALSE);
+}
+
+
+/*
+ * Command: trace save
+ *----------------------------------------------------------------------------
+ */
+
+COMMAND_DO_WORK_UC(cl_trace_save_cmd)
+{
+  char *fname= 0;
+
+  if (!uc->tracer)
+    {
+      con->dd_printf("Tracing is off\n");
+      return(DD_FALSE);
+    }
+  if ((cmdline->param(0) == 0) ||
+      ((fname= cmdline->param(0)->get_svalue()) == NULL))
+    {
+      con->dd_printf("File name is missing.\n");
+      return(DD_FALSE);
+    }
+  if (!uc->tracer->save(fname))
+    con->dd_printf("Error writing `%s': %s\n", fname, strerror(errno));
+  return(DD_FALSE);
+}
+
+
+/*
+ * Command: trace info
+ *----------------------------------------------------------------------------
+ */
+
+COMMAND_DO_WORK_UC(cl_trace_info_cmd)
+{
+  if (!uc->tracer)
+    con->dd_printf("Tracing is off\n");
+  else
+    uc->tracer->print_info(con);
+  return(DD_FALSE);
+}
+
+
+/*
+ * Command: trace print
+ *----------------------------------------------------------------------------
+ * Decodes the ring or a trace file, using the program loaded into ROM
+ */
+
+COMMAND_DO_WORK_UC(cl_trace_print_cmd)
+{
+  class cl_cmd_arg *params[2]= { cmdline->param(0),
+                                 cmdline->param(1) };
+  char *fname= 0;
+  long max= 20;
+  FILE *f;
+
+  if (cmdline->syntax_match(uc, NUMBER))
+    max= params[0]->value.number;
+  else if (cmdline->syntax_match(uc, STRING))
+    {
+      fname= params[0]->value.string.string;
+      max= 0;
+    }
+  else if (cmdline->syntax_match(uc, STRING NUMBER))
+    {
+      fname= params[0]->value.string.string;
+      max= params[1]->value.number;
+    }
+  else if (params[0])
+    {
+      con->dd_printf("%s\n", short_help?short_help:"Error: wrong syntax\n");
+      return(DD_FALSE);
+    }
+
+  if (!fname)
+    {
+      if (!uc->tracer)
+        con->dd_printf("Tracing is off\n");
+      else
+        uc->tracer->print(con, max);
+      return(DD_FALSE);
+    }
+  if ((f= fopen(fname, "rb")) == NULL)
+    {
+      con->dd_printf("Can't open `%s': %s\n", fname, strerror(errno));
+      return(DD_FALSE);
+    }
+  class cl_trace_decoder dec(uc, con);
+  if (dec.print_file(f, max) < 0)
+    con->dd_printf("`%s' is not a trace file\n", fname);
+  fclose(f);
+  return(DD_FALSE);
+}
+
+
+/* End of cmd.src/cmdtrace.cc */
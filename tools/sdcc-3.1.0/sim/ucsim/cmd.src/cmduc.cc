@@ -64,6 +64,9 @@ COMMAND_DO_WORK_UC(cl_state_cmd)
                  (uc->ticks->ticks == 0)?0.0:
                  (100.0*((double)(uc->idle_ticks->ticks)/
                          (double)(uc->ticks->ticks))));
+  if (uc->idle_skipped)
+    con->dd_printf("Skipped in idle loops= %g sec (%lu clks)\n",
+                   uc->idle_skipped / uc->xtal, uc->idle_skipped);
   con->dd_printf("Max value of stack pointer= 0x%06x, avg= 0x%06x\n",
                  uc->sp_max, uc->sp_avg);
   return(0);
@@ -115,6 +118,56 @@ COMMAND_DO_WORK_UC(cl_dl_cmd)
 }
 
 
+/*
+ * Command: snapshot
+ *----------------------------------------------------------------------------
+ */
+
+//int
+//cl_snapshot_cmd::do_work(class cl_sim *sim,
+//                       class cl_cmdline *cmdline, class cl_console_base *con)
+COMMAND_DO_WORK_UC(cl_snapshot_cmd)
+{
+  char *fname= 0;
+
+  if ((cmdline->param(0) == 0) ||
+      ((fname= cmdline->param(0)->get_svalue()) == NULL))
+    {
+      con->dd_printf("File name is missing.\n");
+      return(0);
+    }
+  if (uc->save_snapshot(fname))
+    con->dd_printf("State saved to %s\n", fname);
+
+  return(0);
+}
+
+
+/*
+ * Command: restore
+ *----------------------------------------------------------------------------
+ */
+
+//int
+//cl_restore_cmd::do_work(class cl_sim *sim,
+//                      class cl_cmdline *cmdline, class cl_console_base *con)
+COMMAND_DO_WORK_UC(cl_restore_cmd)
+{
+  char *fname= 0;
+
+  if ((cmdline->param(0) == 0) ||
+      ((fname= cmdline->param(0)->get_svalue()) == NULL))
+    {
+      con->dd_printf("File name is missing.\n");
+      return(0);
+    }
+  if (uc->load_snapshot(fname))
+    con->dd_printf("State restored from %s, PC=0x%06x\n", fname, uc->PC);
+
+  return(0);
+}
+
+
 /*
  * Command: pc
  *----------------------------------------------------------------------------
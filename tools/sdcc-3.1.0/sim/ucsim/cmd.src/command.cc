@@ -598,6 +598,9 @@ cl_cmd::work(class cl_app *app,
   class cl_uc *uc= 0;
   if (sim)
     uc= sim->uc;
+  // lazily ticked hw elements are shown up to date
+  if (uc)
+    uc->sync_hw();
   switch (operate_on)
     {
     case operate_on_app:
@@ -303,52 +303,7 @@ cl_console_base::proc_input(class cl_cmdset *cmdset)
       if (cmdstr && *cmdstr == '\004')
         retval = 1;
       else
-        {
-          class cl_cmdline *cmdline= 0;
-          class cl_cmd *cm = 0;
-          if (flags & CONS_ECHO)
-            dd_printf("%s\n", cmdstr);
-          cmdline= new cl_cmdline(app, cmdstr, this);
-          cmdline->init();
-          if (cmdline->repeat() &&
-              accept_last() &&
-              last_command)
-            {
-              cm = last_command;
-              delete cmdline;
-              cmdline = last_cmdline;
-            }
-          else
-            {
-              cm= cmdset->get_cmd(cmdline, accept_last());
-              if (last_cmdline)
-                {
-                  delete last_cmdline;
-                  last_cmdline = 0;
-                }
-              last_command = 0;
-            }
-          if (cm)
-            {
-              retval= cm->work(app, cmdline, this);
-              if (cm->can_repeat)
-                {
-                  last_command = cm;
-                  last_cmdline = cmdline;
-                }
-              else
-                delete cmdline;
-            }
-          else
-            {
-              uc_yy_set_string_to_parse(cmdstr);
-              yyparse();
-              uc_yy_free_string_to_parse();
-              delete cmdline;
-            }
-          /*if (!cm)
-            retval= interpret(cmdstr);*/
-        }
+        retval= exec_cmd(cmdset, cmdstr);
     }
   //retval= sim->do_cmd(cmd, this);
   un_redirect();
@@ -359,6 +314,61 @@ cl_console_base::proc_input(class cl_cmdset *cmdset)
 }
 
 
+/* Executes one command line */
+
+int
+cl_console_base::exec_cmd(class cl_cmdset *cmdset, char *cmdstr)
+{
+  int retval= 0;
+  class cl_cmdline *cmdline= 0;
+  class cl_cmd *cm = 0;
+
+  if (flags & CONS_ECHO)
+    dd_printf("%s\n", cmdstr);
+  cmdline= new cl_cmdline(app, cmdstr, this);
+  cmdline->init();
+  if (cmdline->repeat() &&
+      accept_last() &&
+      last_command)
+    {
+      cm = last_command;
+      delete cmdline;
+      cmdline = last_cmdline;
+    }
+  else
+    {
+      cm= cmdset->get_cmd(cmdline, accept_last());
+      if (last_cmdline)
+        {
+          delete last_cmdline;
+          last_cmdline = 0;
+        }
+      last_command = 0;
+    }
+  if (cm)
+    {
+      retval= cm->work(app, cmdline, this);
+      if (cm->can_repeat)
+        {
+          last_command = cm;
+          last_cmdline = cmdline;
+        }
+      else
+        delete cmdline;
+    }
+  else
+    {
+      uc_yy_set_string_to_parse(cmdstr);
+      yyparse();
+      uc_yy_free_string_to_parse();
+      delete cmdline;
+    }
+  /*if (!cm)
+    retval= interpret(cmdstr);*/
+  return(retval);
+}
+
+
 /*
  * Command interpreter
  *____________________________________________________________________________
@@ -0,0 +1,532 @@
+/*
+ * Simulator of microcontrollers (cmd.src/newcmdbin.cc)
+ */
+
+/* This file is part of microcontroller simulator: ucsim.
+
+UCSIM is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+UCSIM is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with UCSIM; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA. */
+/*@1@*/
+
+#include "ddconfig.h"
+
+#include <stdio.h>
+#include <errno.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <sys/types.h>
+#ifdef SOCKET_AVAIL
+# include HEADER_SOCKET
+#endif
+#ifdef HAVE_UNISTD_H
+# include <unistd.h>
+#endif
+#include "i_string.h"
+
+// prj
+#include "globals.h"
+#include "utils.h"
+
+// sim
+#include "simcl.h"
+#include "appcl.h"
+
+// local
+#include "newcmdbincl.h"
+
+
+#ifdef SOCKET_AVAIL
+
+/*
+ * Console of binary protocol
+ *____________________________________________________________________________
+ */
+
+cl_bin_console::cl_bin_console(UCSOCKET_T afd, class cl_app *the_app):
+  cl_console()
+{
+  app= the_app;
+  fd= afd;
+  prompt= 0;
+  flags= CONS_INTERACTIVE;
+  id= 0;
+  lines_printed= new cl_ustrings(100, 100, "console_cache");
+  isize= osize= tsize= 4096;
+  ibuf= (unsigned char *)malloc(isize);
+  obuf= (unsigned char *)malloc(osize);
+  text= (char *)malloc(tsize);
+  ilen= olen= tlen= 0;
+  busy= stop_pending= DD_FALSE;
+  stop_reason= resGO;
+  run_tag= 0;
+}
+
+cl_bin_console::~cl_bin_console(void)
+{
+  class cl_commander_base *cmd= app->get_commander();
+
+  if (cmd->frozen_console == this)
+    cmd->frozen_console= 0;
+  if (fd >= 0)
+    {
+      shutdown(fd, 2);
+      close(fd);
+    }
+  free(ibuf);
+  free(obuf);
+  free(text);
+}
+
+int
+cl_bin_console::init(void)
+{
+  cl_console::init();
+  // Prompt is never printed, it would go into the output of commands
+  flags|= CONS_PROMPT;
+  return(0);
+}
+
+int
+cl_bin_console::running(void)
+{
+  return(app->get_sim()->state & SIM_GO);
+}
+
+
+/*
+ * Output of commands is collected and sent in answers
+ */
+
+int
+cl_bin_console::cmd_do_print(const char *format, va_list ap)
+{
+  char *s;
+  int len;
+
+  if (rout)
+    {
+      len= vfprintf(rout, format, ap);
+      fflush(rout);
+      return(len);
+    }
+#ifdef HAVE_VASPRINTF
+  if (vasprintf(&s, format, ap) < 0)
+    return(0);
+#else
+  s= (char *)malloc(80*25);
+# ifdef HAVE_VSNPRINTF
+  vsnprintf(s, 80*25, format, ap);
+# else
+  _vsnprintf(s, 80*25, format, ap);
+# endif
+#endif
+  len= strlen(s);
+  if (tlen + len > tsize)
+    {
+      while (tlen + len > tsize)
+        tsize*= 2;
+      text= (char *)realloc(text, tsize);
+    }
+  memcpy(text + tlen, s, len);
+  tlen+= len;
+  free(s);
+  return(len);
+}
+
+void
+cl_bin_console::put(const void *data, int len)
+{
+  if (olen + len > osize)
+    {
+      while (olen + len > osize)
+        osize*= 2;
+      obuf= (unsigned char *)realloc(obuf, osize);
+    }
+  memcpy(obuf + olen, data, len);
+  olen+= len;
+}
+
+void
+cl_bin_console::put_u16(int v)
+{
+  put_u8(v);
+  put_u8(v >> 8);
+}
+
+void
+cl_bin_console::put_u32(t_addr v)
+{
+  put_u16(v & 0xffff);
+  put_u16((v >> 16) & 0xffff);
+}
+
+int
+cl_bin_console::begin_frame(int type, int tag)
+{
+  int start= olen;
+
+  put_u8(type);
+  put_u8(tag);
+  put_u16(0);
+  return(start);
+}
+
+void
+cl_bin_console::end_frame(int start)
+{
+  int len= olen - start - BIN_HEADER;
+
+  obuf[start+2]= len & 0xff;
+  obuf[start+3]= (len >> 8) & 0xff;
+}
+
+/* Collected text goes into the frame started at `start', as much as
+   fits in, the rest remains for the next one */
+
+void
+cl_bin_console::put_text(int start)
+{
+  int room= BIN_MAX_PAYLOAD - (olen - start - BIN_HEADER);
+  int len= tlen;
+
+  if (len > room)
+    len= room;
+  put(text, len);
+  memmove(text, text + len, tlen - len);
+  tlen-= len;
+}
+
+void
+cl_bin_console::flush(void)
+{
+  int i= 0, n;
+
+  while (i < olen &&
+         fd >= 0)
+    {
+#ifdef MSG_NOSIGNAL
+      n= send(fd, obuf + i, olen - i, MSG_NOSIGNAL);
+#else
+      n= write(fd, obuf + i, olen - i);
+#endif
+      if (n < 0)
+        {
+          if (errno == EINTR)
+            continue;
+          // Connection is lost, it will be noticed by the next read
+          break;
+        }
+      i+= n;
+    }
+  olen= 0;
+}
+
+
+/*
+ * Processing of requests
+ */
+
+int
+cl_bin_console::proc_input(class cl_cmdset *cmdset)
+{
+  int n, i, len, retval= 0;
+
+  if (isize - ilen < 4096)
+    {
+      isize*= 2;
+      ibuf= (unsigned char *)realloc(ibuf, isize);
+    }
+  n= read(fd, ibuf + ilen, isize - ilen);
+  if (n == 0)
+    return(1);
+  if (n < 0)
+    return((errno == EINTR || errno == EAGAIN) ? 0 : 1);
+  ilen+= n;
+
+  // All complete frames are processed, answers are sent together
+  i= 0;
+  busy= DD_TRUE;
+  while (!retval &&
+         ilen - i >= BIN_HEADER &&
+         ilen - i >= BIN_HEADER + (len= ibuf[i+2] | (ibuf[i+3] << 8)))
+    {
+      retval= proc_frame(cmdset, ibuf[i], ibuf[i+1],
+                         ibuf + i + BIN_HEADER, len);
+      i+= BIN_HEADER + len;
+      if (stop_pending)
+        send_stop();
+    }
+  busy= DD_FALSE;
+  memmove(ibuf, ibuf + i, ilen - i);
+  ilen-= i;
+  flush();
+  return(retval);
+}
+
+int
+cl_bin_console::proc_frame(class cl_cmdset *cmdset, int type, int tag,
+                           unsigned char *data, int len)
+{
+  int f;
+
+  app->get_sim()->uc->sync_hw();
+  switch (type)
+    {
+    case BIN_HELLO:
+      f= begin_frame(BIN_REPLY|BIN_HELLO, tag);
+      put_u8(BIN_VERSION);
+      put_text(f);
+      end_frame(f);
+      break;
+    case BIN_CMD:
+      return(do_cmd(cmdset, tag, data, len));
+    case BIN_READ:
+      do_read(tag, data, len);
+      break;
+    case BIN_WRITE:
+      do_write(tag, data, len);
+      break;
+    case BIN_PC:
+      do_pc(tag, data, len);
+      break;
+    case BIN_STOP:
+      do_stop(tag);
+      break;
+    default:
+      f= begin_frame(BIN_REPLY|BIN_ERROR, tag);
+      dd_printf("Unknown request 0x%02x\n", type);
+      put_text(f);
+      end_frame(f);
+      break;
+    }
+  return(0);
+}
+
+/* Text command, executed as it was typed in */
+
+int
+cl_bin_console::do_cmd(class cl_cmdset *cmdset, int tag,
+                       unsigned char *data, int len)
+{
+  char *cmdstr;
+  int f, retval= 0;
+
+  if (running())
+    {
+      f= begin_frame(BIN_REPLY|BIN_ERROR, tag);
+      dd_printf("Simulation is running\n");
+      put_text(f);
+      end_frame(f);
+      return(0);
+    }
+  cmdstr= (char *)malloc(len + 1);
+  memcpy(cmdstr, data, len);
+  cmdstr[len]= '\0';
+  while (len > 0 &&
+         (cmdstr[len-1] == '\n' || cmdstr[len-1] == '\r'))
+    cmdstr[--len]= '\0';
+  retval= exec_cmd(cmdset, cmdstr);
+  un_redirect();
+  free(cmdstr);
+  if (running())
+    run_tag= tag;
+
+  f= begin_frame(BIN_REPLY|BIN_CMD, tag);
+  put_u8(running() ? BIN_RUNNING : 0);
+  put_u32(app->get_sim()->uc->PC);
+  put_text(f);
+  end_frame(f);
+  return(retval);
+}
+
+/* Ranges of a request: u8 name length, name, u32 address, u16 count */
+
+static int
+get_range(class cl_uc *uc, unsigned char *data, int len, int *pos,
+          class cl_address_space **mem, t_addr *addr, int *count)
+{
+  char name[64];
+  int i= *pos, n;
+
+  if (i >= len ||
+      (n= data[i]) >= (int)sizeof(name) ||
+      i + 1 + n + 6 > len)
+    return(-1);
+  memcpy(name, data + i + 1, n);
+  name[n]= '\0';
+  i+= 1 + n;
+  *addr= data[i] | (data[i+1] << 8) | (data[i+2] << 16) |
+    ((t_addr)data[i+3] << 24);
+  *count= data[i+4] | (data[i+5] << 8);
+  *pos= i + 6;
+  *mem= uc->address_space(name);
+  if (!*mem)
+    return(BIN_NO_MEM);
+  if (*count &&
+      (!(*mem)->valid_address(*addr) ||
+       !(*mem)->valid_address(*addr + *count - 1)))
+    return(BIN_BAD_ADDR);
+  return(BIN_OK);
+}
+
+void
+cl_bin_console::do_read(int tag, unsigned char *data, int len)
+{
+  class cl_uc *uc= app->get_sim()->uc;
+  class cl_address_space *mem;
+  t_addr addr;
+  int pos= 0, count, status, width, i, j, f;
+  t_mem v;
+
+  f= begin_frame(BIN_REPLY|BIN_READ, tag);
+  while (pos < len)
+    {
+      if ((status= get_range(uc, data, len, &pos, &mem, &addr, &count)) < 0)
+        {
+          olen= f;
+          f= begin_frame(BIN_REPLY|BIN_ERROR, tag);
+          dd_printf("Bad range in read request\n");
+          put_text(f);
+          break;
+        }
+      width= (status == BIN_OK) ? (mem->width + 7) / 8 : 0;
+      if (status == BIN_OK &&
+          olen - f + 2 + count * width > BIN_HEADER + BIN_MAX_PAYLOAD)
+        status= BIN_TOO_LONG;
+      put_u8(status);
+      if (status != BIN_OK)
+        {
+          put_u8(0);
+          continue;
+        }
+      put_u8(width);
+      for (i= 0; i < count; i++)
+        {
+          v= mem->get(addr + i);
+          for (j= 0; j < width; j++, v>>= 8)
+            put_u8(v & 0xff);
+        }
+    }
+  end_frame(f);
+}
+
+/* Ranges are followed by count cells, width of cells is the same as in
+   the answer of read */
+
+void
+cl_bin_console::do_write(int tag, unsigned char *data, int len)
+{
+  class cl_uc *uc= app->get_sim()->uc;
+  class cl_address_space *mem;
+  t_addr addr;
+  int pos= 0, count, status, width, i, j, f;
+  t_mem v;
+
+  f= begin_frame(BIN_REPLY|BIN_WRITE, tag);
+  while (pos < len)
+    {
+      status= get_range(uc, data, len, &pos, &mem, &addr, &count);
+      width= (status == BIN_OK) ? (mem->width + 7) / 8 : 1;
+      if (status < 0 ||
+          pos + count * width > len)
+        {
+          olen= f;
+          f= begin_frame(BIN_REPLY|BIN_ERROR, tag);
+          dd_printf("Bad range in write request\n");
+          put_text(f);
+          break;
+        }
+      if (status == BIN_OK)
+        for (i= 0; i < count; i++)
+          {
+            v= 0;
+            for (j= width-1; j >= 0; j--)
+              v= (v << 8) | data[pos + i*width + j];
+            mem->write(addr + i, v);
+          }
+      pos+= count * width;
+      put_u8(status);
+    }
+  end_frame(f);
+}
+
+void
+cl_bin_console::do_pc(int tag, unsigned char *data, int len)
+{
+  class cl_uc *uc= app->get_sim()->uc;
+  int f;
+
+  if (len >= 4)
+    uc->PC= data[0] | (data[1] << 8) | (data[2] << 16) |
+      ((t_addr)data[3] << 24);
+  f= begin_frame(BIN_REPLY|BIN_PC, tag);
+  put_u32(uc->PC);
+  end_frame(f);
+}
+
+void
+cl_bin_console::do_stop(int tag)
+{
+  int f;
+
+  if (running())
+    app->get_sim()->stop(resUSER);
+  f= begin_frame(BIN_REPLY|BIN_STOP, tag);
+  put_u8(running() ? BIN_RUNNING : 0);
+  end_frame(f);
+}
+
+
+/*
+ * Notification about stop of the simulation
+ */
+
+void
+cl_bin_console::stopped(int reason)
+{
+  class cl_commander_base *cmd= app->get_commander();
+
+  // Event breakpoints leave the console frozen, it is released here
+  flags&= ~CONS_FROZEN;
+  if (cmd->frozen_console == this)
+    cmd->frozen_console= 0;
+  stop_reason= reason;
+  if (busy)
+    stop_pending= DD_TRUE;
+  else
+    {
+      send_stop();
+      flush();
+    }
+}
+
+void
+cl_bin_console::send_stop(void)
+{
+  int f;
+
+  f= begin_frame(BIN_EV_STOP, 0);
+  put_u8(stop_reason);
+  put_u8(run_tag);
+  put_u32(app->get_sim()->uc->PC);
+  put_text(f);
+  end_frame(f);
+  stop_pending= DD_FALSE;
+}
+
+#endif /* SOCKET_AVAIL */
+
+
+/* End of cmd.src/newcmdbin.cc */
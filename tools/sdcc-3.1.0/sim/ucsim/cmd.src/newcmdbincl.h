@@ -0,0 +1,123 @@
+/*
+ * Simulator of microcontrollers (cmd.src/newcmdbincl.h)
+ */
+
+/* This file is part of microcontroller simulator: ucsim.
+
+UCSIM is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+UCSIM is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with UCSIM; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA. */
+/*@1@*/
+
+#ifndef CMD_NEWCMDBINCL_HEADER
+#define CMD_NEWCMDBINCL_HEADER
+
+#include "newcmdposixcl.h"
+
+
+/* Binary debugger protocol. Every frame is
+
+     u8 type, u8 tag, u16 length, length bytes of payload
+
+   multi-byte numbers are little endian. Answer of a request has type
+   BIN_REPLY|request and the tag of the request, so requests can be sent
+   without waiting for the answers of the previous ones. */
+
+#define BIN_VERSION     1
+#define BIN_HEADER      4
+#define BIN_MAX_PAYLOAD 0xffff
+
+#define BIN_HELLO       0x01    // -> u8 version, text
+#define BIN_CMD         0x02    // text -> u8 flags, u32 PC, output
+#define BIN_READ        0x03    // ranges -> per range u8 status, u8 width, data
+#define BIN_WRITE       0x04    // ranges with data -> per range u8 status
+#define BIN_PC          0x05    // [u32 new PC] -> u32 PC
+#define BIN_STOP        0x06    // -> u8 flags
+#define BIN_EV_STOP     0x40    // event: u8 reason, u8 tag, u32 PC, text
+#define BIN_ERROR       0x7f    // answer to a bad request: text
+#define BIN_REPLY       0x80
+
+// Flags of answers
+#define BIN_RUNNING     0x01    // Simulation is going
+
+// Status of memory ranges
+#define BIN_OK          0
+#define BIN_NO_MEM      1       // Unknown address space
+#define BIN_BAD_ADDR    2       // Range is out of the address space
+#define BIN_TOO_LONG    3       // Answer would not fit in a frame
+
+
+/*
+ * Console of a debugger speaking the binary protocol
+ */
+
+#ifdef SOCKET_AVAIL
+
+class cl_bin_console: public cl_console
+{
+protected:
+  UCSOCKET_T fd;
+  unsigned char *ibuf;          // Received bytes, not processed yet
+  int ilen, isize;
+  unsigned char *obuf;          // Frames to send
+  int olen, osize;
+  char *text;                   // Output of commands
+  int tlen, tsize;
+  bool busy;                    // A request is being processed
+  bool stop_pending;            // Stop event waits for the answer
+  int stop_reason;
+  int run_tag;                  // Tag of request which started simulation
+
+public:
+  cl_bin_console(UCSOCKET_T afd, class cl_app *the_app);
+  virtual ~cl_bin_console(void);
+  virtual int init(void);
+
+  virtual int cmd_do_print(const char *format, va_list ap);
+  virtual UCSOCKET_T get_in_fd(void) { return(fd); }
+  virtual bool is_tty(void) const { return(DD_FALSE); }
+  virtual bool is_eof(void) const { return(fd < 0); }
+  virtual bool input_avail(void) { return(DD_FALSE); }
+  virtual char *read_line(void) { return(0); }
+  virtual int proc_input(class cl_cmdset *cmdset);
+  virtual void stopped(int reason);
+
+protected:
+  virtual int proc_frame(class cl_cmdset *cmdset, int type, int tag,
+                         unsigned char *data, int len);
+  virtual int do_cmd(class cl_cmdset *cmdset, int tag,
+                     unsigned char *data, int len);
+  virtual void do_read(int tag, unsigned char *data, int len);
+  virtual void do_write(int tag, unsigned char *data, int len);
+  virtual void do_pc(int tag, unsigned char *data, int len);
+  virtual void do_stop(int tag);
+  virtual void send_stop(void);
+
+  void put(const void *data, int len);
+  void put_u8(int v) { unsigned char c= v; put(&c, 1); }
+  void put_u16(int v);
+  void put_u32(t_addr v);
+  int begin_frame(int type, int tag);
+  void end_frame(int start);
+  void put_text(int start);
+  void flush(void);
+  int running(void);
+};
+
+#endif /* SOCKET_AVAIL */
+
+
+#endif
+
+/* End of cmd.src/newcmdbincl.h */
@@ -122,6 +122,9 @@ public:
   virtual int init(void);
   virtual void welcome(void);
   virtual int proc_input(class cl_cmdset *cmdset);
+  virtual int exec_cmd(class cl_cmdset *cmdset, char *cmdstr);
+  // Simulation started from this console has been stopped
+  virtual void stopped(int reason) {}
 
   void print_prompt(void);
   int dd_printf(const char *format, ...);
@@ -0,0 +1,826 @@
+/*
+ * Simulator of microcontrollers (cmd.src/newcmdgdb.cc)
+ */
+
+/* This file is part of microcontroller simulator: ucsim.
+
+UCSIM is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+UCSIM is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with UCSIM; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA. */
+/*@1@*/
+
+#include "ddconfig.h"
+
+#include <stdio.h>
+#include <errno.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <sys/types.h>
+#ifdef SOCKET_AVAIL
+# include HEADER_SOCKET
+#endif
+#ifdef HAVE_UNISTD_H
+# include <unistd.h>
+#endif
+#include "i_string.h"
+
+// prj
+#include "globals.h"
+#include "utils.h"
+
+// sim
+#include "simcl.h"
+#include "appcl.h"
+#include "brkcl.h"
+
+// local
+#include "newcmdgdbcl.h"
+
+
+#ifdef SOCKET_AVAIL
+
+static int
+hex_val(int c)
+{
+  if (c >= '0' && c <= '9')
+    return(c - '0');
+  if (c >= 'a' && c <= 'f')
+    return(c - 'a' + 10);
+  if (c >= 'A' && c <= 'F')
+    return(c - 'A' + 10);
+  return(-1);
+}
+
+/* Decodes hex pairs of `s' into `buf', returns number of bytes */
+
+static int
+hex2bin(const char *s, int len, char *buf)
+{
+  int i, h, l;
+
+  for (i= 0; i < len*2; i+= 2)
+    {
+      if ((h= hex_val(s[i])) < 0 ||
+          (l= hex_val(s[i+1])) < 0)
+        break;
+      buf[i/2]= (h << 4) | l;
+    }
+  return(i/2);
+}
+
+
+/*
+ * Console of gdb remote protocol
+ *____________________________________________________________________________
+ */
+
+cl_gdb_console::cl_gdb_console(UCSOCKET_T afd, class cl_app *the_app):
+  cl_console()
+{
+  app= the_app;
+  fd= afd;
+  prompt= 0;
+  flags= CONS_INTERACTIVE;
+  id= 0;
+  lines_printed= new cl_ustrings(100, 100, "console_cache");
+  isize= osize= tsize= GDB_PACKET_SIZE;
+  ibuf= (char *)malloc(isize);
+  obuf= (char *)malloc(osize);
+  text= (char *)malloc(tsize);
+  ilen= olen= tlen= 0;
+  no_ack= resumed= DD_FALSE;
+}
+
+cl_gdb_console::~cl_gdb_console(void)
+{
+  class cl_commander_base *cmd= app->get_commander();
+
+  if (cmd->frozen_console == this)
+    cmd->frozen_console= 0;
+  if (fd >= 0)
+    {
+      shutdown(fd, 2);
+      close(fd);
+    }
+  free(ibuf);
+  free(obuf);
+  free(text);
+}
+
+int
+cl_gdb_console::init(void)
+{
+  cl_console::init();
+  // Prompt is never printed, it would go into the output of commands
+  flags|= CONS_PROMPT;
+  return(0);
+}
+
+int
+cl_gdb_console::running(void)
+{
+  return(app->get_sim()->state & SIM_GO);
+}
+
+
+/*
+ * Output
+ */
+
+int
+cl_gdb_console::cmd_do_print(const char *format, va_list ap)
+{
+  char *s;
+  int len;
+
+  if (rout)
+    {
+      len= vfprintf(rout, format, ap);
+      fflush(rout);
+      return(len);
+    }
+#ifdef HAVE_VASPRINTF
+  if (vasprintf(&s, format, ap) < 0)
+    return(0);
+#else
+  s= (char *)malloc(80*25);
+# ifdef HAVE_VSNPRINTF
+  vsnprintf(s, 80*25, format, ap);
+# else
+  _vsnprintf(s, 80*25, format, ap);
+# endif
+#endif
+  len= strlen(s);
+  if (tlen + len > tsize)
+    {
+      while (tlen + len > tsize)
+        tsize*= 2;
+      text= (char *)realloc(text, tsize);
+    }
+  memcpy(text + tlen, s, len);
+  tlen+= len;
+  free(s);
+  return(len);
+}
+
+void
+cl_gdb_console::put(const char *data, int len)
+{
+  if (olen + len > osize)
+    {
+      while (olen + len > osize)
+        osize*= 2;
+      obuf= (char *)realloc(obuf, osize);
+    }
+  memcpy(obuf + olen, data, len);
+  olen+= len;
+}
+
+/* Numbers are sent in the byte order of the target (little endian) */
+
+void
+cl_gdb_console::put_hex(unsigned long val, int bytes)
+{
+  char s[3];
+
+  while (bytes-- > 0)
+    {
+      sprintf(s, "%02x", (int)(val & 0xff));
+      put(s, 2);
+      val>>= 8;
+    }
+}
+
+int
+cl_gdb_console::begin_packet(void)
+{
+  int start= olen;
+
+  put("$", 1);
+  return(start);
+}
+
+void
+cl_gdb_console::end_packet(int start)
+{
+  unsigned char sum= 0;
+  char s[4];
+  int i;
+
+  for (i= start+1; i < olen; i++)
+    sum+= obuf[i];
+  sprintf(s, "#%02x", sum);
+  put(s, 3);
+}
+
+void
+cl_gdb_console::put_packet(const char *data)
+{
+  int f= begin_packet();
+
+  put(data, strlen(data));
+  end_packet(f);
+}
+
+void
+cl_gdb_console::flush(void)
+{
+  int i= 0, n;
+
+  while (i < olen &&
+         fd >= 0)
+    {
+#ifdef MSG_NOSIGNAL
+      n= send(fd, obuf + i, olen - i, MSG_NOSIGNAL);
+#else
+      n= write(fd, obuf + i, olen - i);
+#endif
+      if (n < 0)
+        {
+          if (errno == EINTR)
+            continue;
+          // Connection is lost, it will be noticed by the next read
+          break;
+        }
+      i+= n;
+    }
+  olen= 0;
+}
+
+
+/*
+ * Processing of packets
+ */
+
+int
+cl_gdb_console::proc_input(class cl_cmdset *cmdset)
+{
+  int n, i, e, retval= 0;
+  unsigned char sum;
+
+  if (isize - ilen < GDB_PACKET_SIZE)
+    {
+      isize*= 2;
+      ibuf= (char *)realloc(ibuf, isize);
+    }
+  n= read(fd, ibuf + ilen, isize - ilen);
+  if (n == 0)
+    return(1);
+  if (n < 0)
+    return((errno == EINTR || errno == EAGAIN) ? 0 : 1);
+  ilen+= n;
+
+  // All complete packets are processed, answers are sent together
+  i= 0;
+  while (!retval &&
+         i < ilen)
+    {
+      if (ibuf[i] == '\003')
+        {
+          if (running())
+            app->get_sim()->stop(resUSER);
+          i++;
+          continue;
+        }
+      if (ibuf[i] != '$')
+        {
+          // acknowledges are not checked, the connection is reliable
+          i++;
+          continue;
+        }
+      for (e= i+1; e < ilen && ibuf[e] != '#'; e++)
+        ;
+      if (e + 2 >= ilen)
+        break;
+      for (sum= 0, n= i+1; n < e; n++)
+        sum+= ibuf[n];
+      if (!no_ack)
+        {
+          if (hex_val(ibuf[e+1])*16 + hex_val(ibuf[e+2]) != sum)
+            {
+              put("-", 1);
+              i= e + 3;
+              continue;
+            }
+          put("+", 1);
+        }
+      ibuf[e]= '\0';
+      retval= proc_packet(cmdset, ibuf + i + 1, e - i - 1);
+      i= e + 3;
+    }
+  memmove(ibuf, ibuf + i, ilen - i);
+  ilen-= i;
+  flush();
+  return(retval);
+}
+
+int
+cl_gdb_console::proc_packet(class cl_cmdset *cmdset, char *data, int len)
+{
+  if (!len)
+    {
+      put_packet("");
+      return(0);
+    }
+  app->get_sim()->uc->sync_hw();
+  switch (*data)
+    {
+    case '?':
+      send_stop(app->get_sim()->stop_reason);
+      break;
+    case 'q': case 'Q':
+      do_query(cmdset, data, len);
+      break;
+    case 'g': case 'G':
+      do_regs(data, len, *data == 'G');
+      break;
+    case 'p': case 'P':
+      do_reg(data, len, *data == 'P');
+      break;
+    case 'm':
+      do_read(data, len);
+      break;
+    case 'M': case 'X':
+      do_write(data, len, *data == 'X');
+      break;
+    case 'c': case 's':
+      do_resume(data, len, *data == 's');
+      break;
+    case 'Z': case 'z':
+      do_break(data, len, *data == 'Z');
+      break;
+    case 'H': case 'T':
+      // there is only one thread
+      put_packet("OK");
+      break;
+    case 'D':
+      put_packet("OK");
+      return(1);
+    case 'k':
+      return(1);
+    default:
+      // empty answer means unsupported packet
+      put_packet("");
+      break;
+    }
+  return(0);
+}
+
+void
+cl_gdb_console::do_query(class cl_cmdset *cmdset, char *data, int len)
+{
+  char s[80];
+
+  if (strncmp(data, "qSupported", 10) == 0)
+    {
+      sprintf(s, "PacketSize=%x;QStartNoAckMode+", GDB_PACKET_SIZE);
+      put_packet(s);
+    }
+  else if (strcmp(data, "QStartNoAckMode") == 0)
+    {
+      put_packet("OK");
+      no_ack= DD_TRUE;
+    }
+  else if (strcmp(data, "qAttached") == 0)
+    put_packet("1");
+  else if (strcmp(data, "qfThreadInfo") == 0)
+    put_packet("m1");
+  else if (strcmp(data, "qsThreadInfo") == 0)
+    put_packet("l");
+  else if (strcmp(data, "qOffsets") == 0)
+    put_packet("Text=0;Data=0;Bss=0");
+  else if (strncmp(data, "qSymbol:", 8) == 0)
+    put_packet("OK");
+  else if (strncmp(data, "qRcmd,", 6) == 0)
+    {
+      // monitor command: any command of the simulator
+      char *cmdstr= (char *)malloc(len);
+      int n, i, f;
+
+      n= hex2bin(data + 6, (len - 6) / 2, cmdstr);
+      cmdstr[n]= '\0';
+      tlen= 0;
+      exec_cmd(cmdset, cmdstr);
+      un_redirect();
+      free(cmdstr);
+      for (i= 0; i < tlen; i+= n)
+        {
+          n= tlen - i;
+          if (n > GDB_PACKET_SIZE/2 - 8)
+            n= GDB_PACKET_SIZE/2 - 8;
+          f= begin_packet();
+          put("O", 1);
+          while (n--)
+            put_hex((unsigned char)text[i++], 1);
+          end_packet(f);
+          n= 0;
+        }
+      tlen= 0;
+      put_packet("OK");
+    }
+  else
+    put_packet("");
+}
+
+
+/*
+ * Registers
+ */
+
+void
+cl_gdb_console::do_regs(char *data, int len, bool write)
+{
+  class cl_uc *uc= app->get_sim()->uc;
+  int i, j, size, f;
+  t_mem v;
+  char *s= data + 1;
+
+  if (!write)
+    {
+      f= begin_packet();
+      for (i= 0; i < uc->dbg_regs(); i++)
+        put_hex(uc->dbg_get_reg(i), uc->dbg_reg_size(i));
+      end_packet(f);
+      return;
+    }
+  for (i= 0; i < uc->dbg_regs(); i++)
+    {
+      size= uc->dbg_reg_size(i);
+      if (s + size*2 > data + len)
+        break;
+      for (v= 0, j= size-1; j >= 0; j--)
+        v= (v << 8) | (hex_val(s[j*2]) << 4) | hex_val(s[j*2+1]);
+      uc->dbg_set_reg(i, v);
+      s+= size*2;
+    }
+  put_packet("OK");
+}
+
+void
+cl_gdb_console::do_reg(char *data, int len, bool write)
+{
+  class cl_uc *uc= app->get_sim()->uc;
+  char *s;
+  int nr, j, size, f;
+  t_mem v;
+
+  nr= strtol(data + 1, &s, 16);
+  if (nr < 0 ||
+      nr >= uc->dbg_regs())
+    {
+      put_packet("E00");
+      return;
+    }
+  size= uc->dbg_reg_size(nr);
+  if (!write)
+    {
+      f= begin_packet();
+      put_hex(uc->dbg_get_reg(nr), size);
+      end_packet(f);
+      return;
+    }
+  if (*s++ != '=' ||
+      s + size*2 > data + len)
+    {
+      put_packet("E01");
+      return;
+    }
+  for (v= 0, j= size-1; j >= 0; j--)
+    v= (v << 8) | (hex_val(s[j*2]) << 4) | hex_val(s[j*2+1]);
+  uc->dbg_set_reg(nr, v);
+  put_packet("OK");
+}
+
+
+/*
+ * Memory
+ */
+
+class cl_address_space *
+cl_gdb_console::decode_addr(t_addr gaddr, t_addr *addr)
+{
+  class cl_uc *uc= app->get_sim()->uc;
+  int space= (gaddr >> GDB_SPACE_SHIFT) & 0xff;
+
+  *addr= gaddr & GDB_ADDR_MASK;
+  if (space >= uc->address_spaces->count)
+    return(0);
+  return((class cl_address_space *)(uc->address_spaces->at(space)));
+}
+
+/* Cells wider than 8 bits are seen as little endian byte groups */
+
+bool
+cl_gdb_console::read_byte(t_addr gaddr, int *val)
+{
+  class cl_address_space *mem;
+  t_addr addr;
+  int w;
+
+  if (!(mem= decode_addr(gaddr, &addr)))
+    return(DD_FALSE);
+  w= (mem->width + 7) / 8;
+  if (!mem->valid_address(addr / w))
+    return(DD_FALSE);
+  *val= (mem->get(addr / w) >> ((addr % w) * 8)) & 0xff;
+  return(DD_TRUE);
+}
+
+bool
+cl_gdb_console::write_byte(t_addr gaddr, int val)
+{
+  class cl_address_space *mem;
+  t_addr addr;
+  int w, sh;
+  t_mem v;
+
+  if (!(mem= decode_addr(gaddr, &addr)))
+    return(DD_FALSE);
+  w= (mem->width + 7) / 8;
+  if (!mem->valid_address(addr / w))
+    return(DD_FALSE);
+  sh= (addr % w) * 8;
+  v= mem->get(addr / w);
+  v= (v & ~((t_mem)0xff << sh)) | ((t_mem)(val & 0xff) << sh);
+  mem->write(addr / w, v);
+  return(DD_TRUE);
+}
+
+void
+cl_gdb_console::do_read(char *data, int len)
+{
+  t_addr gaddr;
+  char *s;
+  int count, i, v, f;
+
+  gaddr= strtoul(data + 1, &s, 16);
+  if (*s++ != ',')
+    {
+      put_packet("E01");
+      return;
+    }
+  count= strtol(s, 0, 16);
+  if (count > (GDB_PACKET_SIZE - 4) / 2)
+    count= (GDB_PACKET_SIZE - 4) / 2;
+  f= begin_packet();
+  for (i= 0; i < count; i++)
+    {
+      // a shorter answer is fine if the end is not readable
+      if (!read_byte(gaddr + i, &v))
+        break;
+      put_hex(v, 1);
+    }
+  if (i == 0 &&
+      count > 0)
+    {
+      olen= f;
+      put_packet("E01");
+      return;
+    }
+  end_packet(f);
+}
+
+void
+cl_gdb_console::do_write(char *data, int len, bool binary)
+{
+  t_addr gaddr;
+  char *s, *end= data + len;
+  int count, i, h, l, v;
+
+  gaddr= strtoul(data + 1, &s, 16);
+  if (*s++ != ',')
+    {
+      put_packet("E01");
+      return;
+    }
+  count= strtol(s, &s, 16);
+  if (*s++ != ':')
+    {
+      put_packet("E01");
+      return;
+    }
+  for (i= 0; i < count; i++)
+    {
+      if (binary)
+        {
+          if (s >= end)
+            break;
+          v= (unsigned char)*s++;
+          if (v == '}' &&
+              s < end)
+            v= (unsigned char)*s++ ^ 0x20;
+        }
+      else
+        {
+          if (s + 2 > end ||
+              (h= hex_val(s[0])) < 0 ||
+              (l= hex_val(s[1])) < 0)
+            break;
+          v= (h << 4) | l;
+          s+= 2;
+        }
+      if (!write_byte(gaddr + i, v))
+        break;
+    }
+  put_packet((i == count) ? "OK" : "E01");
+}
+
+
+/*
+ * Execution
+ */
+
+void
+cl_gdb_console::do_resume(char *data, int len, bool step)
+{
+  class cl_sim *sim= app->get_sim();
+  class cl_uc *uc= sim->uc;
+  int res;
+
+  if (running())
+    return;
+  if (len > 1)
+    uc->PC= strtoul(data + 1, 0, 16) & GDB_ADDR_MASK;
+  if (step ||
+      uc->fbrk_at(uc->PC))
+    {
+      // Breakpoint at PC would stop the run before the instruction
+      res= uc->do_inst(1);
+      if (step ||
+          res != resGO ||
+          uc->events->count)
+        {
+          send_stop((res != resGO) ? res : resBREAKPOINT);
+          return;
+        }
+    }
+  resumed= DD_TRUE;
+  sim->start(this);
+}
+
+/* Z0/Z1: fetch breakpoint, Z2/Z3/Z4: write/read/access watchpoint of
+   `kind' cells */
+
+void
+cl_gdb_console::do_break(char *data, int len, bool insert)
+{
+  class cl_uc *uc= app->get_sim()->uc;
+  class cl_address_space *mem;
+  t_addr gaddr, addr;
+  int type, kind, i;
+  char *s;
+  enum brk_event ev;
+  char op;
+
+  type= data[1] - '0';
+  if (data[2] != ',')
+    {
+      put_packet("E01");
+      return;
+    }
+  gaddr= strtoul(data + 3, &s, 16);
+  kind= (*s == ',') ? strtol(s + 1, 0, 16) : 1;
+  switch (type)
+    {
+    case 0: case 1:
+      addr= gaddr & GDB_ADDR_MASK;
+      if (!uc->rom ||
+          !uc->rom->valid_address(addr))
+        {
+          put_packet("E01");
+          return;
+        }
+      if (insert &&
+          !uc->fbrk->bp_at(addr))
+        {
+          class cl_brk *b= new cl_fetch_brk(uc->rom, uc->make_new_brknr(),
+                                            addr, brkFIX, 1);
+          b->init();
+          uc->fbrk->add_bp(b);
+        }
+      else if (!insert &&
+               uc->fbrk->bp_at(addr))
+        uc->fbrk->del_bp(addr);
+      break;
+    case 2: case 3: case 4:
+      if (!(mem= decode_addr(gaddr, &addr)))
+        {
+          put_packet("E01");
+          return;
+        }
+      op= (type == 2) ? 'W' : ((type == 3) ? 'R' : 'A');
+      ev= (type == 2) ? brkWRITE : ((type == 3) ? brkREAD : brkACCESS);
+      if (kind < 1)
+        kind= 1;
+      for (i= 0; i < kind; i++)
+        {
+          if (!mem->valid_address(addr + i))
+            break;
+          if (insert)
+            {
+              class cl_ev_brk *b= uc->mk_ebrk(brkFIX, mem, op, addr + i, 1);
+              uc->ebrk->add_bp(b);
+            }
+          else
+            {
+              // cl_uc::rm_ebrk() would remove the same address of
+              // other memories too
+              int j;
+              for (j= uc->ebrk->count - 1; j >= 0; j--)
+                {
+                  class cl_ev_brk *eb= (class cl_ev_brk *)(uc->ebrk->at(j));
+                  if (eb->addr == addr + i &&
+                      eb->get_mem() == mem &&
+                      eb->event == ev)
+                    uc->ebrk->del_bp(j, 0);
+                }
+            }
+        }
+      break;
+    default:
+      put_packet("");
+      return;
+    }
+  put_packet("OK");
+}
+
+
+/*
+ * Notification about stop of the simulation
+ */
+
+void
+cl_gdb_console::stopped(int reason)
+{
+  class cl_commander_base *cmd= app->get_commander();
+
+  // Event breakpoints leave the console frozen, it is released here
+  flags&= ~CONS_FROZEN;
+  if (cmd->frozen_console == this)
+    cmd->frozen_console= 0;
+  if (resumed)
+    {
+      resumed= DD_FALSE;
+      send_stop(reason);
+      flush();
+    }
+}
+
+/* T packet with the watchpoint which stopped the run and the PC */
+
+void
+cl_gdb_console::send_stop(int reason)
+{
+  class cl_uc *uc= app->get_sim()->uc;
+  char s[64];
+  int sig, f;
+
+  switch (reason)
+    {
+    case resUSER: sig= GDB_SIGINT; break;
+    case resINV_INST: sig= GDB_SIGILL; break;
+    case resINV_ADDR: case resSTACK_OV: sig= GDB_SIGSEGV; break;
+    default: sig= GDB_SIGTRAP; break;
+    }
+  // messages of the stop are not needed
+  tlen= 0;
+  f= begin_packet();
+  sprintf(s, "T%02x", sig);
+  put(s, strlen(s));
+  if (uc->events->count)
+    {
+      class cl_ev_brk *eb=
+        dynamic_cast<class cl_ev_brk *>(uc->events->object_at(0));
+      if (eb)
+        {
+          sprintf(s, "%s:%lx;",
+                  (eb->event == brkWRITE) ? "watch" :
+                  ((eb->event == brkREAD) ? "rwatch" : "awatch"),
+                  (unsigned long)((uc->address_spaces->index_of(eb->get_mem())
+                                   << GDB_SPACE_SHIFT) | eb->addr));
+          put(s, strlen(s));
+        }
+    }
+  sprintf(s, "%02x:", uc->dbg_regs() - 1);
+  put(s, 3);
+  put_hex(uc->dbg_get_reg(uc->dbg_regs() - 1),
+          uc->dbg_reg_size(uc->dbg_regs() - 1));
+  put(";", 1);
+  end_packet(f);
+}
+
+#endif /* SOCKET_AVAIL */
+
+
+/* End of cmd.src/newcmdgdb.cc */
@@ -0,0 +1,106 @@
+/*
+ * Simulator of microcontrollers (cmd.src/newcmdgdbcl.h)
+ */
+
+/* This file is part of microcontroller simulator: ucsim.
+
+UCSIM is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+UCSIM is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with UCSIM; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA. */
+/*@1@*/
+
+#ifndef CMD_NEWCMDGDBCL_HEADER
+#define CMD_NEWCMDGDBCL_HEADER
+
+#include "newcmdposixcl.h"
+
+
+/* GDB remote serial protocol. Memory addresses of gdb select the
+   address space by the highest byte: n means the nth address space of
+   the controller (in the order of `info memory'), the lower 24 bits are
+   the address inside. Registers are the ones of cl_uc::dbg_get_reg(). */
+
+#define GDB_SPACE_SHIFT 24
+#define GDB_ADDR_MASK   0xffffff
+#define GDB_PACKET_SIZE 4096
+
+// Signals of stop replies
+#define GDB_SIGINT      2
+#define GDB_SIGILL      4
+#define GDB_SIGTRAP     5
+#define GDB_SIGSEGV     11
+
+
+/*
+ * Console of a gdb connection
+ */
+
+#ifdef SOCKET_AVAIL
+
+class cl_gdb_console: public cl_console
+{
+protected:
+  UCSOCKET_T fd;
+  char *ibuf;                   // Received bytes, not processed yet
+  int ilen, isize;
+  char *obuf;                   // Packets to send
+  int olen, osize;
+  char *text;                   // Output of monitor commands
+  int tlen, tsize;
+  bool no_ack;                  // QStartNoAckMode is in effect
+  bool resumed;                 // Stop reply is owed for c
+
+public:
+  cl_gdb_console(UCSOCKET_T afd, class cl_app *the_app);
+  virtual ~cl_gdb_console(void);
+  virtual int init(void);
+
+  virtual int cmd_do_print(const char *format, va_list ap);
+  virtual UCSOCKET_T get_in_fd(void) { return(fd); }
+  virtual bool is_tty(void) const { return(DD_FALSE); }
+  virtual bool is_eof(void) const { return(fd < 0); }
+  virtual bool input_avail(void) { return(DD_FALSE); }
+  virtual char *read_line(void) { return(0); }
+  virtual int proc_input(class cl_cmdset *cmdset);
+  virtual void stopped(int reason);
+
+protected:
+  virtual int proc_packet(class cl_cmdset *cmdset, char *data, int len);
+  virtual void do_query(class cl_cmdset *cmdset, char *data, int len);
+  virtual void do_regs(char *data, int len, bool write);
+  virtual void do_reg(char *data, int len, bool write);
+  virtual void do_read(char *data, int len);
+  virtual void do_write(char *data, int len, bool binary);
+  virtual void do_resume(char *data, int len, bool step);
+  virtual void do_break(char *data, int len, bool insert);
+  virtual void send_stop(int reason);
+
+  class cl_address_space *decode_addr(t_addr gaddr, t_addr *addr);
+  bool read_byte(t_addr gaddr, int *val);
+  bool write_byte(t_addr gaddr, int val);
+  void put(const char *data, int len);
+  void put_hex(unsigned long val, int bytes);
+  int begin_packet(void);
+  void end_packet(int start);
+  void put_packet(const char *data);
+  void flush(void);
+  int running(void);
+};
+
+#endif /* SOCKET_AVAIL */
+
+
+#endif
+
+/* End of cmd.src/newcmdgdbcl.h */
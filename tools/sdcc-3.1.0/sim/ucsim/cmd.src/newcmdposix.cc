@@ -62,6 +62,8 @@ Software Foundation, 59 Temple Place - Suite 330, Boston, MA
 
 // local
 #include "newcmdposixcl.h"
+#include "newcmdbincl.h"
+#include "newcmdgdbcl.h"
 
 
 /*
@@ -235,9 +237,11 @@ cl_console::read_line(void)
  */
 #ifdef SOCKET_AVAIL
 
-cl_listen_console::cl_listen_console(int serverport, class cl_app *the_app)
+cl_listen_console::cl_listen_console(int serverport, class cl_app *the_app,
+                                     enum listen_kind akind)
 {
   app= the_app;
+  kind= akind;
   if ((sock= make_server_socket(serverport)) >= 0)
     {
       if (listen(sock, 10) < 0)
@@ -264,6 +268,16 @@ cl_listen_console::proc_input(class cl_cmdset *cmdset)
       perror("accept");
       return(0);
     }
+  if (kind == LISTEN_BIN)
+    {
+      cmd->add_console(new cl_bin_console(newsock, app));
+      return(0);
+    }
+  if (kind == LISTEN_GDB)
+    {
+      cmd->add_console(new cl_gdb_console(newsock, app));
+      return(0);
+    }
   if (!(in= fdopen(newsock, "r")))
     fprintf(stderr, "cannot open port for input\n");
   if (!(out= fdopen(newsock, "w")))
@@ -324,6 +338,8 @@ cl_commander::init(void)
   class cl_optref console_on_option(this);
   class cl_optref config_file_option(this);
   class cl_optref port_number_option(this);
+  class cl_optref bin_port_option(this);
+  class cl_optref gdb_port_option(this);
   class cl_console_base *con;
 
   console_on_option.init();
@@ -331,6 +347,8 @@ cl_commander::init(void)
   config_file_option.init();
   config_file_option.use("config_file");
   port_number_option.init();
+  bin_port_option.init();
+  gdb_port_option.init();
 
   cl_base::init();
   set_name("Commander");
@@ -340,6 +358,12 @@ cl_commander::init(void)
 #ifdef SOCKET_AVAIL
   if (port_number_option.use("port_number"))
     add_console(new cl_listen_console(port_number_option.get_value((long)0), app));
+  if (bin_port_option.use("bin_port_number"))
+    add_console(new cl_listen_console(bin_port_option.get_value((long)0), app,
+                                      LISTEN_BIN));
+  if (gdb_port_option.use("gdb_port_number"))
+    add_console(new cl_listen_console(gdb_port_option.get_value((long)0), app,
+                                      LISTEN_GDB));
 #endif
 
   /* The following code is commented out because it produces gcc warnings
@@ -361,7 +385,8 @@ cl_commander::init(void)
       exec_on(con, Config);
       need_config= DD_FALSE;
     }
-  if (cons->get_count() == 0)
+  if (cons->get_count() == 0 &&
+      !app->batch_mode())
     {
       add_console(con= new cl_console(stdin, stdout, app));
       exec_on(con, Config);
@@ -64,13 +64,22 @@ private:
 };
 
 #ifdef SOCKET_AVAIL
+// Protocol of connections accepted by a listener
+enum listen_kind {
+  LISTEN_TEXT,	// command line
+  LISTEN_BIN,	// binary protocol of cl_bin_console
+  LISTEN_GDB	// gdb remote protocol of cl_gdb_console
+};
+
 class cl_listen_console: public cl_console
 {
 private:
   int sock;
+  enum listen_kind kind;
 
 public:
-  cl_listen_console(int serverport, class cl_app *the_app);
+  cl_listen_console(int serverport, class cl_app *the_app,
+                    enum listen_kind akind= LISTEN_TEXT);
 
   virtual void welcome(void) {}
 
@@ -215,7 +215,7 @@
 /* XXX */
 #undef SOCKLEN_T
 
-/* XXX */
+/* Count memory accesses for the statistic command */
 #undef STATISTIC
 
 /* Define to 1 if you have the ANSI C header files. */
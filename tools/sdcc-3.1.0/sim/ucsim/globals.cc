@@ -72,6 +72,21 @@ struct id_element error_type_names[]= {
   { err_warning,	"warning" }
 };
 
+struct id_element stop_reasons[]= {
+  { resGO,		"running" },
+  { resHALT,		"halted" },
+  { resINV_ADDR,	"invalid address" },
+  { resSTACK_OV,	"stack overflow" },
+  { resBREAKPOINT,	"breakpoint" },
+  { resINTERRUPT,	"interrupt" },
+  { resWDTRESET,	"watchdog reset" },
+  { resUSER,		"user stopped" },
+  { resINV_INST,	"invalid instruction" },
+  { resERROR,		"error" },
+  { resCYCLES,		"cycles executed" },
+  { 0, 0 }
+};
+
 
 const char *warranty= 
 "                            NO WARRANTY\n"
@@ -43,6 +43,7 @@ extern struct id_element mem_ids[];
 extern struct id_element mem_classes[];
 extern struct id_element cpu_states[];
 extern struct id_element error_type_names[];
+extern struct id_element stop_reasons[];
 //extern char *case_string(enum letter_case lcase, const char *str);
 
 extern char *warranty;
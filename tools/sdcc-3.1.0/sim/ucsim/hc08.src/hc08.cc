@@ -37,6 +37,7 @@ Software Foundation, 59 Temple Place - Suite 330, Boston, MA
 
 // prj
 #include "pobjcl.h"
+#include "utils.h"
 
 // sim
 #include "simcl.h"
@@ -369,6 +370,21 @@ cl_hc08::disass(t_addr addr, const char *sep)
 }
 
 
+bool
+cl_hc08::save_state(FILE *f)
+{
+  return(cl_uc::save_state(f) &&
+         SAVE_VAR(f, regs));
+}
+
+bool
+cl_hc08::load_state(FILE *f)
+{
+  return(cl_uc::load_state(f) &&
+         LOAD_VAR(f, regs));
+}
+
+
 void
 cl_hc08::print_regs(class cl_console_base *con)
 {
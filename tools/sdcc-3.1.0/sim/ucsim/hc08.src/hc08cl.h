@@ -59,6 +59,9 @@ public:
   virtual const char *disass(t_addr addr, const char *sep);
   virtual void print_regs(class cl_console_base *con);
 
+  virtual bool save_state(FILE *f);
+  virtual bool load_state(FILE *f);
+
   virtual int exec_inst(void);
 
   virtual const char *get_disasm_info(t_addr addr,
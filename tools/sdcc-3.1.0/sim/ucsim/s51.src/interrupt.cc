@@ -96,6 +96,18 @@ cl_interrupt::tick(int cycles)
   return(resGO);
 }
 
+/* Level triggered inputs must be sampled in every cycle, edges are
+   reported by the port */
+
+long
+cl_interrupt::wakeup_in(void)
+{
+  if ((bit_IT0 || bit_INT0) &&
+      (bit_IT1 || bit_INT1))
+    return(-1);
+  return(0);
+}
+
 void
 cl_interrupt::reset(void)
 {
@@ -127,6 +139,28 @@ cl_interrupt::happen(class cl_hw *where, enum hw_event he, void *params)
 }
 
 
+bool
+cl_interrupt::save_state(FILE *f)
+{
+  return(cl_hw::save_state(f) &&
+         SAVE_VAR(f, was_reti) &&
+         SAVE_VAR(f, bit_IT0) &&
+         SAVE_VAR(f, bit_IT1) &&
+         SAVE_VAR(f, bit_INT0) &&
+         SAVE_VAR(f, bit_INT1));
+}
+
+bool
+cl_interrupt::load_state(FILE *f)
+{
+  return(cl_hw::load_state(f) &&
+         LOAD_VAR(f, was_reti) &&
+         LOAD_VAR(f, bit_IT0) &&
+         LOAD_VAR(f, bit_IT1) &&
+         LOAD_VAR(f, bit_INT0) &&
+         LOAD_VAR(f, bit_INT1));
+}
+
 void
 cl_interrupt::print_info(class cl_console_base *con)
 {
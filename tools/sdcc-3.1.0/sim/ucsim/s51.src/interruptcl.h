@@ -53,9 +53,13 @@ public:
   //virtual void mem_cell_changed(class cl_m *mem, t_addr addr);
 
   virtual int tick(int cycles);
+  virtual long wakeup_in(void);
   virtual void reset(void);
   virtual void happen(class cl_hw *where, enum hw_event he, void *params);
 
+  virtual bool save_state(FILE *f);
+  virtual bool load_state(FILE *f);
+
   virtual void print_info(class cl_console_base *con);
 };
 
@@ -27,6 +27,9 @@ Software Foundation, 59 Temple Place - Suite 330, Boston, MA
 
 #include <ctype.h>
 
+// prj
+#include "utils.h"
+
 // sim.src
 #include "itsrccl.h"
 
@@ -188,6 +191,14 @@ cl_pca::tick(int cycles)
   return(ret);
 }
 
+long
+cl_pca::wakeup_in(void)
+{
+  if (!bit_CR)
+    return(-1);
+  return(0);
+}
+
 void
 cl_pca::do_pca_counter(int cycles)
 {
@@ -320,6 +331,38 @@ cl_pca::happen(class cl_hw *where, enum hw_event he, void *params)
 }
 
 
+bool
+cl_pca::save_state(FILE *f)
+{
+  return(cl_hw::save_state(f) &&
+         SAVE_VAR(f, ccapm) &&
+         SAVE_VAR(f, t0_overflows) &&
+         SAVE_VAR(f, ECI_edge) &&
+         SAVE_VAR(f, clk_source) &&
+         SAVE_VAR(f, bit_CIDL) &&
+         SAVE_VAR(f, bit_WDTE) &&
+         SAVE_VAR(f, bit_ECF) &&
+         SAVE_VAR(f, bit_CR) &&
+         SAVE_VAR(f, cex_pos) &&
+         SAVE_VAR(f, cex_neg));
+}
+
+bool
+cl_pca::load_state(FILE *f)
+{
+  return(cl_hw::load_state(f) &&
+         LOAD_VAR(f, ccapm) &&
+         LOAD_VAR(f, t0_overflows) &&
+         LOAD_VAR(f, ECI_edge) &&
+         LOAD_VAR(f, clk_source) &&
+         LOAD_VAR(f, bit_CIDL) &&
+         LOAD_VAR(f, bit_WDTE) &&
+         LOAD_VAR(f, bit_ECF) &&
+         LOAD_VAR(f, bit_CR) &&
+         LOAD_VAR(f, cex_pos) &&
+         LOAD_VAR(f, cex_neg));
+}
+
 void
 cl_pca::print_info(class cl_console_base *con)
 {
@@ -27,6 +27,10 @@ Software Foundation, 59 Temple Place - Suite 330, Boston, MA
 
 #include <ctype.h>
 
+// prj
+#include "utils.h"
+
+// local
 #include "portcl.h"
 #include "regs51.h"
 #include "types51.h"
@@ -145,6 +149,22 @@ cl_port::mem_cell_changed(class cl_m *mem, t_addr addr)
   write(sfr, &d);
 }*/
 
+bool
+cl_port::save_state(FILE *f)
+{
+  return(cl_hw::save_state(f) &&
+         SAVE_VAR(f, port_pins) &&
+         SAVE_VAR(f, prev));
+}
+
+bool
+cl_port::load_state(FILE *f)
+{
+  return(cl_hw::load_state(f) &&
+         LOAD_VAR(f, port_pins) &&
+         LOAD_VAR(f, prev));
+}
+
 void
 cl_port::print_info(class cl_console_base *con)
 {
@@ -44,18 +44,51 @@ Software Foundation, 59 Temple Place - Suite 330, Boston, MA
 
 // prj
 #include "globals.h"
+#include "utils.h"
 
 // local
 #include "serialcl.h"
+#include "serialiocl.h"
 #include "regs51.h"
 #include "uc51cl.h"
 #include "cmdutil.h"
 
 
+cl_serial_file_option::cl_serial_file_option(class cl_serial *the_serial):
+  cl_optref(the_serial)
+{
+  serial= the_serial;
+}
+
+void
+cl_serial_file_option::option_changed(void)
+{
+  if (serial)
+    serial->files_changed();
+}
+
+
+cl_serial_mode_option::cl_serial_mode_option(class cl_serial *the_serial):
+  cl_optref(the_serial)
+{
+  serial= the_serial;
+}
+
+void
+cl_serial_mode_option::option_changed(void)
+{
+  if (serial)
+    serial->modes_changed();
+}
+
+
 cl_serial::cl_serial(class cl_uc *auc):
   cl_hw(auc, HW_UART, 0, "uart")
 {
   serial_in= serial_out= NIL;
+  serial_fast_option= serial_flow_option= 0;
+  io= 0;
+  fast= flow= DD_FALSE;
 }
 
 cl_serial::~cl_serial(void)
@@ -76,18 +109,17 @@ cl_serial::~cl_serial(void)
 #endif
       fclose(serial_out);
     }
+  if (io)
+    delete io;
   delete serial_in_file_option;
   delete serial_out_file_option;
+  delete serial_fast_option;
+  delete serial_flow_option;
 }
 
 int
 cl_serial::init(void)
 {
-#ifdef HAVE_TERMIOS_H
-  int i;
-  struct termios tattr;
-#endif
-
   set_name("mcs51_uart");
   sfr= uc->address_space(MEM_SFR_ID);
   if (sfr)
@@ -100,10 +132,10 @@ cl_serial::init(void)
       register_cell(sfr, SCON, &scon, wtd_restore_write);
     }
 
-  serial_in_file_option= new cl_optref(this);
+  serial_in_file_option= new cl_serial_file_option(this);
   serial_in_file_option->init();
   serial_in_file_option->use("serial_in_file");
-  serial_out_file_option= new cl_optref(this);
+  serial_out_file_option= new cl_serial_file_option(this);
   serial_out_file_option->init();
   serial_out_file_option->use("serial_out_file");
 
@@ -115,8 +147,46 @@ cl_serial::init(void)
 
   //serial_in = (FILE*)application->args->get_parg(0, "Ser_in");
   //serial_out= (FILE*)application->args->get_parg(0, "Ser_out");
-  serial_in = (FILE*)serial_in_file_option->get_value((void*)0);
-  serial_out= (FILE*)serial_out_file_option->get_value((void*)0);
+  // host side of the line belongs to the first controller, others can
+  // be linked to each other only
+  if (uc->core_id == 0)
+    {
+      serial_in = (FILE*)serial_in_file_option->get_value((void*)0);
+      serial_out= (FILE*)serial_out_file_option->get_value((void*)0);
+      setup_files(DD_TRUE);
+      setup_io();
+    }
+
+  serial_fast_option= new cl_serial_mode_option(this);
+  serial_fast_option->init();
+  serial_fast_option->use("serial_fast");
+  serial_flow_option= new cl_serial_mode_option(this);
+  serial_flow_option->init();
+  serial_flow_option->use("serial_flow");
+  modes_changed();
+
+  class cl_hw *t2= uc->get_hw(HW_TIMER, 2, 0);
+  if ((there_is_t2= t2 != 0))
+    {
+      t_mem d= sfr->get(T2CON);
+      t2_baud= d & (bmRCLK | bmTCLK);
+    }
+  else
+    t2_baud= DD_FALSE;
+
+  return(0);
+}
+
+/* Prepares the files of serial_in and serial_out, verbose warns about
+   non-terminal files */
+
+void
+cl_serial::setup_files(bool verbose)
+{
+#ifdef HAVE_TERMIOS_H
+  int i;
+  struct termios tattr;
+#endif
 
   if (serial_in != serial_out && serial_in)
     {
@@ -144,8 +214,9 @@ cl_serial::init(void)
         }
       else
 #endif
-        fprintf(stderr, "Warning: serial input interface connected to a "
-                "non-terminal file.\n");
+        if (verbose)
+          fprintf(stderr, "Warning: serial input interface connected to a "
+                  "non-terminal file.\n");
     }
   if (serial_out)
     {
@@ -173,20 +244,105 @@ cl_serial::init(void)
         }
       else
 #endif
-        fprintf(stderr, "Warning: serial output interface connected to a "
-                "non-terminal file.\n");
+        if (verbose)
+          fprintf(stderr, "Warning: serial output interface connected to a "
+                  "non-terminal file.\n");
     }
+}
 
-  class cl_hw *t2= uc->get_hw(HW_TIMER, 2, 0);
-  if ((there_is_t2= t2 != 0))
+/* Socket or pty of the serial_unix or serial_pty option replaces the
+   files */
+
+void
+cl_serial::setup_io(void)
+{
+  class cl_optref unix_option(this);
+  class cl_optref pty_option(this);
+  char *s;
+
+  unix_option.init();
+  pty_option.init();
+  if (unix_option.use("serial_unix") &&
+      (s= unix_option.get_value((char*)0)) != NULL &&
+      *s)
     {
-      t_mem d= sfr->get(T2CON);
-      t2_baud= d & (bmRCLK | bmTCLK);
+      io= new cl_serial_io();
+      io->init();
+      if (!io->open_unix(s))
+        {
+          delete io;
+          io= 0;
+        }
     }
-  else
-    t2_baud= DD_FALSE;
+  else if (pty_option.use("serial_pty") &&
+           (s= pty_option.get_value((char*)0)) != NULL)
+    {
+      // empty value means a pty without link
+      io= new cl_serial_io();
+      io->init();
+      if (!io->open_pty(s))
+        {
+          delete io;
+          io= 0;
+        }
+    }
+}
 
-  return(0);
+void
+cl_serial::modes_changed(void)
+{
+  fast= serial_fast_option->get_value(bool(DD_FALSE));
+  flow= serial_flow_option->get_value(bool(DD_FALSE));
+  schedule();
+}
+
+/* Option of the files got a new value (e.g. each test of a batch run
+   gets its own files) */
+
+void
+cl_serial::files_changed(void)
+{
+  FILE *fi= (FILE*)serial_in_file_option->get_value((void*)0);
+  FILE *fo= (FILE*)serial_out_file_option->get_value((void*)0);
+
+  if (uc->core_id ||
+      (fi == serial_in &&
+       fo == serial_out))
+    return;
+  serial_in= fi;
+  serial_out= fo;
+  setup_files(DD_FALSE);
+  s_receiving= DD_FALSE;
+  schedule();
+}
+
+/* Serial line to the uart of an other controller, it replaces the
+   socket or pty and the files on both sides */
+
+bool
+cl_serial::connect(class cl_hw *other)
+{
+  class cl_serial *peer= (class cl_serial *)other;
+  class cl_serial_link *a, *b;
+
+  if (other->cathegory != HW_UART ||
+      other->uc == uc)
+    return(DD_FALSE);
+  a= new cl_serial_link(uc);
+  a->init();
+  b= new cl_serial_link(peer->uc);
+  b->init();
+  a->connect(b);
+  b->connect(a);
+  if (io)
+    delete io;
+  io= a;
+  schedule();
+  if (peer->io)
+    delete peer->io;
+  peer->io= b;
+  peer->schedule();
+  return(DD_TRUE);
 }
 
 void
@@ -335,47 +491,60 @@ cl_serial::serial_bit_cnt(void)
   return(0);
 }
 
+/* A character is waiting on the input */
+
+bool
+cl_serial::rx_ready(void)
+{
+  if (io)
+    return(io->rx_avail() > 0);
+  if (!serial_in)
+    return(DD_FALSE);
+#ifdef _WIN32
+  HANDLE handle = (HANDLE)_get_osfhandle(fileno(serial_in));
+  assert(INVALID_HANDLE_VALUE != handle);
+
+  return(input_avail(handle));
+#else
+  return(input_avail(fileno(serial_in)));
+#endif
+}
+
 int
 cl_serial::tick(int cycles)
 {
   char c;
 
+  if (io)
+    io->tick(cycles);
   serial_bit_cnt(/*_mode*/);
+  // Full output buffer holds the transmitter like a deasserted CTS
   if (s_sending &&
-      (s_tr_bit >= _bits))
+      (fast || s_tr_bit >= _bits) &&
+      !(io && io->tx_full()))
     {
       s_sending= DD_FALSE;
       scon->set_bit1(bmTI);
-      if (serial_out)
+      if (io)
+        io->put(s_out);
+      else if (serial_out)
         {
           putc(s_out, serial_out);
           fflush(serial_out);
         }
-      s_tr_bit-= _bits;
+      s_tr_bit= fast?0:(s_tr_bit - _bits);
       //printf("serial out %d bit rems %d\n",s_tr_bit,uc->ticks->ticks);
     }
-  if ((/*scn & bmREN*/_bmREN) &&
-      serial_in &&
-      !s_receiving)
-    {
-#ifdef _WIN32
-      HANDLE handle = (HANDLE)_get_osfhandle(fileno(serial_in));
-      assert(INVALID_HANDLE_VALUE != handle);
-
-      if (input_avail(handle))
-#else
-      if (input_avail(fileno(serial_in)))
-#endif
-        {
-          s_receiving= DD_TRUE;
-          s_rec_bit= 0;
-          s_rec_tick= /*uc51->*/s_rec_t1= 0;
-        }
-    }
   if (s_receiving &&
       (s_rec_bit >= _bits))
     {
-      if (::read(fileno(serial_in), &c, 1) == 1)
+      if (io)
+        {
+          s_in= io->get();
+          sbuf->set(s_in);
+          received(s_in);
+        }
+      else if (::read(fileno(serial_in), &c, 1) == 1)
         {
           s_in= c;
           sbuf->set(s_in);
@@ -384,6 +553,18 @@ cl_serial::tick(int cycles)
       s_receiving= DD_FALSE;
       s_rec_bit-= _bits;
     }
+  // Without timing characters would overrun each other, so fast mode
+  // waits for RI to be cleared too. A fast character is stored at the
+  // next tick to let the program read SBUF after clearing RI.
+  if ((/*scn & bmREN*/_bmREN) &&
+      !s_receiving &&
+      !((flow || fast) && (scon->get() & bmRI)) &&
+      rx_ready())
+    {
+      s_receiving= DD_TRUE;
+      s_rec_bit= fast?_bits:0;
+      s_rec_tick= /*uc51->*/s_rec_t1= 0;
+    }
 
   int l;
   s_tr_tick+= (l= cycles * uc->clock_per_cycle());
@@ -397,6 +578,20 @@ cl_serial::received(int c)
   scon->set_bit1(bmRI);
 }
 
+long
+cl_serial::wakeup_in(void)
+{
+  if (s_sending ||
+      s_receiving)
+    return(0);
+  // Socket and pty are polled while the uart is idle
+  if (io)
+    return((_bmREN && io->rx_avail())?0:SIO_POLL_CYCLES);
+  if (!(_bmREN && serial_in))
+    return(-1);
+  return(0);
+}
+
 void
 cl_serial::reset(void)
 {
@@ -446,6 +641,50 @@ cl_serial::happen(class cl_hw *where, enum hw_event he, void *params)
     }
 }
 
+bool
+cl_serial::save_state(FILE *f)
+{
+  return(cl_hw::save_state(f) &&
+         SAVE_VAR(f, t2_baud) &&
+         SAVE_VAR(f, s_in) &&
+         SAVE_VAR(f, s_out) &&
+         SAVE_VAR(f, s_sending) &&
+         SAVE_VAR(f, s_receiving) &&
+         SAVE_VAR(f, s_rec_bit) &&
+         SAVE_VAR(f, s_tr_bit) &&
+         SAVE_VAR(f, s_rec_t1) &&
+         SAVE_VAR(f, s_tr_t1) &&
+         SAVE_VAR(f, s_rec_tick) &&
+         SAVE_VAR(f, s_tr_tick) &&
+         SAVE_VAR(f, _mode) &&
+         SAVE_VAR(f, _bmREN) &&
+         SAVE_VAR(f, _bmSMOD) &&
+         SAVE_VAR(f, _bits) &&
+         SAVE_VAR(f, _divby));
+}
+
+bool
+cl_serial::load_state(FILE *f)
+{
+  return(cl_hw::load_state(f) &&
+         LOAD_VAR(f, t2_baud) &&
+         LOAD_VAR(f, s_in) &&
+         LOAD_VAR(f, s_out) &&
+         LOAD_VAR(f, s_sending) &&
+         LOAD_VAR(f, s_receiving) &&
+         LOAD_VAR(f, s_rec_bit) &&
+         LOAD_VAR(f, s_tr_bit) &&
+         LOAD_VAR(f, s_rec_t1) &&
+         LOAD_VAR(f, s_tr_t1) &&
+         LOAD_VAR(f, s_rec_tick) &&
+         LOAD_VAR(f, s_tr_tick) &&
+         LOAD_VAR(f, _mode) &&
+         LOAD_VAR(f, _bmREN) &&
+         LOAD_VAR(f, _bmSMOD) &&
+         LOAD_VAR(f, _bits) &&
+         LOAD_VAR(f, _divby));
+}
+
 void
 cl_serial::print_info(class cl_console_base *con)
 {
@@ -476,6 +715,11 @@ cl_serial::print_info(class cl_console_base *con)
   con->dd_printf(" TB8=%c", (sc&bmTB8)?'1':'0');
   con->dd_printf(" irq=%c", (sc&bmTI)?'1':'0');
   con->dd_printf("\n");
+  if (fast || flow)
+    con->dd_printf("Timing %s, flow control %s\n",
+                   fast?"OFF":"ON", (flow || fast)?"ON":"OFF");
+  if (io)
+    io->print_info(con);
   /*con->dd_printf("s_rec_t1=%d s_rec_bit=%d s_rec_tick=%d\n",
                  s_rec_t1, s_rec_bit, s_rec_tick);
   con->dd_printf("s_tr_t1=%d s_tr_bit=%d s_tr_tick=%d\n",
@@ -30,11 +30,35 @@ Software Foundation, 59 Temple Place - Suite 330, Boston, MA
 
 #include "stypes.h"
 #include "pobjcl.h"
+#include "optioncl.h"
 #include "uccl.h"
 
 //#include "newcmdcl.h"
 
 
+class cl_serial;
+
+// Reference to serial_in_file/serial_out_file, reconnects the uart when
+// the option gets a new file
+class cl_serial_file_option: public cl_optref
+{
+protected:
+  class cl_serial *serial;
+public:
+  cl_serial_file_option(class cl_serial *the_serial);
+  virtual void option_changed(void);
+};
+
+// Reference to serial_fast/serial_flow
+class cl_serial_mode_option: public cl_optref
+{
+protected:
+  class cl_serial *serial;
+public:
+  cl_serial_mode_option(class cl_serial *the_serial);
+  virtual void option_changed(void);
+};
+
 class cl_serial: public cl_hw
 {
 protected:
@@ -45,10 +69,15 @@ protected:
   struct termios saved_attributes_in; // Attributes of serial interface
   struct termios saved_attributes_out;
 #endif
-  class cl_optref *serial_in_file_option;
-  class cl_optref *serial_out_file_option;
+  class cl_serial_file_option *serial_in_file_option;
+  class cl_serial_file_option *serial_out_file_option;
   FILE *serial_in;      // Serial line input
   FILE *serial_out;     // Serial line output
+  class cl_serial_mode_option *serial_fast_option;
+  class cl_serial_mode_option *serial_flow_option;
+  class cl_serial_io *io;       // Socket or pty, used instead of the files
+  bool  fast;           // Characters are moved without baud rate timing
+  bool  flow;           // Receiver waits until RI is cleared
   uchar s_in;           // Serial channel input reg
   uchar s_out;          // Serial channel output reg
   bool  s_sending;      // Transmitter is working
@@ -68,7 +97,15 @@ public:
   cl_serial(class cl_uc *auc);
   virtual ~cl_serial(void);
   virtual int init(void);
+  virtual void files_changed(void);
+  virtual void modes_changed(void);
+protected:
+  virtual void setup_files(bool verbose);
+  virtual void setup_io(void);
+  virtual bool rx_ready(void);
+public:
 
+  virtual bool connect(class cl_hw *other);
   virtual void new_hw_added(class cl_hw *new_hw);
   virtual void added_to_uc(void);
   virtual t_mem read(class cl_memory_cell *cell);
@@ -80,9 +117,13 @@ public:
   virtual void received(int c);
 
   virtual int tick(int cycles);
+  virtual long wakeup_in(void);
   virtual void reset(void);
   virtual void happen(class cl_hw *where, enum hw_event he, void *params);
 
+  virtual bool save_state(FILE *f);
+  virtual bool load_state(FILE *f);
+
   virtual void print_info(class cl_console_base *con);
 };
 
@@ -0,0 +1,362 @@
+/*
+ * Simulator of microcontrollers (serialio.cc)
+ */
+
+/* This file is part of microcontroller simulator: ucsim.
+
+UCSIM is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+UCSIM is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with UCSIM; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA. */
+/*@1@*/
+
+
+#include "ddconfig.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <fcntl.h>
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#ifdef HAVE_TERMIOS_H
+#include <termios.h>
+#endif
+#endif
+#include "i_string.h"
+
+// cmd.src
+#include "newcmdcl.h"
+
+// sim.src
+#include "simcl.h"
+
+// local
+#include "serialiocl.h"
+
+
+cl_serial_io::cl_serial_io(void):
+  cl_base()
+{
+  fd= listen_fd= -1;
+  path= pty_name= 0;
+  rx= tx= 0;
+  rx_in= rx_out= tx_in= tx_out= 0;
+  rx_total= tx_total= 0;
+  cycles= 0;
+}
+
+cl_serial_io::~cl_serial_io(void)
+{
+  disconnect();
+#ifndef _WIN32
+  if (listen_fd >= 0)
+    close(listen_fd);
+  if (path)
+    ::unlink(path);
+#endif
+  if (path)
+    free(path);
+  if (pty_name)
+    free(pty_name);
+  if (rx)
+    free(rx);
+  if (tx)
+    free(tx);
+}
+
+int
+cl_serial_io::init(void)
+{
+  cl_base::init();
+  set_name("serial_io");
+  rx= (unsigned char *)malloc(SIO_RING_SIZE);
+  tx= (unsigned char *)malloc(SIO_RING_SIZE);
+  return(0);
+}
+
+#ifndef _WIN32
+static void
+set_nonblock(int fd)
+{
+  int i;
+
+  if ((i= fcntl(fd, F_GETFL, 0)) >= 0)
+    fcntl(fd, F_SETFL, i | O_NONBLOCK);
+}
+#endif
+
+/* Listen on a Unix domain socket, one peer can be connected at a time,
+   an other one is accepted when it disconnects */
+
+bool
+cl_serial_io::open_unix(const char *socket_path)
+{
+#ifndef _WIN32
+  struct sockaddr_un a;
+  int s;
+
+  if (strlen(socket_path) >= sizeof(a.sun_path))
+    {
+      fprintf(stderr, "Socket name `%s' is too long\n", socket_path);
+      return(DD_FALSE);
+    }
+  if ((s= socket(AF_UNIX, SOCK_STREAM, 0)) < 0)
+    {
+      perror("socket");
+      return(DD_FALSE);
+    }
+  memset(&a, 0, sizeof(a));
+  a.sun_family= AF_UNIX;
+  strcpy(a.sun_path, socket_path);
+  ::unlink(socket_path);
+  if (bind(s, (struct sockaddr *)&a, sizeof(a)) < 0 ||
+      listen(s, 1) < 0)
+    {
+      fprintf(stderr, "Listen on `%s': %s\n", socket_path, strerror(errno));
+      close(s);
+      return(DD_FALSE);
+    }
+  set_nonblock(s);
+  listen_fd= s;
+  path= strdup(socket_path);
+  fprintf(stderr, "Listening on %s for a serial connection.\n", socket_path);
+  return(DD_TRUE);
+#else
+  fprintf(stderr, "Unix sockets are not supported on this platform\n");
+  return(DD_FALSE);
+#endif
+}
+
+/* Pseudo terminal in raw mode, name of the slave side is printed and
+   linked to `link' if it is not empty */
+
+bool
+cl_serial_io::open_pty(const char *link)
+{
+#if !defined(_WIN32) && defined(HAVE_TERMIOS_H)
+  struct termios t;
+  char *name;
+  int m;
+
+  if ((m= posix_openpt(O_RDWR | O_NOCTTY)) < 0 ||
+      grantpt(m) < 0 ||
+      unlockpt(m) < 0 ||
+      (name= ptsname(m)) == NULL)
+    {
+      perror("pty");
+      if (m >= 0)
+        close(m);
+      return(DD_FALSE);
+    }
+  if (tcgetattr(m, &t) == 0)
+    {
+      cfmakeraw(&t);
+      tcsetattr(m, TCSANOW, &t);
+    }
+  set_nonblock(m);
+  fd= m;
+  pty_name= strdup(name);
+  if (link &&
+      *link)
+    {
+      ::unlink(link);
+      if (symlink(name, link) < 0)
+        fprintf(stderr, "Link `%s': %s\n", link, strerror(errno));
+      else
+        path= strdup(link);
+    }
+  fprintf(stderr, "Serial line is on %s\n", name);
+  return(DD_TRUE);
+#else
+  fprintf(stderr, "Pseudo terminals are not supported on this platform\n");
+  return(DD_FALSE);
+#endif
+}
+
+void
+cl_serial_io::disconnect(void)
+{
+#ifndef _WIN32
+  if (fd >= 0)
+    close(fd);
+#endif
+  fd= -1;
+}
+
+/* Moves as much data between the rings and the fd as possible without
+   blocking. Reading stops when the receive ring is full, so a fast
+   sender is stopped by the socket itself. */
+
+void
+cl_serial_io::poll(void)
+{
+#ifndef _WIN32
+  unsigned int i, n;
+  int r;
+
+  cycles= 0;
+  if (fd < 0 &&
+      listen_fd >= 0)
+    {
+      if ((fd= accept(listen_fd, NULL, NULL)) >= 0)
+        set_nonblock(fd);
+    }
+  if (fd < 0)
+    return;
+  while (tx_in != tx_out)
+    {
+      i= tx_out & (SIO_RING_SIZE-1);
+      n= tx_in - tx_out;
+      if (n > SIO_RING_SIZE - i)
+        n= SIO_RING_SIZE - i;
+#ifdef MSG_NOSIGNAL
+      if (listen_fd >= 0)
+        r= send(fd, tx + i, n, MSG_NOSIGNAL);
+      else
+#endif
+        r= write(fd, tx + i, n);
+      if (r > 0)
+        {
+          tx_out+= r;
+          continue;
+        }
+      if (r < 0 &&
+          errno == EINTR)
+        continue;
+      if (r < 0 &&
+          errno != EAGAIN &&
+          errno != EWOULDBLOCK &&
+          listen_fd >= 0)
+        {
+          // Peer is gone, data remains for the next one
+          disconnect();
+          return;
+        }
+      break;
+    }
+  while (rx_in - rx_out < SIO_RING_SIZE)
+    {
+      i= rx_in & (SIO_RING_SIZE-1);
+      n= SIO_RING_SIZE - (rx_in - rx_out);
+      if (n > SIO_RING_SIZE - i)
+        n= SIO_RING_SIZE - i;
+      r= ::read(fd, rx + i, n);
+      if (r > 0)
+        {
+          rx_in+= r;
+          rx_total+= r;
+          continue;
+        }
+      if (r < 0 &&
+          errno == EINTR)
+        continue;
+      // End of file of a socket, pty gives EIO while slave is closed
+      if (r == 0 &&
+          listen_fd >= 0)
+        disconnect();
+      break;
+    }
+#endif
+}
+
+void
+cl_serial_io::print_info(class cl_console_base *con)
+{
+  if (listen_fd >= 0)
+    con->dd_printf("Unix socket %s, %s\n", path,
+                   (fd >= 0)?"connected":"waiting for connection");
+  else if (pty_name)
+    con->dd_printf("Pseudo terminal %s\n", pty_name);
+  con->dd_printf("Received %lu bytes, %u in buffer; "
+                 "sent %lu bytes, %u in buffer\n",
+                 rx_total, rx_in - rx_out, tx_total, tx_in - tx_out);
+}
+
+
+/*
+ * Serial line between controllers
+ */
+
+cl_serial_link::cl_serial_link(class cl_uc *auc):
+  cl_serial_io()
+{
+  uc= auc;
+  peer= 0;
+  in= 0;
+  in_stamp= 0;
+  in_in= in_out= 0;
+}
+
+cl_serial_link::~cl_serial_link(void)
+{
+  if (peer)
+    peer->peer= 0;
+  if (in)
+    free(in);
+  if (in_stamp)
+    free(in_stamp);
+}
+
+int
+cl_serial_link::init(void)
+{
+  cl_serial_io::init();
+  set_name("serial_link");
+  in= (unsigned char *)malloc(SIO_RING_SIZE);
+  in_stamp= (unsigned long *)malloc(SIO_RING_SIZE * sizeof(unsigned long));
+  return(0);
+}
+
+void
+cl_serial_link::poll(void)
+{
+  unsigned long now= uc->sim->quanta;
+  unsigned int i;
+
+  cycles= 0;
+  if (!peer)
+    return;
+  while (tx_in != tx_out &&
+         peer->in_in - peer->in_out < SIO_RING_SIZE)
+    {
+      i= peer->in_in++ & (SIO_RING_SIZE-1);
+      peer->in[i]= tx[tx_out++ & (SIO_RING_SIZE-1)];
+      peer->in_stamp[i]= now;
+    }
+  while (in_in != in_out &&
+         in_stamp[in_out & (SIO_RING_SIZE-1)] < now &&
+         rx_in - rx_out < SIO_RING_SIZE)
+    {
+      rx[rx_in++ & (SIO_RING_SIZE-1)]= in[in_out++ & (SIO_RING_SIZE-1)];
+      rx_total++;
+    }
+}
+
+void
+cl_serial_link::print_info(class cl_console_base *con)
+{
+  if (peer)
+    con->dd_printf("Linked to controller %d, %u bytes on the line\n",
+                   peer->uc->core_id, peer->in_in - peer->in_out);
+  else
+    con->dd_printf("Link is broken\n");
+  cl_serial_io::print_info(con);
+}
+
+
+/* End of s51.src/serialio.cc */
@@ -0,0 +1,110 @@
+/*
+ * Simulator of microcontrollers (serialiocl.h)
+ */
+
+/* This file is part of microcontroller simulator: ucsim.
+
+UCSIM is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+UCSIM is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with UCSIM; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA. */
+/*@1@*/
+
+
+#ifndef SERIALIOCL_HEADER
+#define SERIALIOCL_HEADER
+
+#include "stypes.h"
+#include "pobjcl.h"
+
+
+#define SIO_RING_SIZE   0x10000 // Size of both rings, must be power of 2
+#define SIO_POLL_CYCLES 256     // Machine cycles between system calls
+
+
+/* Host side of the serial line on a Unix domain socket or a pseudo
+   terminal. Received bytes are read in chunks into a ring and fed to the
+   uart from there, bytes sent by the uart are collected in an other
+   ring and written out when the fd accepts them. The fds are non-
+   blocking and polled in every SIO_POLL_CYCLES machine cycles only, so
+   the simulation is never stopped by the host side. */
+
+class cl_serial_io: public cl_base
+{
+protected:
+  int fd;               // Connected peer or pty master, -1 if none
+  int listen_fd;        // Unix socket waiting for peer, -1 if none
+  char *path;           // Socket or link to the pty, removed at end
+  char *pty_name;       // Slave side of the pty
+  unsigned char *rx, *tx;
+  unsigned int rx_in, rx_out, tx_in, tx_out;    // Free running indexes
+  unsigned long rx_total, tx_total;
+  int cycles;           // Since the last poll
+public:
+  cl_serial_io(void);
+  virtual ~cl_serial_io(void);
+  virtual int init(void);
+
+  virtual bool open_unix(const char *socket_path);
+  virtual bool open_pty(const char *link);
+
+  // Called by the uart
+  void tick(int ncycles)
+  {
+    if ((cycles+= ncycles) >= SIO_POLL_CYCLES)
+      poll();
+  }
+  int rx_avail(void) { return(rx_in - rx_out); }
+  int get(void) { return(rx[rx_out++ & (SIO_RING_SIZE-1)]); }
+  bool tx_full(void) { return(tx_in - tx_out >= SIO_RING_SIZE); }
+  void put(int c)
+  {
+    tx[tx_in++ & (SIO_RING_SIZE-1)]= c;
+    tx_total++;
+  }
+
+  virtual void poll(void);
+  virtual void print_info(class cl_console_base *con);
+
+protected:
+  virtual void disconnect(void);
+};
+
+
+/* One end of a serial line between two co-simulated controllers. Bytes
+   sent are stamped with the number of the actual time slice (see
+   cl_sim::step_cores()) and the other end receives them in a later
+   slice only, so the transfer does not depend on the order in which
+   the controllers run. */
+
+class cl_serial_link: public cl_serial_io
+{
+protected:
+  class cl_uc *uc;
+  class cl_serial_link *peer;
+  unsigned char *in;            // Bytes sent by the peer
+  unsigned long *in_stamp;      // Slices they were sent in
+  unsigned int in_in, in_out;   // Free running indexes
+public:
+  cl_serial_link(class cl_uc *auc);
+  virtual ~cl_serial_link(void);
+  virtual int init(void);
+
+  virtual void connect(class cl_serial_link *the_peer) { peer= the_peer; }
+  virtual void poll(void);
+  virtual void print_info(class cl_console_base *con);
+};
+
+#endif
+
+/* End of s51.src/serialiocl.h */
@@ -56,24 +56,33 @@ cl_sim51::cl_sim51(class cl_app *the_app):
 class cl_uc *
 cl_sim51::mk_controller(void)
 {
-  int i;
   const char *typ= NIL;
   class cl_optref type_option(this);
+  class cl_uc *c;
 
   type_option.init();
   type_option.use("cpu_type");
-  i= 0;
   if ((typ= type_option.get_value(typ)) == NIL)
     typ= "C51";
+  if ((c= mk_core(typ)) == NULL)
+    fprintf(stderr, "Unknown processor type. "
+	    "Use -H option to see known types.\n");
+  return(c);
+}
+
+class cl_uc *
+cl_sim51::mk_core(const char *typ)
+{
+  int i;
+
+  if (typ == NULL)
+    return(mk_controller());
+  i= 0;
   while ((cpus_51[i].type_str != NULL) &&
 	 (strcmp(typ, cpus_51[i].type_str) != 0))
     i++;
   if (cpus_51[i].type_str == NULL)
-    {
-      fprintf(stderr, "Unknown processor type. "
-	      "Use -H option to see known types.\n");
-      return(NULL);
-    }
+    return(NULL);
   switch (cpus_51[i].type)
     {
     case CPU_51: case CPU_31:
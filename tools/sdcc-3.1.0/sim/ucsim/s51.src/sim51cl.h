@@ -37,6 +37,7 @@ public:
   cl_sim51(class cl_app *the_app);
   //virtual int proc_arg(char optopt, char *optarg);
   virtual class cl_uc *mk_controller(void);
+  virtual class cl_uc *mk_core(const char *type);
 };
 
 
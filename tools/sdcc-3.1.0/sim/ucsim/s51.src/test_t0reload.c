@@ -0,0 +1,44 @@
+#include <reg51.h>
+
+/* Timer #0 in mode 1 reloads TH0 only, overflowing every 0x1000 cycles.
+   Main polls the uart, so the simulator can skip the idle loop. The
+   result is left in P1: 0 if the number of overflows is right. */
+
+#define CHARS 64
+/* 10 bits of 96 cycles each (TH1=0xfd, SMOD=0) */
+#define CHAR_CYCLES 960
+
+volatile unsigned char t0cnt;
+
+void t0_it(void) interrupt 1
+{
+  TH0= 0xf0;
+  t0cnt++;
+}
+
+void main(void)
+{
+  unsigned char i, expected;
+
+  TMOD= 0x21;
+  TH1= 0xfd;
+  TR1= 1;
+  SCON= 0x40;
+  TL0= 0;
+  TH0= 0xf0;
+  ET0= 1;
+  EA= 1;
+  TR0= 1;
+  for (i= 0; i < CHARS; i++)
+    {
+      SBUF= 'A';
+      while (!TI)
+        ;
+      TI= 0;
+    }
+  TR0= 0;
+  expected= (unsigned long)CHARS * CHAR_CYCLES / 0x1000;
+  P1= (t0cnt >= expected-1 && t0cnt <= expected+1)?0:t0cnt;
+  for (;;)
+    ;
+}
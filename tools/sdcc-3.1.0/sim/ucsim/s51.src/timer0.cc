@@ -25,6 +25,10 @@ Software Foundation, 59 Temple Place - Suite 330, Boston, MA
 02111-1307, USA. */
 /*@1@*/
 
+// prj
+#include "utils.h"
+
+// local
 #include "timer0cl.h"
 #include "regs51.h"
 #include "types51.h"
@@ -105,8 +109,9 @@ cl_timer0::init(void)
         }
       //cell_tl= sfr->get_cell(addr_tl);
       //cell_th= sfr->get_cell(addr_th);
-      use_cell(sfr, addr_tl, &cell_tl, wtd_restore);
-      use_cell(sfr, addr_th, &cell_th, wtd_restore);
+      // reading the counter syncs the timer, see wakeup_in()
+      register_cell(sfr, addr_tl, &cell_tl, wtd_restore_write);
+      register_cell(sfr, addr_th, &cell_th, wtd_restore_write);
     }
   return(0);
 }
@@ -182,6 +187,33 @@ cl_timer0::tick(int cycles)
   return(resGO);
 }
 
+/* Stopped timer does not count, except TH0 in mode 3 which runs by TR1.
+   A timer counting machine cycles is due at its overflow, counters and
+   gated timers depend on the pins. */
+
+long
+cl_timer0::wakeup_in(void)
+{
+  t_mem tl, th;
+
+  if (!TR &&
+      mode != 3)
+    return(-1);
+  if (mode == 3 ||
+      GATE ||
+      C_T)
+    return(0);
+  tl= cell_tl->get();
+  th= cell_th->get();
+  switch (mode)
+    {
+    case 0: return((0xff - th) * 32 + 32 - (tl & 0x1f));
+    case 1: return(0x10000 - ((th << 8) | tl));
+    case 2: return(0x100 - tl);
+    }
+  return(0);
+}
+
 int
 cl_timer0::do_mode0(int cycles)
 {
@@ -369,6 +401,30 @@ cl_timer0::happen(class cl_hw *where, enum hw_event he, void *params)
     }
 }
 
+bool
+cl_timer0::save_state(FILE *f)
+{
+  return(cl_hw::save_state(f) &&
+         SAVE_VAR(f, mode) &&
+         SAVE_VAR(f, GATE) &&
+         SAVE_VAR(f, C_T) &&
+         SAVE_VAR(f, TR) &&
+         SAVE_VAR(f, INT) &&
+         SAVE_VAR(f, T_edge));
+}
+
+bool
+cl_timer0::load_state(FILE *f)
+{
+  return(cl_hw::load_state(f) &&
+         LOAD_VAR(f, mode) &&
+         LOAD_VAR(f, GATE) &&
+         LOAD_VAR(f, C_T) &&
+         LOAD_VAR(f, TR) &&
+         LOAD_VAR(f, INT) &&
+         LOAD_VAR(f, T_edge));
+}
+
 void
 cl_timer0::print_info(class cl_console_base *con)
 {
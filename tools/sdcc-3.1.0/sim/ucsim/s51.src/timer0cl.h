@@ -57,6 +57,7 @@ public:
   //virtual void mem_cell_changed(class cl_mem *mem, t_addr addr);
 
   virtual int tick(int cycles);
+  virtual long wakeup_in(void);
   virtual int do_mode0(int cycles);
   virtual int do_mode1(int cycles);
   virtual int do_mode2(int cycles);
@@ -64,6 +65,9 @@ public:
   virtual void overflow(void);
   virtual void happen(class cl_hw *where, enum hw_event he, void *params);
 
+  virtual bool save_state(FILE *f);
+  virtual bool load_state(FILE *f);
+
   virtual void print_info(class cl_console_base *con);
 };
 
@@ -25,6 +25,10 @@ Software Foundation, 59 Temple Place - Suite 330, Boston, MA
 02111-1307, USA. */
 /*@1@*/
 
+// prj
+#include "utils.h"
+
+// local
 #include "timer2cl.h"
 #include "regs51.h"
 #include "types51.h"
@@ -388,6 +392,34 @@ cl_timer2::happen(class cl_hw *where, enum hw_event he, void *params)
     }
 }
 
+bool
+cl_timer2::save_state(FILE *f)
+{
+  return(cl_timer0::save_state(f) &&
+         SAVE_VAR(f, RCLK) &&
+         SAVE_VAR(f, TCLK) &&
+         SAVE_VAR(f, CP_RL2) &&
+         SAVE_VAR(f, EXEN2) &&
+         SAVE_VAR(f, t2ex_edge) &&
+         SAVE_VAR(f, bit_dcen) &&
+         SAVE_VAR(f, bit_t2oe) &&
+         SAVE_VAR(f, bit_t2ex));
+}
+
+bool
+cl_timer2::load_state(FILE *f)
+{
+  return(cl_timer0::load_state(f) &&
+         LOAD_VAR(f, RCLK) &&
+         LOAD_VAR(f, TCLK) &&
+         LOAD_VAR(f, CP_RL2) &&
+         LOAD_VAR(f, EXEN2) &&
+         LOAD_VAR(f, t2ex_edge) &&
+         LOAD_VAR(f, bit_dcen) &&
+         LOAD_VAR(f, bit_t2oe) &&
+         LOAD_VAR(f, bit_t2ex));
+}
+
 void
 cl_timer2::print_info(class cl_console_base *con)
 {
@@ -75,6 +75,7 @@ public:
   //virtual void mem_cell_changed(class cl_mem *mem, t_addr addr);
 
   virtual int  tick(int cycles);
+  virtual long wakeup_in(void) { return(0); }
   virtual int  do_t2_baud(int cycles);
   virtual void do_t2_capture(int cycles);
   virtual void do_t2_reload(int cycles);
@@ -82,6 +83,9 @@ public:
   virtual void do_t2_clock_out(int cycles);
   virtual void happen(class cl_hw *where, enum hw_event he, void *params);
   
+  virtual bool save_state(FILE *f);
+  virtual bool load_state(FILE *f);
+
   virtual void print_info(class cl_console_base *con);
 };
 
@@ -30,6 +30,9 @@ Software Foundation, 59 Temple Place - Suite 330, Boston, MA
 #include <stdio.h>
 #include <stdlib.h>
 
+// prj
+#include "utils.h"
+
 // local
 #include "uc390hwcl.h"
 #include "regs51.h"
@@ -272,6 +275,24 @@ cl_uc390_hw::reset(void)
   timed_access_state = 0;
 }
 
+bool
+cl_uc390_hw::save_state(FILE *f)
+{
+  return (cl_hw::save_state (f) &&
+          SAVE_VAR (f, ctm_ticks) &&
+          SAVE_VAR (f, timed_access_ticks) &&
+          SAVE_VAR (f, timed_access_state));
+}
+
+bool
+cl_uc390_hw::load_state(FILE *f)
+{
+  return (cl_hw::load_state (f) &&
+          LOAD_VAR (f, ctm_ticks) &&
+          LOAD_VAR (f, timed_access_ticks) &&
+          LOAD_VAR (f, timed_access_state));
+}
+
 void
 cl_uc390_hw::print_info(class cl_console_base *con)
 {
@@ -55,6 +55,9 @@ public:
   //virtual void mem_cell_changed (class cl_mem *mem, t_addr addr);
 
   virtual void reset (void);
+  virtual bool save_state (FILE *f);
+  virtual bool load_state (FILE *f);
+
   virtual void print_info (class cl_console_base *con);
 };
 
@@ -105,6 +105,7 @@ cl_51core::cl_51core(int Itype, int Itech, class cl_sim *asim):
 
   irq_stop_option= new cl_irq_stop_option(this);
   stop_at_it= DD_FALSE;
+  make_itab();
 }
 
 
@@ -457,6 +458,135 @@ cl_51core::print_regs(class cl_console_base *con)
   print_disass(PC, con);
 }
 
+/* Registers for remote debuggers: R0-R7 of the selected bank, ACC, B,
+   DPL, DPH, SP, PSW and PC */
+
+static const t_addr dbg_sfrs[6]= { ACC, B, DPL, DPH, SP, PSW };
+
+t_mem
+cl_51core::dbg_get_reg(int nr)
+{
+  if (nr < 8)
+    return(get_reg(nr)->get());
+  if (nr < 14)
+    return(sfr->get(dbg_sfrs[nr-8]));
+  return(PC);
+}
+
+void
+cl_51core::dbg_set_reg(int nr, t_mem val)
+{
+  if (nr < 8)
+    get_reg(nr)->write(val);
+  else if (nr < 14)
+    sfr->write(dbg_sfrs[nr-8], val);
+  else
+    PC= val & 0xffff;
+}
+
+
+/*
+ * Idle loops
+ *
+ * The loop may only read bits, registers, internal RAM and the bit
+ * addressable SFRs (flags and ports, which change only by hw events) and
+ * may only write A and C, from the values it reads. Timer and serial
+ * data registers are not bit addressable so polling them is never
+ * skipped.
+ */
+
+static bool
+idle_direct(t_mem addr)
+{
+  return(addr < 0x80 ||
+         (addr & 7) == 0);
+}
+
+bool
+cl_51core::idle_loop(t_addr end)
+{
+  struct t_decoded_inst *d;
+  t_addr start, addr;
+  t_mem code;
+  int len;
+
+  // branch closing the loop
+  code= rom->get(end);
+  switch (code)
+    {
+    case 0x80: case 0x40: case 0x50: case 0x60: case 0x70:
+      // SJMP, JC, JNC, JZ, JNZ
+      len= 2;
+      break;
+    case 0x20: case 0x30: case 0xb4: case 0xb6: case 0xb7:
+      // JB, JNB, CJNE
+      len= 3;
+      break;
+    case 0xb5:
+      if (!idle_direct(rom->get(end+1)))
+        return(DD_FALSE);
+      len= 3;
+      break;
+    default:
+      if ((code & 0xf8) != 0xb8)
+        return(DD_FALSE);
+      len= 3;
+      break;
+    }
+  start= end + len + (signed char)(rom->get(end + len - 1));
+  if (start > end ||
+      end - start >= IDLE_LOOP_SIZE)
+    return(DD_FALSE);
+
+  for (addr= start; addr <= end; addr+= len)
+    {
+      if (!(d= decoded_at(addr)) ||
+          (d->flags & DECODED_SLOW))
+        return(DD_FALSE);
+      if (addr == end)
+        return(DD_TRUE);
+      code= rom->get(addr);
+      switch (code)
+        {
+        case 0x80: case 0x40: case 0x50: case 0x60: case 0x70:
+        case 0xa2: case 0x82: case 0x72: case 0x54: case 0x44:
+          // jumps, MOV/ANL/ORL C,bit, ANL/ORL A,#data
+          len= 2;
+          break;
+        case 0x20: case 0x30: case 0xb4: case 0xb6: case 0xb7:
+          // JB, JNB, CJNE
+          len= 3;
+          break;
+        case 0xe6: case 0xe7:
+          // MOV A,@Ri
+          len= 1;
+          break;
+        case 0xe5:
+          // MOV A,direct
+          if (!idle_direct(rom->get(addr+1)))
+            return(DD_FALSE);
+          len= 2;
+          break;
+        case 0xb5:
+          // CJNE A,direct,rel
+          if (!idle_direct(rom->get(addr+1)))
+            return(DD_FALSE);
+          len= 3;
+          break;
+        default:
+          if ((code & 0xf8) == 0xe8)
+            len= 1; // MOV A,Rn
+          else if ((code & 0xf8) == 0xb8)
+            len= 3; // CJNE Rn,#data,rel
+          else
+            return(DD_FALSE);
+          break;
+        }
+    }
+  // an instruction overlaps the branch
+  return(DD_FALSE);
+}
+
 
 /*
  * Converting bit address into real memory
@@ -535,6 +665,26 @@ cl_51core::reset(void)
   //was_reti= DD_FALSE;
 }
 
+bool
+cl_51core::save_state(FILE *f)
+{
+  return(cl_uc::save_state(f) &&
+         SAVE_VAR(f, prev_p1) &&
+         SAVE_VAR(f, prev_p3) &&
+         SAVE_VAR(f, p3_int0_edge) &&
+         SAVE_VAR(f, p3_int1_edge));
+}
+
+bool
+cl_51core::load_state(FILE *f)
+{
+  return(cl_uc::load_state(f) &&
+         LOAD_VAR(f, prev_p1) &&
+         LOAD_VAR(f, prev_p3) &&
+         LOAD_VAR(f, p3_int0_edge) &&
+         LOAD_VAR(f, p3_int1_edge));
+}
+
 
 /*
  * Setting up SFR area to reset value
@@ -570,8 +720,10 @@ cl_51core::clear_sfr(void)
   sfr->write(SCON, 0);
   sfr->write(PCON, 0);
 
+#ifdef STATISTIC
   sfr->set_nuof_writes(0);
   sfr->set_nuof_reads(0);
+#endif
 }
 
 
@@ -688,6 +840,173 @@ cl_51core::get_reg(uchar regnum)
 }
 
 
+/*
+ * Table of instruction handlers, indexed by opcode
+ */
+
+cl_51core::t_inst51 cl_51core::itab[256];
+bool cl_51core::itab_made= DD_FALSE;
+
+void
+cl_51core::make_itab(void)
+{
+  int code;
+
+  if (itab_made)
+    return;
+  for (code= 0; code < 256; code++)
+    switch (code)
+      {
+      case 0x00: itab[code]= &cl_51core::inst_nop; break;
+      case 0x01: case 0x21: case 0x41: case 0x61:
+      case 0x81: case 0xa1: case 0xc1: case 0xe1:itab[code]= &cl_51core::inst_ajmp_addr;break;
+      case 0x02: itab[code]= &cl_51core::inst_ljmp; break;
+      case 0x03: itab[code]= &cl_51core::inst_rr; break;
+      case 0x04: itab[code]= &cl_51core::inst_inc_a; break;
+      case 0x05: itab[code]= &cl_51core::inst_inc_addr; break;
+      case 0x06: case 0x07: itab[code]= &cl_51core::inst_inc_Sri; break;
+      case 0x08: case 0x09: case 0x0a: case 0x0b:
+      case 0x0c: case 0x0d: case 0x0e: case 0x0f: itab[code]= &cl_51core::inst_inc_rn; break;
+      case 0x10: itab[code]= &cl_51core::inst_jbc_bit_addr; break;
+      case 0x11: case 0x31: case 0x51: case 0x71:
+      case 0x91: case 0xb1: case 0xd1: case 0xf1:itab[code]= &cl_51core::inst_acall_addr;break;
+      case 0x12: itab[code]= &cl_51core::inst_lcall_addr; break;
+      case 0x13: itab[code]= &cl_51core::inst_rrc; break;
+      case 0x14: itab[code]= &cl_51core::inst_dec_a; break;
+      case 0x15: itab[code]= &cl_51core::inst_dec_addr; break;
+      case 0x16: case 0x17: itab[code]= &cl_51core::inst_dec_Sri; break;
+      case 0x18: case 0x19: case 0x1a: case 0x1b:
+      case 0x1c: case 0x1d: case 0x1e: case 0x1f: itab[code]= &cl_51core::inst_dec_rn; break;
+      case 0x20: itab[code]= &cl_51core::inst_jb_bit_addr; break;
+      case 0x22: itab[code]= &cl_51core::inst_ret; break;
+      case 0x23: itab[code]= &cl_51core::inst_rl; break;
+      case 0x24: itab[code]= &cl_51core::inst_add_a_Sdata; break;
+      case 0x25: itab[code]= &cl_51core::inst_add_a_addr; break;
+      case 0x26: case 0x27: itab[code]= &cl_51core::inst_add_a_Sri; break;
+      case 0x28: case 0x29: case 0x2a: case 0x2b:
+      case 0x2c: case 0x2d: case 0x2e: case 0x2f:itab[code]= &cl_51core::inst_add_a_rn;break;
+      case 0x30: itab[code]= &cl_51core::inst_jnb_bit_addr; break;
+      case 0x32: itab[code]= &cl_51core::inst_reti; break;
+      case 0x33: itab[code]= &cl_51core::inst_rlc; break;
+      case 0x34: itab[code]= &cl_51core::inst_addc_a_Sdata; break;
+      case 0x35: itab[code]= &cl_51core::inst_addc_a_addr; break;
+      case 0x36: case 0x37: itab[code]= &cl_51core::inst_addc_a_Sri; break;
+      case 0x38: case 0x39: case 0x3a: case 0x3b:
+      case 0x3c: case 0x3d: case 0x3e: case 0x3f:itab[code]= &cl_51core::inst_addc_a_rn;break;
+      case 0x40: itab[code]= &cl_51core::inst_jc_addr; break;
+      case 0x42: itab[code]= &cl_51core::inst_orl_addr_a; break;
+      case 0x43: itab[code]= &cl_51core::inst_orl_addr_Sdata; break;
+      case 0x44: itab[code]= &cl_51core::inst_orl_a_Sdata; break;
+      case 0x45: itab[code]= &cl_51core::inst_orl_a_addr; break;
+      case 0x46: case 0x47: itab[code]= &cl_51core::inst_orl_a_Sri; break;
+      case 0x48: case 0x49: case 0x4a: case 0x4b:
+      case 0x4c: case 0x4d: case 0x4e: case 0x4f: itab[code]= &cl_51core::inst_orl_a_rn;break;
+      case 0x50: itab[code]= &cl_51core::inst_jnc_addr; break;
+      case 0x52: itab[code]= &cl_51core::inst_anl_addr_a; break;
+      case 0x53: itab[code]= &cl_51core::inst_anl_addr_Sdata; break;
+      case 0x54: itab[code]= &cl_51core::inst_anl_a_Sdata; break;
+      case 0x55: itab[code]= &cl_51core::inst_anl_a_addr; break;
+      case 0x56: case 0x57: itab[code]= &cl_51core::inst_anl_a_Sri; break;
+      case 0x58: case 0x59: case 0x5a: case 0x5b:
+      case 0x5c: case 0x5d: case 0x5e: case 0x5f: itab[code]= &cl_51core::inst_anl_a_rn;break;
+      case 0x60: itab[code]= &cl_51core::inst_jz_addr; break;
+      case 0x62: itab[code]= &cl_51core::inst_xrl_addr_a; break;
+      case 0x63: itab[code]= &cl_51core::inst_xrl_addr_Sdata; break;
+      case 0x64: itab[code]= &cl_51core::inst_xrl_a_Sdata; break;
+      case 0x65: itab[code]= &cl_51core::inst_xrl_a_addr; break;
+      case 0x66: case 0x67: itab[code]= &cl_51core::inst_xrl_a_Sri; break;
+      case 0x68: case 0x69: case 0x6a: case 0x6b:
+      case 0x6c: case 0x6d: case 0x6e: case 0x6f: itab[code]= &cl_51core::inst_xrl_a_rn;break;
+      case 0x70: itab[code]= &cl_51core::inst_jnz_addr; break;
+      case 0x72: itab[code]= &cl_51core::inst_orl_c_bit; break;
+      case 0x73: itab[code]= &cl_51core::inst_jmp_Sa_dptr; break;
+      case 0x74: itab[code]= &cl_51core::inst_mov_a_Sdata; break;
+      case 0x75: itab[code]= &cl_51core::inst_mov_addr_Sdata; break;
+      case 0x76: case 0x77: itab[code]= &cl_51core::inst_mov_Sri_Sdata; break;
+      case 0x78: case 0x79: case 0x7a: case 0x7b: case 0x7c:
+      case 0x7d: case 0x7e: case 0x7f: itab[code]= &cl_51core::inst_mov_rn_Sdata; break;
+      case 0x80: itab[code]= &cl_51core::inst_sjmp; break;
+      case 0x82: itab[code]= &cl_51core::inst_anl_c_bit; break;
+      case 0x83: itab[code]= &cl_51core::inst_movc_a_Sa_pc; break;
+      case 0x84: itab[code]= &cl_51core::inst_div_ab; break;
+      case 0x85: itab[code]= &cl_51core::inst_mov_addr_addr; break;
+      case 0x86: case 0x87: itab[code]= &cl_51core::inst_mov_addr_Sri; break;
+      case 0x88: case 0x89: case 0x8a: case 0x8b:
+      case 0x8c: case 0x8d: case 0x8e: case 0x8f:itab[code]= &cl_51core::inst_mov_addr_rn;break;
+      case 0x90: itab[code]= &cl_51core::inst_mov_dptr_Sdata; break;
+      case 0x92: itab[code]= &cl_51core::inst_mov_bit_c; break;
+      case 0x93: itab[code]= &cl_51core::inst_movc_a_Sa_dptr; break;
+      case 0x94: itab[code]= &cl_51core::inst_subb_a_Sdata; break;
+      case 0x95: itab[code]= &cl_51core::inst_subb_a_addr; break;
+      case 0x96: case 0x97: itab[code]= &cl_51core::inst_subb_a_Sri; break;
+      case 0x98: case 0x99: case 0x9a: case 0x9b:
+      case 0x9c: case 0x9d: case 0x9e: case 0x9f:itab[code]= &cl_51core::inst_subb_a_rn;break;
+      case 0xa0: itab[code]= &cl_51core::inst_orl_c_Sbit; break;
+      case 0xa2: itab[code]= &cl_51core::inst_mov_c_bit; break;
+      case 0xa3: itab[code]= &cl_51core::inst_inc_dptr; break;
+      case 0xa4: itab[code]= &cl_51core::inst_mul_ab; break;
+      case 0xa5: itab[code]= &cl_51core::inst_unknown_code; break;
+      case 0xa6: case 0xa7: itab[code]= &cl_51core::inst_mov_Sri_addr; break;
+      case 0xa8: case 0xa9: case 0xaa: case 0xab:
+      case 0xac: case 0xad: case 0xae: case 0xaf:itab[code]= &cl_51core::inst_mov_rn_addr;break;
+      case 0xb0: itab[code]= &cl_51core::inst_anl_c_Sbit; break;
+      case 0xb2: itab[code]= &cl_51core::inst_cpl_bit; break;
+      case 0xb3: itab[code]= &cl_51core::inst_cpl_c; break;
+      case 0xb4: itab[code]= &cl_51core::inst_cjne_a_Sdata_addr; break;
+      case 0xb5: itab[code]= &cl_51core::inst_cjne_a_addr_addr; break;
+      case 0xb6: case 0xb7: itab[code]= &cl_51core::inst_cjne_Sri_Sdata_addr; break;
+      case 0xb8: case 0xb9: case 0xba: case 0xbb: case 0xbc:
+      case 0xbd: case 0xbe: case 0xbf: itab[code]= &cl_51core::inst_cjne_rn_Sdata_addr; break;
+      case 0xc0: itab[code]= &cl_51core::inst_push; break;
+      case 0xc2: itab[code]= &cl_51core::inst_clr_bit; break;
+      case 0xc3: itab[code]= &cl_51core::inst_clr_c; break;
+      case 0xc4: itab[code]= &cl_51core::inst_swap; break;
+      case 0xc5: itab[code]= &cl_51core::inst_xch_a_addr; break;
+      case 0xc6: case 0xc7: itab[code]= &cl_51core::inst_xch_a_Sri; break;
+      case 0xc8: case 0xc9: case 0xca: case 0xcb:
+      case 0xcc: case 0xcd: case 0xce: case 0xcf: itab[code]= &cl_51core::inst_xch_a_rn;break;
+      case 0xd0: itab[code]= &cl_51core::inst_pop; break;
+      case 0xd2: itab[code]= &cl_51core::inst_setb_bit; break;
+      case 0xd3: itab[code]= &cl_51core::inst_setb_c; break;
+      case 0xd4: itab[code]= &cl_51core::inst_da_a; break;
+      case 0xd5: itab[code]= &cl_51core::inst_djnz_addr_addr; break;
+      case 0xd6: case 0xd7: itab[code]= &cl_51core::inst_xchd_a_Sri; break;
+      case 0xd8: case 0xd9: case 0xda: case 0xdb: case 0xdc:
+      case 0xdd: case 0xde: case 0xdf: itab[code]= &cl_51core::inst_djnz_rn_addr; break;
+      case 0xe0: itab[code]= &cl_51core::inst_movx_a_Sdptr; break;
+      case 0xe2: case 0xe3: itab[code]= &cl_51core::inst_movx_a_Sri; break;
+      case 0xe4: itab[code]= &cl_51core::inst_clr_a; break;
+      case 0xe5: itab[code]= &cl_51core::inst_mov_a_addr; break;
+      case 0xe6: case 0xe7: itab[code]= &cl_51core::inst_mov_a_Sri; break;
+      case 0xe8: case 0xe9: case 0xea: case 0xeb:
+      case 0xec: case 0xed: case 0xee: case 0xef: itab[code]= &cl_51core::inst_mov_a_rn;break;
+      case 0xf0: itab[code]= &cl_51core::inst_movx_Sdptr_a; break;
+      case 0xf2: case 0xf3: itab[code]= &cl_51core::inst_movx_Sri_a; break;
+      case 0xf4: itab[code]= &cl_51core::inst_cpl_a; break;
+      case 0xf5: itab[code]= &cl_51core::inst_mov_addr_a; break;
+      case 0xf6: case 0xf7: itab[code]= &cl_51core::inst_mov_Sri_a; break;
+      case 0xf8: case 0xf9: case 0xfa: case 0xfb:
+      case 0xfc: case 0xfd: case 0xfe: case 0xff: itab[code]= &cl_51core::inst_mov_rn_a;break;
+      default:
+        itab[code]= &cl_51core::inst_unknown_code;
+        break;
+      }
+  itab_made= DD_TRUE;
+}
+
+int
+cl_51core::inst_lcall_addr(uchar code)
+{
+  return(inst_lcall(code, 0, DD_FALSE));
+}
+
+int
+cl_51core::inst_unknown_code(uchar code)
+{
+  return(inst_unknown());
+}
+
+
 /*
  * Fetching one instruction and executing it
  */
@@ -696,152 +1015,14 @@ int
 cl_51core::exec_inst(void)
 {
   t_mem code;
-  int res= resGO;
 
   //pr_inst();
   instPC= PC;
-  if (fetch(&code))
+  if (fetch_inst(&code))
     return(resBREAKPOINT);
   //tick_hw(1);
   tick(1);
-  switch (code)
-    {
-    case 0x00: res= inst_nop(code); break;
-    case 0x01: case 0x21: case 0x41: case 0x61:
-    case 0x81: case 0xa1: case 0xc1: case 0xe1:res=inst_ajmp_addr(code);break;
-    case 0x02: res= inst_ljmp(code); break;
-    case 0x03: res= inst_rr(code); break;
-    case 0x04: res= inst_inc_a(code); break;
-    case 0x05: res= inst_inc_addr(code); break;
-    case 0x06: case 0x07: res= inst_inc_Sri(code); break;
-    case 0x08: case 0x09: case 0x0a: case 0x0b:
-    case 0x0c: case 0x0d: case 0x0e: case 0x0f: res= inst_inc_rn(code); break;
-    case 0x10: res= inst_jbc_bit_addr(code); break;
-    case 0x11: case 0x31: case 0x51: case 0x71:
-    case 0x91: case 0xb1: case 0xd1: case 0xf1:res=inst_acall_addr(code);break;
-    case 0x12: res= inst_lcall(code, 0, DD_FALSE); break;
-    case 0x13: res= inst_rrc(code); break;
-    case 0x14: res= inst_dec_a(code); break;
-    case 0x15: res= inst_dec_addr(code); break;
-    case 0x16: case 0x17: res= inst_dec_Sri(code); break;
-    case 0x18: case 0x19: case 0x1a: case 0x1b:
-    case 0x1c: case 0x1d: case 0x1e: case 0x1f: res= inst_dec_rn(code); break;
-    case 0x20: res= inst_jb_bit_addr(code); break;
-    case 0x22: res= inst_ret(code); break;
-    case 0x23: res= inst_rl(code); break;
-    case 0x24: res= inst_add_a_Sdata(code); break;
-    case 0x25: res= inst_add_a_addr(code); break;
-    case 0x26: case 0x27: res= inst_add_a_Sri(code); break;
-    case 0x28: case 0x29: case 0x2a: case 0x2b:
-    case 0x2c: case 0x2d: case 0x2e: case 0x2f:res= inst_add_a_rn(code);break;
-    case 0x30: res= inst_jnb_bit_addr(code); break;
-    case 0x32: res= inst_reti(code); break;
-    case 0x33: res= inst_rlc(code); break;
-    case 0x34: res= inst_addc_a_Sdata(code); break;
-    case 0x35: res= inst_addc_a_addr(code); break;
-    case 0x36: case 0x37: res= inst_addc_a_Sri(code); break;
-    case 0x38: case 0x39: case 0x3a: case 0x3b:
-    case 0x3c: case 0x3d: case 0x3e: case 0x3f:res= inst_addc_a_rn(code);break;
-    case 0x40: res= inst_jc_addr(code); break;
-    case 0x42: res= inst_orl_addr_a(code); break;
-    case 0x43: res= inst_orl_addr_Sdata(code); break;
-    case 0x44: res= inst_orl_a_Sdata(code); break;
-    case 0x45: res= inst_orl_a_addr(code); break;
-    case 0x46: case 0x47: res= inst_orl_a_Sri(code); break;
-    case 0x48: case 0x49: case 0x4a: case 0x4b:
-    case 0x4c: case 0x4d: case 0x4e: case 0x4f: res= inst_orl_a_rn(code);break;
-    case 0x50: res= inst_jnc_addr(code); break;
-    case 0x52: res= inst_anl_addr_a(code); break;
-    case 0x53: res= inst_anl_addr_Sdata(code); break;
-    case 0x54: res= inst_anl_a_Sdata(code); break;
-    case 0x55: res= inst_anl_a_addr(code); break;
-    case 0x56: case 0x57: res= inst_anl_a_Sri(code); break;
-    case 0x58: case 0x59: case 0x5a: case 0x5b:
-    case 0x5c: case 0x5d: case 0x5e: case 0x5f: res= inst_anl_a_rn(code);break;
-    case 0x60: res= inst_jz_addr(code); break;
-    case 0x62: res= inst_xrl_addr_a(code); break;
-    case 0x63: res= inst_xrl_addr_Sdata(code); break;
-    case 0x64: res= inst_xrl_a_Sdata(code); break;
-    case 0x65: res= inst_xrl_a_addr(code); break;
-    case 0x66: case 0x67: res= inst_xrl_a_Sri(code); break;
-    case 0x68: case 0x69: case 0x6a: case 0x6b:
-    case 0x6c: case 0x6d: case 0x6e: case 0x6f: res= inst_xrl_a_rn(code);break;
-    case 0x70: res= inst_jnz_addr(code); break;
-    case 0x72: res= inst_orl_c_bit(code); break;
-    case 0x73: res= inst_jmp_Sa_dptr(code); break;
-    case 0x74: res= inst_mov_a_Sdata(code); break;
-    case 0x75: res= inst_mov_addr_Sdata(code); break;
-    case 0x76: case 0x77: res= inst_mov_Sri_Sdata(code); break;
-    case 0x78: case 0x79: case 0x7a: case 0x7b: case 0x7c:
-    case 0x7d: case 0x7e: case 0x7f: res=inst_mov_rn_Sdata(code); break;
-    case 0x80: res= inst_sjmp(code); break;
-    case 0x82: res= inst_anl_c_bit(code); break;
-    case 0x83: res= inst_movc_a_Sa_pc(code); break;
-    case 0x84: res= inst_div_ab(code); break;
-    case 0x85: res= inst_mov_addr_addr(code); break;
-    case 0x86: case 0x87: res= inst_mov_addr_Sri(code); break;
-    case 0x88: case 0x89: case 0x8a: case 0x8b:
-    case 0x8c: case 0x8d: case 0x8e: case 0x8f:res=inst_mov_addr_rn(code);break;
-    case 0x90: res= inst_mov_dptr_Sdata(code); break;
-    case 0x92: res= inst_mov_bit_c(code); break;
-    case 0x93: res= inst_movc_a_Sa_dptr(code); break;
-    case 0x94: res= inst_subb_a_Sdata(code); break;
-    case 0x95: res= inst_subb_a_addr(code); break;
-    case 0x96: case 0x97: res= inst_subb_a_Sri(code); break;
-    case 0x98: case 0x99: case 0x9a: case 0x9b:
-    case 0x9c: case 0x9d: case 0x9e: case 0x9f:res= inst_subb_a_rn(code);break;
-    case 0xa0: res= inst_orl_c_Sbit(code); break;
-    case 0xa2: res= inst_mov_c_bit(code); break;
-    case 0xa3: res= inst_inc_dptr(code); break;
-    case 0xa4: res= inst_mul_ab(code); break;
-    case 0xa5: res= inst_unknown(); break;
-    case 0xa6: case 0xa7: res= inst_mov_Sri_addr(code); break;
-    case 0xa8: case 0xa9: case 0xaa: case 0xab:
-    case 0xac: case 0xad: case 0xae: case 0xaf:res=inst_mov_rn_addr(code);break;
-    case 0xb0: res= inst_anl_c_Sbit(code); break;
-    case 0xb2: res= inst_cpl_bit(code); break;
-    case 0xb3: res= inst_cpl_c(code); break;
-    case 0xb4: res= inst_cjne_a_Sdata_addr(code); break;
-    case 0xb5: res= inst_cjne_a_addr_addr(code); break;
-    case 0xb6: case 0xb7: res= inst_cjne_Sri_Sdata_addr(code); break;
-    case 0xb8: case 0xb9: case 0xba: case 0xbb: case 0xbc:
-    case 0xbd: case 0xbe: case 0xbf: res=inst_cjne_rn_Sdata_addr(code); break;
-    case 0xc0: res= inst_push(code); break;
-    case 0xc2: res= inst_clr_bit(code); break;
-    case 0xc3: res= inst_clr_c(code); break;
-    case 0xc4: res= inst_swap(code); break;
-    case 0xc5: res= inst_xch_a_addr(code); break;
-    case 0xc6: case 0xc7: res= inst_xch_a_Sri(code); break;
-    case 0xc8: case 0xc9: case 0xca: case 0xcb:
-    case 0xcc: case 0xcd: case 0xce: case 0xcf: res= inst_xch_a_rn(code);break;
-    case 0xd0: res= inst_pop(code); break;
-    case 0xd2: res= inst_setb_bit(code); break;
-    case 0xd3: res= inst_setb_c(code); break;
-    case 0xd4: res= inst_da_a(code); break;
-    case 0xd5: res= inst_djnz_addr_addr(code); break;
-    case 0xd6: case 0xd7: res= inst_xchd_a_Sri(code); break;
-    case 0xd8: case 0xd9: case 0xda: case 0xdb: case 0xdc:
-    case 0xdd: case 0xde: case 0xdf: res=inst_djnz_rn_addr(code); break;
-    case 0xe0: res= inst_movx_a_Sdptr(code); break;
-    case 0xe2: case 0xe3: res= inst_movx_a_Sri(code); break;
-    case 0xe4: res= inst_clr_a(code); break;
-    case 0xe5: res= inst_mov_a_addr(code); break;
-    case 0xe6: case 0xe7: res= inst_mov_a_Sri(code); break;
-    case 0xe8: case 0xe9: case 0xea: case 0xeb:
-    case 0xec: case 0xed: case 0xee: case 0xef: res= inst_mov_a_rn(code);break;
-    case 0xf0: res= inst_movx_Sdptr_a(code); break;
-    case 0xf2: case 0xf3: res= inst_movx_Sri_a(code); break;
-    case 0xf4: res= inst_cpl_a(code); break;
-    case 0xf5: res= inst_mov_addr_a(code); break;
-    case 0xf6: case 0xf7: res= inst_mov_Sri_a(code); break;
-    case 0xf8: case 0xf9: case 0xfa: case 0xfb:
-    case 0xfc: case 0xfd: case 0xfe: case 0xff: res= inst_mov_rn_a(code);break;
-    default:
-      res= inst_unknown();
-      break;
-    }
-  //post_inst();
-  return(res);
+  return((this->*itab[code])(code));
 }
 
 
@@ -100,12 +100,19 @@ public:
   virtual struct name_entry *bit_tbl(void);
   virtual const char *disass(t_addr addr, const char *sep);
   virtual void   print_regs(class cl_console_base *con);
+  virtual int    dbg_regs(void) { return(15); }
+  virtual int    dbg_reg_size(int nr) { return((nr == 14)?2:1); }
+  virtual t_mem  dbg_get_reg(int nr);
+  virtual void   dbg_set_reg(int nr, t_mem val);
+  virtual bool   idle_loop(t_addr end);
   virtual class cl_address_space *bit2mem(t_addr bitaddr,
                                           t_addr *memaddr, t_mem *bitmask);
   virtual t_addr bit_address(class cl_memory *mem,
                              t_addr mem_address,
                              int bit_number);
   virtual void   reset(void);
+  virtual bool   save_state(FILE *f);
+  virtual bool   load_state(FILE *f);
   virtual void   clear_sfr(void);
   virtual void   analyze(t_addr addr);
   virtual int    it_priority(uchar ie_mask);
@@ -123,10 +130,16 @@ protected:
   virtual class cl_memory_cell *get_direct(t_mem addr);
   virtual class cl_memory_cell *get_reg(uchar regnum);
 
+  typedef int (cl_51core::*t_inst51)(uchar code);
+  static t_inst51 itab[256];
+  static bool itab_made;
+  static void make_itab(void);
+
   virtual int   exec_inst(void);
   //virtual void  post_inst(void);
 
   virtual int inst_unknown(void);
+  virtual int inst_unknown_code(uchar code);
   virtual int inst_nop(uchar code);                     /* 00 */
   virtual int inst_ajmp_addr(uchar code);               /* [02468ace]1 */
   virtual int inst_ljmp(uchar code);                    /* 02 */
@@ -138,6 +151,7 @@ protected:
   virtual int inst_jbc_bit_addr(uchar code);            /* 10 */
   virtual int inst_acall_addr(uchar code);              /* [13579bdf]1 */
   virtual int inst_lcall(uchar code, uint addr, bool intr);/* 12 */
+  virtual int inst_lcall_addr(uchar code);              /* 12 */
   virtual int inst_rrc(uchar code);                     /* 13 */
   virtual int inst_dec_a(uchar code);                   /* 14 */
   virtual int inst_dec_addr(uchar code);                /* 15 */
@@ -251,6 +265,7 @@ public:
   virtual int init(void);
 
   virtual void write(class cl_memory_cell *cell, t_mem *val);
+  virtual long wakeup_in(void) { return(-1); }
   //virtual void happen(class cl_hw *where, enum hw_event he, void *params);
 };
 
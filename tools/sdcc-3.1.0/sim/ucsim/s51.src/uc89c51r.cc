@@ -30,6 +30,9 @@ Software Foundation, 59 Temple Place - Suite 330, Boston, MA
 #include <stdio.h>
 #include <ctype.h>
 
+// prj
+#include "utils.h"
+
 // local
 #include "uc89c51rcl.h"
 #include "regs51.h"
@@ -78,6 +81,28 @@ cl_uc89c51r::reset(void)
   sfr->write(IPH, 0);
 }
 
+bool
+cl_uc89c51r::save_state(FILE *f)
+{
+  return(cl_uc51r::save_state(f) &&
+         SAVE_VAR(f, dpl0) &&
+         SAVE_VAR(f, dph0) &&
+         SAVE_VAR(f, dpl1) &&
+         SAVE_VAR(f, dph1) &&
+         SAVE_VAR(f, dps));
+}
+
+bool
+cl_uc89c51r::load_state(FILE *f)
+{
+  return(cl_uc51r::load_state(f) &&
+         LOAD_VAR(f, dpl0) &&
+         LOAD_VAR(f, dph0) &&
+         LOAD_VAR(f, dpl1) &&
+         LOAD_VAR(f, dph1) &&
+         LOAD_VAR(f, dps));
+}
+
 int
 cl_uc89c51r::it_priority(uchar ie_mask)
 {
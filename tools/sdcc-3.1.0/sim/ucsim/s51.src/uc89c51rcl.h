@@ -47,6 +47,8 @@ public:
   virtual void make_memories(void);
 
   virtual void  reset(void);
+  virtual bool  save_state(FILE *f);
+  virtual bool  load_state(FILE *f);
   virtual void  pre_inst(void);
   virtual void  post_inst(void);
   virtual int   it_priority(uchar ie_mask);
@@ -27,6 +27,9 @@ Software Foundation, 59 Temple Place - Suite 330, Boston, MA
 
 #include <ctype.h>
 
+// prj
+#include "utils.h"
+
 // local
 #include "wdtcl.h"
 #include "regs51.h"
@@ -88,6 +91,14 @@ cl_wdt::tick(int cycles)
   return(0);
 }
 
+long
+cl_wdt::wakeup_in(void)
+{
+  if (wdt < 0)
+    return(-1);
+  return(reset_value - wdt + 1);
+}
+
 void
 cl_wdt::reset(void)
 {
@@ -95,9 +106,26 @@ cl_wdt::reset(void)
   wdt= -1;
 }
 
+bool
+cl_wdt::save_state(FILE *f)
+{
+  return(cl_hw::save_state(f) &&
+         SAVE_VAR(f, wdt) &&
+         SAVE_VAR(f, written_since_reset));
+}
+
+bool
+cl_wdt::load_state(FILE *f)
+{
+  return(cl_hw::load_state(f) &&
+         LOAD_VAR(f, wdt) &&
+         LOAD_VAR(f, written_since_reset));
+}
+
 void
 cl_wdt::print_info(class cl_console_base *con)
 {
+  sync();
   con->dd_printf("%s[%d] %s counter=%d (remains=%d)\n", id_string, id,
                  (wdt>=0)?"ON":"OFF", wdt, (wdt>=0)?(reset_value-wdt):0);
 }
@@ -54,8 +54,12 @@ public:
   //virtual t_mem set_cmd(t_mem value);
 
   virtual int tick(int cycles);
+  virtual long wakeup_in(void);
   virtual void reset(void);
   
+  virtual bool save_state(FILE *f);
+  virtual bool load_state(FILE *f);
+
   virtual void print_info(class cl_console_base *con);
 };
 
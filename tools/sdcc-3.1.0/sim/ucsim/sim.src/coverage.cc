@@ -0,0 +1,430 @@
+/*
+ * Simulator of microcontrollers (sim.src/coverage.cc)
+ */
+
+/* This file is part of microcontroller simulator: ucsim.
+
+UCSIM is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+UCSIM is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with UCSIM; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA. */
+/*@1@*/
+
+#include "ddconfig.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "i_string.h"
+
+// cmd.src
+#include "newcmdcl.h"
+
+// local
+#include "uccl.h"
+#include "coveragecl.h"
+
+
+/*
+ * Coverage maps
+ */
+
+cl_coverage::cl_coverage(class cl_uc *auc):
+  cl_base()
+{
+  uc= auc;
+  code_start= code_size= 0;
+  exec_map= cond_map= taken_map= not_taken_map= 0;
+}
+
+cl_coverage::~cl_coverage(void)
+{
+  if (exec_map)
+    free(exec_map);
+  if (cond_map)
+    free(cond_map);
+  if (taken_map)
+    free(taken_map);
+  if (not_taken_map)
+    free(not_taken_map);
+}
+
+int
+cl_coverage::init(void)
+{
+  t_addr bytes;
+
+  cl_base::init();
+  set_name("coverage");
+  if (uc->rom)
+    {
+      code_start= uc->rom->start_address;
+      code_size= uc->rom->get_size();
+    }
+  bytes= (code_size + 7) / 8;
+  if (!bytes)
+    bytes= 1;
+  exec_map= (unsigned char *)calloc(bytes, 1);
+  cond_map= (unsigned char *)calloc(bytes, 1);
+  taken_map= (unsigned char *)calloc(bytes, 1);
+  not_taken_map= (unsigned char *)calloc(bytes, 1);
+  return(0);
+}
+
+void
+cl_coverage::clear(void)
+{
+  t_addr bytes= (code_size + 7) / 8;
+
+  memset(exec_map, 0, bytes);
+  memset(cond_map, 0, bytes);
+  memset(taken_map, 0, bytes);
+  memset(not_taken_map, 0, bytes);
+}
+
+/* COV_* bits of an address */
+
+int
+cl_coverage::get(t_addr addr)
+{
+  t_addr i= addr - code_start;
+  unsigned char m;
+  int bits= 0;
+
+  if (i >= code_size)
+    return(0);
+  m= 1 << (i & 7);
+  i>>= 3;
+  if (exec_map[i] & m)
+    bits|= COV_EXEC;
+  if (cond_map[i] & m)
+    bits|= COV_COND;
+  if (taken_map[i] & m)
+    bits|= COV_TAKEN;
+  if (not_taken_map[i] & m)
+    bits|= COV_NOT_TAKEN;
+  return(bits);
+}
+
+void
+cl_coverage::set(t_addr addr, int bits)
+{
+  t_addr i= addr - code_start;
+  unsigned char m;
+
+  if (i >= code_size)
+    return;
+  m= 1 << (i & 7);
+  i>>= 3;
+  if (bits & COV_EXEC)
+    exec_map[i]|= m;
+  if (bits & COV_COND)
+    cond_map[i]|= m;
+  if (bits & COV_TAKEN)
+    taken_map[i]|= m;
+  if (bits & COV_NOT_TAKEN)
+    not_taken_map[i]|= m;
+}
+
+/* Disassembler tables mark relative jumps by `r' and `R', these are the
+   conditional ones (JC, JNZ, DJNZ, CJNE, ...) on the 51 */
+
+bool
+cl_coverage::is_cond_branch(t_addr addr)
+{
+  int b= uc->inst_branch(addr);
+
+  return(b == 'r' ||
+         b == 'R');
+}
+
+void
+cl_coverage::first_exec(t_addr addr)
+{
+  set(addr, COV_EXEC | (is_cond_branch(addr)?COV_COND:0));
+}
+
+void
+cl_coverage::branch_done(t_addr addr, t_addr next)
+{
+  if (next == addr + uc->inst_length(addr))
+    set(addr, COV_NOT_TAKEN);
+  else
+    set(addr, COV_TAKEN);
+}
+
+
+/*
+ * Saved maps, loading ORs them into the current ones so results of
+ * several runs can be merged
+ */
+
+bool
+cl_coverage::save(const char *file_name)
+{
+  FILE *f;
+  t_addr i;
+  int bits;
+
+  if ((f= fopen(file_name, "w")) == NULL)
+    return(DD_FALSE);
+  fprintf(f, "# ucsim coverage\n");
+  fprintf(f, "# cpu %s\n", uc->id_string());
+  for (i= 0; i < code_size; i++)
+    if ((bits= get(code_start + i)) != 0)
+      fprintf(f, "%06" _A_ "x %x\n", code_start + i, bits);
+  bits= ferror(f);
+  fclose(f);
+  return(!bits);
+}
+
+/* Returns number of addresses read or -1 if file can not be opened */
+
+int
+cl_coverage::load(const char *file_name)
+{
+  FILE *f;
+  char line[256];
+  unsigned long addr;
+  int bits, n= 0;
+
+  if ((f= fopen(file_name, "r")) == NULL)
+    return(-1);
+  while (fgets(line, sizeof(line), f))
+    {
+      if (line[0] == '#')
+        continue;
+      if (sscanf(line, "%lx %x", &addr, &bits) != 2)
+        continue;
+      set(addr, bits);
+      n++;
+    }
+  fclose(f);
+  return(n);
+}
+
+void
+cl_coverage::print_info(class cl_console_base *con)
+{
+  t_addr i;
+  unsigned long execs= 0, conds= 0, both= 0, taken= 0, not_taken= 0;
+  int bits;
+
+  for (i= 0; i < code_size; i++)
+    {
+      if (!((bits= get(code_start + i)) & COV_EXEC))
+        continue;
+      execs++;
+      if (!(bits & COV_COND))
+        continue;
+      conds++;
+      if ((bits & (COV_TAKEN|COV_NOT_TAKEN)) == (COV_TAKEN|COV_NOT_TAKEN))
+        both++;
+      else if (bits & COV_TAKEN)
+        taken++;
+      else
+        not_taken++;
+    }
+  con->dd_printf("Executed instructions: %lu\n", execs);
+  con->dd_printf("Conditional branches: %lu, both directions: %lu, "
+                 "only taken: %lu, only not taken: %lu\n",
+                 conds, both, taken, not_taken);
+}
+
+
+/*
+ * lcov report
+ */
+
+static int
+line_addr_cmp(const void *p1, const void *p2)
+{
+  const struct t_cov_line *l1= (const struct t_cov_line *)p1;
+  const struct t_cov_line *l2= (const struct t_cov_line *)p2;
+
+  if (l1->addr < l2->addr)
+    return(-1);
+  if (l1->addr > l2->addr)
+    return(1);
+  return(0);
+}
+
+static int
+line_src_cmp(const void *p1, const void *p2)
+{
+  const struct t_cov_line *l1= *(const struct t_cov_line **)p1;
+  const struct t_cov_line *l2= *(const struct t_cov_line **)p2;
+  int i;
+
+  if ((i= strcmp(l1->file, l2->file)) != 0)
+    return(i);
+  if (l1->line != l2->line)
+    return(l1->line - l2->line);
+  return(line_addr_cmp(l1, l2));
+}
+
+/* Reads L:C$file$line$level$block:addr and L:X records (end of
+   functions), returns them sorted by address with the end of the code
+   of every line. The end is the next higher address of any record. */
+
+int
+cl_coverage::read_cdb_lines(FILE *f, class cl_strings *files,
+                            struct t_cov_line **lines)
+{
+  char line[1024], *s, *e, *a;
+  int n= 0, size= 256, i, j;
+  t_index idx;
+  struct t_cov_line *l;
+
+  *lines= (struct t_cov_line *)malloc(size * sizeof(struct t_cov_line));
+  while (fgets(line, sizeof(line), f))
+    {
+      if (line[0] != 'L' ||
+          line[1] != ':' ||
+          (line[2] != 'X' &&
+           (line[2] != 'C' || line[3] != '$')) ||
+          (a= strrchr(line, ':')) == line+1)
+        continue;
+      if (n == size)
+        {
+          size*= 2;
+          *lines= (struct t_cov_line *)realloc(*lines,
+                                               size * sizeof(struct t_cov_line));
+        }
+      l= &(*lines)[n];
+      l->addr= strtoul(a+1, NULL, 16);
+      l->file= 0;
+      l->line= 0;
+      if (line[2] == 'C')
+        {
+          s= line+4;
+          if ((e= strchr(s, '$')) == NULL)
+            continue;
+          *e= '\0';
+          l->line= strtol(e+1, NULL, 10);
+          if (!files->search(s, idx))
+            files->add(strdup(s));
+          files->search(s, idx);
+          l->file= (const char *)(files->at(idx));
+        }
+      n++;
+    }
+  qsort(*lines, n, sizeof(struct t_cov_line), line_addr_cmp);
+  for (i= 0; i < n; i= j)
+    {
+      for (j= i+1; j < n && (*lines)[j].addr == (*lines)[i].addr; j++)
+        ;
+      t_addr end= (j < n)?(*lines)[j].addr:((*lines)[i].addr + 1);
+      while (i < j)
+        (*lines)[i++].end= end;
+    }
+  return(n);
+}
+
+/* Records of one source file sorted by line */
+
+void
+cl_coverage::write_lcov_file(FILE *f, const char *dir,
+                             struct t_cov_line **recs, int n)
+{
+  int i, j, lf= 0, lh= 0, brf= 0, brh= 0, block, len, bits;
+  bool hit;
+  t_addr a;
+
+  fprintf(f, "TN:\nSF:%s%s\n", dir, recs[0]->file);
+  for (i= 0; i < n; i= j)
+    {
+      hit= DD_FALSE;
+      for (j= i; j < n && recs[j]->line == recs[i]->line; j++)
+        for (a= recs[j]->addr; a < recs[j]->end && !hit; a++)
+          if (get(a) & COV_EXEC)
+            hit= DD_TRUE;
+      fprintf(f, "DA:%d,%d\n", recs[i]->line, hit?1:0);
+      lf++;
+      if (hit)
+        lh++;
+      // Branches are found by walking the instructions of the line
+      block= 0;
+      for (j= i; j < n && recs[j]->line == recs[i]->line; j++)
+        for (a= recs[j]->addr; a < recs[j]->end; a+= len)
+          {
+            if ((len= uc->inst_length(a)) < 1)
+              len= 1;
+            if (!is_cond_branch(a))
+              continue;
+            bits= get(a);
+            if (bits & COV_EXEC)
+              fprintf(f, "BRDA:%d,%d,0,%d\nBRDA:%d,%d,1,%d\n",
+                      recs[i]->line, block, (bits & COV_TAKEN)?1:0,
+                      recs[i]->line, block, (bits & COV_NOT_TAKEN)?1:0);
+            else
+              fprintf(f, "BRDA:%d,%d,0,-\nBRDA:%d,%d,1,-\n",
+                      recs[i]->line, block, recs[i]->line, block);
+            brf+= 2;
+            brh+= ((bits & COV_TAKEN)?1:0) + ((bits & COV_NOT_TAKEN)?1:0);
+            block++;
+          }
+    }
+  fprintf(f, "LF:%d\nLH:%d\nBRF:%d\nBRH:%d\nend_of_record\n",
+          lf, lh, brf, brh);
+}
+
+/* Writes an lcov tracefile using line records of the cdb file. Source
+   files are taken from the directory of the cdb. Returns number of
+   source files or -1 if the cdb can not be read. */
+
+int
+cl_coverage::write_lcov(const char *cdb_name, FILE *f)
+{
+  FILE *cdb;
+  class cl_strings *files;
+  struct t_cov_line *lines, **recs;
+  int n, nrecs, i, j;
+  char *dir, *s;
+
+  if ((cdb= fopen(cdb_name, "r")) == NULL)
+    return(-1);
+  files= new cl_strings(8, 8, "coverage files");
+  n= read_cdb_lines(cdb, files, &lines);
+  fclose(cdb);
+
+  recs= (struct t_cov_line **)malloc((n?n:1) * sizeof(struct t_cov_line *));
+  for (i= nrecs= 0; i < n; i++)
+    if (lines[i].file)
+      recs[nrecs++]= &lines[i];
+  qsort(recs, nrecs, sizeof(struct t_cov_line *), line_src_cmp);
+
+  dir= strdup(cdb_name);
+  if ((s= strrchr(dir, '/')) != NULL)
+    s[1]= '\0';
+  else
+    dir[0]= '\0';
+  for (i= 0; i < nrecs; i= j)
+    {
+      for (j= i+1; j < nrecs && recs[j]->file == recs[i]->file; j++)
+        ;
+      write_lcov_file(f, dir, &recs[i], j-i);
+    }
+  free(dir);
+  free(recs);
+  free(lines);
+  // Names are strdup()-ed, free_item() of cl_strings would delete them
+  n= files->count;
+  for (i= 0; i < n; i++)
+    free(files->at(i));
+  files->disconn_all();
+  delete files;
+  return(n);
+}
+
+
+/* End of sim.src/coverage.cc */
@@ -0,0 +1,105 @@
+/*
+ * Simulator of microcontrollers (sim.src/coveragecl.h)
+ */
+
+/* This file is part of microcontroller simulator: ucsim.
+
+UCSIM is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+UCSIM is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with UCSIM; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA. */
+/*@1@*/
+
+#ifndef SIM_COVERAGECL_HEADER
+#define SIM_COVERAGECL_HEADER
+
+#include <stdio.h>
+
+// prj
+#include "stypes.h"
+#include "pobjcl.h"
+
+
+// Coverage bits of a ROM address, also used in saved files
+#define COV_EXEC        0x01    // Instruction was executed
+#define COV_COND        0x02    // It is a conditional branch
+#define COV_TAKEN       0x04    // Branch jumped
+#define COV_NOT_TAKEN   0x08    // Branch went on with the next instruction
+
+/* C line record of a cdb file, file is NULL for end of a function */
+
+struct t_cov_line
+{
+  t_addr addr, end;
+  const char *file;
+  int line;
+};
+
+
+/* Code coverage. There is a bit per ROM address in each map: executed
+   instructions, conditional branches (classified by inst_branch() at
+   their first execution) and directions the branches went. When both
+   directions of a branch are seen an instruction costs two bit tests. */
+
+class cl_coverage: public cl_base
+{
+protected:
+  class cl_uc *uc;
+  t_addr code_start, code_size;
+  unsigned char *exec_map;
+  unsigned char *cond_map;
+  unsigned char *taken_map;
+  unsigned char *not_taken_map;
+
+public:
+  cl_coverage(class cl_uc *auc);
+  virtual ~cl_coverage(void);
+  virtual int init(void);
+
+  // Called by the controller after an instruction, next is the new PC
+  void inst_done(t_addr addr, t_addr next)
+  {
+    t_addr i= addr - code_start;
+    unsigned char m;
+    if (i >= code_size)
+      return;
+    m= 1 << (i & 7);
+    i>>= 3;
+    if (!(exec_map[i] & m))
+      first_exec(addr);
+    if (cond_map[i] & m & ~(taken_map[i] & not_taken_map[i]))
+      branch_done(addr, next);
+  }
+
+  virtual void clear(void);
+  virtual int get(t_addr addr);
+  virtual bool is_cond_branch(t_addr addr);
+  virtual bool save(const char *file_name);
+  virtual int load(const char *file_name);
+  virtual void print_info(class cl_console_base *con);
+  virtual int write_lcov(const char *cdb_name, FILE *f);
+
+protected:
+  virtual void first_exec(t_addr addr);
+  virtual void branch_done(t_addr addr, t_addr next);
+  virtual void set(t_addr addr, int bits);
+  virtual int read_cdb_lines(FILE *f, class cl_strings *files,
+                             struct t_cov_line **lines);
+  virtual void write_lcov_file(FILE *f, const char *dir,
+                               struct t_cov_line **recs, int n);
+};
+
+
+#endif
+
+/* End of sim.src/coveragecl.h */
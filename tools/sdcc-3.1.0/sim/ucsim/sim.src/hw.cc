@@ -31,6 +31,7 @@ Software Foundation, 59 Temple Place - Suite 330, Boston, MA
 #include "i_string.h"
 
 #include "stypes.h"
+#include "utils.h"
 #include "hwcl.h"
 
 
@@ -116,6 +117,10 @@ cl_hw::cl_hw(class cl_uc *auc, enum hw_cath cath, int aid, const char *aid_strin
 {
   flags= HWF_INSIDE;
   uc= auc;
+  synced= uc?(uc->hw_cycles):0;
+  wakeup= synced;
+  if (uc)
+    uc->hw_wakeup= 0;
   cathegory= cath;
   id= aid;
   if (aid_string &&
@@ -266,6 +271,73 @@ cl_hw::tick(int cycles)
   return(0);
 }
 
+/*
+ * Scheduling of ticks
+ *
+ * wakeup_in() tells how many machine cycles can pass before the element
+ * must be ticked: 0 means after every instruction, negative means not
+ * until one of its cells is accessed or a partner informs it. Skipped
+ * cycles are given to tick() in one call by sync().
+ */
+
+void
+cl_hw::sync(void)
+{
+  unsigned long c;
+
+  if (!uc)
+    return;
+  c= uc->hw_cycles - synced;
+  synced= uc->hw_cycles;
+  while (c > 0x7fffffffUL)
+    {
+      tick(0x7fffffff);
+      c-= 0x7fffffffUL;
+    }
+  if (c)
+    tick(c);
+}
+
+void
+cl_hw::schedule(void)
+{
+  long n= wakeup_in();
+
+  if (n < 0)
+    wakeup= HW_NEVER;
+  else
+    wakeup= synced + n;
+  if (uc &&
+      wakeup < uc->hw_wakeup)
+    uc->hw_wakeup= wakeup;
+}
+
+/*
+ * Snapshot of the internal state of the element. Derived classes save
+ * their own variables after calling these; cells are part of the
+ * snapshot of memory chips.
+ */
+
+bool
+cl_hw::save_state(FILE *f)
+{
+  return(SAVE_VAR(f, cathegory) &&
+         SAVE_VAR(f, id));
+}
+
+bool
+cl_hw::load_state(FILE *f)
+{
+  enum hw_cath c;
+  int i;
+
+  if (!LOAD_VAR(f, c) ||
+      !LOAD_VAR(f, i))
+    return(DD_FALSE);
+  return(c == cathegory &&
+         i == id);
+}
+
 void
 cl_hw::inform_partners(enum hw_event he, void *params)
 {
@@ -398,7 +470,10 @@ void
 cl_partner_hw::happen(class cl_hw *where, enum hw_event he, void *params)
 {
   if (partner)
-    partner->happen(where, he, params);
+    {
+      partner->happen(where, he, params);
+      partner->schedule();
+    }
 }
 
 
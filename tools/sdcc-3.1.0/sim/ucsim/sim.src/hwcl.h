@@ -99,6 +99,9 @@ public:
 protected:
   class cl_list *partners;
   class cl_list *watched_cells;
+public:
+  unsigned long synced;         // uc->hw_cycles tick() has been called up to
+  unsigned long wakeup;         // uc->hw_cycles when tick() is needed again
 public:
   cl_hw(class cl_uc *auc, enum hw_cath cath, int aid, const char *aid_string);
   virtual ~cl_hw(void);
@@ -125,10 +128,18 @@ public:
   virtual void address_space_added(class cl_address_space *as);
 
   virtual int tick(int cycles);
+  virtual long wakeup_in(void) { return(0); }
+  virtual void sync(void);
+  virtual void schedule(void);
   virtual void reset(void) {}
   virtual void happen(class cl_hw * /*where*/, enum hw_event /*he*/,
                       void * /*params*/) {}
   virtual void inform_partners(enum hw_event he, void *params);
+  // Interconnect with the same kind of hw of an other controller
+  virtual bool connect(class cl_hw * /*peer*/) { return(DD_FALSE); }
+
+  virtual bool save_state(FILE *f);
+  virtual bool load_state(FILE *f);
 
   virtual void print_info(class cl_console_base *con);
 };
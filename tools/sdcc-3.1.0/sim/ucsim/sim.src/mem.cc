@@ -46,6 +46,7 @@
 // local
 #include "memcl.h"
 #include "hwcl.h"
+#include "tracecl.h"
 
 
 static class cl_mem_error_registry mem_error_registry;
@@ -341,7 +342,10 @@ cl_hw_operator::read(void)
   t_mem d= 0;
 
   if (hw)
-    d= hw->read(cell);
+    {
+      hw->sync();
+      d= hw->read(cell);
+    }
 
   if (next_operator)
     next_operator->read();
@@ -356,7 +360,10 @@ cl_hw_operator::read(enum hw_cath skip)
 
   if (hw &&
       hw->cathegory != skip)
-    d= hw->read(cell);
+    {
+      hw->sync();
+      d= hw->read(cell);
+    }
 
   if (next_operator)
     next_operator->read();
@@ -368,10 +375,17 @@ t_mem
 cl_hw_operator::write(t_mem val)
 {
   if (hw)
-    hw->write(cell, &val);
+    {
+      hw->sync();
+      hw->write(cell, &val);
+    }
   if (next_operator)
     val= next_operator->write(val);
-  return(*data= (val & mask));
+  *data= (val & mask);
+  // wakeup_in() of the hw must see the new value
+  if (hw)
+    hw->schedule();
+  return(*data);
 }
 
 
@@ -421,6 +435,102 @@ cl_read_operator::read(void)
 }
 
 
+/* Access counters of an address space */
+
+cl_mem_profile::cl_mem_profile(class cl_address_space *the_mem):
+  cl_base()
+{
+  mem= the_mem;
+  set_name(mem->get_name());
+  reads= (unsigned long *)calloc(mem->get_size(), sizeof(unsigned long));
+  writes= (unsigned long *)calloc(mem->get_size(), sizeof(unsigned long));
+}
+
+cl_mem_profile::~cl_mem_profile(void)
+{
+  free(reads);
+  free(writes);
+}
+
+void
+cl_mem_profile::clear(void)
+{
+  memset(reads, 0, mem->get_size() * sizeof(unsigned long));
+  memset(writes, 0, mem->get_size() * sizeof(unsigned long));
+}
+
+
+/* Counting accesses of a cell while profiling */
+
+cl_profile_operator::cl_profile_operator(class cl_memory_cell *acell,
+                                         t_addr addr,
+                                         t_mem *data_place, t_mem the_mask,
+                                         class cl_mem_profile *the_prof):
+  cl_memory_operator(acell, addr, data_place, the_mask)
+{
+  prof= the_prof;
+  reads= &prof->reads[addr - prof->mem->start_address];
+  writes= &prof->writes[addr - prof->mem->start_address];
+}
+
+t_mem
+cl_profile_operator::read(void)
+{
+  (*reads)++;
+  if (next_operator)
+    return(next_operator->read());
+  else
+    return(*data);
+}
+
+t_mem
+cl_profile_operator::read(enum hw_cath skip)
+{
+  (*reads)++;
+  if (next_operator)
+    return(next_operator->read(skip));
+  else
+    return(*data);
+}
+
+t_mem
+cl_profile_operator::write(t_mem val)
+{
+  (*writes)++;
+  if (next_operator)
+    return(next_operator->write(val));
+  else
+    return(*data= (val & mask));
+}
+
+
+/* Recording writes into the trace */
+
+cl_trace_operator::cl_trace_operator(class cl_memory_cell *acell,
+                                     t_addr addr,
+                                     t_mem *data_place, t_mem the_mask,
+                                     class cl_tracer *the_tracer,
+                                     int the_space):
+  cl_memory_operator(acell, addr, data_place, the_mask)
+{
+  tracer= the_tracer;
+  space= the_space;
+}
+
+t_mem
+cl_trace_operator::write(t_mem val)
+{
+  if (next_operator)
+    val= next_operator->write(val);
+  else
+    val= *data= (val & mask);
+  // Only side effects of instructions, not of the idle mode
+  if (tracer->uc->inst_exec)
+    tracer->written(space, address, val);
+  return(val);
+}
+
+
 /*
  *                                                                  Memory cell
  */
@@ -649,6 +759,58 @@ cl_memory_cell::del_operator(class cl_brk *brk)
 }
 
 
+void
+cl_memory_cell::del_operator(class cl_mem_profile *prof)
+{
+  if (!operators)
+    return;
+  class cl_memory_operator *op= operators;
+  if (operators->match(prof))
+    {
+      operators= op->get_next();
+      delete op;
+    }
+  else
+    {
+      while (op->get_next() &&
+             !op->get_next()->match(prof))
+        op= op->get_next();
+      if (op->get_next())
+        {
+          class cl_memory_operator *m= op->get_next();
+          op->set_next(m->get_next());
+          delete m;
+        }
+    }
+}
+
+
+void
+cl_memory_cell::del_operator(class cl_tracer *tracer)
+{
+  if (!operators)
+    return;
+  class cl_memory_operator *op= operators;
+  if (operators->match(tracer))
+    {
+      operators= op->get_next();
+      delete op;
+    }
+  else
+    {
+      while (op->get_next() &&
+             !op->get_next()->match(tracer))
+        op= op->get_next();
+      if (op->get_next())
+        {
+          class cl_memory_operator *m= op->get_next();
+          op->set_next(m->get_next());
+          delete m;
+        }
+    }
+}
+
+
 class cl_memory_cell *
 cl_memory_cell::add_hw(class cl_hw *hw, int *ith, t_addr addr)
 {
@@ -703,8 +865,11 @@ cl_address_space::cl_address_space(const char *id,
   start_address= astart;
   decoders= new cl_decoder_list(2, 2, DD_FALSE);
   cells= (class cl_memory_cell **)calloc(size, sizeof(class cl_memory_cell*));
+  slots= (t_mem **)calloc(size, sizeof(t_mem *));
 
   dummy= new cl_dummy_cell();
+  cell_mask= dummy->get_mask();
+  generation= 0;
 }
 
 cl_address_space::~cl_address_space(void)
@@ -714,19 +879,33 @@ cl_address_space::~cl_address_space(void)
   for (i= 0; i < size; i++)
     if (cells[i])
       delete cells[i];
+  free(slots);
   delete dummy;
 }
 
 
+/* Cells without operators are accessed through slots[], others (and
+   not yet created cells) through the cell object */
+
 t_mem
 cl_address_space::read(t_addr addr)
 {
+  t_addr idx= addr-start_address;
+  if (idx < size &&
+      addr >= start_address &&
+      slots[idx])
+    return(*slots[idx]);
   return get_cell(addr)->read();
 }
 
 t_mem
 cl_address_space::read(t_addr addr, enum hw_cath skip)
 {
+  t_addr idx= addr-start_address;
+  if (idx < size &&
+      addr >= start_address &&
+      slots[idx])
+    return(*slots[idx]);
   cl_memory_cell *cell = get_cell(addr);
   if (cell == dummy)
     {
@@ -738,24 +917,74 @@ cl_address_space::read(t_addr addr, enum hw_cath skip)
 t_mem
 cl_address_space::get(t_addr addr)
 {
+  t_addr idx= addr-start_address;
+  if (idx < size &&
+      addr >= start_address &&
+      slots[idx])
+    return(*slots[idx]);
   return get_cell(addr)->get();
 }
 
 t_mem
 cl_address_space::write(t_addr addr, t_mem val)
 {
+  t_addr idx= addr-start_address;
+  cell_changed(addr);
+  if (idx < size &&
+      addr >= start_address &&
+      slots[idx])
+    return(*slots[idx]= val & cell_mask);
   return get_cell(addr)->write(val);
 }
 
 void
 cl_address_space::set(t_addr addr, t_mem val)
 {
+  t_addr idx= addr-start_address;
+  cell_changed(addr);
+  if (idx < size &&
+      addr >= start_address &&
+      slots[idx])
+    {
+      *slots[idx]= val & cell_mask;
+      return;
+    }
   get_cell(addr)->set(val);
 }
 
+/* Storing values of a loaded image without callbacks. Plain cells
+   which follow each other in their chip are copied in one run, values
+   must fit into the cells. */
+
+void
+cl_address_space::set_block(t_addr addr, const t_mem *vals, t_addr n)
+{
+  t_addr i, run, idx;
+
+  generation++;
+  for (i= 0; i < n; i+= run)
+    {
+      idx= addr + i - start_address;
+      run= 1;
+      if (addr + i >= start_address &&
+          idx < size &&
+          slots[idx])
+        {
+          while (i + run < n &&
+                 idx + run < size &&
+                 slots[idx + run] == slots[idx] + run)
+            run++;
+          memcpy(slots[idx], vals + i, run * sizeof(t_mem));
+        }
+      else
+        get_cell(addr + i)->set(vals[i]);
+    }
+}
+
 t_mem
 cl_address_space::wadd(t_addr addr, long what)
 {
+  cell_changed(addr);
   return get_cell(addr)->wadd(what);
 }
 
@@ -765,6 +994,7 @@ void
 cl_address_space::set_bit1(t_addr addr, t_mem bits)
 {
   cl_memory_cell *cell = get_cell(addr);
+  cell_changed(addr);
   if (cell == dummy)
     {
     return;
@@ -776,6 +1006,7 @@ void
 cl_address_space::set_bit0(t_addr addr, t_mem bits)
 {
   cl_memory_cell *cell = get_cell(addr);
+  cell_changed(addr);
   if (cell == dummy)
     {
       return;
@@ -783,6 +1014,17 @@ cl_address_space::set_bit0(t_addr addr, t_mem bits)
   cell->set_bit0(bits);
 }
 
+/* Value, flags or operators of a cell changed. The controller drops what
+   it predecoded from that address if this is its rom. */
+
+void
+cl_address_space::cell_changed(t_addr addr)
+{
+  if (uc &&
+      uc->rom == this)
+    uc->code_changed(addr);
+}
+
 class cl_address_decoder *
 cl_address_space::get_decoder(t_addr addr)
 {
@@ -793,7 +1035,9 @@ cl_address_space::get_decoder(t_addr addr)
         dynamic_cast<class cl_address_decoder *>(decoders->object_at(i));
       if (!d)
         continue;
-      if (d->covers(addr, addr))
+      // covers() is true only inside, the ends belong to the decoder too
+      if (addr >= d->as_begin &&
+          addr <= d->as_end)
         {
           return d;
         }
@@ -822,10 +1066,32 @@ cl_address_space::get_cell(t_addr addr)
           decode_cell(addr, decoder->memchip,
                       addr - decoder->as_begin + decoder->chip_begin);
         }
+      update_slot(idx);
     }
   return(cells[idx]);
 }
 
+/* Re-enable or disable fast access of a cell after its data place or
+   operator list has changed */
+
+void
+cl_address_space::update_slot(t_addr idx)
+{
+  class cl_memory_cell *cell= cells[idx];
+
+  cell_changed(idx + start_address);
+#ifdef STATISTIC
+  // cells count their own accesses
+  slots[idx]= NULL;
+#else
+  if (cell &&
+      !cell->hooked())
+    slots[idx]= cell->get_data();
+  else
+    slots[idx]= NULL;
+#endif
+}
+
 
 int
 cl_address_space::get_cell_flag(t_addr addr)
@@ -842,6 +1108,7 @@ cl_address_space::get_cell_flag(t_addr addr, enum cell_flag flag)
 void
 cl_address_space::set_cell_flag(t_addr addr, bool set_to, enum cell_flag flag)
 {
+  cell_changed(addr);
   get_cell(addr)->set_flag(flag, set_to);
 }
 
@@ -862,6 +1129,7 @@ cl_address_space::decode_cell(t_addr addr,
       cell->un_decode();
     }
   cell->decode(chip, chipaddr);
+  update_slot(addr-start_address);
 
   return(!cell->get_flag(CELL_NON_DECODED));
 }
@@ -881,6 +1149,7 @@ cl_address_space::undecode_cell(t_addr addr)
       return;
     }
   cells[idx]->un_decode();
+  update_slot(idx);
 }
 
 void
@@ -960,6 +1229,7 @@ cl_address_space::register_hw(t_addr addr, class cl_hw *hw,
       return(NULL);
     }
   cell->add_hw(hw, ith, addr);
+  update_slot(addr-start_address);
   //printf("adding hw %s to cell 0x%x(%d) of %s\n", hw->id_string, addr, idx, get_name("as"));
   if (announce)
     ;//uc->sim->/*app->*/mem_cell_changed(this, addr);//FIXME
@@ -1000,7 +1270,10 @@ cl_address_space::set_brk(t_addr addr, class cl_brk *brk)
       break;
     }
   if (op)
-    cell->append_operator(op);
+    {
+      cell->append_operator(op);
+      update_slot(addr-start_address);
+    }
 }
 
 void
@@ -1017,6 +1290,7 @@ cl_address_space::del_brk(t_addr addr, class cl_brk *brk)
     case brkWRITE: case brkWXRAM: case brkWIRAM: case brkWSFR:
     case brkREAD: case brkRXRAM: case brkRCODE: case brkRIRAM: case brkRSFR:
       cell->del_operator(brk);
+      update_slot(addr-start_address);
       break;
     case brkNONE:
       set_cell_flag(addr, DD_FALSE, CELL_FETCH_BRK);
@@ -1028,6 +1302,74 @@ cl_address_space::del_brk(t_addr addr, class cl_brk *brk)
 }
 
 
+/* Hooking every cell to count accesses in the side arrays of prof, cells
+   lose their fast path until the profile is stopped */
+
+void
+cl_address_space::start_profile(class cl_mem_profile *prof)
+{
+  t_addr i;
+
+  for (i= 0; i < size; i++)
+    {
+      class cl_memory_cell *cell= get_cell(start_address + i);
+      if (cell == dummy)
+        continue;
+      cell->prepend_operator(new cl_profile_operator(cell, start_address + i,
+                                                     cell->get_data(),
+                                                     cell->get_mask(),
+                                                     prof));
+      update_slot(i);
+    }
+}
+
+void
+cl_address_space::stop_profile(class cl_mem_profile *prof)
+{
+  t_addr i;
+
+  for (i= 0; i < size; i++)
+    if (cells[i])
+      {
+        cells[i]->del_operator(prof);
+        update_slot(i);
+      }
+}
+
+/* Hooking every cell to record writes into the trace */
+
+void
+cl_address_space::start_trace(class cl_tracer *tracer, int space)
+{
+  t_addr i;
+
+  for (i= 0; i < size; i++)
+    {
+      class cl_memory_cell *cell= get_cell(start_address + i);
+      if (cell == dummy)
+        continue;
+      cell->prepend_operator(new cl_trace_operator(cell, start_address + i,
+                                                   cell->get_data(),
+                                                   cell->get_mask(),
+                                                   tracer, space));
+      update_slot(i);
+    }
+}
+
+void
+cl_address_space::stop_trace(class cl_tracer *tracer)
+{
+  t_addr i;
+
+  for (i= 0; i < size; i++)
+    if (cells[i])
+      {
+        cells[i]->del_operator(tracer);
+        update_slot(i);
+      }
+}
+
+
 /*
  * List of address spaces
  */
@@ -1128,6 +1470,37 @@ cl_memory_chip::set_bit0(t_addr addr, t_mem bits)
 }
 
 
+/*
+ * Content of the chip is saved as it is, size and width must match
+ * when it is loaded back
+ */
+
+bool
+cl_memory_chip::save_state(FILE *f)
+{
+  if (!array)
+    return(DD_FALSE);
+  return(SAVE_VAR(f, size) &&
+         SAVE_VAR(f, width) &&
+         save_data(f, array, size * sizeof(t_mem)));
+}
+
+bool
+cl_memory_chip::load_state(FILE *f)
+{
+  t_addr s;
+  int w;
+
+  if (!array ||
+      !LOAD_VAR(f, s) ||
+      !LOAD_VAR(f, w) ||
+      s != size ||
+      w != width)
+    return(DD_FALSE);
+  return(load_data(f, array, size * sizeof(t_mem)));
+}
+
+
 /*
  *                                                              Address decoder
  */
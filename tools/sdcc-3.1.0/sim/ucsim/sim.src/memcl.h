@@ -30,6 +30,8 @@ Software Foundation, 59 Temple Place - Suite 330, Boston, MA
 
 #include "ddconfig.h"
 
+#include <stdio.h>
+
 // prj
 #include "stypes.h"
 #include "pobjcl.h"
@@ -143,6 +145,8 @@ public:
 
   virtual bool match(class cl_hw *the_hw) { return(DD_FALSE); }
   virtual bool match(class cl_brk *brk) { return(DD_FALSE); }
+  virtual bool match(class cl_mem_profile *prof) { return(DD_FALSE); }
+  virtual bool match(class cl_tracer *tracer) { return(DD_FALSE); }
 
   virtual t_mem read(void);
   virtual t_mem read(enum hw_cath skip) { return(read()); }
@@ -203,6 +207,56 @@ public:
 };
 
 
+/* Access counters of an address space, kept outside of the cells */
+
+class cl_mem_profile: public cl_base
+{
+public:
+  class cl_address_space *mem;
+  unsigned long *reads, *writes;        // Indexed by address - start
+public:
+  cl_mem_profile(class cl_address_space *the_mem);
+  virtual ~cl_mem_profile(void);
+  virtual void clear(void);
+};
+
+class cl_profile_operator: public cl_memory_operator
+{
+protected:
+  class cl_mem_profile *prof;
+  unsigned long *reads, *writes;        // Counters of this cell
+public:
+  cl_profile_operator(class cl_memory_cell *acell, t_addr addr,
+                      t_mem *data_place, t_mem the_mask,
+                      class cl_mem_profile *the_prof);
+
+  virtual bool match(class cl_mem_profile *the_prof)
+  { return(prof == the_prof); }
+
+  virtual t_mem read(void);
+  virtual t_mem read(enum hw_cath skip);
+  virtual t_mem write(t_mem val);
+};
+
+/* Recording writes of the simulated program into the trace */
+
+class cl_trace_operator: public cl_memory_operator
+{
+protected:
+  class cl_tracer *tracer;
+  int space;                            // Index of the address space
+public:
+  cl_trace_operator(class cl_memory_cell *acell, t_addr addr,
+                    t_mem *data_place, t_mem the_mask,
+                    class cl_tracer *the_tracer, int the_space);
+
+  virtual bool match(class cl_tracer *the_tracer)
+  { return(tracer == the_tracer); }
+
+  virtual t_mem write(t_mem val);
+};
+
+
 /*
  * version 3 of cell
  */
@@ -228,6 +282,7 @@ public:
   virtual t_mem get_mask(void) { return(mask); }
   virtual TYPE_UBYTE get_flags(void);
   virtual bool get_flag(enum cell_flag flag);
+  virtual bool hooked(void) { return(operators != 0); }
   virtual void set_flags(TYPE_UBYTE what);
   virtual void set_flag(enum cell_flag flag, bool val);
 
@@ -249,6 +304,8 @@ public:
   virtual void append_operator(class cl_memory_operator *op);
   virtual void prepend_operator(class cl_memory_operator *op);
   virtual void del_operator(class cl_brk *brk);
+  virtual void del_operator(class cl_mem_profile *prof);
+  virtual void del_operator(class cl_tracer *tracer);
 
   virtual class cl_memory_cell *add_hw(class cl_hw *hw, int *ith, t_addr addr);
   //virtual class cl_hw *get_hw(int ith);
@@ -275,6 +332,13 @@ class cl_address_space: public cl_memory
 {
 protected:
   class cl_memory_cell **cells, *dummy;
+  // Data of plain cells (no hw or breakpoint operators), read and
+  // written directly. NULL where the cell must be asked.
+  t_mem **slots;
+  t_mem cell_mask;
+  // Incremented by bulk changes, single cells are reported by
+  // cell_changed()
+  unsigned long generation;
 public:
   class cl_decoder_list *decoders;
 public:
@@ -282,19 +346,26 @@ public:
   virtual ~cl_address_space(void);
 
   virtual bool is_address_space(void) { return(DD_TRUE); }
+  unsigned long get_generation(void) { return(generation); }
 
   virtual t_mem read(t_addr addr);
   virtual t_mem read(t_addr addr, enum hw_cath skip);
   virtual t_mem get(t_addr addr);
   virtual t_mem write(t_addr addr, t_mem val);
   virtual void set(t_addr addr, t_mem val);
+  virtual void set_block(t_addr addr, const t_mem *vals, t_addr n);
   virtual t_mem wadd(t_addr addr, long what);
   virtual void set_bit1(t_addr addr, t_mem bits);
   virtual void set_bit0(t_addr addr, t_mem bits);
 
+  void cell_changed(t_addr addr);
+
   virtual class cl_address_decoder *get_decoder(t_addr addr);
 
   virtual class cl_memory_cell *get_cell(t_addr addr);
+protected:
+  virtual void update_slot(t_addr idx);
+public:
   virtual int get_cell_flag(t_addr addr);
   virtual bool get_cell_flag(t_addr addr, enum cell_flag flag);
   virtual void set_cell_flag(t_addr addr, bool set_to, enum cell_flag flag);
@@ -312,6 +383,11 @@ public:
   virtual void set_brk(t_addr addr, class cl_brk *brk);
   virtual void del_brk(t_addr addr, class cl_brk *brk);
 
+  virtual void start_profile(class cl_mem_profile *prof);
+  virtual void stop_profile(class cl_mem_profile *prof);
+  virtual void start_trace(class cl_tracer *tracer, int space);
+  virtual void stop_trace(class cl_tracer *tracer);
+
 #ifdef STATISTIC
   virtual unsigned long get_nuof_reads(void) { return(0); }
   virtual unsigned long get_nuof_writes(void) { return(0); }
@@ -355,6 +431,9 @@ public:
   virtual void set(t_addr addr, t_mem val);
   virtual void set_bit1(t_addr addr, t_mem bits);
   virtual void set_bit0(t_addr addr, t_mem bits);
+
+  virtual bool save_state(FILE *f);
+  virtual bool load_state(FILE *f);
 };
 
 
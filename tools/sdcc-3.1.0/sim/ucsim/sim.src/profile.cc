@@ -0,0 +1,501 @@
+/*
+ * Simulator of microcontrollers (sim.src/profile.cc)
+ */
+
+/* This file is part of microcontroller simulator: ucsim.
+
+UCSIM is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+UCSIM is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with UCSIM; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA. */
+/*@1@*/
+
+#include "ddconfig.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "i_string.h"
+
+// cmd.src
+#include "newcmdcl.h"
+
+// local
+#include "uccl.h"
+#include "profilecl.h"
+
+
+/*
+ * Code symbols
+ */
+
+cl_prof_symbol::cl_prof_symbol(const char *aname, t_addr the_addr):
+  cl_base()
+{
+  set_name(aname);
+  addr= the_addr;
+  end= the_addr;
+  has_end= DD_FALSE;
+}
+
+
+cl_prof_symbols::cl_prof_symbols(void):
+  cl_sorted_list(16, 16, "symbols")
+{
+}
+
+const void *
+cl_prof_symbols::key_of(void *item)
+{
+  return(&(((class cl_prof_symbol *)item)->addr));
+}
+
+int
+cl_prof_symbols::compare(const void *key1, const void *key2)
+{
+  t_addr a1= *(const t_addr *)key1, a2= *(const t_addr *)key2;
+
+  if (a1 < a2)
+    return(-1);
+  if (a1 > a2)
+    return(1);
+  return(0);
+}
+
+/* Symbol which contains the address, it is the nearest one below addr if
+   the end of the function is not known */
+
+class cl_prof_symbol *
+cl_prof_symbols::symbol_of(t_addr addr)
+{
+  t_index i;
+  class cl_prof_symbol *sym;
+
+  if (!search(&addr, i))
+    {
+      if (i == 0)
+        return(0);
+      i--;
+    }
+  sym= (class cl_prof_symbol *)at(i);
+  if (sym->has_end &&
+      addr > sym->end)
+    return(0);
+  return(sym);
+}
+
+
+/*
+ * Profiler
+ */
+
+cl_profiler::cl_profiler(class cl_uc *auc):
+  cl_base()
+{
+  uc= auc;
+  code_start= code_size= 0;
+  execs= cycles= 0;
+  mems= new cl_list(2, 2, "profiled memories");
+  symbols= new cl_prof_symbols();
+}
+
+cl_profiler::~cl_profiler(void)
+{
+  int i;
+
+  for (i= 0; i < mems->count; i++)
+    {
+      class cl_mem_profile *p= (class cl_mem_profile *)(mems->at(i));
+      p->mem->stop_profile(p);
+    }
+  mems->free_all();
+  delete mems;
+  symbols->free_all();
+  delete symbols;
+  if (execs)
+    free(execs);
+  if (cycles)
+    free(cycles);
+}
+
+int
+cl_profiler::init(void)
+{
+  int i;
+
+  cl_base::init();
+  set_name("profiler");
+  if (uc->rom)
+    {
+      code_start= uc->rom->start_address;
+      code_size= uc->rom->get_size();
+    }
+  execs= (unsigned long *)calloc(code_size?code_size:1,
+                                 sizeof(unsigned long));
+  cycles= (unsigned long *)calloc(code_size?code_size:1,
+                                  sizeof(unsigned long));
+  // ROM is counted by inst_done(), its fetch path is left alone
+  for (i= 0; i < uc->address_spaces->count; i++)
+    {
+      class cl_address_space *as=
+        (class cl_address_space *)(uc->address_spaces->at(i));
+      if (as == uc->rom)
+        continue;
+      class cl_mem_profile *p= new cl_mem_profile(as);
+      p->init();
+      as->start_profile(p);
+      mems->add(p);
+    }
+  return(0);
+}
+
+void
+cl_profiler::clear(void)
+{
+  int i;
+
+  memset(execs, 0, code_size * sizeof(unsigned long));
+  memset(cycles, 0, code_size * sizeof(unsigned long));
+  for (i= 0; i < mems->count; i++)
+    ((class cl_mem_profile *)(mems->at(i)))->clear();
+}
+
+
+/* Reads function symbols of a .noi or .cdb file produced by the linker,
+   returns number of functions found or -1 on error */
+
+int
+cl_profiler::read_symbols(const char *file_name)
+{
+  FILE *f;
+  const char *ext;
+  int n;
+
+  if ((f= fopen(file_name, "r")) == NULL)
+    return(-1);
+  symbols->free_all();
+  ext= strrchr(file_name, '.');
+  if (ext &&
+      strcasecmp(ext, ".noi") == 0)
+    n= read_noi(f);
+  else
+    n= read_cdb(f);
+  fclose(f);
+  return(n);
+}
+
+/* Name of the function from a cdb key like G$main$0$0 */
+
+static char *
+cdb_name(const char *key, char *buf, int size)
+{
+  const char *s= strchr(key, '$');
+  int i= 0;
+
+  if (!s)
+    s= key;
+  else
+    s++;
+  while (*s &&
+         *s != '$' &&
+         i < size-1)
+    buf[i++]= *s++;
+  buf[i]= '\0';
+  return(buf);
+}
+
+/* Functions are declared by F: records, linker gives the start address
+   in L:key:addr and the end in L:Xkey:addr records */
+
+int
+cl_profiler::read_cdb(FILE *f)
+{
+  char line[1024], name[256], *s, *a;
+  class cl_strings *funcs= new cl_strings(16, 16, "cdb functions");
+  t_index idx;
+  int i;
+
+  while (fgets(line, sizeof(line), f))
+    {
+      if (line[0] != 'F' ||
+          line[1] != ':')
+        continue;
+      if ((s= strchr(line+2, '(')) != NULL)
+        *s= '\0';
+      funcs->add(strdup(line+2));
+    }
+  rewind(f);
+  while (fgets(line, sizeof(line), f))
+    {
+      if (line[0] != 'L' ||
+          line[1] != ':' ||
+          line[2] == 'A' ||
+          line[2] == 'C')
+        continue;
+      if ((a= strrchr(line, ':')) == NULL ||
+          a == line+1)
+        continue;
+      *a++= '\0';
+      s= line+2;
+      bool is_end= (*s == 'X');
+      if (is_end)
+        s++;
+      if (!funcs->search(s, idx))
+        continue;
+      t_addr addr= strtoul(a, NULL, 16);
+      if (!is_end)
+        {
+          symbols->add(new cl_prof_symbol(cdb_name(s, name, sizeof(name)),
+                                          addr));
+          continue;
+        }
+      // End record, look for the function it closes
+      for (i= 0; i < symbols->count; i++)
+        {
+          class cl_prof_symbol *sym=
+            (class cl_prof_symbol *)(symbols->at(i));
+          if (!sym->has_end &&
+              sym->addr <= addr &&
+              strcmp(sym->get_name(), cdb_name(s, name, sizeof(name))) == 0)
+            {
+              sym->end= addr;
+              sym->has_end= DD_TRUE;
+              break;
+            }
+        }
+    }
+  delete funcs;
+  return(symbols->count);
+}
+
+/* Address of a NoICE record is page:0xaddr */
+
+static t_addr
+noi_addr(const char *s)
+{
+  const char *c= strchr(s, ':');
+
+  return(strtoul(c?(c+1):s, NULL, 0));
+}
+
+/* FUNC and SFUNC records start a function, ENDF closes the last one. If
+   there is no function record (no debug info) DEF symbols are used. */
+
+int
+cl_profiler::read_noi(FILE *f)
+{
+  char line[1024], *cmd, *name, *a;
+  class cl_prof_symbol *last= 0;
+  bool had_func= DD_FALSE;
+
+  while (fgets(line, sizeof(line), f))
+    {
+      if ((cmd= strtok(line, " \t\r\n")) == NULL)
+        continue;
+      if (strcasecmp(cmd, "FUNC") == 0 ||
+          strcasecmp(cmd, "SFUNC") == 0)
+        {
+          if ((name= strtok(NULL, " \t\r\n")) == NULL ||
+              (a= strtok(NULL, " \t\r\n")) == NULL)
+            continue;
+          if (!had_func)
+            symbols->free_all();
+          had_func= DD_TRUE;
+          symbols->add(last= new cl_prof_symbol(name, noi_addr(a)));
+        }
+      else if (strcasecmp(cmd, "ENDF") == 0)
+        {
+          if (!last ||
+              (a= strtok(NULL, " \t\r\n")) == NULL)
+            continue;
+          last->end= noi_addr(a);
+          last->has_end= DD_TRUE;
+          last= 0;
+        }
+      else if (strcasecmp(cmd, "DEF") == 0 &&
+               !had_func)
+        {
+          if ((name= strtok(NULL, " \t\r\n")) == NULL ||
+              (a= strtok(NULL, " \t\r\n")) == NULL)
+            continue;
+          t_addr addr= noi_addr(a);
+          if (addr < code_start ||
+              addr - code_start >= code_size)
+            continue;
+          if (*name == '_')
+            name++;
+          symbols->add(new cl_prof_symbol(name, addr));
+        }
+    }
+  return(symbols->count);
+}
+
+
+/* Totals of functions, last element belongs to code outside of known
+   functions. Returns number of elements, funcs must be freed. */
+
+int
+cl_profiler::functions(struct t_prof_func **funcs)
+{
+  int n= symbols->count + 1;
+  t_addr i;
+  t_index idx;
+
+  *funcs= (struct t_prof_func *)calloc(n, sizeof(struct t_prof_func));
+  for (idx= 0; idx < symbols->count; idx++)
+    (*funcs)[idx].sym= (class cl_prof_symbol *)(symbols->at(idx));
+  for (i= 0; i < code_size; i++)
+    {
+      if (!execs[i])
+        continue;
+      class cl_prof_symbol *sym= symbols->symbol_of(code_start + i);
+      if (!sym ||
+          (idx= symbols->index_of(sym)) == ccNotFound)
+        idx= n-1;
+      (*funcs)[idx].execs+= execs[i];
+      (*funcs)[idx].cycles+= cycles[i];
+    }
+  return(n);
+}
+
+static int
+func_cmp(const void *p1, const void *p2)
+{
+  const struct t_prof_func *f1= (const struct t_prof_func *)p1;
+  const struct t_prof_func *f2= (const struct t_prof_func *)p2;
+
+  if (f1->cycles > f2->cycles)
+    return(-1);
+  if (f1->cycles < f2->cycles)
+    return(1);
+  return(0);
+}
+
+void
+cl_profiler::print_functions(class cl_console_base *con, int max)
+{
+  struct t_prof_func *funcs;
+  unsigned long total= 0;
+  int n, i;
+
+  n= functions(&funcs);
+  for (i= 0; i < n; i++)
+    total+= funcs[i].cycles;
+  qsort(funcs, n, sizeof(struct t_prof_func), func_cmp);
+  con->dd_printf("     Execs     Cycles      %%  Function\n");
+  for (i= 0; i < n && (max <= 0 || i < max); i++)
+    {
+      if (!funcs[i].execs)
+        break;
+      con->dd_printf("%10lu %10lu %6.2f  ", funcs[i].execs, funcs[i].cycles,
+                     total?(100.0*funcs[i].cycles/total):0.0);
+      if (funcs[i].sym)
+        con->dd_printf("%s (0x%06" _A_ "x)\n", funcs[i].sym->get_name(),
+                       funcs[i].sym->addr);
+      else
+        con->dd_printf("???\n");
+    }
+  con->dd_printf("Total: %lu cycles\n", total);
+  free(funcs);
+}
+
+/* Non zero counters of a memory in [start,end], for ROM these are
+   executions and cycles, for other memories reads and writes */
+
+void
+cl_profiler::print_memory(class cl_console_base *con,
+                          class cl_address_space *mem,
+                          t_addr start, t_addr end)
+{
+  unsigned long *c1= 0, *c2= 0;
+  t_addr i;
+  int j;
+
+  if (mem == uc->rom)
+    {
+      c1= execs;
+      c2= cycles;
+      con->dd_printf("Address       Execs     Cycles\n");
+    }
+  else
+    {
+      for (j= 0; j < mems->count; j++)
+        {
+          class cl_mem_profile *p= (class cl_mem_profile *)(mems->at(j));
+          if (p->mem == mem)
+            {
+              c1= p->reads;
+              c2= p->writes;
+            }
+        }
+      con->dd_printf("Address       Reads     Writes\n");
+    }
+  if (!c1)
+    return;
+  if (start < mem->start_address)
+    start= mem->start_address;
+  if (end > mem->highest_valid_address())
+    end= mem->highest_valid_address();
+  for (i= start; i <= end; i++)
+    {
+      t_addr o= i - mem->start_address;
+      if (c1[o] ||
+          c2[o])
+        con->dd_printf("0x%06" _A_ "x %10lu %10lu\n", i, c1[o], c2[o]);
+    }
+}
+
+/* Writes the execution counters in the format of callgrind so
+   kcachegrind and callgrind_annotate can be used to browse them */
+
+bool
+cl_profiler::write_callgrind(FILE *f)
+{
+  struct t_prof_func *funcs;
+  unsigned long total_e= 0, total_c= 0;
+  class cl_prof_symbol *last= 0;
+  bool started= DD_FALSE;
+  int n, i;
+  t_addr a;
+
+  n= functions(&funcs);
+  for (i= 0; i < n; i++)
+    {
+      total_e+= funcs[i].execs;
+      total_c+= funcs[i].cycles;
+    }
+  fprintf(f, "# callgrind format\n");
+  fprintf(f, "version: 1\n");
+  fprintf(f, "creator: ucsim\n");
+  fprintf(f, "cmd: %s\n", uc->id_string());
+  fprintf(f, "positions: instr\n");
+  fprintf(f, "events: Instructions Cycles\n");
+  fprintf(f, "summary: %lu %lu\n", total_e, total_c);
+  // Addresses are in order, a new block starts where the function changes
+  for (a= 0; a < code_size; a++)
+    {
+      if (!execs[a])
+        continue;
+      class cl_prof_symbol *sym= symbols->symbol_of(code_start + a);
+      if (!started ||
+          sym != last)
+        fprintf(f, "\nfl=???\nfn=%s\n", sym?sym->get_name():"???");
+      started= DD_TRUE;
+      last= sym;
+      fprintf(f, "0x%" _A_ "x %lu %lu\n", code_start + a, execs[a], cycles[a]);
+    }
+  free(funcs);
+  return(!ferror(f));
+}
+
+
+/* End of sim.src/profile.cc */
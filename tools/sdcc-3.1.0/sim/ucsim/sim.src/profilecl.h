@@ -0,0 +1,117 @@
+/*
+ * Simulator of microcontrollers (sim.src/profilecl.h)
+ */
+
+/* This file is part of microcontroller simulator: ucsim.
+
+UCSIM is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+UCSIM is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with UCSIM; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA. */
+/*@1@*/
+
+#ifndef SIM_PROFILECL_HEADER
+#define SIM_PROFILECL_HEADER
+
+#include <stdio.h>
+
+// prj
+#include "stypes.h"
+#include "pobjcl.h"
+
+// local
+#include "memcl.h"
+
+
+/* Code symbol (function) read from a cdb or noi file */
+
+class cl_prof_symbol: public cl_base
+{
+public:
+  t_addr addr, end;     // end is only valid if has_end
+  bool has_end;
+public:
+  cl_prof_symbol(const char *aname, t_addr the_addr);
+};
+
+/* Symbols sorted by address */
+
+class cl_prof_symbols: public cl_sorted_list
+{
+public:
+  cl_prof_symbols(void);
+  virtual const void *key_of(void *item);
+  virtual int compare(const void *key1, const void *key2);
+
+  virtual class cl_prof_symbol *symbol_of(t_addr addr);
+};
+
+/* Totals of a function */
+
+struct t_prof_func
+{
+  class cl_prof_symbol *sym;
+  unsigned long execs, cycles;
+};
+
+
+/* Execution and memory access statistics. The controller has one while
+   profiling is switched on, counters are in arrays indexed by address
+   so nothing is allocated per cell or executed when it is off. */
+
+class cl_profiler: public cl_base
+{
+protected:
+  class cl_uc *uc;
+  t_addr code_start, code_size;
+public:
+  unsigned long *execs;         // Executions of instruction at ROM address
+  unsigned long *cycles;        // Machine cycles spent there
+  class cl_list *mems;          // cl_mem_profile of data memories
+  class cl_prof_symbols *symbols;
+
+public:
+  cl_profiler(class cl_uc *auc);
+  virtual ~cl_profiler(void);
+  virtual int init(void);
+
+  // Called by the controller after an instruction
+  void inst_done(t_addr addr, int inst_cycles)
+  {
+    t_addr i= addr - code_start;
+    if (i < code_size)
+      {
+        execs[i]++;
+        cycles[i]+= inst_cycles;
+      }
+  }
+
+  virtual void clear(void);
+  virtual int read_symbols(const char *file_name);
+  virtual int functions(struct t_prof_func **funcs);
+
+  virtual void print_functions(class cl_console_base *con, int max);
+  virtual void print_memory(class cl_console_base *con,
+                            class cl_address_space *mem,
+                            t_addr start, t_addr end);
+  virtual bool write_callgrind(FILE *f);
+
+protected:
+  virtual int read_cdb(FILE *f);
+  virtual int read_noi(FILE *f);
+};
+
+
+#endif
+
+/* End of sim.src/profilecl.h */
@@ -53,11 +53,19 @@ cl_sim::cl_sim(class cl_app *the_app):
 {
   app= the_app;
   uc= 0;
+  cores= new cl_list(2, 2, "controllers");
+  quantum_option= 0;
+  quantum= 1000;
+  quanta= 0;
+  slice_end= 0;
+  slice_core= 0;
   //arguments= new cl_list(2, 2);
   //accept_args= more_args?strdup(more_args):0;
   gui= new cl_gui(this);
 
   state = SIM_QUIT;
+  run_until= HW_NEVER;
+  stop_reason= resGO;
   argc = 0;
   argv = 0;
 }
@@ -66,17 +74,23 @@ int
 cl_sim::init(void)
 {
   cl_base::init();
+  quantum_option= new cl_optref(this);
+  quantum_option->init();
+  quantum_option->use("quantum");
   build_cmdset(app->get_commander()->cmdset);
   if (!(uc= mk_controller()))
     return(1);
+  cores->add(uc);
   uc->init();
   return(0);
 }
 
 cl_sim::~cl_sim(void)
 {
-  if (uc)
-    delete uc;
+  cores->free_all();
+  delete cores;
+  if (quantum_option)
+    delete quantum_option;
 }
 
 class cl_uc *
@@ -85,6 +99,57 @@ cl_sim::mk_controller(void)
   return(new cl_uc(this));
 }
 
+/* Controller of the given type, or of the default one if type is NULL.
+   Simulators which know only one type accept no type name. */
+
+class cl_uc *
+cl_sim::mk_core(const char *type)
+{
+  if (type)
+    return(NULL);
+  return(mk_controller());
+}
+
+/* An other controller which runs together with the existing ones. It
+   starts with a reset at time zero, and runs alone until it catches up
+   with the others. */
+
+class cl_uc *
+cl_sim::add_core(const char *type)
+{
+  class cl_uc *c;
+
+  if (!(c= mk_core(type)))
+    return(NULL);
+  c->core_id= cores->count;
+  cores->add(c);
+  c->init();
+  if (cores->count == 2)
+    {
+      if ((quantum= quantum_option->get_value(quantum)) < 1)
+        quantum= 1;
+      slice_core= 0;
+      slice_end= ((class cl_uc *)(cores->at(0)))->hw_cycles + quantum;
+    }
+  return(c);
+}
+
+/* Machine cycles of controller c under the same time as cycles of the
+   first controller */
+
+unsigned long
+cl_sim::core_cycles(class cl_uc *c, unsigned long cycles)
+{
+  class cl_uc *first= (class cl_uc *)(cores->at(0));
+  double f0= first->xtal / first->clock_per_cycle();
+  double f= c->xtal / c->clock_per_cycle();
+
+  if (c == first ||
+      f == f0)
+    return(cycles);
+  return((unsigned long)(cycles * (f / f0)));
+}
+
 
 /*
  * Main cycle of the simulator
@@ -115,14 +180,65 @@ cl_sim::main(void)
   return(0);
 }
 
+/*
+ * Executing a block of instructions, consoles are checked for input
+ * between blocks only
+ */
+
 int
 cl_sim::step(void)
 {
   if (state & SIM_GO)
-    uc->do_inst(1);
+    {
+      if (cores->count > 1)
+        step_cores();
+      else
+        uc->do_block(SIM_BLOCK, run_until);
+      if ((state & SIM_GO) &&
+          uc->hw_cycles >= run_until)
+        stop(resCYCLES);
+    }
   return(0);
 }
 
+/*
+ * Co-simulation of more controllers
+ *
+ * Controllers run one after the other, each up to the end of the same
+ * time slice, which is `quantum' machine cycles of the first controller
+ * (others run for the same time by their own clock). Links between
+ * controllers deliver data sent in a slice in the next slice only, see
+ * `quanta', so results depend on the quantum but neither on the order
+ * of controllers nor on the host. A controller which stops the
+ * simulation becomes the selected one.
+ */
+
+void
+cl_sim::step_cores(void)
+{
+  class cl_uc *selected= uc, *c;
+  unsigned long end, start;
+
+  c= (class cl_uc *)(cores->at(slice_core));
+  end= core_cycles(c, slice_end);
+  start= c->hw_cycles;
+  uc= c;
+  c->do_block(SIM_BLOCK, (c == selected && run_until < end)?run_until:end);
+  if (!(state & SIM_GO))
+    return;
+  uc= selected;
+  // clock of a controller in power down mode does not run
+  if (c->hw_cycles < end &&
+      c->hw_cycles != start)
+    return;
+  if (++slice_core >= cores->count)
+    {
+      slice_core= 0;
+      quanta++;
+      slice_end+= quantum;
+    }
+}
+
 /*int
 cl_sim::do_cmd(char *cmdstr, class cl_console_base *console)
 {
@@ -145,22 +261,41 @@ void
 cl_sim::start(class cl_console_base *con)
 {
   state|= SIM_GO;
+  run_until= HW_NEVER;
+  stop_reason= resGO;
+  if ((quantum= quantum_option->get_value(quantum)) < 1)
+    quantum= 1;
   con->flags|= CONS_FROZEN;
   app->get_commander()->frozen_console= con;
   app->get_commander()->set_fd_set();
 }
 
+/* Run until the given number of machine cycles are executed */
+
+void
+cl_sim::start_for(class cl_console_base *con, unsigned long cycles)
+{
+  start(con);
+  run_until= uc->hw_cycles + cycles;
+}
+
 void
 cl_sim::stop(int reason)
 {
   class cl_commander_base *cmd= app->get_commander();
+  int i;
 
   state&= ~SIM_GO;
+  stop_reason= reason;
+  for (i= 0; i < cores->count; i++)
+    ((class cl_uc *)(cores->at(i)))->sync_hw();
   if (cmd->frozen_console)
     {
       if (reason == resUSER &&
           cmd->frozen_console->input_avail())
         cmd->frozen_console->read_line();
+      if (cores->count > 1)
+        cmd->frozen_console->dd_printf("Controller %d\n", uc->core_id);
       cmd->frozen_console->dd_printf("Stop at 0x%06x: (%d) ", uc->PC, reason);
       switch (reason)
         {
@@ -197,6 +332,9 @@ cl_sim::stop(int reason)
         case resERROR:
           // uc::check_error prints error messages...
           break;
+        case resCYCLES:
+          cmd->frozen_console->dd_printf("Cycles executed\n");
+          break;
         default:
           cmd->frozen_console->dd_printf("Unknown reason\n");
           break;
@@ -205,7 +343,9 @@ cl_sim::stop(int reason)
       //if (cmd->actual_console != cmd->frozen_console)
       cmd->frozen_console->flags&= ~CONS_FROZEN;
       cmd->frozen_console->print_prompt();
+      class cl_console_base *con= cmd->frozen_console;
       cmd->frozen_console= 0;
+      con->stopped(reason);
     }
   cmd->set_fd_set();
 }
@@ -214,8 +354,12 @@ void
 cl_sim::stop(class cl_ev_brk *brk)
 {
   class cl_commander_base *cmd= app->get_commander();
+  int i;
 
   state&= ~SIM_GO;
+  stop_reason= resBREAKPOINT;
+  for (i= 0; i < cores->count; i++)
+    ((class cl_uc *)(cores->at(i)))->sync_hw();
   if (cmd->frozen_console)
     {
       class cl_console_base *con= cmd->frozen_console;
@@ -229,6 +373,7 @@ cl_sim::stop(class cl_ev_brk *brk)
                      brk->id, brk->get_mem()->get_name(), brk->addr,
                      uc->instPC,
                      uc->disass(uc->instPC, " "));
+      con->stopped(resBREAKPOINT);
       //con->flags&= ~CONS_FROZEN;
       //con->print_prompt();
       //cmd->frozen_console= 0;
@@ -269,6 +414,36 @@ cl_sim::build_cmdset(class cl_cmdset *cmdset)
   cmd->init();
   cmd->add_name("n");
 
+  cmdset->add(cmd= new cl_run_for_cmd("runfor", 0,
+"runfor cycles      Go for given number of machine cycles",
+"long help of runfor"));
+  cmd->init();
+
+  {
+    cset= new cl_cmdset();
+    cset->init();
+    cset->add(cmd= new cl_core_list_cmd("list", 0,
+"core list          List co-simulated controllers, * marks the selected",
+"long help of core list"));
+    cmd->init();
+    cset->add(cmd= new cl_core_add_cmd("add", 0,
+"core add [\"TYPE\"] Add a controller which runs with the others",
+"long help of core add"));
+    cmd->init();
+    cset->add(cmd= new cl_core_select_cmd("select", 0,
+"core select nr     Select controller, other commands work on it",
+"long help of core select"));
+    cmd->init();
+    cset->add(cmd= new cl_core_link_cmd("link", 0,
+"core link nr1 nr2  Connect uarts of two controllers",
+"long help of core link"));
+    cmd->init();
+  }
+  cmdset->add(cmd= new cl_super_cmd("core", 0,
+"core subcommand    Co-simulation of more controllers",
+"long help of core", cset));
+  cmd->init();
+
   {
     cset= new cl_cmdset();
     cset->init();
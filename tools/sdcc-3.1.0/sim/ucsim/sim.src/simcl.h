@@ -44,17 +44,31 @@ Software Foundation, 59 Temple Place - Suite 330, Boston, MA
 #include "argcl.h"
 
 
+// Nr of instructions executed between checks of consoles
+#define SIM_BLOCK	1000
+
+
 class cl_sim: public cl_base
 {
 public:
   class cl_app *app;
   int state; // See SIM_XXXX
+  unsigned long run_until; // Stop when uc->hw_cycles reaches this
+  int stop_reason; // Reason of the last stop, see resXXXX
   int argc; char **argv;
 
   //class cl_commander_base *cmd;
-  class cl_uc *uc;
+  class cl_uc *uc;              // Selected controller, commands work on it
+  class cl_list *cores;         // All controllers, first is made by init()
   class cl_gui *gui;
 
+  // Controllers run in turns of time slices, see step_cores()
+  class cl_optref *quantum_option;
+  long quantum;                 // Machine cycles of first uc in a slice
+  unsigned long quanta;         // Number of finished slices
+  unsigned long slice_end;      // hw_cycles of first uc at end of slice
+  int slice_core;               // Index of controller running in the slice
+
   //char *accept_args;
   //class cl_list *arguments;
   
@@ -64,6 +78,9 @@ public:
   virtual int init(void);
   
   virtual class cl_uc *mk_controller(void);
+  virtual class cl_uc *mk_core(const char *type);
+  virtual class cl_uc *add_core(const char *type);
+  virtual unsigned long core_cycles(class cl_uc *c, unsigned long cycles);
   virtual void build_cmdset(class cl_cmdset *cmdset);
 
   virtual class cl_uc *get_uc(void) { return(uc); }
@@ -73,9 +90,11 @@ public:
   
   virtual int main(void);
   virtual void start(class cl_console_base *con);
+  virtual void start_for(class cl_console_base *con, unsigned long cycles);
   virtual void stop(int reason);
   virtual void stop(class cl_ev_brk *brk);
   virtual int step(void);
+  virtual void step_cores(void);
 };
 
 
@@ -20,23 +20,25 @@ class cl_hw_test: public cl_hw
 {
 public:
   cl_hw_test(void): cl_hw(0, HW_PORT, 0, "0") {}
-  virtual t_mem r(class cl_cell *cell, t_addr addr);
-  virtual void write(class cl_mem *mem, t_addr addr, t_mem *val);
+  virtual t_mem read(class cl_memory_cell *cell);
+  virtual void write(class cl_memory_cell *cell, t_mem *val);
 };
 
 t_mem
-cl_hw_test::r(class cl_cell *cell, t_addr addr)
+cl_hw_test::read(class cl_memory_cell *cell)
 {
   return(cell->get());
 }
 
 void
-cl_hw_test::write(class cl_mem *mem, t_addr addr, t_mem *val)
+cl_hw_test::write(class cl_memory_cell *cell, t_mem *val)
 {
 }
 
+/* Read/write through the address space */
+
 double
-do_rw_test(class cl_mem *mem, int time)
+do_rw_test(class cl_address_space *mem, int time)
 {
   double counter;
   t_addr a;
@@ -46,7 +48,7 @@ do_rw_test(class cl_mem *mem, int time)
   counter= 0;
   alarm(time);
   while (go)
-    for (a= 0; go && a < mem->size; a++)
+    for (a= 0; go && a < mem->get_size(); a++)
       {
         t_mem d2;
         for (d2= 0; go && d2 <= 255; d2++)
@@ -61,39 +63,67 @@ do_rw_test(class cl_mem *mem, int time)
   return(counter);
 }
 
+/* Read/write through the cell objects, as every access did before the
+   address space got its flat fast path */
+
+double
+do_cell_rw_test(class cl_address_space *mem, int time)
+{
+  double counter;
+  t_addr a;
+  t_mem d;
+
+  go= 1;
+  counter= 0;
+  alarm(time);
+  while (go)
+    for (a= 0; go && a < mem->get_size(); a++)
+      {
+        t_mem d2;
+        for (d2= 0; go && d2 <= 255; d2++)
+          {
+            d2= mem->get_cell(a)->write(d2);
+            d= mem->get_cell(a)->read();
+            if (d != d2)
+              printf("%"_M_"d written to mem and %"_M_"d read back!\n", d2, d);
+            counter+= 1;
+          }
+      }
+  return(counter);
+}
+
 int
 main(void)
 {
   int i;
-  class cl_mem *mem;
-  class cl_m *m2;
-  class cl_console_base *con;
+  class cl_address_space *as;
+  class cl_memory_chip *chip;
+  class cl_address_decoder *ad;
 
   signal(SIGALRM, alarmed);
-  con= new cl_console_base(stdin, stdout, 0);
 
-  mem= new cl_mem(MEM_SFR, "egy", 0x10000, 8, 0);
-  mem->init();
-  printf("%g operations on classic memory within 5 sec\n",
-         do_rw_test(mem, 5));
-  //mem->dump(con);
+  as= new cl_address_space("xram", 0, 0x10000, 8);
+  as->init();
+  chip= new cl_memory_chip("xram_chip", 0x10000, 8);
+  chip->init();
+  ad= new cl_address_decoder(as, chip, 0, 0xffff, 0);
+  ad->init();
+  as->decoders->add(ad);
+  ad->activate(0);
 
-  m2= new cl_m(MEM_TYPES, "test", 0x10000, 8, 0);
-  m2->init();
-  printf("%g operations on new memory within 5 sec\n",
-         do_rw_test(m2, 5));
+  printf("%g operations on plain memory within 5 sec\n",
+         do_rw_test(as, 5));
+  printf("%g operations on plain memory cells within 5 sec\n",
+         do_cell_rw_test(as, 5));
 
   class cl_hw_test *hw= new cl_hw_test();
   for (i= 0; i < 0x10000; i++)
     {
-      class cl_cell *c= m2->get_cell(i);
       int dummy;
-      if (c)
-        c->add_hw(hw, &dummy);
+      as->register_hw(i, hw, &dummy, DD_FALSE);
     }
-  printf("%g operations on new memory within 5 sec with hw read\n",
-         do_rw_test(m2, 5));
-  //m2->dump(con);
+  printf("%g operations on memory within 5 sec with hw read\n",
+         do_rw_test(as, 5));
 
   return(0);
 }
@@ -0,0 +1,478 @@
+/*
+ * Simulator of microcontrollers (sim.src/trace.cc)
+ */
+
+/* This file is part of microcontroller simulator: ucsim.
+
+UCSIM is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+UCSIM is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with UCSIM; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA. */
+/*@1@*/
+
+#include "ddconfig.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include "i_string.h"
+
+// prj
+#include "utils.h"
+
+// cmd.src
+#include "newcmdcl.h"
+
+// local
+#include "uccl.h"
+#include "tracecl.h"
+
+
+/* Encoding helpers */
+
+static inline unsigned char *
+put_varint(unsigned char *p, unsigned long v)
+{
+  while (v >= 0x80)
+    {
+      *p++= (v & 0x7f) | 0x80;
+      v>>= 7;
+    }
+  *p++= v;
+  return(p);
+}
+
+static bool
+get_varint(unsigned char **p, unsigned char *end, unsigned long *v)
+{
+  int shift= 0;
+
+  *v= 0;
+  while (*p < end)
+    {
+      unsigned char c= *(*p)++;
+      *v|= (unsigned long)(c & 0x7f) << shift;
+      if (!(c & 0x80))
+        return(DD_TRUE);
+      shift+= 7;
+    }
+  return(DD_FALSE);
+}
+
+// Fields of block headers in files are 32 bit little endian
+
+static bool
+put_u32(FILE *f, unsigned long v)
+{
+  unsigned char b[4];
+
+  b[0]= v;
+  b[1]= v >> 8;
+  b[2]= v >> 16;
+  b[3]= v >> 24;
+  return(fwrite(b, 4, 1, f) == 1);
+}
+
+static bool
+get_u32(FILE *f, unsigned long *v)
+{
+  unsigned char b[4];
+
+  if (fread(b, 4, 1, f) != 1)
+    return(DD_FALSE);
+  *v= b[0] | (b[1] << 8) | (b[2] << 16) | ((unsigned long)b[3] << 24);
+  return(DD_TRUE);
+}
+
+
+/*
+ * Recorder
+ */
+
+cl_tracer::cl_tracer(class cl_uc *auc, unsigned long size):
+  cl_base()
+{
+  uc= auc;
+  nuof_blocks= size / TRACE_BLOCK_SIZE;
+  if (nuof_blocks < 2)
+    nuof_blocks= 2;
+  buf= 0;
+  blocks= 0;
+  first= cur= 0;
+  valid= 0;
+  last_pc= 0;
+  last_cycles= 0;
+  nuof_writes= 0;
+  lost_writes= 0;
+  dropped_insts= 0;
+  file= 0;
+  hooked= new cl_list(2, 2, "traced memories");
+}
+
+cl_tracer::~cl_tracer(void)
+{
+  int i;
+
+  stop_file();
+  for (i= 0; i < hooked->count; i++)
+    ((class cl_address_space *)(hooked->at(i)))->stop_trace(this);
+  delete hooked;
+  if (buf)
+    free(buf);
+  if (blocks)
+    free(blocks);
+}
+
+int
+cl_tracer::init(void)
+{
+  int i;
+
+  cl_base::init();
+  set_name("tracer");
+  buf= (unsigned char *)malloc(nuof_blocks * TRACE_BLOCK_SIZE);
+  blocks= (struct t_trace_block *)calloc(nuof_blocks,
+                                         sizeof(struct t_trace_block));
+  // Code is not written by the program, fetches are not recorded
+  for (i= 0; i < uc->address_spaces->count; i++)
+    {
+      class cl_address_space *as=
+        (class cl_address_space *)(uc->address_spaces->at(i));
+      if (as == uc->rom)
+        continue;
+      as->start_trace(this, i);
+      hooked->add(as);
+    }
+  last_cycles= uc->hw_cycles;
+  new_block(uc->PC);
+  return(0);
+}
+
+/* Closes the current block and starts the next one. In file mode the
+   closed block is written out, otherwise the oldest one is dropped when
+   the ring is full. */
+
+void
+cl_tracer::new_block(t_addr pc)
+{
+  if (valid)
+    {
+      if (file)
+        write_block(file, cur);
+      cur= (cur + 1) % nuof_blocks;
+      if (valid == nuof_blocks)
+        {
+          dropped_insts+= blocks[first].insts;
+          first= (first + 1) % nuof_blocks;
+        }
+      else
+        valid++;
+    }
+  else
+    valid= 1;
+  blocks[cur].pc= pc;
+  blocks[cur].cycles= last_cycles;
+  blocks[cur].insts= 0;
+  blocks[cur].used= 0;
+  last_pc= pc;
+}
+
+/* Called after the instruction at addr and the hw elements are done */
+
+void
+cl_tracer::inst_done(t_addr addr)
+{
+  struct t_trace_block *blk= &blocks[cur];
+  unsigned char *p;
+  long d;
+  int i;
+
+  if (blk->used + TRACE_MAX_RECORD > TRACE_BLOCK_SIZE)
+    {
+      new_block(addr);
+      blk= &blocks[cur];
+    }
+  p= buf + cur*TRACE_BLOCK_SIZE + blk->used;
+  d= (long)addr - (long)last_pc;
+  p= put_varint(p, ((((unsigned long)d << 1) ^ (d < 0 ? ~0UL : 0UL)) << 1) |
+                (nuof_writes ? 1 : 0));
+  p= put_varint(p, uc->hw_cycles - last_cycles);
+  if (nuof_writes)
+    {
+      *p++= nuof_writes;
+      for (i= 0; i < nuof_writes; i++)
+        {
+          *p++= writes[i].space;
+          p= put_varint(p, writes[i].addr);
+          p= put_varint(p, writes[i].val);
+        }
+      nuof_writes= 0;
+    }
+  blk->used= p - (buf + cur*TRACE_BLOCK_SIZE);
+  blk->insts++;
+  last_pc= addr;
+  last_cycles= uc->hw_cycles;
+}
+
+
+bool
+cl_tracer::write_header(FILE *f)
+{
+  return(fprintf(f, "%s %s\n", TRACE_MAGIC, uc->id_string()) > 0);
+}
+
+bool
+cl_tracer::write_block(FILE *f, int idx)
+{
+  struct t_trace_block *blk= &blocks[idx];
+
+  if (!blk->insts)
+    return(DD_TRUE);
+  return(put_u32(f, blk->used) &&
+         put_u32(f, blk->pc) &&
+         put_u32(f, blk->cycles) &&
+         put_u32(f, (unsigned long)((blk->cycles >> 16) >> 16)) &&
+         put_u32(f, blk->insts) &&
+         fwrite(buf + idx*TRACE_BLOCK_SIZE, 1, blk->used, f) == blk->used);
+}
+
+/* Streams every finished block into the file, so the whole run is kept
+   and the ring holds only the last part */
+
+bool
+cl_tracer::start_file(const char *file_name)
+{
+  FILE *f;
+
+  stop_file();
+  if ((f= fopen(file_name, "wb")) == NULL)
+    return(DD_FALSE);
+  if (!write_header(f))
+    {
+      fclose(f);
+      return(DD_FALSE);
+    }
+  // Earlier instructions are not put into the file
+  new_block(uc->PC);
+  file= f;
+  return(DD_TRUE);
+}
+
+void
+cl_tracer::stop_file(void)
+{
+  if (!file)
+    return;
+  write_block(file, cur);
+  fclose(file);
+  file= 0;
+  // Blocks in the file must not be repeated by the next one
+  new_block(uc->PC);
+}
+
+/* Writes content of the ring */
+
+bool
+cl_tracer::save(const char *file_name)
+{
+  FILE *f;
+  bool ok;
+  int i;
+
+  if ((f= fopen(file_name, "wb")) == NULL)
+    return(DD_FALSE);
+  ok= write_header(f);
+  for (i= 0; ok && i < valid; i++)
+    ok= write_block(f, (first + i) % nuof_blocks);
+  if (fclose(f) != 0)
+    ok= DD_FALSE;
+  return(ok);
+}
+
+void
+cl_tracer::print_info(class cl_console_base *con)
+{
+  unsigned long insts= 0, bytes= 0;
+  int i;
+
+  for (i= 0; i < valid; i++)
+    {
+      insts+= blocks[(first + i) % nuof_blocks].insts;
+      bytes+= blocks[(first + i) % nuof_blocks].used;
+    }
+  con->dd_printf("Ring of %d blocks, %d KiB\n", nuof_blocks,
+                 nuof_blocks*(TRACE_BLOCK_SIZE/1024));
+  con->dd_printf("%lu instructions in %lu bytes (%.2f bytes/inst)\n",
+                 insts, bytes, insts?((double)bytes/insts):0.0);
+  con->dd_printf("%lu instructions dropped from the ring\n", dropped_insts);
+  if (lost_writes)
+    con->dd_printf("%lu writes not recorded (more than %d by an instruction)\n",
+                   lost_writes, TRACE_MAX_WRITES);
+  if (file)
+    con->dd_printf("Streaming into a file\n");
+}
+
+/* Prints the last max instructions of the ring, all if max is 0 */
+
+void
+cl_tracer::print(class cl_console_base *con, unsigned long max)
+{
+  class cl_trace_decoder dec(uc, con);
+  unsigned long insts= 0, skip= 0;
+  int i;
+
+  for (i= 0; i < valid; i++)
+    insts+= blocks[(first + i) % nuof_blocks].insts;
+  if (max &&
+      max < insts)
+    skip= insts - max;
+  for (i= 0; i < valid; i++)
+    {
+      int idx= (first + i) % nuof_blocks;
+      if (skip >= blocks[idx].insts)
+        {
+          skip-= blocks[idx].insts;
+          continue;
+        }
+      dec.print_block(&blocks[idx], buf + idx*TRACE_BLOCK_SIZE, skip);
+      skip= 0;
+    }
+}
+
+
+/*
+ * Decoder
+ */
+
+cl_trace_decoder::cl_trace_decoder(class cl_uc *auc,
+                                   class cl_console_base *acon):
+  cl_base()
+{
+  uc= auc;
+  con= acon;
+}
+
+/* Prints a trace file, only the last max instructions if max is not 0.
+   Returns number of printed blocks or -1 if the file is not valid. */
+
+int
+cl_trace_decoder::print_file(FILE *f, unsigned long max)
+{
+  char head[256];
+  char *id;
+  struct t_trace_block blk;
+  unsigned long hi, insts= 0, skip= 0;
+  unsigned char *data;
+  long start;
+  int n= 0;
+
+  if (!fgets(head, sizeof(head), f) ||
+      strncmp(head, TRACE_MAGIC " ", strlen(TRACE_MAGIC)+1) != 0)
+    return(-1);
+  id= format_string("%s %s\n", TRACE_MAGIC, uc->id_string());
+  if (strcmp(head, id) != 0)
+    con->dd_printf("Warning: trace was recorded by an other controller: %s",
+                   head + strlen(TRACE_MAGIC)+1);
+  free(id);
+  // First pass counts instructions to find the start of the last max
+  start= ftell(f);
+  while (get_u32(f, &blk.used) &&
+         fseek(f, 12, SEEK_CUR) == 0 &&
+         get_u32(f, &blk.insts) &&
+         fseek(f, blk.used, SEEK_CUR) == 0)
+    insts+= blk.insts;
+  if (max &&
+      max < insts)
+    skip= insts - max;
+  fseek(f, start, SEEK_SET);
+  data= (unsigned char *)malloc(TRACE_BLOCK_SIZE);
+  while (get_u32(f, &blk.used))
+    {
+      unsigned long pc, lo;
+      if (blk.used > TRACE_BLOCK_SIZE ||
+          !get_u32(f, &pc) ||
+          !get_u32(f, &lo) ||
+          !get_u32(f, &hi) ||
+          !get_u32(f, &blk.insts) ||
+          fread(data, 1, blk.used, f) != blk.used)
+        {
+          con->dd_printf("Trace file is truncated\n");
+          break;
+        }
+      blk.pc= pc;
+      blk.cycles= lo | ((hi << 16) << 16);
+      if (skip >= blk.insts)
+        {
+          skip-= blk.insts;
+          continue;
+        }
+      print_block(&blk, data, skip);
+      skip= 0;
+      n++;
+    }
+  free(data);
+  return(n);
+}
+
+/* Prints instructions of a block after the first skip ones with the
+   cycle counter at their end. Code is
+   disassembled from the ROM of the controller so the same program must
+   be loaded which was recorded. */
+
+int
+cl_trace_decoder::print_block(struct t_trace_block *blk, unsigned char *data,
+                              unsigned long skip)
+{
+  unsigned char *p= data, *end= data + blk->used;
+  unsigned long v, cyc, n= 0;
+  unsigned long cycles= blk->cycles;
+  t_addr pc= blk->pc;
+  int i, nw;
+
+  while (p < end)
+    {
+      unsigned long z, addr, val;
+      long d;
+      if (!get_varint(&p, end, &v) ||
+          !get_varint(&p, end, &cyc))
+        break;
+      z= v >> 1;
+      d= (z & 1) ? ~(long)(z >> 1) : (long)(z >> 1);
+      pc+= d;
+      nw= (v & 1) ? *p++ : 0;
+      cycles+= cyc;
+      if (n++ >= skip)
+        {
+          con->dd_printf("%10lu ", cycles);
+          uc->print_disass(pc, con);
+        }
+      for (i= 0; i < nw; i++)
+        {
+          int space= *p++;
+          if (!get_varint(&p, end, &addr) ||
+              !get_varint(&p, end, &val))
+            break;
+          if (n <= skip)
+            continue;
+          class cl_address_space *as= 0;
+          if (space < uc->address_spaces->count)
+            as= (class cl_address_space *)(uc->address_spaces->at(space));
+          con->dd_printf("%10s   %s[0x%lx]= 0x%lx\n", "",
+                         as?as->get_name():"?", addr, val);
+        }
+    }
+  return(n);
+}
+
+
+/* End of sim.src/trace.cc */
@@ -0,0 +1,142 @@
+/*
+ * Simulator of microcontrollers (sim.src/tracecl.h)
+ */
+
+/* This file is part of microcontroller simulator: ucsim.
+
+UCSIM is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+UCSIM is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with UCSIM; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA. */
+/*@1@*/
+
+#ifndef SIM_TRACECL_HEADER
+#define SIM_TRACECL_HEADER
+
+#include <stdio.h>
+
+// prj
+#include "stypes.h"
+#include "pobjcl.h"
+
+// local
+#include "memcl.h"
+
+
+/* The trace is a ring of blocks. A block starts with the absolute PC and
+   cycle counter so it can be decoded without the previous ones, records
+   of instructions inside are delta encoded:
+
+   varint  zigzag(PC - previous PC) << 1 | has_writes
+   varint  machine cycles since the previous one (idle time included)
+   [byte   number of writes
+    {byte space, varint address, varint value} ...]
+
+   A varint holds 7 bits per byte, low bits first, bit 7 set if more
+   bytes follow. */
+
+#define TRACE_BLOCK_SIZE        0x10000
+#define TRACE_MAX_WRITES        8       // Recorded writes of an instruction
+#define TRACE_MAX_RECORD        (2*5 + 1 + TRACE_MAX_WRITES*(1 + 2*5))
+#define TRACE_MAGIC             "ucsim trace 1"
+
+struct t_trace_block
+{
+  t_addr pc;                    // PC of the first instruction
+  unsigned long cycles;         // Machine cycles before the first one
+  unsigned long insts;          // Instructions in the block
+  unsigned long used;           // Bytes of records
+};
+
+struct t_trace_write
+{
+  int space;                    // Index in uc->address_spaces
+  t_addr addr;
+  t_mem val;
+};
+
+
+/* Recorder, the controller has one while tracing is on */
+
+class cl_tracer: public cl_base
+{
+public:
+  class cl_uc *uc;
+protected:
+  unsigned char *buf;           // Data of blocks
+  struct t_trace_block *blocks;
+  int nuof_blocks;
+  int first, valid;             // Oldest block and number of used ones
+  int cur;                      // Block being filled
+  t_addr last_pc;
+  unsigned long last_cycles;    // hw_cycles after the previous instruction
+  struct t_trace_write writes[TRACE_MAX_WRITES];
+  int nuof_writes;
+  unsigned long lost_writes;    // More than TRACE_MAX_WRITES in an inst
+  unsigned long dropped_insts;  // Overwritten by the ring
+  FILE *file;                   // Blocks are streamed here if not NULL
+  class cl_list *hooked;        // Address spaces with trace operators
+
+public:
+  cl_tracer(class cl_uc *auc, unsigned long size);
+  virtual ~cl_tracer(void);
+  virtual int init(void);
+
+  virtual bool start_file(const char *file_name);
+  virtual void stop_file(void);
+  virtual bool save(const char *file_name);
+  virtual void print_info(class cl_console_base *con);
+  virtual void print(class cl_console_base *con, unsigned long max);
+
+  // Called by trace operators of cells and by the controller
+  void written(int space, t_addr addr, t_mem val)
+  {
+    if (nuof_writes < TRACE_MAX_WRITES)
+      {
+        writes[nuof_writes].space= space;
+        writes[nuof_writes].addr= addr;
+        writes[nuof_writes].val= val;
+        nuof_writes++;
+      }
+    else
+      lost_writes++;
+  }
+  void inst_done(t_addr addr);
+
+protected:
+  virtual void new_block(t_addr pc);
+  virtual bool write_header(FILE *f);
+  virtual bool write_block(FILE *f, int idx);
+};
+
+
+/* Prints recorded blocks as disassembled instructions of the loaded
+   program, used for the ring and for trace files */
+
+class cl_trace_decoder: public cl_base
+{
+protected:
+  class cl_uc *uc;
+  class cl_console_base *con;
+public:
+  cl_trace_decoder(class cl_uc *auc, class cl_console_base *acon);
+
+  virtual int print_file(FILE *f, unsigned long max);
+  virtual int print_block(struct t_trace_block *blk, unsigned char *data,
+                          unsigned long skip);
+};
+
+
+#endif
+
+/* End of sim.src/tracecl.h */
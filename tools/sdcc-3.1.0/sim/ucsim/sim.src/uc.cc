@@ -46,6 +46,9 @@ Software Foundation, 59 Temple Place - Suite 330, Boston, MA
 #include "infocl.h"
 #include "timercl.h"
 #include "cmdstatcl.h"
+#include "cmdprofcl.h"
+#include "cmdtracecl.h"
+#include "cmdcovcl.h"
 #include "cmdmemcl.h"
 #include "cmdutil.h"
 
@@ -55,6 +58,9 @@ Software Foundation, 59 Temple Place - Suite 330, Boston, MA
 #include "memcl.h"
 #include "simcl.h"
 #include "itsrccl.h"
+#include "profilecl.h"
+#include "tracecl.h"
+#include "coveragecl.h"
 
 static class cl_uc_error_registry uc_error_registry;
 
@@ -122,6 +128,22 @@ cl_xtal_option::option_changed(void)
   uc->xtal= d;
 }
 
+cl_idle_skip_option::cl_idle_skip_option(class cl_uc *the_uc):
+  cl_optref(the_uc)
+{
+  uc= the_uc;
+}
+
+void
+cl_idle_skip_option::option_changed(void)
+{
+  if (!uc)
+    return;
+  bool b;
+  option->get_value(&b);
+  uc->idle_skip= b;
+}
+
 
 /*
  * Abstract microcontroller
@@ -144,6 +166,8 @@ cl_uc::cl_uc(class cl_sim *asim):
   //for (i= MEM_ROM; i < MEM_TYPES; i++) mems->add(0);
   xtal_option= new cl_xtal_option(this);
   xtal_option->init();
+  idle_skip_option= new cl_idle_skip_option(this);
+  idle_skip_option->init();
   ticks= new cl_ticker(+1, 0, "time");
   isr_ticks= new cl_ticker(+1, TICK_INISR, "isr");
   idle_ticks= new cl_ticker(+1, TICK_IDLE, "idle");
@@ -158,12 +182,32 @@ cl_uc::cl_uc(class cl_sim *asim):
   sp_max= 0;
   sp_avg= 0;
   inst_exec= DD_FALSE;
+  hw_cycles= 0;
+  hw_wakeup= 0;
+  idle_skip= DD_FALSE;
+  idle_skipped= 0;
+  idle_start= idle_end= 0;
+  idle_mark= idle_period= 0;
+  idle_passes= 0;
+  decoded= 0;
+  decoded_gen= 0;
+  idle_checked= DD_FALSE;
+  profiler= 0;
+  tracer= 0;
+  coverage= 0;
+  core_id= 0;
 }
 
 
 cl_uc::~cl_uc(void)
 {
   //delete mems;
+  if (profiler)
+    delete profiler;
+  if (tracer)
+    delete tracer;
+  if (coverage)
+    delete coverage;
   delete hws;
   //delete options;
   delete ticks;
@@ -180,9 +224,12 @@ cl_uc::~cl_uc(void)
   errors->free_all();
   delete errors;
   delete xtal_option;
+  delete idle_skip_option;
   delete address_spaces;
   delete memchips;
   //delete address_decoders;
+  if (decoded)
+    free(decoded);
 }
 
 
@@ -197,6 +244,8 @@ cl_uc::init(void)
     xtal= xtal_option->get_value(xtal);
   else
     xtal= 11059200;
+  if (idle_skip_option->use("idle_skip"))
+    idle_skip= idle_skip_option->get_value(idle_skip);
   make_memories();
   rom= address_space(MEM_ROM_ID);
   ebrk= new brk_coll(2, 2, rom);
@@ -205,6 +254,9 @@ cl_uc::init(void)
   brk_counter= 0;
   mk_hw_elements();
   reset();
+  // commands and input files are set up by the first controller
+  if (core_id)
+    return(0);
   class cl_cmdset *cs= sim->app->get_commander()->cmdset;
   build_cmdset(cs);
 
@@ -237,6 +289,8 @@ cl_uc::reset(void)
   ticks->ticks= 0;
   isr_ticks->ticks= 0;
   idle_ticks->ticks= 0;
+  idle_skipped= 0;
+  idle_passes= 0;
   /*FIXME should we clear user counters?*/
   il= (class it_level *)(it_levels->top());
   while (il &&
@@ -256,6 +310,7 @@ cl_uc::reset(void)
     {
       class cl_hw *hw= (class cl_hw *)(hws->at(i));
       hw->reset();
+      hw->schedule();
     }
 }
 
@@ -318,6 +373,16 @@ cl_uc::build_cmdset(class cl_cmdset *cmdset)
   cmd->init();
   cmd->add_name("dl");
 
+  cmdset->add(cmd= new cl_snapshot_cmd("snapshot", 0,
+"snapshot \"FILE\"    Save state of the simulated machine into FILE",
+"long help of snapshot"));
+  cmd->init();
+
+  cmdset->add(cmd= new cl_restore_cmd("restore", 0,
+"restore \"FILE\"     Load state of the simulated machine from FILE",
+"long help of restore"));
+  cmd->init();
+
   cmdset->add(cmd= new cl_pc_cmd("pc", 0,
 "pc [addr]          Set/get PC",
 "long help of pc"));
@@ -538,6 +603,150 @@ cmd->init();*/
     cmd->init();
   }
 
+  {
+    super_cmd= (class cl_super_cmd *)(cmdset->get_cmd("profile"));
+    if (super_cmd)
+      cset= super_cmd->get_subcommands();
+    else {
+      cset= new cl_cmdset();
+      cset->init();
+    }
+    cset->add(cmd= new cl_profile_on_cmd("on", 0,
+"profile on         Start collecting execution statistics",
+"long help of profile on"));
+    cmd->init();
+    cmd->add_name("start");
+    cset->add(cmd= new cl_profile_off_cmd("off", 0,
+"profile off        Stop collecting and drop the statistics",
+"long help of profile off"));
+    cmd->init();
+    cmd->add_name("stop");
+    cset->add(cmd= new cl_profile_clear_cmd("clear", 0,
+"profile clear      Zero all counters",
+"long help of profile clear"));
+    cmd->init();
+    cset->add(cmd= new cl_profile_symbols_cmd("symbols", 0,
+"profile symbols \"FILE\"\n"
+"                   Read functions from a .cdb or .noi file",
+"long help of profile symbols"));
+    cmd->init();
+    cset->add(cmd= new cl_profile_functions_cmd("functions", 0,
+"profile functions [n]\n"
+"                   List functions by cycles spent in them",
+"long help of profile functions"));
+    cmd->init();
+    cset->add(cmd= new cl_profile_memory_cmd("memory", 0,
+"profile memory memory_type [start [stop]]\n"
+"                   List access counters of a memory",
+"long help of profile memory"));
+    cmd->init();
+    cset->add(cmd= new cl_profile_callgrind_cmd("callgrind", 0,
+"profile callgrind \"FILE\"\n"
+"                   Write statistics in callgrind format",
+"long help of profile callgrind"));
+    cmd->init();
+  }
+  if (!super_cmd) {
+    cmdset->add(cmd= new cl_super_cmd("profile", 0,
+"profile subcommand Execution statistics, see `profile' command for more help",
+"long help of profile", cset));
+    cmd->init();
+  }
+
+  {
+    super_cmd= (class cl_super_cmd *)(cmdset->get_cmd("trace"));
+    if (super_cmd)
+      cset= super_cmd->get_subcommands();
+    else {
+      cset= new cl_cmdset();
+      cset->init();
+    }
+    cset->add(cmd= new cl_trace_on_cmd("on", 0,
+"trace on [size]    Start recording instructions into a ring of size KiB",
+"long help of trace on"));
+    cmd->init();
+    cmd->add_name("start");
+    cset->add(cmd= new cl_trace_off_cmd("off", 0,
+"trace off          Stop recording and drop the trace",
+"long help of trace off"));
+    cmd->init();
+    cmd->add_name("stop");
+    cset->add(cmd= new cl_trace_file_cmd("file", 0,
+"trace file [\"FILE\"]\n"
+"                   Stream the trace into FILE, or stop streaming",
+"long help of trace file"));
+    cmd->init();
+    cset->add(cmd= new cl_trace_save_cmd("save", 0,
+"trace save \"FILE\"  Write the ring into FILE",
+"long help of trace save"));
+    cmd->init();
+    cset->add(cmd= new cl_trace_info_cmd("info", 0,
+"trace info         State of the recorder",
+"long help of trace info"));
+    cmd->init();
+    cset->add(cmd= new cl_trace_print_cmd("print", 0,
+"trace print [\"FILE\"] [n]\n"
+"                   Disassemble last n instructions of the ring or FILE",
+"long help of trace print"));
+    cmd->init();
+  }
+  if (!super_cmd) {
+    cmdset->add(cmd= new cl_super_cmd("trace", 0,
+"trace subcommand   Instruction trace, see `trace' command for more help",
+"long help of trace", cset));
+    cmd->init();
+  }
+
+  {
+    super_cmd= (class cl_super_cmd *)(cmdset->get_cmd("coverage"));
+    if (super_cmd)
+      cset= super_cmd->get_subcommands();
+    else {
+      cset= new cl_cmdset();
+      cset->init();
+    }
+    cset->add(cmd= new cl_coverage_on_cmd("on", 0,
+"coverage on        Start marking executed instructions and branches",
+"long help of coverage on"));
+    cmd->init();
+    cmd->add_name("start");
+    cset->add(cmd= new cl_coverage_off_cmd("off", 0,
+"coverage off       Stop marking and drop the maps",
+"long help of coverage off"));
+    cmd->init();
+    cmd->add_name("stop");
+    cset->add(cmd= new cl_coverage_clear_cmd("clear", 0,
+"coverage clear     Clear all maps",
+"long help of coverage clear"));
+    cmd->init();
+    cset->add(cmd= new cl_coverage_info_cmd("info", 0,
+"coverage info      Number of covered instructions and branches",
+"long help of coverage info"));
+    cmd->init();
+    cset->add(cmd= new cl_coverage_save_cmd("save", 0,
+"coverage save \"FILE\"\n"
+"                   Save the maps into FILE",
+"long help of coverage save"));
+    cmd->init();
+    cset->add(cmd= new cl_coverage_load_cmd("load", 0,
+"coverage load \"FILE\"\n"
+"                   Merge maps saved by an other run",
+"long help of coverage load"));
+    cmd->init();
+    cmd->add_name("merge");
+    cset->add(cmd= new cl_coverage_lcov_cmd("lcov", 0,
+"coverage lcov \"CDB\" \"FILE\"\n"
+"                   Write lcov tracefile using lines of CDB",
+"long help of coverage lcov"));
+    cmd->init();
+  }
+  if (!super_cmd) {
+    cmdset->add(cmd= new cl_super_cmd("coverage", 0,
+"coverage subcommand Code coverage, see `coverage' command for more help",
+"long help of coverage", cset));
+    cmd->init();
+  }
+
   {
     super_cmd= (class cl_super_cmd *)(cmdset->get_cmd("memory"));
     if (super_cmd)
@@ -691,31 +900,194 @@ cl_uc::memory(const char *id)
 }
 
 
+/*
+ * Loading program images
+ *____________________________________________________________________________
+ *
+ * The whole file is read into memory and decoded into a byte image of
+ * the ROM, runs of loaded bytes are then stored by set_block().
+ */
+
+struct t_load_image
+{
+  uchar *data;
+  uchar *loaded;        // byte was specified by the file
+  unsigned long size;   // in bytes
+  unsigned long outside;// number of bytes dropped, out of ROM
+};
+
+static void
+image_put(struct t_load_image *img, unsigned long addr,
+          const uchar *src, unsigned long n)
+{
+  if (addr >= img->size)
+    {
+      img->outside+= n;
+      return;
+    }
+  if (n > img->size - addr)
+    {
+      img->outside+= n - (img->size - addr);
+      n= img->size - addr;
+    }
+  memcpy(img->data + addr, src, n);
+  memset(img->loaded + addr, 1, n);
+}
+
+static int
+hex_digit(int c)
+{
+  if (c >= '0' && c <= '9')
+    return(c - '0');
+  if (c >= 'A' && c <= 'F')
+    return(c - 'A' + 10);
+  if (c >= 'a' && c <= 'f')
+    return(c - 'a' + 10);
+  return(-1);
+}
+
+static int
+hex_byte(const uchar *p, const uchar *end)
+{
+  int h, l;
+
+  if (end - p < 2 ||
+      (h= hex_digit(p[0])) < 0 ||
+      (l= hex_digit(p[1])) < 0)
+    return(-1);
+  return(h*16 + l);
+}
+
+/* Intel HEX: data (00), end (01), extended segment (02) and extended
+   linear (04) address records, start address records are ignored */
+
 static long
-ReadInt(FILE *f, bool *ok, int bytes)
+parse_hex(struct t_load_image *img, const uchar *p, const uchar *end)
+{
+  long recnum= 0;
+  unsigned long base= 0;
+  int dnum, rtyp= 0, i, b;
+  uint addr;
+  uchar rec[260], chk;
+
+  while (rtyp != 1)
+    {
+      while (p < end &&
+             *p != ':')
+        p++;
+      if (p >= end)
+        {fprintf(stderr, ": not found\n");break;}
+      p++;
+      recnum++;
+      // count, address, type, data and checksum
+      chk= 0;
+      if ((dnum= hex_byte(p, end)) >= 0)
+        for (i= 0; i < dnum+5; i++)
+          {
+            if ((b= hex_byte(p + 2*i, end)) < 0)
+              break;
+            rec[i]= b;
+            chk+= b;
+          }
+      if (dnum < 0 ||
+          i < dnum+5)
+        {
+          application->debug("Read error in record %ld.\n", recnum);
+          break;
+        }
+      p+= 2*(dnum+5);
+      addr= rec[1]*256 + rec[2];
+      rtyp= rec[3];
+      if (chk != 0)
+        {
+          application->debug("Checksum error (%x instead of %x) in "
+                             "record %ld.\n",
+                             (uchar)(chk - rec[dnum+4]), rec[dnum+4], recnum);
+          continue;
+        }
+      switch (rtyp)
+        {
+        case 0:
+          image_put(img, base + addr, &rec[4], dnum);
+          break;
+        case 2:
+          if (dnum >= 2)
+            base= (rec[4]*256 + rec[5]) << 4;
+          break;
+        case 4:
+          if (dnum >= 2)
+            base= (unsigned long)(rec[4]*256 + rec[5]) << 16;
+          break;
+        case 1: case 3: case 5:
+          break;
+        default:
+          application->debug("Unknown record type %d(0x%x)\n", rtyp, rtyp);
+          break;
+        }
+    }
+  return(recnum);
+}
+
+static unsigned long
+elf_get(const uchar *p, int n, bool big)
+{
+  unsigned long v= 0;
+  int i;
+
+  for (i= 0; i < n; i++)
+    v|= (unsigned long)p[big?(n-1-i):i] << (8*i);
+  return(v);
+}
+
+/* ELF32: file contents of PT_LOAD segments are loaded to their
+   physical address */
+
+static bool
+parse_elf(struct t_load_image *img, const uchar *buf, unsigned long len)
 {
-  char s2[3];
-  long l= 0;
+  bool big;
+  unsigned long phoff, phentsize, phnum, i;
 
-  *ok= DD_FALSE;
-  while (bytes)
+  if (len < 52 ||
+      buf[4] != 1)
     {
-      if (fscanf(f, "%2c", &s2[0]) == EOF)
-        return(0);
-      s2[2]= '\0';
-      l= l*256 + strtol(s2, NULL, 16);
-      bytes--;
+      fprintf(stderr, "Only 32 bit ELF files can be loaded\n");
+      return(DD_FALSE);
+    }
+  big= buf[5] == 2;
+  phoff= elf_get(&buf[28], 4, big);
+  phentsize= elf_get(&buf[42], 2, big);
+  phnum= elf_get(&buf[44], 2, big);
+  for (i= 0; i < phnum; i++)
+    {
+      const uchar *ph= buf + phoff + i*phentsize;
+      unsigned long offset, filesz;
+      if (phoff + i*phentsize + 32 > len)
+        {
+          fprintf(stderr, "Truncated ELF program header\n");
+          return(DD_FALSE);
+        }
+      if (elf_get(ph, 4, big) != 1/*PT_LOAD*/ ||
+          (filesz= elf_get(&ph[16], 4, big)) == 0)
+        continue;
+      offset= elf_get(&ph[4], 4, big);
+      if (offset > len ||
+          filesz > len - offset)
+        {
+          fprintf(stderr, "Truncated ELF segment\n");
+          return(DD_FALSE);
+        }
+      image_put(img, elf_get(&ph[12], 4, big), buf + offset, filesz);
     }
-  *ok= DD_TRUE;
-  return(l);
+  return(DD_TRUE);
 }
 
 
 /*
- * Reading intel hexa file into EROM
+ * Reading intel hexa, ELF or raw binary (.bin) file into EROM
  *____________________________________________________________________________
  *
- * If parameter is a NULL pointer, this function reads data from `cmd_in'
+ * ROMs wider than 8 bits get two bytes per cell, low byte first.
  *
  */
 
@@ -723,18 +1095,13 @@ long
 cl_uc::read_hex_file(const char *nam)
 {
   FILE *f;
-  int c;
-  long written= 0, recnum= 0;
-
-  uchar dnum;     // data number
-  uchar rtyp=0;   // record type
-  uint  addr= 0;  // address
-  uchar rec[300]; // data record
-  uchar sum ;     // checksum
-  uchar chk ;     // check
-  int  i;
-  bool ok, get_low= 1;
-  uchar low= 0, high;
+  uchar *buf;
+  long len, written= 0, recnum= 0;
+  struct t_load_image img;
+  t_addr start, size, a, n;
+  int unit;
+  t_mem *vals;
+  const char *ext;
 
   if (!rom)
     {
@@ -750,96 +1117,253 @@ cl_uc::read_hex_file(const char *nam)
       return(-1);
     }
   else
-    if ((f= fopen(nam, "r")) == NULL)
+    if ((f= fopen(nam, "rb")) == NULL)
       {
         fprintf(stderr, "Can't open `%s': %s\n", nam, strerror(errno));
         return(-1);
       }
 
-  //memset(inst_map, '\0', sizeof(inst_map));
-  ok= DD_TRUE;
-  while (ok &&
-         rtyp != 1)
+  fseek(f, 0, SEEK_END);
+  if ((len= ftell(f)) < 0)
+    len= 0;
+  fseek(f, 0, SEEK_SET);
+  buf= (uchar *)malloc(len+1);
+  len= fread(buf, 1, len, f);
+  fclose(f);
+
+  unit= (rom->width > 8)?2:1;
+  start= rom->get_start_address();
+  size= rom->get_size();
+  img.size= (start + size) * unit;
+  img.data= (uchar *)calloc(img.size, 1);
+  img.loaded= (uchar *)calloc(img.size, 1);
+  img.outside= 0;
+
+  ext= strrchr(nam, '.');
+  if (len >= 4 &&
+      memcmp(buf, "\177ELF", 4) == 0)
+    parse_elf(&img, buf, len);
+  else if (ext &&
+           strcasecmp(ext, ".bin") == 0)
+    image_put(&img, start*unit, buf, len);
+  else
+    recnum= parse_hex(&img, buf, buf+len);
+  free(buf);
+  if (img.outside)
+    application->debug("%lu bytes are out of ROM\n", img.outside);
+
+  vals= (t_mem *)malloc(size * sizeof(t_mem));
+  for (a= start; a < start+size; a+= n?n:1)
     {
-      while (((c= getc(f)) != ':') &&
-             (c != EOF)) ;
-      if (c != ':')
-        {fprintf(stderr, ": not found\n");break;}
-      recnum++;
-      dnum= ReadInt(f, &ok, 1);//printf("dnum=%02x",dnum);
-      chk = dnum;
-      addr= ReadInt(f, &ok, 2);//printf("addr=%04x",addr);
-      chk+= (addr & 0xff);
-      chk+= ((addr >> 8) & 0xff);
-      rtyp= ReadInt(f, &ok, 1);//printf("rtyp=%02x ",rtyp);
-      chk+= rtyp;
-      for (i= 0; ok && (i < dnum); i++)
-        {
-          rec[i]= ReadInt(f, &ok, 1);//printf("%02x",rec[i]);
-          chk+= rec[i];
-        }
-      if (ok)
+      for (n= 0; a+n < start+size; n++)
         {
-          sum= ReadInt(f, &ok, 1);//printf(" sum=%02x\n",sum);
-          if (ok)
+          unsigned long b= (a+n)*unit;
+          if (unit == 1)
             {
-              if (((sum + chk) & 0xff) == 0)
-                {
-                  if (rtyp == 0)
-                    {
-                      if (rom->width > 8)
-                        addr/= 2;
-                      for (i= 0; i < dnum; i++)
-                        {
-                          if (rom->width <= 8)
-                            {
-                              rom->set(addr, rec[i]);
-                              addr++;
-                              written++;
-                            }
-                          else if (rom->width <= 16)
-                            {
-                              if (get_low)
-                                {
-                                  low= rec[i];
-                                  get_low= 0;
-                                }
-                              else
-                                {
-                                  high= rec[i];
-                                  rom->set(addr, (high*256)+low);
-                                  addr++;
-                                  written++;
-                                  get_low= 1;
-                                }
-                            }
-                        }
-                    }
-                  else
-                    if (rtyp != 1)
-                      application->debug("Unknown record type %d(0x%x)\n",
-                                         rtyp, rtyp);
-                }
-              else
-                application->debug("Checksum error (%x instead of %x) in "
-                                   "record %ld.\n", chk, sum, recnum);
+              if (!img.loaded[b])
+                break;
+              vals[n]= img.data[b];
             }
           else
-            application->debug("Read error in record %ld.\n", recnum);
+            {
+              if (!img.loaded[b] &&
+                  !img.loaded[b+1])
+                break;
+              vals[n]= img.data[b+1]*256 + img.data[b];
+            }
+        }
+      if (n)
+        {
+          rom->set_block(a, vals, n);
+          written+= n;
         }
     }
-  if (rom->width > 8 &&
-      !get_low)
-    rom->set(addr, low);
+  free(vals);
+  free(img.data);
+  free(img.loaded);
 
-  if (nam)
-    fclose(f);
   application->debug("%ld records have been read\n", recnum);
   analyze(0);
   return(written);
 }
 
 
+/*
+ * Snapshot of the simulated machine
+ *____________________________________________________________________________
+ *
+ * State of the CPU, content of all memory chips and internal state of
+ * hw elements are written in binary form, as they are stored in this
+ * executable. Breakpoints, options and user counters are not part of
+ * the snapshot. It can be loaded into the same type of controller which
+ * is simulated by the same executable.
+ */
+
+bool
+cl_uc::save_state(FILE *f)
+{
+  int i, n, src;
+
+  sync_hw();
+  if (!SAVE_VAR(f, PC) ||
+      !SAVE_VAR(f, state) ||
+      !SAVE_VAR(f, ticks->ticks) ||
+      !SAVE_VAR(f, isr_ticks->ticks) ||
+      !SAVE_VAR(f, idle_ticks->ticks) ||
+      !SAVE_VAR(f, hw_cycles) ||
+      !SAVE_VAR(f, sp_max) ||
+      !SAVE_VAR(f, sp_avg))
+    return(DD_FALSE);
+
+  // last item is the bottom of the stack of it levels, it is kept,
+  // others are saved from the bottom to be pushed back in order
+  n= it_levels->count - 1;
+  if (!SAVE_VAR(f, n))
+    return(DD_FALSE);
+  for (i= n - 1; i >= 0; i--)
+    {
+      class it_level *il= (class it_level *)(it_levels->at(i));
+      src= il->source?(it_sources->index_of(il->source)):-1;
+      if (!SAVE_VAR(f, il->level) ||
+          !SAVE_VAR(f, il->addr) ||
+          !SAVE_VAR(f, il->PC) ||
+          !SAVE_VAR(f, src))
+        return(DD_FALSE);
+    }
+
+  if (!SAVE_VAR(f, memchips->count))
+    return(DD_FALSE);
+  for (i= 0; i < memchips->count; i++)
+    if (!((class cl_memory_chip *)(memchips->at(i)))->save_state(f))
+      return(DD_FALSE);
+
+  if (!SAVE_VAR(f, hws->count))
+    return(DD_FALSE);
+  for (i= 0; i < hws->count; i++)
+    if (!((class cl_hw *)(hws->at(i)))->save_state(f))
+      return(DD_FALSE);
+  return(DD_TRUE);
+}
+
+bool
+cl_uc::load_state(FILE *f)
+{
+  int i, n, src;
+  t_index count;
+  class it_level *il;
+
+  if (!LOAD_VAR(f, PC) ||
+      !LOAD_VAR(f, state) ||
+      !LOAD_VAR(f, ticks->ticks) ||
+      !LOAD_VAR(f, isr_ticks->ticks) ||
+      !LOAD_VAR(f, idle_ticks->ticks) ||
+      !LOAD_VAR(f, hw_cycles) ||
+      !LOAD_VAR(f, sp_max) ||
+      !LOAD_VAR(f, sp_avg))
+    return(DD_FALSE);
+  instPC= PC;
+
+  il= (class it_level *)(it_levels->top());
+  while (il &&
+         il->level >= 0)
+    {
+      il= (class it_level *)(it_levels->pop());
+      delete il;
+      il= (class it_level *)(it_levels->top());
+    }
+  if (!LOAD_VAR(f, n))
+    return(DD_FALSE);
+  for (i= 0; i < n; i++)
+    {
+      int level;
+      uint addr, pc;
+      if (!LOAD_VAR(f, level) ||
+          !LOAD_VAR(f, addr) ||
+          !LOAD_VAR(f, pc) ||
+          !LOAD_VAR(f, src))
+        return(DD_FALSE);
+      il= new it_level(level, addr, pc,
+                       (src >= 0 && src < it_sources->count)?
+                       ((class cl_it_src *)(it_sources->at(src))):0);
+      it_levels->push(il);
+    }
+  stack_ops->free_all();
+
+  if (!LOAD_VAR(f, count) ||
+      count != memchips->count)
+    return(DD_FALSE);
+  for (i= 0; i < memchips->count; i++)
+    if (!((class cl_memory_chip *)(memchips->at(i)))->load_state(f))
+      return(DD_FALSE);
+  // chips were written directly, predecoded opcodes may be wrong
+  drop_decoded();
+
+  if (!LOAD_VAR(f, count) ||
+      count != hws->count)
+    return(DD_FALSE);
+  hw_wakeup= 0;
+  for (i= 0; i < hws->count; i++)
+    {
+      class cl_hw *hw= (class cl_hw *)(hws->at(i));
+      if (!hw->load_state(f))
+        return(DD_FALSE);
+      hw->synced= hw_cycles;
+      hw->schedule();
+    }
+  return(DD_TRUE);
+}
+
+bool
+cl_uc::save_snapshot(const char *nam)
+{
+  FILE *f;
+  bool ok;
+
+  if ((f= fopen(nam, "wb")) == NULL)
+    {
+      fprintf(stderr, "Can't open `%s': %s\n", nam, strerror(errno));
+      return(DD_FALSE);
+    }
+  ok= fprintf(f, "ucsim snapshot %s\n", id_string()) > 0 &&
+    save_state(f);
+  if (fclose(f) != 0)
+    ok= DD_FALSE;
+  if (!ok)
+    fprintf(stderr, "Error writing snapshot `%s'\n", nam);
+  return(ok);
+}
+
+bool
+cl_uc::load_snapshot(const char *nam)
+{
+  FILE *f;
+  char *head, line[200];
+  bool ok;
+
+  if ((f= fopen(nam, "rb")) == NULL)
+    {
+      fprintf(stderr, "Can't open `%s': %s\n", nam, strerror(errno));
+      return(DD_FALSE);
+    }
+  head= format_string("ucsim snapshot %s\n", id_string());
+  ok= fgets(line, sizeof(line), f) &&
+    strcmp(line, head) == 0;
+  free(head);
+  if (!ok)
+    fprintf(stderr, "`%s' is not a snapshot of %s\n", nam, id_string());
+  else if (!(ok= load_state(f)))
+    {
+      // machine is in an undefined state now
+      fprintf(stderr, "Error reading snapshot `%s', resetting\n", nam);
+      reset();
+    }
+  fclose(f);
+  if (ok)
+    analyze(0);
+  return(ok);
+}
+
+
 /*
  * Handling instruction map
  *
@@ -1082,6 +1606,26 @@ cl_uc::print_regs(class cl_console_base *con)
   con->dd_printf("No registers\n");
 }
 
+/* Registers for remote debuggers, only the PC is known here */
+
+int
+cl_uc::dbg_reg_size(int nr)
+{
+  return((rom && rom->get_size() > 0x10000)?4:2);
+}
+
+t_mem
+cl_uc::dbg_get_reg(int nr)
+{
+  return(PC);
+}
+
+void
+cl_uc::dbg_set_reg(int nr, t_mem val)
+{
+  PC= val;
+}
+
 int
 cl_uc::inst_length(t_addr addr)
 {
@@ -1351,12 +1895,26 @@ cl_uc::tick_hw(int cycles)
   class cl_hw *hw;
   int i;//, cpc= clock_per_cycle();
 
-  // tick hws
-  for (i= 0; i < hws->count; i++)
+  // tick hws which are due, others catch up when they are touched
+  hw_cycles+= cycles;
+  if (hw_cycles >= hw_wakeup)
     {
-      hw= (class cl_hw *)(hws->at(i));
-      if (hw->flags & HWF_INSIDE)
-        hw->tick(cycles);
+      // state seen by an idle loop may change
+      idle_passes= 0;
+      hw_wakeup= HW_NEVER;
+      for (i= 0; i < hws->count; i++)
+        {
+          hw= (class cl_hw *)(hws->at(i));
+          if (!(hw->flags & HWF_INSIDE))
+            continue;
+          if (hw->wakeup <= hw_cycles)
+            {
+              hw->sync();
+              hw->schedule();
+            }
+          else if (hw->wakeup < hw_wakeup)
+            hw_wakeup= hw->wakeup;
+        }
     }
   do_extra_hw(cycles);
   return(0);
@@ -1366,6 +1924,18 @@ void
 cl_uc::do_extra_hw(int cycles)
 {}
 
+/* Bringing every hw element up to date before its state is looked at
+   from outside of the simulation */
+
+void
+cl_uc::sync_hw(void)
+{
+  int i;
+
+  for (i= 0; i < hws->count; i++)
+    ((class cl_hw *)(hws->at(i)))->sync();
+}
+
 int
 cl_uc::tick(int cycles)
 {
@@ -1490,10 +2060,16 @@ cl_uc::fetch(void)
 {
   ulong code;
 
+  struct t_decoded_inst *d;
+
   if (!rom)
     return(0);
 
-  code= rom->read(PC);
+  if ((d= decoded_at(PC)) &&
+      !(d->flags & DECODED_SLOW))
+    code= d->code;
+  else
+    code= rom->read(PC);
   PC= rom->inc_address(PC);
   return(code);
 }
@@ -1527,6 +2103,97 @@ cl_uc::fetch(t_mem *code)
   return(0);
 }
 
+/*
+ * Fetching opcode of the next instruction through the predecode cache.
+ * Cells which need attention (fetch breakpoint, read event breakpoint,
+ * hw) are fetched by fetch(code).
+ */
+
+bool
+cl_uc::fetch_inst(t_mem *code)
+{
+  struct t_decoded_inst *d;
+
+  if (!(d= decoded_at(PC)) ||
+      (d->flags & DECODED_SLOW))
+    return(fetch(code));
+  *code= d->code;
+  PC= rom->inc_address(PC);
+  return(0);
+}
+
+/*
+ * Predecoded content of a rom address, NULL if addr is out of rom.
+ * Changed cells are dropped by code_changed(), loading an image drops
+ * the whole cache.
+ */
+
+struct t_decoded_inst *
+cl_uc::decoded_at(t_addr addr)
+{
+  t_addr idx;
+  struct t_decoded_inst *d;
+
+  if (!rom)
+    return(0);
+  idx= addr - rom->get_start_address();
+  if (idx < 0 ||
+      idx >= rom->get_size())
+    return(0);
+  if (!decoded ||
+      decoded_gen != rom->get_generation())
+    drop_decoded();
+  d= &decoded[idx];
+  if (!(d->flags & DECODED_VALID))
+    {
+      d->code= rom->get(addr);
+      d->flags= DECODED_VALID;
+      if (rom->get_cell_flag(addr, CELL_FETCH_BRK) ||
+          rom->get_cell(addr)->hooked())
+        d->flags|= DECODED_SLOW;
+    }
+  return(d);
+}
+
+void
+cl_uc::drop_decoded(void)
+{
+  if (!rom)
+    return;
+  if (!decoded)
+    decoded= (struct t_decoded_inst *)malloc(rom->get_size() *
+                                             sizeof(struct t_decoded_inst));
+  memset(decoded, 0, rom->get_size() * sizeof(struct t_decoded_inst));
+  decoded_gen= rom->get_generation();
+  idle_checked= DD_FALSE;
+}
+
+/*
+ * A rom cell was written or got a breakpoint or operator. Its own entry
+ * is dropped, and so is the idle loop analysis of branches whose loop
+ * may contain it.
+ */
+
+void
+cl_uc::code_changed(t_addr addr)
+{
+  t_addr idx, i;
+
+  if (!decoded)
+    return;
+  idx= addr - rom->get_start_address();
+  if (idx < 0 ||
+      idx >= rom->get_size())
+    return;
+  decoded[idx].flags= 0;
+  if (!idle_checked)
+    return;
+  for (i= idx - 4; i < idx + IDLE_LOOP_SIZE; i++)
+    if (i >= 0 &&
+        i < rom->get_size())
+      decoded[i].flags&= ~(DECODED_IDLE_CHECKED | DECODED_IDLE);
+}
+
 int
 cl_uc::do_inst(int step)
 {
@@ -1553,12 +2220,128 @@ cl_uc::do_inst(int step)
   return(res);
 }
 
+/*
+ * Executing a block of instructions while the simulation is running.
+ * Breakpoints are found by the predecode cache (fetch_inst) and events
+ * and errors are only processed by post_inst() when some of them are
+ * pending. do_inst() stops the simulation if needed so only the state
+ * of the simulator and the cycle limit is checked between instructions.
+ */
+
+int
+cl_uc::do_block(int insts, unsigned long cycles_end)
+{
+  int res= resGO;
+
+  while (insts-- > 0 &&
+         (sim->state & SIM_GO) &&
+         hw_cycles < cycles_end)
+    {
+      res= do_inst(1);
+      // backward jump may close an idle loop
+      if (PC <= instPC &&
+          idle_skip)
+        skip_idle(cycles_end);
+    }
+  return(res);
+}
+
+/*
+ * Fast-forwarding idle loops
+ *
+ * A short loop which only tests flags and changes nothing but the
+ * registers it uses for the tests (see idle_loop()) goes round the
+ * same way until a hw element changes something, and hw elements only
+ * do that when they wake up. After two iterations of the same length
+ * without a hw wakeup as many whole iterations are skipped as fit before
+ * the next wakeup (or the end of the run), so the loop exits at the
+ * same cycle as it would by executing every iteration.
+ */
+
+void
+cl_uc::skip_idle(unsigned long cycles_end)
+{
+  struct t_decoded_inst *d;
+  unsigned long limit, n, period;
+  int cpc;
+
+  if (!inst_ticks ||
+      instPC - PC >= IDLE_LOOP_SIZE ||
+      state != stGO ||
+      ebrk->count ||
+      profiler ||
+      tracer ||
+      coverage)
+    return;
+  if (PC != idle_start ||
+      instPC != idle_end)
+    {
+      idle_start= PC;
+      idle_end= instPC;
+      idle_mark= hw_cycles;
+      idle_passes= 0;
+      return;
+    }
+  period= hw_cycles - idle_mark;
+  idle_mark= hw_cycles;
+  if (idle_passes == 0 ||
+      period != idle_period)
+    {
+      idle_period= period;
+      idle_passes= 1;
+      return;
+    }
+  if (++idle_passes < 2)
+    return;
+
+  if (!(d= decoded_at(instPC)))
+    return;
+  if (!(d->flags & DECODED_IDLE_CHECKED))
+    {
+      bool idle= idle_loop(instPC);
+      // analysis may have refreshed the cache
+      d= decoded_at(instPC);
+      d->flags|= DECODED_IDLE_CHECKED | (idle?DECODED_IDLE:0);
+      idle_checked= DD_TRUE;
+    }
+  if (!(d->flags & DECODED_IDLE))
+    return;
+
+  limit= (hw_wakeup < cycles_end)?hw_wakeup:cycles_end;
+  if (limit <= hw_cycles + period)
+    return;
+  n= (limit - hw_cycles - 1) / period;
+  // tickers count in int
+  cpc= clock_per_cycle();
+  if (n > 0x10000000UL / cpc / period)
+    n= 0x10000000UL / cpc / period;
+  if (!n)
+    return;
+  tick(n * period);
+  tick_hw(n * period);
+  idle_mark= hw_cycles;
+  idle_skipped+= n * period * cpc;
+}
+
+/*
+ * Analysing the loop closed by the backward branch at `end'. Controllers
+ * which know their instructions tell if it is an idle loop.
+ */
+
+bool
+cl_uc::idle_loop(t_addr end)
+{
+  return(DD_FALSE);
+}
+
 void
 cl_uc::pre_inst(void)
 {
   inst_exec= DD_TRUE;
   inst_ticks= 0;
-  events->disconn_all();
+  instPC= PC;
+  if (events->count)
+    events->disconn_all();
 }
 
 int
@@ -1571,7 +2354,20 @@ cl_uc::exec_inst(void)
 void
 cl_uc::post_inst(void)
 {
+  // No ticks if a breakpoint stopped the instruction at fetch
+  if (profiler &&
+      inst_exec &&
+      inst_ticks)
+    profiler->inst_done(instPC, inst_ticks);
   tick_hw(inst_ticks);
+  if (tracer &&
+      inst_exec &&
+      inst_ticks)
+    tracer->inst_done(instPC);
+  if (coverage &&
+      inst_exec &&
+      inst_ticks)
+    coverage->inst_done(instPC, PC);
   if (errors->count)
     check_errors();
   if (events->count)
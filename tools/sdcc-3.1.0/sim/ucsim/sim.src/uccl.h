@@ -72,6 +72,31 @@ public:
   virtual void option_changed(void);
 };
 
+class cl_idle_skip_option: public cl_optref
+{
+protected:
+  class cl_uc *uc;
+public:
+  cl_idle_skip_option(class cl_uc *the_uc);
+  virtual void option_changed(void);
+};
+
+/* Predecoded instruction, see cl_uc::fetch_inst() */
+
+#define DECODED_VALID   0x01    /* code is valid */
+#define DECODED_SLOW    0x02    /* fetch breakpoint or operator on the cell */
+#define DECODED_IDLE_CHECKED 0x04 /* backward branch was analysed */
+#define DECODED_IDLE    0x08    /* it closes an idle loop, see skip_idle() */
+
+/* Longest idle loop in bytes of code */
+#define IDLE_LOOP_SIZE  16
+
+struct t_decoded_inst
+{
+  t_mem code;
+  TYPE_UBYTE flags;
+};
+
 /* Abstract microcontroller */
 
 class cl_uc: public cl_base
@@ -82,6 +107,7 @@ public:
   int state;                    // GO, IDLE, PD
   //class cl_list *options;
   class cl_xtal_option *xtal_option;
+  class cl_idle_skip_option *idle_skip_option;
 
   t_addr PC, instPC;            // Program Counter
   bool inst_exec;               // Instruction is executed
@@ -90,12 +116,17 @@ public:
   class cl_ticker *idle_ticks;  // Time in idle mode
   class cl_list *counters;      // User definable timers (tickers)
   int inst_ticks;               // ticks of an instruction
+  unsigned long hw_cycles;      // Machine cycles given to tick_hw()
+  unsigned long hw_wakeup;      // Earliest wakeup of hw elements
+  bool idle_skip;               // Fast-forward idle loops
+  unsigned long idle_skipped;   // XTAL clocks skipped in idle loops
   double xtal;                  // Clock speed
 
   int brk_counter;              // Number of breakpoints
   class brk_coll *fbrk;         // Collection of FETCH break-points
   class brk_coll *ebrk;         // Collection of EVENT breakpoints
   class cl_sim *sim;
+  int core_id;                  // Index in sim->cores
   //class cl_list *mems;
   class cl_hws *hws;
 
@@ -115,6 +146,19 @@ public:
   t_addr sp_max;
   t_addr sp_avg;
 
+  class cl_profiler *profiler;  // Execution statistics, 0 if switched off
+  class cl_tracer *tracer;      // Instruction trace, 0 if switched off
+  class cl_coverage *coverage;  // Code coverage, 0 if switched off
+
+protected:
+  struct t_decoded_inst *decoded;       // Opcodes of executed rom addresses
+  unsigned long decoded_gen;            // Generation of rom they belong to
+  bool idle_checked;                    // Some entry has DECODED_IDLE_CHECKED
+  t_addr idle_start, idle_end;          // Loop watched by skip_idle()
+  unsigned long idle_mark;              // hw_cycles at last pass of its start
+  unsigned long idle_period;            // Cycles of its last iteration
+  int idle_passes;                      // Iterations without hw event
+
 public:
   cl_uc(class cl_sim *asim);
   virtual ~cl_uc(void);
@@ -141,6 +185,12 @@ public:
   // file handling
   virtual long read_hex_file(const char *nam);
 
+  // snapshot of the simulated machine
+  virtual bool save_state(FILE *f);
+  virtual bool load_state(FILE *f);
+  virtual bool save_snapshot(const char *nam);
+  virtual bool load_snapshot(const char *nam);
+
   // instructions, code analyzer
   virtual void analyze(t_addr addr) {}
   virtual bool inst_at(t_addr addr);
@@ -170,7 +220,15 @@ public:
   // execution
   virtual t_mem fetch(void);
   virtual bool fetch(t_mem *code);
+  virtual bool fetch_inst(t_mem *code);
+  virtual struct t_decoded_inst *decoded_at(t_addr addr);
+  virtual void drop_decoded(void);
+  virtual void code_changed(t_addr addr);
   virtual int do_inst(int step);
+  virtual int do_block(int insts, unsigned long cycles_end);
+  virtual void sync_hw(void);
+  virtual void skip_idle(unsigned long cycles_end);
+  virtual bool idle_loop(t_addr end);
   virtual void pre_inst(void);
   virtual int exec_inst(void);
   virtual void post_inst(void);
@@ -203,6 +261,11 @@ public:
   virtual struct name_entry *bit_tbl(void);
   virtual void print_disass(t_addr addr, class cl_console_base *con);
   virtual void print_regs(class cl_console_base *con);
+  // registers for remote debuggers, PC is the last one
+  virtual int dbg_regs(void) { return(1); }
+  virtual int dbg_reg_size(int nr);
+  virtual t_mem dbg_get_reg(int nr);
+  virtual void dbg_set_reg(int nr, t_mem val);
   virtual int inst_length(t_addr addr);
   virtual int inst_branch(t_addr addr);
   virtual int longest_inst(void);
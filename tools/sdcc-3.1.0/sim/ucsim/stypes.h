@@ -146,6 +146,7 @@ enum mem_class
 #define resINV_INST	106	/* Invalid instruction */
 #define resBITADDR	107	/* Bit address is uninterpretable */
 #define resERROR	108	/* Error happened during instruction exec */
+#define resCYCLES	109	/* Given number of cycles executed */
 
 #define BIT_MASK(bitaddr) (1 << (bitaddr & 0x07))
 
@@ -226,6 +227,9 @@ enum hw_event {
 #define HWF_OUTSIDE	0x0002
 #define HWF_MISC	0x0004
 
+/* Wakeup of a hw element which needs no tick until it is touched */
+#define HW_NEVER	(~0UL)
+
 
 /* Letter cases */
 enum letter_case {
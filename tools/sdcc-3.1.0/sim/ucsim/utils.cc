@@ -180,6 +180,19 @@ case_string(enum letter_case lcase, const char *str)
   return(s);
 }
 
+bool
+save_data(FILE *f, const void *data, int size)
+{
+  return(fwrite(data, size, 1, f) == 1);
+}
+
+bool
+load_data(FILE *f, void *data, int size)
+{
+  return(fread(data, size, 1, f) == 1);
+}
+
+
 /*const char *
 case_string(enum letter_case lcase, const char *str)
 {
@@ -46,6 +46,12 @@ extern int get_string_id(struct id_element *ids, const char *str, int def);
 extern char *format_string(const char *format, ...);
 extern const char *object_name(class cl_base *o);
 extern char *case_string(enum letter_case lcase, const char *str);
+extern bool save_data(FILE *f, const void *data, int size);
+extern bool load_data(FILE *f, void *data, int size);
+
+// Raw binary copy of a variable, used by snapshots of the simulated machine
+#define SAVE_VAR(f, var) save_data((f), &(var), sizeof(var))
+#define LOAD_VAR(f, var) load_data((f), &(var), sizeof(var))
 
 
 #endif
@@ -40,6 +40,7 @@ Software Foundation, 59 Temple Place - Suite 330, Boston, MA
 
 // prj
 #include "pobjcl.h"
+#include "utils.h"
 
 // sim
 #include "simcl.h"
@@ -392,6 +393,37 @@ cl_r2k::disass(t_addr addr, const char *sep)
 }
 
 
+bool
+cl_r2k::save_state(FILE *f)
+{
+  return(cl_z80::save_state(f) &&
+         SAVE_VAR(f, mmu.xpc) &&
+         SAVE_VAR(f, mmu.dataseg) &&
+         SAVE_VAR(f, mmu.stackseg) &&
+         SAVE_VAR(f, mmu.segsize) &&
+         SAVE_VAR(f, mmu.io_flag) &&
+         SAVE_VAR(f, mmu.mmidr) &&
+         SAVE_VAR(f, ip) &&
+         SAVE_VAR(f, iir) &&
+         SAVE_VAR(f, eir));
+}
+
+bool
+cl_r2k::load_state(FILE *f)
+{
+  return(cl_z80::load_state(f) &&
+         LOAD_VAR(f, mmu.xpc) &&
+         LOAD_VAR(f, mmu.dataseg) &&
+         LOAD_VAR(f, mmu.stackseg) &&
+         LOAD_VAR(f, mmu.segsize) &&
+         LOAD_VAR(f, mmu.io_flag) &&
+         LOAD_VAR(f, mmu.mmidr) &&
+         LOAD_VAR(f, ip) &&
+         LOAD_VAR(f, iir) &&
+         LOAD_VAR(f, eir));
+}
+
+
 void
 cl_r2k::print_regs(class cl_console_base *con)
 {
@@ -37,6 +37,7 @@ Software Foundation, 59 Temple Place - Suite 330, Boston, MA
 
 // prj
 #include "pobjcl.h"
+#include "utils.h"
 
 // sim
 #include "simcl.h"
@@ -60,6 +61,7 @@ cl_z80::cl_z80(int Itype, int Itech, class cl_sim *asim):
   cl_uc(asim)
 {
   type= Itype;
+  make_itab();
 }
 
 int
@@ -388,6 +390,21 @@ cl_z80::disass(t_addr addr, const char *sep)
 }
 
 
+bool
+cl_z80::save_state(FILE *f)
+{
+  return(cl_uc::save_state(f) &&
+         SAVE_VAR(f, regs));
+}
+
+bool
+cl_z80::load_state(FILE *f)
+{
+  return(cl_uc::load_state(f) &&
+         LOAD_VAR(f, regs));
+}
+
+
 void
 cl_z80::print_regs(class cl_console_base *con)
 {
@@ -428,192 +445,230 @@ cl_z80::print_regs(class cl_console_base *con)
  * Execution
  */
 
+/*
+ * Table of instruction handlers, indexed by opcode
+ */
+
+cl_z80::t_instz80 cl_z80::itab[256];
+bool cl_z80::itab_made= DD_FALSE;
+
+void
+cl_z80::make_itab(void)
+{
+  int code;
+
+  if (itab_made)
+    return;
+  for (code= 0; code < 256; code++)
+    switch (code)
+      {
+      case 0x00: itab[code]= &cl_z80::inst_nop; break;
+      case 0x01: case 0x02: case 0x06: itab[code]= &cl_z80::inst_ld; break;
+      case 0x03: case 0x04: itab[code]= &cl_z80::inst_inc; break;
+      case 0x05: itab[code]= &cl_z80::inst_dec; break;
+      case 0x07: itab[code]= &cl_z80::inst_rlca; break;
+
+      case 0x08: itab[code]= &cl_z80::inst_ex; break;
+      case 0x09: itab[code]= &cl_z80::inst_add; break;
+      case 0x0a: case 0x0e: itab[code]= &cl_z80::inst_ld; break;
+      case 0x0b: case 0x0d: itab[code]= &cl_z80::inst_dec; break;
+      case 0x0c: itab[code]= &cl_z80::inst_inc; break;
+      case 0x0f: itab[code]= &cl_z80::inst_rrca; break;
+
+
+      case 0x10: itab[code]= &cl_z80::inst_djnz; break;
+      case 0x11: case 0x12: case 0x16: itab[code]= &cl_z80::inst_ld; break;
+      case 0x13: case 0x14: itab[code]= &cl_z80::inst_inc; break;
+      case 0x15: itab[code]= &cl_z80::inst_dec; break;
+      case 0x17: itab[code]= &cl_z80::inst_rla; break;
+
+      case 0x18: itab[code]= &cl_z80::inst_jr; break;
+      case 0x19: itab[code]= &cl_z80::inst_add; break;
+      case 0x1a: case 0x1e: itab[code]= &cl_z80::inst_ld; break;
+      case 0x1b: case 0x1d: itab[code]= &cl_z80::inst_dec; break;
+      case 0x1c: itab[code]= &cl_z80::inst_inc; break;
+      case 0x1f: itab[code]= &cl_z80::inst_rra; break;
+
+
+      case 0x20: itab[code]= &cl_z80::inst_jr; break;
+      case 0x21: case 0x22: case 0x26: itab[code]= &cl_z80::inst_ld; break;
+      case 0x23: case 0x24: itab[code]= &cl_z80::inst_inc; break;
+      case 0x25: itab[code]= &cl_z80::inst_dec; break;
+      case 0x27: itab[code]= &cl_z80::inst_daa; break;
+
+      case 0x28: itab[code]= &cl_z80::inst_jr; break;
+      case 0x29: itab[code]= &cl_z80::inst_add; break;
+      case 0x2a: case 0x2e: itab[code]= &cl_z80::inst_ld; break;
+      case 0x2b: case 0x2d: itab[code]= &cl_z80::inst_dec; break;
+      case 0x2c: itab[code]= &cl_z80::inst_inc; break;
+      case 0x2f: itab[code]= &cl_z80::inst_cpl; break;
+
+
+      case 0x30: itab[code]= &cl_z80::inst_jr; break;
+      case 0x31: case 0x32: case 0x36: itab[code]= &cl_z80::inst_ld; break;
+      case 0x33: case 0x34: itab[code]= &cl_z80::inst_inc; break;
+      case 0x35: itab[code]= &cl_z80::inst_dec; break;
+      case 0x37: itab[code]= &cl_z80::inst_scf; break;
+
+      case 0x38: itab[code]= &cl_z80::inst_jr; break;
+      case 0x39: itab[code]= &cl_z80::inst_add; break;
+      case 0x3a: case 0x3e: itab[code]= &cl_z80::inst_ld; break;
+      case 0x3b: case 0x3d: itab[code]= &cl_z80::inst_dec; break;
+      case 0x3c: itab[code]= &cl_z80::inst_inc; break;
+      case 0x3f: itab[code]= &cl_z80::inst_ccf; break;
+
+      case 0x40: case 0x41: case 0x42: case 0x43: case 0x44: case 0x45: case 0x46: case 0x47:
+      case 0x48: case 0x49: case 0x4a: case 0x4b: case 0x4c: case 0x4d: case 0x4e: case 0x4f:
+        itab[code]= &cl_z80::inst_ld; break;
+
+      case 0x50: case 0x51: case 0x52: case 0x53: case 0x54: case 0x55: case 0x56: case 0x57:
+      case 0x58: case 0x59: case 0x5a: case 0x5b: case 0x5c: case 0x5d: case 0x5e: case 0x5f:
+        itab[code]= &cl_z80::inst_ld; break;
+
+      case 0x60: case 0x61: case 0x62: case 0x63: case 0x64: case 0x65: case 0x66: case 0x67:
+      case 0x68: case 0x69: case 0x6a: case 0x6b: case 0x6c: case 0x6d: case 0x6e: case 0x6f:
+        itab[code]= &cl_z80::inst_ld; break;
+
+      case 0x70: case 0x71: case 0x72: case 0x73: case 0x74: case 0x75: case 0x77:
+      case 0x78: case 0x79: case 0x7a: case 0x7b: case 0x7c: case 0x7d: case 0x7e: case 0x7f:
+        itab[code]= &cl_z80::inst_ld; break;
+      case 0x76:
+        itab[code]= &cl_z80::inst_halt; break;
+
+      case 0x80: case 0x81: case 0x82: case 0x83: case 0x84: case 0x85: case 0x86: case 0x87:
+        itab[code]= &cl_z80::inst_add; break;
+      case 0x88: case 0x89: case 0x8a: case 0x8b: case 0x8c: case 0x8d: case 0x8e: case 0x8f:
+        itab[code]= &cl_z80::inst_adc; break;
+
+      case 0x90: case 0x91: case 0x92: case 0x93: case 0x94: case 0x95: case 0x96: case 0x97:
+        itab[code]= &cl_z80::inst_sub; break;
+      case 0x98: case 0x99: case 0x9a: case 0x9b: case 0x9c: case 0x9d: case 0x9e: case 0x9f:
+        itab[code]= &cl_z80::inst_sbc; break;
+
+      case 0xa0: case 0xa1: case 0xa2: case 0xa3: case 0xa4: case 0xa5: case 0xa6: case 0xa7:
+        itab[code]= &cl_z80::inst_and; break;
+      case 0xa8: case 0xa9: case 0xaa: case 0xab: case 0xac: case 0xad: case 0xae: case 0xaf:
+        itab[code]= &cl_z80::inst_xor; break;
+
+      case 0xb0: case 0xb1: case 0xb2: case 0xb3: case 0xb4: case 0xb5: case 0xb6: case 0xb7:
+        itab[code]= &cl_z80::inst_or; break;
+      case 0xb8: case 0xb9: case 0xba: case 0xbb: case 0xbc: case 0xbd: case 0xbe: case 0xbf:
+        itab[code]= &cl_z80::inst_cp; break;
+
+      case 0xc0: itab[code]= &cl_z80::inst_ret; break;
+      case 0xc1: itab[code]= &cl_z80::inst_pop; break;
+      case 0xc2: case 0xc3: itab[code]= &cl_z80::inst_jp; break;
+      case 0xc4: itab[code]= &cl_z80::inst_call; break;
+      case 0xc5: itab[code]= &cl_z80::inst_push; break;
+      case 0xc6: itab[code]= &cl_z80::inst_add; break;
+      case 0xc7: itab[code]= &cl_z80::inst_rst; break;
+
+      case 0xc8: case 0xc9: itab[code]= &cl_z80::inst_ret; break;
+      case 0xca: itab[code]= &cl_z80::inst_jp; break;
+
+        /* CB escapes out to 2 byte opcodes(CB include), opcodes
+           to do register bit manipulations */
+      case 0xcb: itab[code]= &cl_z80::inst_esc_cb; break;
+      case 0xcc: case 0xcd: itab[code]= &cl_z80::inst_call; break;
+      case 0xce: itab[code]= &cl_z80::inst_adc; break;
+      case 0xcf: itab[code]= &cl_z80::inst_rst; break;
+
+
+      case 0xd0: itab[code]= &cl_z80::inst_ret; break;
+      case 0xd1: itab[code]= &cl_z80::inst_pop; break;
+      case 0xd2: itab[code]= &cl_z80::inst_jp; break;
+      case 0xd3: itab[code]= &cl_z80::inst_out; break;
+      case 0xd4: itab[code]= &cl_z80::inst_call; break;
+      case 0xd5: itab[code]= &cl_z80::inst_push; break;
+      case 0xd6: itab[code]= &cl_z80::inst_sub; break;
+      case 0xd7: itab[code]= &cl_z80::inst_rst; break;
+
+      case 0xd8: itab[code]= &cl_z80::inst_ret; break;
+      case 0xd9: itab[code]= &cl_z80::inst_exx; break;
+      case 0xda: itab[code]= &cl_z80::inst_jp; break;
+      case 0xdb: itab[code]= &cl_z80::inst_in; break;
+      case 0xdc: itab[code]= &cl_z80::inst_call; break;
+        /* DD escapes out to 2 to 4 byte opcodes(DD included)
+          with a variety of uses.  It can precede the CB escape
+          sequence to extend CB codes with IX+immed_byte */
+      case 0xdd: itab[code]= &cl_z80::inst_esc_dd; break;
+      case 0xde: itab[code]= &cl_z80::inst_sbc; break;
+      case 0xdf: itab[code]= &cl_z80::inst_rst; break;
+
+
+      case 0xe0: itab[code]= &cl_z80::inst_ret; break;
+      case 0xe1: itab[code]= &cl_z80::inst_pop; break;
+      case 0xe2: itab[code]= &cl_z80::inst_jp; break;
+      case 0xe3: itab[code]= &cl_z80::inst_ex; break;
+      case 0xe4: itab[code]= &cl_z80::inst_call; break;
+      case 0xe5: itab[code]= &cl_z80::inst_push; break;
+      case 0xe6: itab[code]= &cl_z80::inst_and; break;
+      case 0xe7: itab[code]= &cl_z80::inst_rst; break;
+
+      case 0xe8: itab[code]= &cl_z80::inst_ret; break;
+      case 0xe9: itab[code]= &cl_z80::inst_jp; break;
+      case 0xea: itab[code]= &cl_z80::inst_jp; break;
+      case 0xeb: itab[code]= &cl_z80::inst_ex; break;
+      case 0xec: itab[code]= &cl_z80::inst_call; break;
+        /* ED escapes out to misc IN, OUT and other oddball opcodes */
+      case 0xed: itab[code]= &cl_z80::inst_esc_ed; break;
+      case 0xee: itab[code]= &cl_z80::inst_xor; break;
+      case 0xef: itab[code]= &cl_z80::inst_rst; break;
+
+
+      case 0xf0: itab[code]= &cl_z80::inst_ret; break;
+      case 0xf1: itab[code]= &cl_z80::inst_pop; break;
+      case 0xf2: itab[code]= &cl_z80::inst_jp; break;
+      case 0xf3: itab[code]= &cl_z80::inst_di; break;
+      case 0xf4: itab[code]= &cl_z80::inst_call; break;
+      case 0xf5: itab[code]= &cl_z80::inst_push; break;
+      case 0xf6: itab[code]= &cl_z80::inst_or; break;
+      case 0xf7: itab[code]= &cl_z80::inst_rst; break;
+
+      case 0xf8: itab[code]= &cl_z80::inst_ret; break;
+      case 0xf9: itab[code]= &cl_z80::inst_ld; break;
+      case 0xfa: itab[code]= &cl_z80::inst_jp; break;
+      case 0xfb: itab[code]= &cl_z80::inst_ei; break;
+      case 0xfc: itab[code]= &cl_z80::inst_call; break;
+        /* DD escapes out to 2 to 4 byte opcodes(DD included)
+          with a variety of uses.  It can precede the CB escape
+          sequence to extend CB codes with IX+immed_byte */
+      case 0xfd: itab[code]= &cl_z80::inst_esc_fd; break;
+      case 0xfe: itab[code]= &cl_z80::inst_cp; break;
+      case 0xff: itab[code]= &cl_z80::inst_rst; break;
+      default:
+        itab[code]= &cl_z80::inst_invalid; break;
+      }
+  itab_made= DD_TRUE;
+}
+
 int
-cl_z80::exec_inst(void)
+cl_z80::inst_esc_cb(t_mem code)
 {
-  t_mem code;
+  return(inst_cb());
+}
 
-  if (fetch(&code))
-    return(resBREAKPOINT);
-  tick(1);
-  switch (code)
-    {
-    case 0x00: return(inst_nop(code));
-    case 0x01: case 0x02: case 0x06: return(inst_ld(code));
-    case 0x03: case 0x04: return(inst_inc(code));
-    case 0x05: return(inst_dec(code));
-    case 0x07: return(inst_rlca(code));
-
-    case 0x08: return(inst_ex(code));
-    case 0x09: return(inst_add(code));
-    case 0x0a: case 0x0e: return(inst_ld(code));
-    case 0x0b: case 0x0d: return(inst_dec(code));
-    case 0x0c: return(inst_inc(code));
-    case 0x0f: return(inst_rrca(code));
-
-
-    case 0x10: return(inst_djnz(code));
-    case 0x11: case 0x12: case 0x16: return(inst_ld(code));
-    case 0x13: case 0x14: return(inst_inc(code));
-    case 0x15: return(inst_dec(code));
-    case 0x17: return(inst_rla(code));
-
-    case 0x18: return(inst_jr(code));
-    case 0x19: return(inst_add(code));
-    case 0x1a: case 0x1e: return(inst_ld(code));
-    case 0x1b: case 0x1d: return(inst_dec(code));
-    case 0x1c: return(inst_inc(code));
-    case 0x1f: return(inst_rra(code));
-
-
-    case 0x20: return(inst_jr(code));
-    case 0x21: case 0x22: case 0x26: return(inst_ld(code));
-    case 0x23: case 0x24: return(inst_inc(code));
-    case 0x25: return(inst_dec(code));
-    case 0x27: return(inst_daa(code));
-
-    case 0x28: return(inst_jr(code));
-    case 0x29: return(inst_add(code));
-    case 0x2a: case 0x2e: return(inst_ld(code));
-    case 0x2b: case 0x2d: return(inst_dec(code));
-    case 0x2c: return(inst_inc(code));
-    case 0x2f: return(inst_cpl(code));
-
-
-    case 0x30: return(inst_jr(code));
-    case 0x31: case 0x32: case 0x36: return(inst_ld(code));
-    case 0x33: case 0x34: return(inst_inc(code));
-    case 0x35: return(inst_dec(code));
-    case 0x37: return(inst_scf(code));
-
-    case 0x38: return(inst_jr(code));
-    case 0x39: return(inst_add(code));
-    case 0x3a: case 0x3e: return(inst_ld(code));
-    case 0x3b: case 0x3d: return(inst_dec(code));
-    case 0x3c: return(inst_inc(code));
-    case 0x3f: return(inst_ccf(code));
-
-    case 0x40: case 0x41: case 0x42: case 0x43: case 0x44: case 0x45: case 0x46: case 0x47:
-    case 0x48: case 0x49: case 0x4a: case 0x4b: case 0x4c: case 0x4d: case 0x4e: case 0x4f:
-      return(inst_ld(code));
-
-    case 0x50: case 0x51: case 0x52: case 0x53: case 0x54: case 0x55: case 0x56: case 0x57:
-    case 0x58: case 0x59: case 0x5a: case 0x5b: case 0x5c: case 0x5d: case 0x5e: case 0x5f:
-      return(inst_ld(code));
-
-    case 0x60: case 0x61: case 0x62: case 0x63: case 0x64: case 0x65: case 0x66: case 0x67:
-    case 0x68: case 0x69: case 0x6a: case 0x6b: case 0x6c: case 0x6d: case 0x6e: case 0x6f:
-      return(inst_ld(code));
-
-    case 0x70: case 0x71: case 0x72: case 0x73: case 0x74: case 0x75: case 0x77:
-    case 0x78: case 0x79: case 0x7a: case 0x7b: case 0x7c: case 0x7d: case 0x7e: case 0x7f:
-      return(inst_ld(code));
-    case 0x76:
-      return(inst_halt(code));
-
-    case 0x80: case 0x81: case 0x82: case 0x83: case 0x84: case 0x85: case 0x86: case 0x87:
-      return(inst_add(code));
-    case 0x88: case 0x89: case 0x8a: case 0x8b: case 0x8c: case 0x8d: case 0x8e: case 0x8f:
-      return(inst_adc(code));
-
-    case 0x90: case 0x91: case 0x92: case 0x93: case 0x94: case 0x95: case 0x96: case 0x97:
-      return(inst_sub(code));
-    case 0x98: case 0x99: case 0x9a: case 0x9b: case 0x9c: case 0x9d: case 0x9e: case 0x9f:
-      return(inst_sbc(code));
-
-    case 0xa0: case 0xa1: case 0xa2: case 0xa3: case 0xa4: case 0xa5: case 0xa6: case 0xa7:
-      return(inst_and(code));
-    case 0xa8: case 0xa9: case 0xaa: case 0xab: case 0xac: case 0xad: case 0xae: case 0xaf:
-      return(inst_xor(code));
-
-    case 0xb0: case 0xb1: case 0xb2: case 0xb3: case 0xb4: case 0xb5: case 0xb6: case 0xb7:
-      return(inst_or(code));
-    case 0xb8: case 0xb9: case 0xba: case 0xbb: case 0xbc: case 0xbd: case 0xbe: case 0xbf:
-      return(inst_cp(code));
-
-    case 0xc0: return(inst_ret(code));
-    case 0xc1: return(inst_pop(code));
-    case 0xc2: case 0xc3: return(inst_jp(code));
-    case 0xc4: return(inst_call(code));
-    case 0xc5: return(inst_push(code));
-    case 0xc6: return(inst_add(code));
-    case 0xc7: return(inst_rst(code));
-
-    case 0xc8: case 0xc9: return(inst_ret(code));
-    case 0xca: return(inst_jp(code));
-
-      /* CB escapes out to 2 byte opcodes(CB include), opcodes
-         to do register bit manipulations */
-    case 0xcb: return(inst_cb());
-    case 0xcc: case 0xcd: return(inst_call(code));
-    case 0xce: return(inst_adc(code));
-    case 0xcf: return(inst_rst(code));
-
-
-    case 0xd0: return(inst_ret(code));
-    case 0xd1: return(inst_pop(code));
-    case 0xd2: return(inst_jp(code));
-    case 0xd3: return(inst_out(code));
-    case 0xd4: return(inst_call(code));
-    case 0xd5: return(inst_push(code));
-    case 0xd6: return(inst_sub(code));
-    case 0xd7: return(inst_rst(code));
-
-    case 0xd8: return(inst_ret(code));
-    case 0xd9: return(inst_exx(code));
-    case 0xda: return(inst_jp(code));
-    case 0xdb: return(inst_in(code));
-    case 0xdc: return(inst_call(code));
-      /* DD escapes out to 2 to 4 byte opcodes(DD included)
-        with a variety of uses.  It can precede the CB escape
-        sequence to extend CB codes with IX+immed_byte */
-    case 0xdd: return(inst_dd());
-    case 0xde: return(inst_sbc(code));
-    case 0xdf: return(inst_rst(code));
-
-
-    case 0xe0: return(inst_ret(code));
-    case 0xe1: return(inst_pop(code));
-    case 0xe2: return(inst_jp(code));
-    case 0xe3: return(inst_ex(code));
-    case 0xe4: return(inst_call(code));
-    case 0xe5: return(inst_push(code));
-    case 0xe6: return(inst_and(code));
-    case 0xe7: return(inst_rst(code));
-
-    case 0xe8: return(inst_ret(code));
-    case 0xe9: return(inst_jp(code));
-    case 0xea: return(inst_jp(code));
-    case 0xeb: return(inst_ex(code));
-    case 0xec: return(inst_call(code));
-      /* ED escapes out to misc IN, OUT and other oddball opcodes */
-    case 0xed: return(inst_ed());
-    case 0xee: return(inst_xor(code));
-    case 0xef: return(inst_rst(code));
-
-
-    case 0xf0: return(inst_ret(code));
-    case 0xf1: return(inst_pop(code));
-    case 0xf2: return(inst_jp(code));
-    case 0xf3: return(inst_di(code));
-    case 0xf4: return(inst_call(code));
-    case 0xf5: return(inst_push(code));
-    case 0xf6: return(inst_or(code));
-    case 0xf7: return(inst_rst(code));
-
-    case 0xf8: return(inst_ret(code));
-    case 0xf9: return(inst_ld(code));
-    case 0xfa: return(inst_jp(code));
-    case 0xfb: return(inst_ei(code));
-    case 0xfc: return(inst_call(code));
-      /* DD escapes out to 2 to 4 byte opcodes(DD included)
-        with a variety of uses.  It can precede the CB escape
-        sequence to extend CB codes with IX+immed_byte */
-    case 0xfd: return(inst_fd());
-    case 0xfe: return(inst_cp(code));
-    case 0xff: return(inst_rst(code));
-    }
+int
+cl_z80::inst_esc_dd(t_mem code)
+{
+  return(inst_dd());
+}
+
+int
+cl_z80::inst_esc_ed(t_mem code)
+{
+  return(inst_ed());
+}
+
+int
+cl_z80::inst_esc_fd(t_mem code)
+{
+  return(inst_fd());
+}
 
+int
+cl_z80::inst_invalid(t_mem code)
+{
   /*if (PC)
     PC--;
   else
@@ -624,6 +679,17 @@ cl_z80::exec_inst(void)
   return(resINV_INST);
 }
 
+int
+cl_z80::exec_inst(void)
+{
+  t_mem code;
+
+  if (fetch_inst(&code))
+    return(resBREAKPOINT);
+  tick(1);
+  return((this->*itab[code])(code));
+}
+
 void cl_z80::store1( TYPE_UWORD addr, t_mem val ) {
   ram->set(addr, val);
 }
@@ -59,7 +59,20 @@ public:
   virtual const char *disass(t_addr addr, const char *sep);
   virtual void print_regs(class cl_console_base *con);
 
+  virtual bool save_state(FILE *f);
+  virtual bool load_state(FILE *f);
+
+  typedef int (cl_z80::*t_instz80)(t_mem code);
+  static t_instz80 itab[256];
+  static bool itab_made;
+  static void make_itab(void);
+
   virtual int exec_inst(void);
+  virtual int inst_esc_cb(t_mem code);
+  virtual int inst_esc_dd(t_mem code);
+  virtual int inst_esc_ed(t_mem code);
+  virtual int inst_esc_fd(t_mem code);
+  virtual int inst_invalid(t_mem code);
 
   virtual const char *get_disasm_info(t_addr addr,
                         int *ret_len,
@@ -6542,6 +6542,7 @@ createFunction (symbol * name, ast * body)
     }
   name->lastLine = lexLineno;
   currFunc = name;
+  timeFunctionBegin (name->name);
 
   /* set the stack pointer */
   stackPtr = -port->stack.direction * port->stack.call_overhead;
@@ -6589,8 +6590,10 @@ createFunction (symbol * name, ast * body)
   /* name needs to be mangled */
   SNPRINTF (name->rname, sizeof (name->rname), "%s%s", port->fun_prefix, name->name);
 
+  timePassBegin (TIME_AST);
   body = resolveSymbols (body); /* resolve the symbols */
   body = decorateType (body, RESULT_TYPE_NONE); /* propagateType & do semantic checks */
+  timePassEnd (TIME_AST);
 
   /* save the stack information */
   if (options.useXstack)
@@ -6621,7 +6624,9 @@ createFunction (symbol * name, ast * body)
   /* create the node & generate intermediate code */
   GcurMemmap = code;
   codeOutBuf = &code->oBuf;
+  timePassBegin (TIME_ICODE);
   piCode = iCodeFromAst (ex);
+  timePassEnd (TIME_ICODE);
   name->generated = 1;
 
   if (fatalError)
@@ -6667,6 +6672,7 @@ skipall:
 
   xstack->syms = NULL;
   istack->syms = NULL;
+  timeFunctionEnd ();
   return NULL;
 }
 
@@ -449,13 +449,33 @@ bitVectnBitsOn (bitVect * bvp)
 int 
 bitVectFirstBit (bitVect * bvp)
 {
-  int i;
+  return bitVectNextBit (bvp, 0);
+}
 
-  if (!bvp)
+/*-----------------------------------------------------------------*/
+/* bitVectNextBit - returns the first bit on at or after pos, -1   */
+/*                  if none; empty bytes are skipped as a whole    */
+/*-----------------------------------------------------------------*/
+int
+bitVectNextBit (bitVect * bvp, int pos)
+{
+  int byteSize;
+
+  if (!bvp || pos < 0)
     return -1;
-  for (i = 0; i < bvp->size; i++)
-    if (bitVectBitValue (bvp, i))
-      return i;
+
+  while (pos < bvp->size)
+    {
+      byteSize = pos / 8;
+      if (bvp->vect[byteSize] == 0)
+        {
+          pos = (byteSize + 1) * 8;
+          continue;
+        }
+      if ((bvp->vect[byteSize] >> (7 - pos % 8)) & ((unsigned char) 1))
+        return pos;
+      pos++;
+    }
 
   return -1;
 }
@@ -58,5 +58,6 @@ bitVect *bitVectCopy (bitVect *);
 int bitVectIsZero (bitVect *);
 int bitVectnBitsOn (bitVect *);
 int bitVectFirstBit (bitVect *);
+int bitVectNextBit (bitVect *, int);
 void bitVectDebugOn (bitVect *, FILE *);
 #endif
@@ -2421,8 +2421,11 @@ cseAllBlocks (ebbIndex * ebbi, int computeOnly)
 
   /* if optimization turned off */
 
+  timePassBegin (TIME_CSE);
   for (i = 0; i < count; i++)
     change += cseBBlock (ebbs[i], computeOnly, ebbi);
+  timeCount (TIME_CNT_CSE_BLOCKS, count);
+  timePassEnd (TIME_CSE);
 
   return change;
 }
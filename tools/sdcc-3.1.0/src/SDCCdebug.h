@@ -24,5 +24,6 @@ void outputDebugStackSymbols (void);
 void outputDebugSymbols (void);
 void dumpSymInfo (const char *pcName, memmap *memItem);
 void emitDebuggerSymbol (const char * debugSym);
+int cdbWriteIndex (const char *name);
 
 #endif
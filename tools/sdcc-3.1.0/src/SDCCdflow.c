@@ -170,12 +170,15 @@ computeDataFlow (ebbIndex * ebbi)
   int i;
   int change;
 
+  timePassBegin (TIME_DFLOW);
+
   for (i = 0; i < count; i++)
     ebbs[i]->killedExprs = NULL;
 
   do
     {
       change = 0;
+      timeCount (TIME_CNT_DFLOW_ITER, 1);
 
       /* for all blocks */
       for (i = 0; i < count; i++)
@@ -254,6 +257,7 @@ computeDataFlow (ebbIndex * ebbi)
     }
   while (change);      /* iterate till no change */
 
+  timePassEnd (TIME_DFLOW);
   return;
 }
 
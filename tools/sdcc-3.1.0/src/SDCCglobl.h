@@ -259,6 +259,7 @@ struct options
     int asmpeep;                /* pass inline assembler thru peep hole */
     int peepReturn;             /* enable peephole optimization for return instructions */
     int debug;                  /* generate extra debug info */
+    int debugIndex;             /* index the .cdb made by the linker */
     int c1mode;                 /* Act like c1 - no pre-proc, asm or link */
     char *peep_file;            /* additional rules for peep hole */
     int nostdlib;               /* Don't use standard lib files */
@@ -298,6 +299,8 @@ struct options
     int noPeepComments;         /* hide peephole optimizer comments */
     int verboseAsm;             /* include comments generated with gen.c */
     int printSearchDirs;        /* display the directories in the compiler's search path */
+    int time_passes;            /* print the time spent in the compiler passes */
+    char *time_trace;           /* write the pass times as trace-event JSON to this file */
     int vc_err_style;           /* errors and warnings are compatible with Micro$oft visual studio */
     int use_stdout;             /* send errors to stdout instead of stderr */
     int no_std_crt0;            /* for the z80/gbz80 do not link default crt0.o*/
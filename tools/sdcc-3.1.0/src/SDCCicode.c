@@ -553,6 +553,7 @@ newiCode (int op, operand * left, operand * right)
   iCode *ic;
 
   ic = Safe_alloc (sizeof (iCode));
+  timeCount (TIME_CNT_ICODES, 1);
 
   ic->seqPoint = seqPoint;
   ic->filename = filename;
@@ -31,6 +31,12 @@ hTab *liveRanges = NULL;
 hTab *iCodehTab = NULL;
 hTab *iCodeSeqhTab = NULL;
 
+/* functions with more iCodes times operand keys than this get their
+   clashes from the live intervals, see computeClash () */
+#ifndef LRANGE_INTERVAL_THRESHOLD
+#define LRANGE_INTERVAL_THRESHOLD 1000000
+#endif
+
 /* all symbols, for which the previous definition is searched
    and warning is emitted if there's none. */
 #define IS_AUTOSYM(op) (IS_ITEMP(op) || \
@@ -671,11 +677,8 @@ rlivePoint (eBBlock ** ebbs, int count, bool emitWarnings)
 
       if(!alive)
         continue;
-      for (key = 1; key < alive->size; key++)
+      for (key = bitVectNextBit (alive, 1); key >= 0; key = bitVectNextBit (alive, key + 1))
         {
-	  if (!bitVectBitValue (alive, key))
-	    continue;
-
 	  unvisitBlocks(ebbs, count);
 	  findNextUseSym (ebbs[i], NULL, hTabItemWithKey (liveRanges, key));
 	}
@@ -684,12 +687,193 @@ rlivePoint (eBBlock ** ebbs, int count, bool emitWarnings)
 }
 
 /*-----------------------------------------------------------------*/
-/* computeClash - find out which live ranges collide with others   */
+/* lrAddPoint - adds iCode seq to the intervals of a live range,   */
+/*              seqs must be added in ascending order              */
 /*-----------------------------------------------------------------*/
 static void
-computeClash (eBBlock ** ebbs, int count)
+lrAddPoint (symbol * sym, int seq)
+{
+  lrIntervals *lri = sym->liveIntervals;
+
+  if (lri->count && lri->iv[lri->count - 1].to >= seq - 1)
+    {
+      if (lri->iv[lri->count - 1].to < seq)
+        lri->iv[lri->count - 1].to = seq;
+      return;
+    }
+
+  if (lri->count == lri->alloc)
+    {
+      lri->alloc = lri->alloc ? 2 * lri->alloc : 4;
+      lri->iv = Safe_realloc (lri->iv, lri->alloc * sizeof (lrInterval));
+    }
+  lri->iv[lri->count].from = seq;
+  lri->iv[lri->count].to = seq;
+  lri->count++;
+}
+
+/*-----------------------------------------------------------------*/
+/* computeLiveIntervals - collects the points of the rlive bitVects */
+/*                        into intervals of each live range        */
+/*-----------------------------------------------------------------*/
+static void
+computeLiveIntervals (eBBlock ** ebbs, int count)
+{
+  symbol *sym;
+  int i, key;
+
+  for (sym = hTabFirstItem (liveRanges, &key); sym;
+       sym = hTabNextItem (liveRanges, &key))
+    {
+      if (!sym->liveIntervals)
+        sym->liveIntervals = Safe_alloc (sizeof (lrIntervals));
+      sym->liveIntervals->count = 0;
+    }
+
+  /* the seqs grow along the blocks, see sequenceiCode () */
+  for (i = 0; i < count; i++)
+    {
+      iCode *ic;
+
+      for (ic = ebbs[i]->sch; ic; ic = ic->next)
+        {
+          for (key = bitVectNextBit (ic->rlive, 1); key >= 0;
+               key = bitVectNextBit (ic->rlive, key + 1))
+            {
+              sym = hTabItemWithKey (liveRanges, key);
+              if (sym)
+                lrAddPoint (sym, ic->seq);
+            }
+        }
+    }
+}
+
+/*-----------------------------------------------------------------*/
+/* freeLiveIntervals - frees the intervals of a live range         */
+/*-----------------------------------------------------------------*/
+static void
+freeLiveIntervals (symbol * sym)
+{
+  if (!sym->liveIntervals)
+    return;
+
+  Safe_free (sym->liveIntervals->iv);
+  Safe_free (sym->liveIntervals);
+  sym->liveIntervals = NULL;
+}
+
+/*-----------------------------------------------------------------*/
+/* lrNextLive - returns the first iCode seq at or after seq at     */
+/*              which the live range is alive, 0 if there is none  */
+/*-----------------------------------------------------------------*/
+int
+lrNextLive (symbol * sym, int seq)
+{
+  lrIntervals *lri = sym->liveIntervals;
+  int lo, hi;
+
+  if (!lri || !lri->count || lri->iv[lri->count - 1].to < seq)
+    return 0;
+
+  /* first interval ending at or after seq */
+  lo = 0;
+  hi = lri->count - 1;
+  while (lo < hi)
+    {
+      int mid = (lo + hi) / 2;
+
+      if (lri->iv[mid].to < seq)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+
+  return lri->iv[lo].from > seq ? lri->iv[lo].from : seq;
+}
+
+/*-----------------------------------------------------------------*/
+/* lrLiveAt - is the live range alive at iCode seq                 */
+/*-----------------------------------------------------------------*/
+bool
+lrLiveAt (symbol * sym, int seq)
+{
+  return lrNextLive (sym, seq) == seq;
+}
+
+/*-----------------------------------------------------------------*/
+/* noClashAt - the iTemps sym1 (key1) and sym2 (key2) are both     */
+/*             alive at ic, but the result of ic just takes over   */
+/*             from an operand which dies there                    */
+/*-----------------------------------------------------------------*/
+static bool
+noClashAt (iCode * ic, symbol * sym1, int key1, symbol * sym2, int key2)
+{
+  /* if the result and left or right is an iTemp */
+  /* than possibly the iTemps do not clash */
+  if ((ic->op == JUMPTABLE) || (ic->op == IFX) ||
+      !IS_ITEMP(IC_RESULT(ic)) ||
+      !(IS_ITEMP(IC_LEFT(ic)) || IS_ITEMP(IC_RIGHT(ic))))
+    return FALSE;
+
+  if (OP_SYMBOL(IC_RESULT(ic))->key == key1
+      && sym1->liveFrom == ic->seq
+      && sym2->liveTo == ic->seq)
+    {
+      if (IS_SYMOP(IC_LEFT(ic)))
+        if (OP_SYMBOL(IC_LEFT(ic))->key == key2)
+          return TRUE;
+      if (IS_SYMOP(IC_RIGHT(ic)))
+        if (OP_SYMBOL(IC_RIGHT(ic))->key == key2)
+          return TRUE;
+    }
+
+  if (OP_SYMBOL(IC_RESULT(ic))->key == key2
+      && sym2->liveFrom == ic->seq
+      && sym1->liveTo == ic->seq)
+    {
+      if (IS_SYMOP(IC_LEFT(ic)))
+        if (OP_SYMBOL(IC_LEFT(ic))->key == key1)
+          return TRUE;
+      if (IS_SYMOP(IC_RIGHT(ic)))
+        if (OP_SYMBOL(IC_RIGHT(ic))->key == key1)
+          return TRUE;
+    }
+
+  return FALSE;
+}
+
+/*-----------------------------------------------------------------*/
+/* setClash - records that the iTemps sym1 and sym2 clash          */
+/*-----------------------------------------------------------------*/
+static void
+setClash (symbol * sym1, int key1, symbol * sym2, int key2)
+{
+  /* the iTemps do clash. set the bits in clashes */
+  sym1->clashes = bitVectSetBit (sym1->clashes, key2);
+  sym2->clashes = bitVectSetBit (sym2->clashes, key1);
+
+  /* check if they share the same spill location */
+  /* what is this good for? */
+  if (SYM_SPIL_LOC(sym1) && SYM_SPIL_LOC(sym2) &&
+      SYM_SPIL_LOC(sym1) == SYM_SPIL_LOC(sym2))
+    {
+      if (sym1->reqv && !sym2->reqv) SYM_SPIL_LOC(sym2)=NULL;
+      else if (sym2->reqv && !sym1->reqv) SYM_SPIL_LOC(sym1)=NULL;
+      else if (sym1->used > sym2->used) SYM_SPIL_LOC(sym2)=NULL;
+      else SYM_SPIL_LOC(sym1)=NULL;
+    }
+}
+
+/*-----------------------------------------------------------------*/
+/* computeClashAtiCodes - pairs up the iTemps alive at each iCode  */
+/*-----------------------------------------------------------------*/
+static void
+computeClashAtiCodes (eBBlock ** ebbs, int count)
 {
   int i;
+  symbol **live = NULL;         /* iTemps alive at the current iCode */
+  int *liveKeys = NULL;         /* and their keys */
+  int liveSize = 0;
 
   /* for all blocks do */
   for (i = 0; i < count; i++)
@@ -699,80 +883,217 @@ computeClash (eBBlock ** ebbs, int count)
       /* for every iCode do */
       for (ic = ebbs[i]->sch; ic; ic = ic->next)
 	{
-	  symbol *sym1, *sym2;
-	  int key1, key2;
-
-	  /* for all iTemps alive at this iCode */
-	  for (key1 = 1; key1 < ic->rlive->size; key1++)
+	  symbol *sym1;
+	  int key1;
+	  int nLive, l1, l2;
+
+	  /* collect the iTemps alive at this iCode once, so the pairs */
+	  /* below are built from the live ones only and not from all */
+	  /* the keys in the (mostly empty) rlive bitVect              */
+	  if (ic->rlive->size > liveSize)
+	    {
+	      liveSize = ic->rlive->size;
+	      live = Safe_realloc (live, liveSize * sizeof (symbol *));
+	      liveKeys = Safe_realloc (liveKeys, liveSize * sizeof (int));
+	    }
+	  nLive = 0;
+	  for (key1 = bitVectNextBit (ic->rlive, 1); key1 >= 0;
+	       key1 = bitVectNextBit (ic->rlive, key1 + 1))
 	    {
-	      if (!bitVectBitValue(ic->rlive, key1))
-	        continue;
-
 	      sym1 = hTabItemWithKey(liveRanges, key1);
 
-	      if (!sym1->isitmp)
-	        continue;
+	      if (sym1->isitmp)
+	        {
+	          live[nLive] = sym1;
+	          liveKeys[nLive++] = key1;
+	        }
+	    }
 
+	  /* for all iTemps alive at this iCode */
+	  for (l1 = 0; l1 < nLive; l1++)
+	    {
 	      /* for all other iTemps alive at this iCode */
-	      for (key2 = key1+1; key2 < ic->rlive->size; key2++)
+	      for (l2 = l1+1; l2 < nLive; l2++)
 	        {
-		  if (!bitVectBitValue(ic->rlive, key2))
-		    continue;
-
-		  sym2 = hTabItemWithKey(liveRanges, key2);
-
-		  if (!sym2->isitmp)
+		  if (noClashAt (ic, live[l1], liveKeys[l1], live[l2], liveKeys[l2]))
 		    continue;
 
-		  /* if the result and left or right is an iTemp */
-		  /* than possibly the iTemps do not clash */
-		  if ((ic->op != JUMPTABLE) && (ic->op != IFX) &&
-		      IS_ITEMP(IC_RESULT(ic)) &&
-		      (IS_ITEMP(IC_LEFT(ic)) || IS_ITEMP(IC_RIGHT(ic))))
-		    {
-		      if (OP_SYMBOL(IC_RESULT(ic))->key == key1
-			  && sym1->liveFrom == ic->seq
-			  && sym2->liveTo == ic->seq)
-		        {
-		          if (IS_SYMOP(IC_LEFT(ic)))
-			    if (OP_SYMBOL(IC_LEFT(ic))->key == key2)
-			      continue;
-		          if (IS_SYMOP(IC_RIGHT(ic)))
-			    if (OP_SYMBOL(IC_RIGHT(ic))->key == key2)
-			      continue;
-			}
-
-		      if (OP_SYMBOL(IC_RESULT(ic))->key == key2
-			  && sym2->liveFrom == ic->seq
-			  && sym1->liveTo == ic->seq)
-		        {
-		          if (IS_SYMOP(IC_LEFT(ic)))
-			    if (OP_SYMBOL(IC_LEFT(ic))->key == key1)
-			      continue;
-		          if (IS_SYMOP(IC_RIGHT(ic)))
-			    if (OP_SYMBOL(IC_RIGHT(ic))->key == key1)
-			      continue;
-			}
-		    }
-
-		  /* the iTemps do clash. set the bits in clashes */
-		  sym1->clashes = bitVectSetBit (sym1->clashes, key2);
-		  sym2->clashes = bitVectSetBit (sym2->clashes, key1);
-
-		  /* check if they share the same spill location */
-		  /* what is this good for? */
-	          if (SYM_SPIL_LOC(sym1) && SYM_SPIL_LOC(sym2) &&
-		      SYM_SPIL_LOC(sym1) == SYM_SPIL_LOC(sym2))
-		    {
-		      if (sym1->reqv && !sym2->reqv) SYM_SPIL_LOC(sym2)=NULL;
-		      else if (sym2->reqv && !sym1->reqv) SYM_SPIL_LOC(sym1)=NULL;
-		      else if (sym1->used > sym2->used) SYM_SPIL_LOC(sym2)=NULL;
-		      else SYM_SPIL_LOC(sym1)=NULL;
-		    }
+		  setClash (live[l1], liveKeys[l1], live[l2], liveKeys[l2]);
 		}
 	    }
 	}
     }
+
+  Safe_free (live);
+  Safe_free (liveKeys);
+}
+
+/* two live ranges alive at the same iCodes, key1 < key2 */
+typedef struct lrOverlap
+{
+  int key1, key2;
+  int from, to;
+} lrOverlap;
+
+static int
+overlapPairCmp (const void *p1, const void *p2)
+{
+  const lrOverlap *o1 = p1, *o2 = p2;
+
+  if (o1->key1 != o2->key1)
+    return o1->key1 < o2->key1 ? -1 : 1;
+  if (o1->key2 != o2->key2)
+    return o1->key2 < o2->key2 ? -1 : 1;
+  return o1->from < o2->from ? -1 : o1->from > o2->from;
+}
+
+static int
+overlapSeqCmp (const void *p1, const void *p2)
+{
+  const lrOverlap *o1 = p1, *o2 = p2;
+
+  if (o1->from != o2->from)
+    return o1->from < o2->from ? -1 : 1;
+  if (o1->key1 != o2->key1)
+    return o1->key1 < o2->key1 ? -1 : 1;
+  return o1->key2 < o2->key2 ? -1 : o1->key2 > o2->key2;
+}
+
+/* an interval of a live range, for the sweep below */
+typedef struct lrSweepItem
+{
+  symbol *sym;
+  int key;
+  int from, to;
+} lrSweepItem;
+
+static int
+sweepItemCmp (const void *p1, const void *p2)
+{
+  const lrSweepItem *s1 = p1, *s2 = p2;
+
+  if (s1->from != s2->from)
+    return s1->from < s2->from ? -1 : 1;
+  return s1->key < s2->key ? -1 : s1->key > s2->key;
+}
+
+/*-----------------------------------------------------------------*/
+/* computeClashByIntervals - finds the clashes by sweeping over    */
+/*             the live intervals instead of visiting every iCode; */
+/*             the result is the same as computeClashAtiCodes ()   */
+/*-----------------------------------------------------------------*/
+static void
+computeClashByIntervals (void)
+{
+  lrSweepItem *items = NULL, **active = NULL;
+  lrOverlap *ovl = NULL;
+  int nItems = 0, nActive = 0, nOvl = 0, ovlAlloc = 0;
+  int i, j, k, key;
+  symbol *sym;
+
+  /* all intervals of all iTemps, by start */
+  for (sym = hTabFirstItem (liveRanges, &key); sym;
+       sym = hTabNextItem (liveRanges, &key))
+    if (sym->isitmp && sym->liveIntervals)
+      nItems += sym->liveIntervals->count;
+  if (!nItems)
+    return;
+  items = Safe_alloc (nItems * sizeof (lrSweepItem));
+  active = Safe_alloc (nItems * sizeof (lrSweepItem *));
+  i = 0;
+  for (sym = hTabFirstItem (liveRanges, &key); sym;
+       sym = hTabNextItem (liveRanges, &key))
+    {
+      if (!sym->isitmp || !sym->liveIntervals)
+        continue;
+      for (j = 0; j < sym->liveIntervals->count; j++, i++)
+        {
+          items[i].sym = sym;
+          items[i].key = key;
+          items[i].from = sym->liveIntervals->iv[j].from;
+          items[i].to = sym->liveIntervals->iv[j].to;
+        }
+    }
+  qsort (items, nItems, sizeof (lrSweepItem), sweepItemCmp);
+
+  /* every interval overlaps the active ones which end at or after */
+  /* its start; the intervals of one live range never overlap      */
+  for (i = 0; i < nItems; i++)
+    {
+      for (j = k = 0; j < nActive; j++)
+        {
+          lrSweepItem *a = active[j];
+
+          if (a->to < items[i].from)
+            continue;
+          active[k++] = a;
+
+          if (nOvl == ovlAlloc)
+            {
+              ovlAlloc = ovlAlloc ? 2 * ovlAlloc : 64;
+              ovl = Safe_realloc (ovl, ovlAlloc * sizeof (lrOverlap));
+            }
+          ovl[nOvl].key1 = a->key < items[i].key ? a->key : items[i].key;
+          ovl[nOvl].key2 = a->key < items[i].key ? items[i].key : a->key;
+          ovl[nOvl].from = items[i].from;
+          ovl[nOvl].to = a->to < items[i].to ? a->to : items[i].to;
+          nOvl++;
+        }
+      nActive = k;
+      active[nActive++] = &items[i];
+    }
+
+  /* keep the first point of each pair where they really clash */
+  qsort (ovl, nOvl, sizeof (lrOverlap), overlapPairCmp);
+  for (i = j = 0; i < nOvl; )
+    {
+      symbol *sym1 = hTabItemWithKey (liveRanges, ovl[i].key1);
+      symbol *sym2 = hTabItemWithKey (liveRanges, ovl[i].key2);
+      int first = 0;
+
+      for (k = i; k < nOvl && ovl[k].key1 == ovl[i].key1 && ovl[k].key2 == ovl[i].key2; k++)
+        {
+          int seq;
+
+          /* at most one point of a pair can be an exception */
+          for (seq = ovl[k].from; !first && seq <= ovl[k].to; seq++)
+            if (!noClashAt (hTabItemWithKey (iCodeSeqhTab, seq),
+                            sym1, ovl[i].key1, sym2, ovl[i].key2))
+              first = seq;
+        }
+      if (first)
+        {
+          ovl[j] = ovl[i];
+          ovl[j++].from = first;
+        }
+      i = k;
+    }
+  nOvl = j;
+
+  /* the spill location check depends on the order, which has to   */
+  /* be the one of computeClashAtiCodes ()                         */
+  qsort (ovl, nOvl, sizeof (lrOverlap), overlapSeqCmp);
+  for (i = 0; i < nOvl; i++)
+    setClash (hTabItemWithKey (liveRanges, ovl[i].key1), ovl[i].key1,
+              hTabItemWithKey (liveRanges, ovl[i].key2), ovl[i].key2);
+
+  Safe_free (ovl);
+  Safe_free (active);
+  Safe_free (items);
+}
+
+/*-----------------------------------------------------------------*/
+/* computeClash - find out which live ranges collide with others   */
+/*-----------------------------------------------------------------*/
+static void
+computeClash (eBBlock ** ebbs, int count)
+{
+  /* big functions have many iTemps alive over long stretches of */
+  /* code, pairing them up at every iCode gets expensive          */
+  if ((double) iCodeSeq * operandKey > LRANGE_INTERVAL_THRESHOLD)
+    computeClashByIntervals ();
+  else
+    computeClashAtiCodes (ebbs, count);
 }
 
 /*-----------------------------------------------------------------*/
@@ -848,6 +1169,8 @@ adjustIChain (eBBlock ** ebbs, int count)
 void
 computeLiveRanges (eBBlock ** ebbs, int count, bool emitWarnings)
 {
+  timePassBegin (TIME_LRANGE);
+
   /* first look through all blocks and adjust the
      sch and ech pointers */
   adjustIChain (ebbs, count);
@@ -870,8 +1193,13 @@ computeLiveRanges (eBBlock ** ebbs, int count, bool emitWarnings)
   /* mark the from & to live ranges for variables used */
   markLiveRanges (ebbs, count);
 
+  /* and the points in between as intervals */
+  computeLiveIntervals (ebbs, count);
+
   /* compute which overlaps with what */
   computeClash(ebbs, count);
+
+  timePassEnd (TIME_LRANGE);
 }
 
 /*-----------------------------------------------------------------*/
@@ -895,6 +1223,7 @@ recomputeLiveRanges (eBBlock ** ebbs, int count)
         sym->liveTo = 0;
         freeBitVect (sym->clashes);
         sym->clashes = NULL;
+        freeLiveIntervals (sym);
       } while ( (sym = hTabNextItem (liveRanges, &key)));
     }
 
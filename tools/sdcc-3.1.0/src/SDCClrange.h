@@ -26,6 +26,23 @@
 #ifndef SDCCLRANGE_H
 #define SDCCLRANGE_H 1
 
+/* The iCode seqs at which a live range is alive, as runs of
+   consecutive seqs in ascending order; see symbol->liveIntervals */
+typedef struct lrInterval
+{
+  int from;                     /* first seq of the run */
+  int to;                       /* last seq of the run */
+}
+lrInterval;
+
+typedef struct lrIntervals
+{
+  int count;
+  int alloc;
+  lrInterval *iv;
+}
+lrIntervals;
+
 extern hTab *liveRanges;
 extern hTab *iCodehTab;
 extern hTab *iCodeSeqhTab;
@@ -34,6 +51,8 @@ int  notUsedInBlock (symbol *, eBBlock *, iCode *);
 bool allDefsOutOfRange (bitVect *, int, int);
 void computeLiveRanges (eBBlock **, int, bool);
 void recomputeLiveRanges (eBBlock **, int);
+int  lrNextLive (symbol *, int);
+bool lrLiveAt (symbol *, int);
 
 void setToRange (operand *, int, bool);
 void hashiCodeKeys (eBBlock **, int);
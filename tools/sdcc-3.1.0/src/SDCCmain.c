@@ -177,6 +177,7 @@ static const OPTION optionsTable[] = {
   {0,   OPTION_DISABLE_WARNING, NULL, "<nnnn> Disable specific warning"},
   {0,   OPTION_WERROR, NULL, "Treat the warnings as errors"},
   {0,   OPTION_DEBUG, NULL, "Enable debugging symbol output"},
+  {0,   "--debug-index", &options.debugIndex, "Write an index of the debug information (.cdx) for sdcdb"},
   {0,   "--cyclomatic", &options.cyclomatic, "Display complexity of compiled functions"},
   {0,   OPTION_STD_C89, NULL, "Use C89 standard only"},
   {0,   OPTION_STD_SDCC89, NULL, "Use C89 standard with SDCC extensions (default)"},
@@ -240,6 +241,8 @@ static const OPTION optionsTable[] = {
   {0,   "--dumptree", &options.dump_tree, "dump front-end AST before generating iCode"},
   {0,   OPTION_DUMP_ALL, NULL, "Dump the internal structure at all stages"},
   {0,   OPTION_ICODE_IN_ASM, &options.iCodeInAsm, "include i-code as comments in the asm file"},
+  {0,   "--time-passes", &options.time_passes, "Print the time spent in every compiler pass"},
+  {0,   "--time-trace", &options.time_trace, "<file> Write the pass times as Chrome trace-event JSON", CLAT_STRING},
 
   {0,   NULL, NULL, "Linker options"},
   {'l', NULL, NULL, "Include the given library in the link"},
@@ -592,7 +595,7 @@ setDefaultOptions (void)
   options.const_seg = CONST_NAME ? Safe_strdup (CONST_NAME) : NULL;     /* default to CONST for generated code */
   options.stack10bit = 0;
   options.out_fmt = 0;
-  options.max_allocs_per_node = 3000;
+  options.max_allocs_per_node = 8000;
 
   /* now for the optimizations */
   /* turn on the everything */
@@ -1841,6 +1844,9 @@ linkEdit (char **envp)
 
   if (system_ret)
     exit (EXIT_FAILURE);
+
+  if (options.debug && options.debugIndex)
+    cdbWriteIndex (dstFileName);
 }
 
 /*-----------------------------------------------------------------*/
@@ -2491,7 +2497,9 @@ main (int argc, char **argv, char **envp)
       if (options.verbose)
         printf ("sdcc: Generating code...\n");
 
+      timePassBegin (TIME_PARSE);
       yyparse ();
+      timePassEnd (TIME_PARSE);
 
       if (!options.c1mode)
         if (sdcc_pclose (yyin))
@@ -2500,6 +2508,7 @@ main (int argc, char **argv, char **envp)
       if (fatalError)
         exit (EXIT_FAILURE);
 
+      timePassBegin (TIME_GLUE);
       if (port->general.do_glue != NULL)
         (*port->general.do_glue) ();
       else
@@ -2509,6 +2518,7 @@ main (int argc, char **argv, char **envp)
           /* in case of NDEBUG */
           glue ();
         }
+      timePassEnd (TIME_GLUE);
 
       if (fatalError)
         exit (EXIT_FAILURE);
@@ -2517,8 +2527,12 @@ main (int argc, char **argv, char **envp)
         {
           if (options.verbose)
             printf ("sdcc: Calling assembler...\n");
+          timePassBegin (TIME_ASSEMBLE);
           assemble (envp);
+          timePassEnd (TIME_ASSEMBLE);
         }
+
+      timePassesReport ();
     }
   closeDumpFiles ();
 
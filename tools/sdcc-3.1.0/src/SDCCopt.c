@@ -1381,6 +1381,8 @@ killDeadCode (ebbIndex * ebbi)
   int gchange = 0;
   int i = 0;
 
+  timePassBegin (TIME_DEADCODE);
+
   /* basic algorithm :-                                          */
   /* first the exclusion rules :-                                */
   /*  1. if result is a global or volatile then skip             */
@@ -1570,6 +1572,7 @@ killDeadCode (ebbIndex * ebbi)
     }                           /* end of do */
   while (change);
 
+  timePassEnd (TIME_DEADCODE);
   return gchange;
 }
 
@@ -1712,6 +1715,8 @@ eBBlockFromiCode (iCode * ic)
   if (!ic)
     return NULL;
 
+  timePassBegin (TIME_OPTIMIZE);
+
   eBBNum = 0;
 
   /* optimize the chain for labels & gotos
@@ -1788,7 +1793,9 @@ eBBlockFromiCode (iCode * ic)
     dumpEbbsToFileExt (DUMP_DEADCODE, ebbi);
 
   /* do loop optimizations */
+  timePassBegin (TIME_LOOP);
   change += (lchange = loopOptimizations (loops, ebbi));
+  timePassEnd (TIME_LOOP);
   if (options.dump_loop)
     dumpEbbsToFileExt (DUMP_LOOP, ebbi);
 
@@ -1867,10 +1874,13 @@ eBBlockFromiCode (iCode * ic)
   discardDeadParamReceives (ebbi->bbOrder, ebbi->count);
 
   /* allocate registers & generate code */
+  timePassBegin (TIME_RALLOC);
   port->assignRegisters (ebbi);
+  timePassEnd (TIME_RALLOC);
 
   /* throw away blocks */
   setToNull ((void *) &graphEdges);
 
+  timePassEnd (TIME_OPTIMIZE);
   return NULL;
 }
@@ -2317,6 +2317,8 @@ peepHole (lineNode ** pls)
 
   assert(labelHash == NULL);
 
+  timePassBegin (TIME_PEEPHOLE);
+
   do
     {
       restart = FALSE;
@@ -2349,6 +2351,8 @@ peepHole (lineNode ** pls)
                 {
                   /* restart at the replaced line */
                   replaced = TRUE;
+                  pr->fired++;
+                  timeCount (TIME_CNT_PEEP_FIRED, 1);
 
                   /* then replace */
                   if (spl == *pls)
@@ -2385,6 +2389,57 @@ peepHole (lineNode ** pls)
       freeTrace (&_G.labels);
     }
   labelHash = NULL;
+
+  timePassEnd (TIME_PEEPHOLE);
+}
+
+/*-----------------------------------------------------------------*/
+/* printPeepRuleStats - lists the rules which have been applied    */
+/*-----------------------------------------------------------------*/
+void
+printPeepRuleStats (FILE * of)
+{
+  peepRule *pr;
+  int n;
+
+  fprintf (of, "\n%-6s %-50s %10s\n", "rule", "first line of match", "fired");
+  for (n = 1, pr = rootRules; pr; n++, pr = pr->next)
+    {
+      if (!pr->fired)
+        continue;
+      fprintf (of, "%-6d %-50.50s %10d\n", n, pr->match ? pr->match->line : "", pr->fired);
+    }
+}
+
+/*-----------------------------------------------------------------*/
+/* getPeepRulesFired - copies the times each rule has been applied */
+/*                     to fired, if given; returns the nr of rules */
+/*-----------------------------------------------------------------*/
+int
+getPeepRulesFired (int *fired)
+{
+  peepRule *pr;
+  int n;
+
+  for (n = 0, pr = rootRules; pr; n++, pr = pr->next)
+    if (fired)
+      fired[n] = pr->fired;
+
+  return n;
+}
+
+/*-----------------------------------------------------------------*/
+/* addPeepRulesFired - adds counts got by getPeepRulesFired ()     */
+/*                     in another process; NULL clears the counts  */
+/*-----------------------------------------------------------------*/
+void
+addPeepRulesFired (const int *fired, int n)
+{
+  peepRule *pr;
+  int i;
+
+  for (i = 0, pr = rootRules; pr && (!fired || i < n); i++, pr = pr->next)
+    pr->fired = fired ? pr->fired + fired[i] : 0;
 }
 
 
@@ -54,6 +54,7 @@ typedef struct peepRule
     unsigned int barrier:1;
     char *cond;
     hTab *vars;
+    int fired;                  /* times applied, for --time-passes */
     struct peepRule *next;
   }
 peepRule;
@@ -79,5 +80,8 @@ lineNode *newLineNode (const char *);
 lineNode *connectLine (lineNode *, lineNode *);
 void initPeepHole (void);
 void peepHole (lineNode **);
+void printPeepRuleStats (FILE *);
+int getPeepRulesFired (int *);
+void addPeepRulesFired (const int *, int);
 
 #endif
@@ -29,7 +29,8 @@
 // quite involved, e.g. the number of bytes of code the code generator would generate.
 //
 // 2) Call
-// create_cfg(), thorup_tree_decomposition(), nicify(), alive_tree_dec(), tree_dec_ralloc_nodes().
+// create_cfg(), narrow_tree_decomposition(), nicify(), alive_tree_dec(), tree_dec_ralloc_nodes()
+// (or tree_dec_ralloc_nodes_parallel()).
 //
 // The Z80 port can serve as an example, see z80_ralloc2_cc() in z80/ralloc2.cc.
 
@@ -38,9 +39,28 @@
 
 #include <iostream>
 #include <limits>
+#include <vector>
+#include <algorithm>
 #include <utility>
 #include <sstream>
 #include <fstream>
+#include <string>
+#include <deque>
+#include <map>
+#include <cstring>
+#include <cstdio>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#endif
 
 #include <boost/graph/graphviz.hpp>
 #include <boost/graph/adjacency_matrix.hpp>
@@ -62,13 +82,6 @@ iCode *ifxForOp (operand *op, const iCode *ic); // Todo: Move this port-dependen
 bool assignment_optimal;
 }
 
-#ifdef HAVE_STX_BTREE_SET_H
-#include <stx/btree_set.h>
-#endif
-#ifdef HAVE_STX_BTREE_MAP_H
-#include <stx/btree_map.h>
-#endif
-
 typedef short int var_t;
 typedef signed char reg_t;
 
@@ -130,31 +143,332 @@ struct i_assignment_t
   }
 };
 
-#ifdef HAVE_STX_BTREE_SET_H
-typedef stx::btree_set<var_t> varset_t; // Faster than std::set
-#else
-typedef std::set<var_t> varset_t;
-#endif
-//typedef std::set<var_t, std::less<var_t>, boost::fast_pool_allocator<var_t> > varset_t; // Slower than ordinary std::set
+// Raw copies, for passing assignments between processes.
+template <class T>
+inline void save_raw(std::string &buf, const T *p, size_t n)
+{
+  buf.append(reinterpret_cast<const char *>(p), n * sizeof(T));
+}
 
-#ifdef HAVE_STX_BTREE_MAP_H
-typedef stx::btree_map<int, float> icosts_t; // Faster than std::map
-#else
-typedef std::map<int, float> icosts_t;
-#endif
-//typedef std::tr1::unordered_set<var_t> varset_t; // Speed about the same as std::set
+template <class T>
+inline void restore_raw(const char *&buf, T *p, size_t n)
+{
+  std::memcpy(p, buf, n * sizeof(T));
+  buf += n * sizeof(T);
+}
+
+// Set of variables, kept sorted in an array: The variables of a bag are few,
+// and are copied with every assignment, which is cheap for an array.
+class varset_t
+{
+  std::vector<var_t> vars;
+
+public:
+  typedef std::vector<var_t>::const_iterator const_iterator;
+
+  const_iterator begin(void) const
+  {
+    return(vars.begin());
+  }
+
+  const_iterator end(void) const
+  {
+    return(vars.end());
+  }
+
+  size_t size(void) const
+  {
+    return(vars.size());
+  }
+
+  const_iterator find(var_t v) const
+  {
+    const_iterator i = std::lower_bound(vars.begin(), vars.end(), v);
+    return((i != vars.end() && *i == v) ? i : vars.end());
+  }
+
+  void insert(var_t v)
+  {
+    std::vector<var_t>::iterator i = std::lower_bound(vars.begin(), vars.end(), v);
+    if (i == vars.end() || *i != v)
+      vars.insert(i, v);
+  }
+
+  void erase(var_t v)
+  {
+    std::vector<var_t>::iterator i = std::lower_bound(vars.begin(), vars.end(), v);
+    if (i != vars.end() && *i == v)
+      vars.erase(i);
+  }
+
+  void swap(varset_t &s)
+  {
+    vars.swap(s.vars);
+  }
+
+  bool operator!=(const varset_t &s) const
+  {
+    return(vars != s.vars);
+  }
+
+  void save(std::string &buf) const
+  {
+    size_t n = vars.size();
+    save_raw(buf, &n, 1);
+    if (n)
+      save_raw(buf, &vars[0], n);
+  }
+
+  void restore(const char *&buf)
+  {
+    size_t n;
+    restore_raw(buf, &n, 1);
+    vars.resize(n);
+    if (n)
+      restore_raw(buf, &vars[0], n);
+  }
+};
+
+// Registers of all variables of the function, in blocks that are shared by the
+// assignments copied from each other until one of them writes to the block.
+#define GLOBAL_BLOCK_SIZE 32
+
+class global_t
+{
+  struct block_t
+  {
+    unsigned int refs;
+    reg_t regs[GLOBAL_BLOCK_SIZE];
+  };
+
+  std::vector<block_t *> blocks;
+  size_t n;
+
+  void release(void)
+  {
+    for (size_t b = 0; b < blocks.size(); b++)
+      if (!--blocks[b]->refs)
+        delete blocks[b];
+    blocks.clear();
+  }
+
+  reg_t &write(size_t v)
+  {
+    block_t *&b = blocks[v / GLOBAL_BLOCK_SIZE];
+    if (b->refs > 1)
+      {
+        block_t *c = new block_t(*b);
+        c->refs = 1;
+        b->refs--;
+        b = c;
+      }
+    return(b->regs[v % GLOBAL_BLOCK_SIZE]);
+  }
+
+public:
+  global_t(void) : n(0)
+  {
+  }
+
+  global_t(const global_t &g) : blocks(g.blocks), n(g.n)
+  {
+    for (size_t b = 0; b < blocks.size(); b++)
+      blocks[b]->refs++;
+  }
+
+  ~global_t(void)
+  {
+    release();
+  }
+
+  global_t &operator=(const global_t &g)
+  {
+    global_t c(g);
+    swap(c);
+    return(*this);
+  }
+
+  void swap(global_t &g)
+  {
+    blocks.swap(g.blocks);
+    std::swap(n, g.n);
+  }
+
+  size_t size(void) const
+  {
+    return(n);
+  }
+
+  // Only used on empty ones: All the variables get r in a single block.
+  void resize(size_t size, reg_t r)
+  {
+    release();
+    n = size;
+    if (!n)
+      return;
+    block_t *b = new block_t;
+    b->refs = (n + GLOBAL_BLOCK_SIZE - 1) / GLOBAL_BLOCK_SIZE;
+    std::fill(b->regs, b->regs + GLOBAL_BLOCK_SIZE, r);
+    blocks.assign(b->refs, b);
+  }
+
+  reg_t operator[](size_t v) const
+  {
+    return(blocks[v / GLOBAL_BLOCK_SIZE]->regs[v % GLOBAL_BLOCK_SIZE]);
+  }
+
+  void set(size_t v, reg_t r)
+  {
+    if ((*this)[v] != r)
+      write(v) = r;
+  }
+
+  // Take the registers from g for the variables that have none here.
+  void merge(const global_t &g)
+  {
+    for (size_t b = 0; b < blocks.size(); b++)
+      {
+        if (blocks[b] == g.blocks[b])
+          continue;
+        for (size_t v = b * GLOBAL_BLOCK_SIZE; v < (b + 1) * GLOBAL_BLOCK_SIZE; v++)
+          if ((*this)[v] == -1 && g[v] != -1)
+            write(v) = g[v];
+      }
+  }
+
+  void save(std::string &buf) const
+  {
+    save_raw(buf, &n, 1);
+    for (size_t b = 0; b < blocks.size(); b++)
+      save_raw(buf, blocks[b]->regs, GLOBAL_BLOCK_SIZE);
+  }
+
+  void restore(const char *&buf)
+  {
+    release();
+    restore_raw(buf, &n, 1);
+    blocks.resize((n + GLOBAL_BLOCK_SIZE - 1) / GLOBAL_BLOCK_SIZE);
+    for (size_t b = 0; b < blocks.size(); b++)
+      {
+        blocks[b] = new block_t;
+        blocks[b]->refs = 1;
+        restore_raw(buf, blocks[b]->regs, GLOBAL_BLOCK_SIZE);
+      }
+  }
+};
+
+// Costs of the instructions in the bag, sorted by instruction.
+class icosts_t
+{
+  std::vector<std::pair<unsigned short int, float> > costs;
+
+  struct less_i
+  {
+    bool operator()(const std::pair<unsigned short int, float> &c, unsigned short int i) const
+    {
+      return(c.first < i);
+    }
+  };
+
+public:
+  // 0 for instructions that have no cost yet.
+  float operator[](unsigned short int i) const
+  {
+    std::vector<std::pair<unsigned short int, float> >::const_iterator c = std::lower_bound(costs.begin(), costs.end(), i, less_i());
+    return((c != costs.end() && c->first == i) ? c->second : 0.0f);
+  }
+
+  void set(unsigned short int i, float cost)
+  {
+    std::vector<std::pair<unsigned short int, float> >::iterator c = std::lower_bound(costs.begin(), costs.end(), i, less_i());
+    if (c != costs.end() && c->first == i)
+      c->second = cost;
+    else
+      costs.insert(c, std::pair<unsigned short int, float>(i, cost));
+  }
+
+  void erase(unsigned short int i)
+  {
+    std::vector<std::pair<unsigned short int, float> >::iterator c = std::lower_bound(costs.begin(), costs.end(), i, less_i());
+    if (c != costs.end() && c->first == i)
+      costs.erase(c);
+  }
+
+  void swap(icosts_t &c)
+  {
+    costs.swap(c.costs);
+  }
+
+  void save(std::string &buf) const
+  {
+    size_t n = costs.size();
+    save_raw(buf, &n, 1);
+    for (size_t c = 0; c < n; c++)
+      {
+        save_raw(buf, &costs[c].first, 1);
+        save_raw(buf, &costs[c].second, 1);
+      }
+  }
+
+  void restore(const char *&buf)
+  {
+    size_t n;
+    restore_raw(buf, &n, 1);
+    costs.resize(n);
+    for (size_t c = 0; c < n; c++)
+      {
+        restore_raw(buf, &costs[c].first, 1);
+        restore_raw(buf, &costs[c].second, 1);
+      }
+  }
+};
 
 struct assignment
 {
   float s;
 
   varset_t local;	// Entries: var
-  std::vector<reg_t> global;	// Entries: global[var] = reg (-1 if no reg assigned)
+  global_t global;	// Entries: global[var] = reg (-1 if no reg assigned)
   icosts_t i_costs;  // Costs for all instructions in bag (needed to avoid double counting costs at join nodes)
   i_assignment_t i_assignment; // Assignment at the instruction currently being added in an introduce node;
 
   bool marked;
 
+  assignment(void) : s(0.0f), marked(false)
+  {
+  }
+
+  void swap(assignment &a)
+  {
+    std::swap(s, a.s);
+    local.swap(a.local);
+    global.swap(a.global);
+    i_costs.swap(a.i_costs);
+    std::swap(i_assignment, a.i_assignment);
+    std::swap(marked, a.marked);
+  }
+
+  void save(std::string &buf) const
+  {
+    save_raw(buf, &s, 1);
+    local.save(buf);
+    global.save(buf);
+    i_costs.save(buf);
+    save_raw(buf, &i_assignment, 1);
+    save_raw(buf, &marked, 1);
+  }
+
+  void restore(const char *&buf)
+  {
+    restore_raw(buf, &s, 1);
+    local.restore(buf);
+    global.restore(buf);
+    i_costs.restore(buf);
+    restore_raw(buf, &i_assignment, 1);
+    restore_raw(buf, &marked, 1);
+  }
+
+  // Lexicographic in the (var, reg) pairs of the local assignment.
   bool operator<(const assignment& a) const
   {
     varset_t::const_iterator i, ai, i_end, ai_end;
@@ -164,10 +478,10 @@ struct assignment
 
     for (i = local.begin(), ai = a.local.begin();; ++i, ++ai)
       {
-        if (i == i_end)
-          return(true);
         if (ai == ai_end)
           return(false);
+        if (i == i_end)
+          return(true);
 
         if (*i < *ai)
           return(true);
@@ -182,8 +496,102 @@ struct assignment
   }
 };
 
-typedef std::list<assignment> assignment_list_t;
-//typedef std::vector<assignment> assignment_list_t; // Probably faster, but would require some code reorganization.
+typedef std::vector<assignment> assignment_list_t;
+
+// Order of the assignments by their position in an assignment_list_t.
+struct assignment_index_less
+{
+  const assignment_list_t &alist;
+
+  assignment_index_less(const assignment_list_t &l) : alist(l)
+  {
+  }
+
+  bool operator()(size_t a, size_t b) const
+  {
+    return(alist[a] < alist[b]);
+  }
+};
+
+// Sort the assignments, in place. Equal ones end up newest first, the order the
+// earlier std::list::sort() gave them, so that forget nodes keep the same ones.
+inline void sort_assignments(assignment_list_t &alist)
+{
+  const size_t n = alist.size();
+  std::vector<size_t> order(n);
+
+  for (size_t i = 0; i < n; i++)
+    order[i] = n - 1 - i;
+  std::stable_sort(order.begin(), order.end(), assignment_index_less(alist));
+
+  // alist[i] gets the assignment from alist[order[i]], one permutation cycle at a time.
+  for (size_t i = 0; i < n; i++)
+    {
+      if (order[i] == n)
+        continue;
+      for (size_t j = i, k;; j = k)
+        {
+          k = order[j];
+          order[j] = n;
+          if (k == i)
+            break;
+          alist[j].swap(alist[k]);
+        }
+    }
+}
+
+#ifndef _WIN32
+inline bool write_all(int fd, const char *buf, size_t len)
+{
+  while (len)
+    {
+      ssize_t n = write(fd, buf, len);
+      if (n < 0 && errno == EINTR)
+        continue;
+      if (n <= 0)
+        return(false);
+      buf += n;
+      len -= n;
+    }
+  return(true);
+}
+
+inline bool read_all(int fd, char *buf, size_t len)
+{
+  while (len)
+    {
+      ssize_t n = read(fd, buf, len);
+      if (n < 0 && errno == EINTR)
+        continue;
+      if (n <= 0)
+        return(false);
+      buf += n;
+      len -= n;
+    }
+  return(true);
+}
+
+// In a worker process that solves a subtree for a guessed ac (see tree_dec_ralloc_pool):
+// The ac to overwrite with the real one, and the pipe it comes through.
+static assignment *guessed_ac;
+static int guessed_ac_fd = -1;
+
+inline void receive_guessed_ac(void)
+{
+  size_t n;
+  std::string buf;
+
+  if (!read_all(guessed_ac_fd, reinterpret_cast<char *>(&n), sizeof(n)))
+    _exit(1);
+  buf.resize(n);
+  if (n && !read_all(guessed_ac_fd, &buf[0], n))
+    _exit(1);
+
+  const char *p = buf.data();
+  guessed_ac->restore(p);
+  guessed_ac = 0;
+}
+#endif
 
 struct tree_dec_node
 {
@@ -245,6 +653,36 @@ add_operand_to_cfg_node(cfg_node &n, operand *o, std::map<std::pair<int, reg_t>,
     }
 }
 
+// Check if the iCodes v is alive at (at[], in increasing order) are connected in the CFG, ignoring the direction of the edges.
+inline bool
+alive_connected(const cfg_t &cfg, var_t v, const std::vector<unsigned int> &at)
+{
+  if (at.size() <= 1)
+    return(true);
+
+  std::set<unsigned int> reached;
+  std::stack<unsigned int> todo;
+  reached.insert(at[0]);
+  todo.push(at[0]);
+  while (!todo.empty())
+    {
+      unsigned int j = todo.top();
+      todo.pop();
+
+      boost::graph_traits<cfg_t>::out_edge_iterator o, o_end;
+      for (boost::tie(o, o_end) = boost::out_edges(j, cfg); o != o_end; ++o)
+        if (cfg[boost::target(*o, cfg)].alive.find(v) != cfg[boost::target(*o, cfg)].alive.end() && reached.insert(boost::target(*o, cfg)).second)
+          todo.push(boost::target(*o, cfg));
+
+      boost::graph_traits<cfg_t>::in_edge_iterator n, n_end;
+      for (boost::tie(n, n_end) = boost::in_edges(j, cfg); n != n_end; ++n)
+        if (cfg[boost::source(*n, cfg)].alive.find(v) != cfg[boost::source(*n, cfg)].alive.end() && reached.insert(boost::source(*n, cfg)).second)
+          todo.push(boost::source(*n, cfg));
+    }
+
+  return(reached.size() == at.size());
+}
+
 // A quick-and-dirty function to get the CFG from sdcc.
 inline iCode *
 create_cfg(cfg_t &cfg, con_t &con, ebbIndex *ebbi)
@@ -282,37 +720,53 @@ create_cfg(cfg_t &cfg, con_t &con, ebbIndex *ebbi)
 
         cfg[i].ic = ic;
 
-        for (int j2 = 0; j2 <= operandKey; j2++)
+        for (int j2 = bitVectNextBit(ic->rlive, 0); j2 >= 0; j2 = bitVectNextBit(ic->rlive, j2 + 1))
           {
-            if (bitVectBitValue(ic->rlive, j2))
+            symbol *sym = (symbol *)(hTabItemWithKey(liveRanges, j2));
+
+            if (!sym->for_newralloc)
+              continue;
+
+            // Add node to conflict graph:
+            if (sym_to_index.find(std::pair<int, reg_t>(j2, 0)) != sym_to_index.end())
+              continue;
+
+            // Other parts of the allocator may rely on the variables corresponding to bytes from the same sdcc variable to have subsequent numbers.
+            for (reg_t k = 0; k < sym->nRegs; k++)
               {
-                symbol *sym = (symbol *)(hTabItemWithKey(liveRanges, j2));
-
-                if (!sym->for_newralloc)
-                  continue;
-
-                // Add node to conflict graph:
-                if (sym_to_index.find(std::pair<int, reg_t>(j2, 0)) != sym_to_index.end())
-                  continue;
-
-                // Other parts of the allocator may rely on the variables corresponding to bytes from the same sdcc variable to have subsequent numbers.
-                for (reg_t k = 0; k < sym->nRegs; k++)
-                  {
-                    boost::add_vertex(con);
-                    con[j].v = j2;
-                    con[j].byte = k;
-                    con[j].size = sym->nRegs;
-                    con[j].name = sym->name;
-                    sym_to_index[std::pair<int, reg_t>(j2, k)] = j;
-                    for (reg_t l = 0; l < k; l++)
-                      boost::add_edge(j - l - 1, j, con);
-                    j++;
-                  }
+                boost::add_vertex(con);
+                con[j].v = j2;
+                con[j].byte = k;
+                con[j].size = sym->nRegs;
+                con[j].name = sym->name;
+                sym_to_index[std::pair<int, reg_t>(j2, k)] = j;
+                for (reg_t l = 0; l < k; l++)
+                  boost::add_edge(j - l - 1, j, con);
+                j++;
               }
           }
       }
   }
 
+  // Get the iCodes the variables are alive at from their live intervals.
+  for (std::map<std::pair<int, reg_t>, var_t>::const_iterator si = sym_to_index.begin(); si != sym_to_index.end(); ++si)
+    {
+      if (si->first.second)
+        continue;
+
+      const symbol *sym = (symbol *)(hTabItemWithKey(liveRanges, si->first.first));
+      const lrIntervals *lri = sym->liveIntervals;
+      for (int l = 0; lri && l < lri->count; l++)
+        for (int seq = lri->iv[l].from; seq <= lri->iv[l].to; seq++)
+          {
+            std::map<int, unsigned int>::const_iterator ki = key_to_index.find(((iCode *)(hTabItemWithKey(iCodeSeqhTab, seq)))->key);
+            if (ki == key_to_index.end()) // Not in the chain anymore after iCodeLabelOptimize().
+              continue;
+            for (reg_t k = 0; k < sym->nRegs; k++)
+              cfg[ki->second].alive.insert(si->second + k);
+          }
+    }
+
   // Get control flow graph from sdcc.
   for (ic = start_ic; ic; ic = ic->next)
     {
@@ -329,19 +783,6 @@ create_cfg(cfg_t &cfg, con_t &con, ebbIndex *ebbi)
         for (symbol *lbl = (symbol *)(setFirstItem (IC_JTLABELS (ic))); lbl; lbl = (symbol *)(setNextItem (IC_JTLABELS (ic))))
           boost::add_edge(key_to_index[ic->key], key_to_index[eBBWithEntryLabel(ebbi, lbl)->sch->key], cfg);
 
-      for (int i = 0; i <= operandKey; i++)
-        {
-          if (sym_to_index.find(std::pair<int, reg_t>(i, 0)) == sym_to_index.end())
-            continue;
-
-          if (bitVectBitValue(ic->rlive, i))
-            {
-              symbol *isym = (symbol *)(hTabItemWithKey(liveRanges, i));
-              for (reg_t k = 0; k < isym->nRegs; k++)
-                cfg[key_to_index[ic->key]].alive.insert(sym_to_index[std::pair<int, int>(i, k)]);
-            }
-        }
-
       add_operand_to_cfg_node(cfg[key_to_index[ic->key]], IC_RESULT(ic), sym_to_index);
       add_operand_to_cfg_node(cfg[key_to_index[ic->key]], IC_LEFT(ic), sym_to_index);
       add_operand_to_cfg_node(cfg[key_to_index[ic->key]], IC_RIGHT(ic), sym_to_index);
@@ -368,22 +809,14 @@ create_cfg(cfg_t &cfg, con_t &con, ebbIndex *ebbi)
 
   // Check for unconnected live ranges, some might have survived dead code elimination.
   // This is essentially a workaround for broken dead code alimination.
-  // Todo: Improve efficiency, e.g. using subgraph or filtered_graph.
   // Todo: Split live ranges instead?
+  std::vector<std::vector<unsigned int> > alive_at(boost::num_vertices(con));
+  for (unsigned int j = 0; j < boost::num_vertices(cfg); j++)
+    for (std::set<var_t>::const_iterator v = cfg[j].alive.begin(); v != cfg[j].alive.end(); ++v)
+      alive_at[*v].push_back(j);
   for (var_t i = boost::num_vertices(con) - 1; i >= 0; i--)
     {
-      cfg_sym_t cfg2;
-      boost::copy_graph(cfg, cfg2);
-      for (int j = boost::num_vertices(cfg) - 1; j >= 0; j--)
-        {
-          if (cfg[j].alive.find(i) == cfg[j].alive.end())
-            {
-              boost::clear_vertex(j, cfg2);
-              boost::remove_vertex(j, cfg2);
-            }
-        }
-      std::vector<boost::graph_traits<cfg_t>::vertices_size_type> component(num_vertices(cfg2));
-      if (boost::connected_components(cfg2, &component[0]) > 1)
+      if (!alive_connected(cfg, i, alive_at[i]))
         {
 #ifdef DEBUG_RALLOC_DEC
           std::cerr << "Non-connected liverange found and extended to connected component of the CFG:" << con[i].name << "\n";
@@ -466,6 +899,192 @@ inline void alive_tree_dec(tree_dec_t &tree_dec, const cfg_t &cfg)
     }
 }
 
+// Opt-in cache of allocation results (--ralloc-cache <dir> in the z80 port):
+// The registers of the variables of a function are stored in a file named by a hash
+// of a canonical description of the function. The description names variables by their
+// index in the conflict graph and instructions by their index in the CFG, so it does not
+// depend on the keys sdcc gave them, or on the name of the function.
+
+// Describe operand o of a node n of the CFG. Temporaries that are not handled by the allocator are numbered in the order they are found.
+inline void ralloc_cache_operand(std::ostringstream &key, operand *o, const cfg_node &n, std::map<int, int> &temps)
+{
+  if (!o)
+    {
+      key << " -";
+      return;
+    }
+
+  switch (o->type)
+    {
+    case SYMBOL:
+      {
+        const symbol *sym = OP_SYMBOL_CONST(o);
+        operand_map_t::const_iterator oi = n.operands.find(sym->key);
+        if (oi != n.operands.end())
+          key << " v" << oi->second;
+        else if (IS_ITEMP(o))
+          {
+            if (temps.find(sym->key) == temps.end())
+              {
+                int t = temps.size();
+                temps[sym->key] = t;
+              }
+            key << " t" << temps[sym->key] << (sym->remat ? "r" : "") << (sym->isspilt ? "s" : "");
+          }
+        else
+          key << " s" << sym->name << (sym->onStack ? "@" : "") << sym->stack;
+        break;
+      }
+    case VALUE:
+      if (isOperandLiteral(o))
+        key << " l" << operandLitValue(o);
+      else
+        key << " a" << OP_VALUE(o)->name;
+      break;
+    default:
+      key << " y";
+      break;
+    }
+
+  struct dbuf_s type;
+  dbuf_init(&type, 64);
+  dbuf_printTypeChain(operandType(o), &type);
+  key << (o->isaddr ? "&" : ":") << dbuf_c_str(&type);
+  dbuf_destroy(&type);
+}
+
+// Canonical description of the function given by G and I, after the port-specific description in prefix.
+template <class G_t, class I_t>
+void ralloc_cache_key(std::string &key, const std::string &prefix, const G_t &G, const I_t &I)
+{
+  std::ostringstream k;
+  std::map<int, int> temps;
+
+  k.precision(17);
+  k << prefix << "\n";
+
+  for (unsigned int v = 0; v < boost::num_vertices(I); v++)
+    {
+      k << "v" << v << " " << I[v].byte << "/" << I[v].size << ":";
+      typename boost::graph_traits<I_t>::adjacency_iterator w, w_end;
+      for (boost::tie(w, w_end) = boost::adjacent_vertices(v, I); w != w_end; ++w)
+        k << " " << *w;
+      k << "\n";
+    }
+
+  for (unsigned int i = 0; i < boost::num_vertices(G); i++)
+    {
+      iCode *ic = G[i].ic;
+
+      k << "i" << i << " " << ic->op << (ic->parmPush ? "p" : "") << (ic->builtinSEND ? "b" : "") << (ic->generated ? "g" : "");
+      if (ic->op == IFX)
+        ralloc_cache_operand(k, IC_COND(ic), G[i], temps);
+      else if (ic->op == JUMPTABLE)
+        ralloc_cache_operand(k, IC_JTCOND(ic), G[i], temps);
+      else if (ic->op != LABEL && ic->op != GOTO && ic->op != INLINEASM)
+        {
+          ralloc_cache_operand(k, IC_LEFT(ic), G[i], temps);
+          ralloc_cache_operand(k, IC_RIGHT(ic), G[i], temps);
+          ralloc_cache_operand(k, IC_RESULT(ic), G[i], temps);
+        }
+
+      k << " ->";
+      typename boost::graph_traits<G_t>::adjacency_iterator j, j_end;
+      for (boost::tie(j, j_end) = boost::adjacent_vertices(i, G); j != j_end; ++j)
+        k << " " << *j;
+
+      std::set<var_t>::const_iterator v;
+      k << " alive";
+      for (v = G[i].alive.begin(); v != G[i].alive.end(); ++v)
+        k << " " << *v << (G[i].dying.find(*v) != G[i].dying.end() ? "d" : "");
+      k << "\n";
+    }
+
+  key = k.str();
+}
+
+// File for key in directory dir, named by the 64-bit FNV-1a hash of key.
+inline std::string ralloc_cache_file(const char *dir, const std::string &key)
+{
+  unsigned long long h = 14695981039346656037ull;
+  for (size_t c = 0; c < key.size(); c++)
+    {
+      h ^= (unsigned char)key[c];
+      h *= 1099511628211ull;
+    }
+
+  char name[32];
+  sprintf(name, "/%016llx.ra", h);
+  return(std::string(dir) + name);
+}
+
+#define RALLOC_CACHE_MAGIC "sdcc ralloc cache 1\n"
+
+// Read the registers of the n variables stored for key. Fails if there is no file, or it belongs to another key.
+// The registers still have to be checked by the port before they are used.
+inline bool ralloc_cache_load(const char *dir, const std::string &key, size_t n, std::vector<reg_t> &regs, bool &optimal)
+{
+  std::ifstream f(ralloc_cache_file(dir, key).c_str(), std::ios::in | std::ios::binary);
+  std::string magic(strlen(RALLOC_CACHE_MAGIC), '\0'), k;
+  size_t len, m;
+  char opt;
+
+  if (!f.read(&magic[0], magic.size()) || magic != RALLOC_CACHE_MAGIC)
+    return(false);
+  if (!f.read(reinterpret_cast<char *>(&len), sizeof(len)) || len != key.size())
+    return(false);
+  k.resize(len);
+  if ((len && !f.read(&k[0], len)) || k != key)
+    return(false);
+  if (!f.read(reinterpret_cast<char *>(&m), sizeof(m)) || m != n || !f.read(&opt, 1))
+    return(false);
+  regs.resize(n);
+  if (n && !f.read(reinterpret_cast<char *>(&regs[0]), n))
+    return(false);
+
+  optimal = opt;
+  return(true);
+}
+
+// Store the registers for key. The file is written under a temporary name and then renamed,
+// so that compilers running in parallel never see a partial one.
+inline void ralloc_cache_store(const char *dir, const std::string &key, const std::vector<reg_t> &regs, bool optimal)
+{
+  const std::string name = ralloc_cache_file(dir, key);
+  std::ostringstream tmp;
+#ifdef _WIN32
+  tmp << name << "." << _getpid();
+#else
+  tmp << name << "." << getpid();
+#endif
+
+  {
+    std::ofstream f(tmp.str().c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    size_t len = key.size(), n = regs.size();
+    char opt = optimal;
+
+    f.write(RALLOC_CACHE_MAGIC, strlen(RALLOC_CACHE_MAGIC));
+    f.write(reinterpret_cast<const char *>(&len), sizeof(len));
+    f.write(key.data(), len);
+    f.write(reinterpret_cast<const char *>(&n), sizeof(n));
+    f.write(&opt, 1);
+    if (n)
+      f.write(reinterpret_cast<const char *>(&regs[0]), n);
+    f.close();
+    if (!f)
+      {
+        remove(tmp.str().c_str());
+        return;
+      }
+  }
+
+#ifdef _WIN32
+  remove(name.c_str());
+#endif
+  if (rename(tmp.str().c_str(), name.c_str()))
+    remove(tmp.str().c_str());
+}
+
 #if defined(DEBUG_RALLOC_DEC) || defined (DEBUG_RALLOC_DEC_ASS)
 void print_assignment(const assignment &a)
 {
@@ -500,15 +1119,11 @@ void assignments_introduce_instruction(assignment_list_t &alist, unsigned short
 
   for (ai = alist.begin(), ai_end = alist.end(); ai != ai_end; ++ai)
     {
-      std::set<var_t> i_variables;
-
-      std::set_intersection(ai->local.begin(), ai->local.end(), G[i].alive.begin(), G[i].alive.end(), std::inserter(i_variables, i_variables.end()));
-
       i_assignment_t ia;
 
-      std::set<var_t>::const_iterator v, v_end;
-      for (v = i_variables.begin(), v_end = i_variables.end(); v != v_end; ++v)
-        if (ai->global[*v] >= 0)
+      varset_t::const_iterator v, v_end;
+      for (v = ai->local.begin(), v_end = ai->local.end(); v != v_end; ++v)
+        if (G[i].alive.find(*v) != G[i].alive.end() && ai->global[*v] >= 0)
           ia.add_var(*v, ai->global[*v]);
 
       ai->i_assignment = ia;
@@ -518,31 +1133,25 @@ void assignments_introduce_instruction(assignment_list_t &alist, unsigned short
 template <class G_t, class I_t>
 void assignments_introduce_variable(assignment_list_t &alist, unsigned short int i, short int v, const G_t &G, const I_t &I)
 {
-  assignment_list_t::iterator ai;
-  bool a_initialized;
-  assignment a;
   size_t c, c_end;
 
-  for (ai = alist.begin(), c = 0, c_end = alist.size(); c < c_end; c++, ai++)
+  // The new assignments are appended, each copied from its original.
+  for (c = 0, c_end = alist.size(); c < c_end; c++)
     {
-      a_initialized = false;
-
       for (reg_t r = 0; r < NUM_REGS; r++)
         {
-          if (!assignment_conflict(*ai, I, v, r))
+          if (!assignment_conflict(alist[c], I, v, r))
             {
-              if(!a_initialized)
-                {
-                  a = *ai;
-                  ai->marked = true;
-                  a.marked = false;
-                  a.local.insert(v);
-                }
-              a.global[v] = r;
+              alist[c].marked = true;
+              alist.push_back(assignment());
+              assignment &a = alist.back();
+              a = alist[c];
+              a.marked = false;
+              a.local.insert(v);
+              a.global.set(v, r);
               a.i_assignment.add_var(v, r);
-              if(!assignment_hopeless(a, i, G, I, v))
-                alist.push_back(a);
-              a.i_assignment.remove_var(v);
+              if(assignment_hopeless(a, i, G, I, v))
+                alist.pop_back();
             }
         }
     }
@@ -550,7 +1159,7 @@ void assignments_introduce_variable(assignment_list_t &alist, unsigned short int
 
 struct assignment_rep
 {
-  assignment_list_t::iterator i;
+  size_t i;
   float s;
 
   bool operator<(const assignment_rep& a) const
@@ -559,11 +1168,28 @@ struct assignment_rep
   }
 };
 
+// The neighbours in I of the variables ac has registers for, in the order of ac.local.
 template <class I_t>
-float compability_cost(const assignment& a, const assignment& ac, const I_t &I)
+void compability_neighbours(std::vector<std::vector<var_t> > &neighbours, const assignment& ac, const I_t &I)
 {
   typedef typename boost::graph_traits<I_t>::adjacency_iterator adjacency_iter_t;
-  
+
+  varset_t::const_iterator vi, vi_end;
+
+  neighbours.resize(ac.local.size());
+  for(vi = ac.local.begin(), vi_end = ac.local.end(); vi != vi_end; ++vi)
+    {
+      if(ac.global[*vi] == -1)
+        continue;
+
+      adjacency_iter_t j, j_end;
+      for (boost::tie(j, j_end) = adjacent_vertices(*vi, I); j != j_end; ++j)
+        neighbours[vi - ac.local.begin()].push_back(*j);
+    }
+}
+
+inline float compability_cost(const assignment& a, const assignment& ac, const std::vector<std::vector<var_t> > &neighbours)
+{
   float c = 0.0f;
   
   varset_t::const_iterator vi, vi_end;
@@ -577,9 +1203,9 @@ float compability_cost(const assignment& a, const assignment& ac, const I_t &I)
         continue;
       }
         
-      adjacency_iter_t j, j_end;
-      for (boost::tie(j, j_end) = adjacent_vertices(v, I); j != j_end; ++j)
-        if(ac.global[v] != -1 && a.global[*j] == ac.global[v])
+      const std::vector<var_t> &n = neighbours[vi - ac.local.begin()];
+      for (std::vector<var_t>::const_iterator j = n.begin(); j != n.end(); ++j)
+        if(a.global[*j] == ac.global[v])
         {
           c += 1000.0f;
           break;
@@ -594,34 +1220,53 @@ float compability_cost(const assignment& a, const assignment& ac, const I_t &I)
 template <class G_t, class I_t>
 void drop_worst_assignments(assignment_list_t &alist, unsigned short int i, const G_t &G, const I_t &I, const assignment& ac)
 {
-  unsigned int n;
+  size_t n, k;
   size_t alist_size;
-  assignment_list_t::iterator ai, an;
 
   if ((alist_size = alist.size()) * NUM_REGS <= static_cast<size_t>(options.max_allocs_per_node) || alist_size <= 1)
     return;
 
   assignment_optimal = false;
 
+#ifndef _WIN32
+  // Which ones are dropped depends on ac, so a worker that guessed it needs the real one now.
+  if (guessed_ac)
+    receive_guessed_ac();
+#endif
+
 #ifdef DEBUG_RALLOC_DEC
   std::cout << "Too many assignments here (" << i << "):" << alist_size << " > " << options.max_allocs_per_node / NUM_REGS << ". Dropping some.\n"; std::cout.flush();
 #endif
 
   assignment_rep *arep = new assignment_rep[alist_size];
 
-  for (n = 0, ai = alist.begin(); n < alist_size; ++ai, n++)
+  std::vector<std::vector<var_t> > neighbours;
+  compability_neighbours(neighbours, ac, I);
+
+  for (n = 0; n < alist_size; n++)
     {
-      arep[n].i = ai;
-      arep[n].s = ai->s + rough_cost_estimate(*ai, i, G, I) + compability_cost(*ai, ac, I);
+      arep[n].i = n;
+      arep[n].s = alist[n].s + rough_cost_estimate(alist[n], i, G, I) + compability_cost(alist[n], ac, neighbours);
     }
 
   std::nth_element(arep + 1, arep + options.max_allocs_per_node / NUM_REGS, arep + alist_size);
 
   //std::cout << "nth elem. est. cost: " << arep[options.max_allocs_per_node / NUM_REGS].s << "\n"; std::cout.flush();
 
+  std::vector<bool> dropped(alist_size, false);
   for (n = options.max_allocs_per_node / NUM_REGS + 1; n < alist_size; n++)
-    alist.erase(arep[n].i);
-    
+    dropped[arep[n].i] = true;
+
+  // Keep the others in their order.
+  for (n = k = 0; n < alist_size; n++)
+    if (!dropped[n])
+      {
+        if (k != n)
+          alist[k].swap(alist[n]);
+        k++;
+      }
+  alist.erase(alist.begin() + k, alist.end());
+
   delete[] arep;
 }
 
@@ -633,12 +1278,10 @@ void tree_dec_ralloc_leaf(T_t &T, typename boost::graph_traits<T_t>::vertex_desc
   std::cout << "Leaf (" << t << "):\n"; std::cout.flush();
 #endif
 
-  assignment a;
   assignment_list_t &alist = T[t].assignments;
 
-  a.s = 0;
-  a.global.resize(boost::num_vertices(I), -1);
-  alist.push_back(a);
+  alist.push_back(assignment());
+  alist.back().global.resize(boost::num_vertices(I), -1);
   
 #ifdef DEBUG_RALLOC_DEC_ASS
   assignment_list_t::iterator ai;
@@ -656,7 +1299,6 @@ void tree_dec_ralloc_introduce(T_t &T, typename boost::graph_traits<T_t>::vertex
 {
   typedef typename boost::graph_traits<T_t>::adjacency_iterator adjacency_iter_t;
   adjacency_iter_t c, c_end;
-  assignment_list_t::iterator ai;
   boost::tie(c, c_end) = adjacent_vertices(t, T);
 
 #ifdef DEBUG_RALLOC_DEC
@@ -686,18 +1328,21 @@ void tree_dec_ralloc_introduce(T_t &T, typename boost::graph_traits<T_t>::vertex
     }
 
   // Summation of costs and early removal of assignments.
-  for (ai = alist.begin(); ai != alist.end();)
+  size_t n, k;
+  for (n = k = 0; n < alist.size(); n++)
     {
-      if ((ai->s += (ai->i_costs[i] = instruction_cost(*ai, i, G, I))) == std::numeric_limits<float>::infinity())
-        ai = alist.erase(ai);
-      else
-        ++ai;
+      float ic = instruction_cost(alist[n], i, G, I);
+      alist[n].i_costs.set(i, ic);
+      if ((alist[n].s += ic) == std::numeric_limits<float>::infinity())
+        continue;
+      if (k != n)
+        alist[k].swap(alist[n]);
+      k++;
     }
-
-  // Free memory in the std::set<var_t, boost::pool_allocator<var_t> > that live in the assignments in the list.
-  //boost::singleton_pool<boost::fast_pool_allocator_tag, sizeof(var_t)>::release_memory();
+  alist.erase(alist.begin() + k, alist.end());
 
 #ifdef DEBUG_RALLOC_DEC_ASS
+  assignment_list_t::iterator ai;
   for(ai = alist.begin(); ai != alist.end(); ++ai)
   	print_assignment(*ai);
   assignment best;
@@ -742,12 +1387,11 @@ void tree_dec_ralloc_forget(T_t &T, typename boost::graph_traits<T_t>::vertex_de
   std::set<var_t> old_vars;
   std::set_difference(T[*c].alive.begin(), T[*c].alive.end(), T[t].alive.begin(), T[t].alive.end(), std::inserter(old_vars, old_vars.end()));
 
-  assignment_list_t::iterator ai, aif;
+  assignment_list_t::iterator ai;
 
   // Restrict assignments (locally) to current variables.
   for (ai = alist.begin(); ai != alist.end(); ++ai)
     {
-      // Erasing by iterators doesn't work with B-Trees, and erasing by value invalidates iterators.
       std::set<var_t>::const_iterator oi, oi_end;
       for (oi = old_vars.begin(), oi_end = old_vars.end(); oi != oi_end; ++oi)
         ai->local.erase(*oi);
@@ -755,33 +1399,22 @@ void tree_dec_ralloc_forget(T_t &T, typename boost::graph_traits<T_t>::vertex_de
       ai->i_costs.erase(i);
     }
 
-  alist.sort();
-  //std::sort(alist.begin(), alist.end());
+  sort_assignments(alist);
 
-  // Collapse (locally) identical assignments.
-  for (ai = alist.begin(); ai != alist.end();)
+  // Collapse (locally) identical assignments, keeping the first cheapest one.
+  size_t n, nf, k;
+  for (n = k = 0; n < alist.size(); k++)
     {
-      aif = ai;
+      nf = n;
 
-      for (++ai; ai != alist.end() && assignments_locally_same(*aif, *ai);)
-        {
-          if (aif->s > ai->s)
-            {
-              alist.erase(aif);
-              aif = ai;
-              ++ai;
-            }
-          else
-            {
-              alist.erase(ai);
-              ai = aif;
-              ++ai;
-            }
-        }
-    }
+      for (++n; n < alist.size() && assignments_locally_same(alist[nf], alist[n]); n++)
+        if (alist[nf].s > alist[n].s)
+          nf = n;
 
-  // Free memory in the std::set<var_t, boost::pool_allocator<var_t> > that live in the assignments in the list.
-  //boost::singleton_pool<boost::fast_pool_allocator_tag, sizeof(var_t)>::release_memory();
+      if (k != nf)
+        alist[k].swap(alist[nf]);
+    }
+  alist.erase(alist.begin() + k, alist.end());
 
 #ifdef DEBUG_RALLOC_DEC
   std::cout << "Remaining assignments: " << alist.size() << "\n"; std::cout.flush();
@@ -818,10 +1451,8 @@ void tree_dec_ralloc_join(T_t &T, typename boost::graph_traits<T_t>::vertex_desc
   assignment_list_t &alist2 = T[*c2].assignments;
   assignment_list_t &alist3 = T[*c3].assignments;
 
-  alist2.sort();
-  //std::sort(alist2.begin(), alist2.end());
-  alist3.sort();
-  //std::sort(alist3.begin(), alist3.end());
+  sort_assignments(alist2);
+  sort_assignments(alist3);
 
   assignment_list_t::iterator ai2, ai3;
   for (ai2 = alist2.begin(), ai3 = alist3.begin(); ai2 != alist2.end() && ai3 != alist3.end();)
@@ -833,9 +1464,9 @@ void tree_dec_ralloc_join(T_t &T, typename boost::graph_traits<T_t>::vertex_desc
           std::set<unsigned int>::iterator bi;
           for (bi = T[t].bag.begin(); bi != T[t].bag.end(); ++bi)
             ai2->s -= ai2->i_costs[*bi];
-          for (size_t i = 0; i < ai2->global.size(); i++)
-            ai2->global[i] = ((ai2->global[i] != -1) ? ai2->global[i] : ai3->global[i]);
-          alist1.push_back(*ai2);
+          ai2->global.merge(ai3->global);
+          alist1.push_back(assignment());
+          alist1.back().swap(*ai2);
           ++ai2;
           ++ai3;
         }
@@ -859,7 +1490,7 @@ void tree_dec_ralloc_join(T_t &T, typename boost::graph_traits<T_t>::vertex_desc
 #endif
 
 #ifdef DEBUG_RALLOC_DEC_ASS
-  std::list<assignment>::iterator ai;
+  assignment_list_t::iterator ai;
   for(ai = alist1.begin(); ai != alist1.end(); ++ai)
   	print_assignment(*ai);
   std::cout << "\n";
@@ -882,9 +1513,13 @@ void get_best_local_assignment(assignment &a, typename boost::graph_traits<T_t>:
 template <class T_t>
 void get_best_local_assignment_biased(assignment &a, typename boost::graph_traits<T_t>::vertex_descriptor t, const T_t &T);
 
+template <class T_t, class G_t, class I_t>
+class tree_dec_ralloc_pool;
+
 // Handle nodes in the tree decomposition, by detecting their type and calling the appropriate function. Recurses.
+// Subtrees that are in the pool have been handed to worker processes.
 template <class T_t, class G_t, class I_t>
-void tree_dec_ralloc_nodes(T_t &T, typename boost::graph_traits<T_t>::vertex_descriptor t, const G_t &G, const I_t &I, const assignment& ac)
+void tree_dec_ralloc_nodes(T_t &T, typename boost::graph_traits<T_t>::vertex_descriptor t, const G_t &G, const I_t &I, const assignment& ac, tree_dec_ralloc_pool<T_t, G_t, I_t> *pool = 0)
 {
   typedef typename boost::graph_traits<T_t>::adjacency_iterator adjacency_iter_t;
 
@@ -892,6 +1527,11 @@ void tree_dec_ralloc_nodes(T_t &T, typename boost::graph_traits<T_t>::vertex_des
   typename boost::graph_traits<T_t>::vertex_descriptor c0, c1;
   assignment ac2;
 
+#ifndef _WIN32
+  if (pool && pool->take(t, ac))
+    return;
+#endif
+
   boost::tie(c, c_end) = adjacent_vertices(t, T);
 
   switch (out_degree(t, T))
@@ -901,15 +1541,15 @@ void tree_dec_ralloc_nodes(T_t &T, typename boost::graph_traits<T_t>::vertex_des
       break;
     case 1:
       c0 = *c;
-      tree_dec_ralloc_nodes(T, c0, G, I, ac);
+      tree_dec_ralloc_nodes(T, c0, G, I, ac, pool);
       T[c0].bag.size() < T[t].bag.size() ? tree_dec_ralloc_introduce(T, t, G, I, ac) : tree_dec_ralloc_forget(T, t, G, I);
       break;
     case 2:
       c0 = *c++;
       c1 = *c;
-      tree_dec_ralloc_nodes(T, c0, G, I, ac);
+      tree_dec_ralloc_nodes(T, c0, G, I, ac, pool);
       get_best_local_assignment_biased(ac2, c0, T);
-      tree_dec_ralloc_nodes(T, c1, G, I, ac2);
+      tree_dec_ralloc_nodes(T, c1, G, I, ac2, pool);
       tree_dec_ralloc_join(T, t, G, I);
       break;
     default:
@@ -918,6 +1558,394 @@ void tree_dec_ralloc_nodes(T_t &T, typename boost::graph_traits<T_t>::vertex_des
     }
 }
 
+#ifndef _WIN32
+// Subtrees smaller than this are not worth a process.
+#define RALLOC_TASK_MIN_NODES 128
+
+// Worker processes for tree_dec_ralloc_nodes(), at most jobs at a time. Each one
+// solves a subtree below a join node. The result is the same as without them:
+// The ac of a subtree only matters once drop_worst_assignments() drops assignments.
+// It is known in advance for the subtrees reached through first children only.
+// The workers of the others start without it, and wait for it at their first drop;
+// it is sent once the subtree of the first child has been solved. It is written
+// while the results are read, a worker may be writing its result instead of reading it.
+template <class T_t, class G_t, class I_t>
+class tree_dec_ralloc_pool
+{
+  typedef typename boost::graph_traits<T_t>::vertex_descriptor vertex_t;
+  typedef typename boost::graph_traits<T_t>::adjacency_iterator adjacency_iter_t;
+
+  struct task
+  {
+    vertex_t t;
+    assignment ac;
+    bool guessed;
+    pid_t pid;
+    int fd;                     // Result from the worker.
+    int ac_fd;                  // ac to the worker, if guessed.
+    std::string pending;        // Part of the ac not written to ac_fd yet.
+    bool finished;
+    std::string result;
+  };
+
+  T_t &T;
+  const G_t &G;
+  const I_t &I;
+  unsigned int jobs;
+  std::vector<task> tasks;
+  std::deque<size_t> queue;     // Not started yet, in the order they are needed.
+  std::vector<size_t> running;
+  std::map<vertex_t, size_t> task_at;
+  std::vector<size_t> sizes;    // Nodes in the subtree.
+  void (*old_sigpipe)(int);
+
+  size_t count_nodes(vertex_t t)
+  {
+    adjacency_iter_t c, c_end;
+    size_t s = 1;
+
+    for (boost::tie(c, c_end) = adjacent_vertices(t, T); c != c_end; ++c)
+      s += count_nodes(*c);
+
+    return(sizes[t] = s);
+  }
+
+  // The topmost join node in the subtree with two subtrees worth a process,
+  // passing by the smaller subtrees of the joins above it. The ac at j is only
+  // known if the path to it goes through first children only.
+  bool find_join(vertex_t t, vertex_t &j, bool &guessed) const
+  {
+    adjacency_iter_t c;
+
+    for (j = t; sizes[j] >= 2 * RALLOC_TASK_MIN_NODES;)
+      {
+        c = adjacent_vertices(j, T).first;
+        if (out_degree(j, T) == 1)
+          j = *c;
+        else if (out_degree(j, T) != 2)
+          break;
+        else if (sizes[*c] >= RALLOC_TASK_MIN_NODES && sizes[*(c + 1)] >= RALLOC_TASK_MIN_NODES)
+          return(true);
+        else if (sizes[*c] >= sizes[*(c + 1)])
+          j = *c;
+        else
+          {
+            j = *(c + 1);
+            guessed = true;
+          }
+      }
+
+    return(false);
+  }
+
+  void work(task &k, int fd)
+  {
+    std::string buf;
+
+    for (size_t r = 0; r < running.size(); r++)
+      {
+        close(tasks[running[r]].fd);
+        if (tasks[running[r]].ac_fd >= 0)
+          close(tasks[running[r]].ac_fd);
+      }
+
+    guessed_ac = k.guessed ? &k.ac : 0;
+    guessed_ac_fd = k.ac_fd;
+    assignment_optimal = true;
+    tree_dec_ralloc_nodes(T, k.t, G, I, k.ac);
+    if (guessed_ac_fd >= 0)
+      close(guessed_ac_fd);
+
+    const assignment_list_t &alist = T[k.t].assignments;
+    size_t n = alist.size();
+    save_raw(buf, &assignment_optimal, 1);
+    save_raw(buf, &n, 1);
+    for (size_t i = 0; i < n; i++)
+      alist[i].save(buf);
+
+    bool ok = write_all(fd, buf.data(), buf.size());
+    std::cout.flush();
+    _exit(ok ? 0 : 1);
+  }
+
+  bool launch(size_t i)
+  {
+    task &k = tasks[i];
+    int p[2], q[2] = {-1, -1};
+
+    std::cout.flush();
+    fflush(stdout);
+    fflush(stderr);
+
+    if (pipe(p) < 0)
+      return(false);
+    if ((k.guessed && pipe(q) < 0) || (k.pid = fork()) < 0)
+      {
+        close(p[0]);
+        close(p[1]);
+        if (q[0] >= 0)
+          {
+            close(q[0]);
+            close(q[1]);
+          }
+        return(false);
+      }
+    if (!k.pid)
+      {
+        close(p[0]);
+        if (k.guessed)
+          close(q[1]);
+        k.ac_fd = q[0];
+        work(k, p[1]);
+      }
+    close(p[1]);
+    if (k.guessed)
+      {
+        close(q[0]);
+        fcntl(q[1], F_SETFL, O_NONBLOCK);
+      }
+    k.fd = p[0];
+    k.ac_fd = q[1];
+    running.push_back(i);
+    return(true);
+  }
+
+  void start(void)
+  {
+    while (running.size() < jobs && !queue.empty() && launch(queue.front()))
+      queue.pop_front();
+
+    // Without processes, everything left is solved here.
+    if (running.empty() && !queue.empty())
+      {
+        jobs = 0;
+        for (; !queue.empty(); queue.pop_front())
+          tasks[queue.front()].finished = true;
+      }
+  }
+
+  void finish(size_t r)
+  {
+    task &k = tasks[running[r]];
+    int status;
+
+    close(k.fd);
+    if (k.ac_fd >= 0)
+      close(k.ac_fd);
+    k.ac_fd = -1;
+    k.pending.clear();
+    if (waitpid(k.pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status))
+      k.result.clear();
+    k.finished = true;
+    running.erase(running.begin() + r);
+  }
+
+  void wait(size_t k)
+  {
+    std::vector<struct pollfd> fds;
+    char buf[65536];
+
+    // Workers waiting for their ac could keep k from starting.
+    std::deque<size_t>::iterator q = std::find(queue.begin(), queue.end(), k);
+    if (q != queue.end() && running.size() >= jobs)
+      {
+        queue.erase(q);
+        if (!launch(k))
+          tasks[k].finished = true;
+      }
+
+    for (start(); !tasks[k].finished; start())
+      {
+        std::vector<size_t> sending;
+
+        fds.resize(running.size());
+        for (size_t r = 0; r < running.size(); r++)
+          {
+            fds[r].fd = tasks[running[r]].fd;
+            fds[r].events = POLLIN;
+            fds[r].revents = 0;
+            if (!tasks[running[r]].pending.empty())
+              sending.push_back(running[r]);
+          }
+        for (size_t s = 0; s < sending.size(); s++)
+          {
+            struct pollfd f;
+            f.fd = tasks[sending[s]].ac_fd;
+            f.events = POLLOUT;
+            f.revents = 0;
+            fds.push_back(f);
+          }
+
+        if (poll(&fds[0], fds.size(), -1) < 0)
+          continue;
+
+        for (size_t s = 0; s < sending.size(); s++)
+          {
+            task &w = tasks[sending[s]];
+            if (!fds[running.size() + s].revents)
+              continue;
+            ssize_t n = write(w.ac_fd, w.pending.data(), w.pending.size());
+            if (n > 0)
+              w.pending.erase(0, n);
+            else if (n < 0 && errno != EINTR && errno != EAGAIN)
+              w.pending.clear();        // The worker is gone, it did not need the ac.
+          }
+
+        for (size_t r = running.size(); r--;)
+          {
+            if (!fds[r].revents)
+              continue;
+            ssize_t n = read(fds[r].fd, buf, sizeof(buf));
+            if (n > 0)
+              tasks[running[r]].result.append(buf, n);
+            else if (n == 0 || errno != EINTR)
+              finish(r);
+          }
+      }
+  }
+
+public:
+  tree_dec_ralloc_pool(T_t &T_, vertex_t root, const G_t &G_, const I_t &I_, unsigned int jobs_) : T(T_), G(G_), I(I_), jobs(jobs_), sizes(boost::num_vertices(T_))
+  {
+    count_nodes(root);
+
+    // A worker that did not need its ac may be gone when it is sent.
+    old_sigpipe = signal(SIGPIPE, SIG_IGN);
+  }
+
+  ~tree_dec_ralloc_pool(void)
+  {
+    while (!running.empty())
+      finish(running.size() - 1);
+
+    signal(SIGPIPE, old_sigpipe);
+  }
+
+  // Hand the larger subtrees below t to workers, the subtree of the first child of a join node
+  // with the ac of t, the one of the second child with a guessed one.
+  void split(vertex_t t, const assignment &ac)
+  {
+    std::vector<std::pair<vertex_t, bool> > parts(1, std::make_pair(t, false));
+    vertex_t j;
+    bool guessed;
+
+    if (!jobs)
+      return;
+
+    // Split the largest part at its topmost join node.
+    while (parts.size() < 2 * jobs)
+      {
+        size_t best = parts.size();
+        for (size_t k = 0; k < parts.size(); k++)
+          if ((best == parts.size() || sizes[parts[k].first] > sizes[parts[best].first]) && find_join(parts[k].first, j, guessed = parts[k].second))
+            best = k;
+        if (best == parts.size())
+          break;
+
+        find_join(parts[best].first, j, guessed = parts[best].second);
+        adjacency_iter_t c = adjacent_vertices(j, T).first;
+        parts[best].first = *c++;
+        parts[best].second = guessed;
+        parts.insert(parts.begin() + best + 1, std::make_pair(*c, true));
+      }
+
+    if (parts.size() < 2)
+      return;
+
+    std::deque<size_t> added;
+    for (size_t k = 0; k < parts.size(); k++)
+      {
+        if (sizes[parts[k].first] < RALLOC_TASK_MIN_NODES)
+          continue;
+        task_at[parts[k].first] = tasks.size();
+        added.push_back(tasks.size());
+        tasks.push_back(task());
+        tasks.back().t = parts[k].first;
+        tasks.back().guessed = parts[k].second;
+        if (!parts[k].second)
+          tasks.back().ac = ac;
+        tasks.back().fd = tasks.back().ac_fd = -1;
+        tasks.back().finished = false;
+      }
+    queue.insert(queue.begin(), added.begin(), added.end());
+    start();
+  }
+
+  // Take the assignments at t from its worker, sending it ac first if it guessed.
+  // False if t is to be solved here.
+  bool take(vertex_t t, const assignment &ac)
+  {
+    typename std::map<vertex_t, size_t>::iterator i = task_at.find(t);
+
+    if (i == task_at.end())
+      return(false);
+
+    size_t k = i->second;
+    task_at.erase(i);
+
+    if (tasks[k].guessed)
+      {
+        std::string buf;
+        size_t n;
+
+        ac.save(buf);
+        n = buf.size();
+        buf.insert(0, reinterpret_cast<const char *>(&n), sizeof(n));
+        tasks[k].ac = ac;
+        // A queued one gets it at the start, a running one while waiting for it.
+        if (tasks[k].ac_fd >= 0)
+          tasks[k].pending.swap(buf);
+        else
+          tasks[k].guessed = false;
+      }
+    wait(k);
+
+    std::string result;
+    result.swap(tasks[k].result);
+    tasks[k].ac = assignment();
+
+    // The worker failed: Solve it here.
+    if (result.empty())
+      {
+        split(t, ac);
+        return(false);
+      }
+
+    const char *p = result.data();
+    bool optimal;
+    size_t n;
+    restore_raw(p, &optimal, 1);
+    restore_raw(p, &n, 1);
+
+    assignment_list_t &alist = T[t].assignments;
+    alist.resize(n);
+    for (size_t a = 0; a < n; a++)
+      alist[a].restore(p);
+
+    assignment_optimal = assignment_optimal && optimal;
+
+    return(true);
+  }
+};
+#endif
+
+// tree_dec_ralloc_nodes(), with up to jobs worker processes.
+template <class T_t, class G_t, class I_t>
+void tree_dec_ralloc_nodes_parallel(T_t &T, typename boost::graph_traits<T_t>::vertex_descriptor t, const G_t &G, const I_t &I, const assignment& ac, int jobs)
+{
+#ifndef _WIN32
+  if (jobs > 1)
+    {
+      tree_dec_ralloc_pool<T_t, G_t, I_t> pool(T, t, G, I, jobs);
+      pool.split(t, ac);
+      tree_dec_ralloc_nodes(T, t, G, I, ac, &pool);
+      return;
+    }
+#endif
+
+  tree_dec_ralloc_nodes(T, t, G, I, ac);
+}
+
 // Find the best root selecting from t_old and the leafs under t.
 template <class T_t>
 std::pair<typename boost::graph_traits<T_t>::vertex_descriptor, size_t> find_best_root(const T_t &T, typename boost::graph_traits<T_t>::vertex_descriptor t, size_t t_s, typename boost::graph_traits<T_t>::vertex_descriptor t_old, size_t t_old_s)
@@ -364,6 +364,7 @@ typedef struct symbol
   struct bitVect *regsUsed;         /* for functions registers used */
   int liveFrom;                     /* live from iCode sequence number */
   int liveTo;                       /* live to sequence number */
+  struct lrIntervals *liveIntervals; /* where it is live, in between */
   int used;                         /* no. of times this was used */
   int recvSize;                     /* size of first argument  */
   struct bitVect *clashes;          /* overlaps with what other symbols */
@@ -33,9 +33,12 @@
 #include <fcntl.h>
 #else
 #include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
 #endif
 #include <string.h>
 #include <ctype.h>
+#include <errno.h>
 #include "SDCCglobl.h"
 #include "SDCCutil.h"
 #include "dbuf_string.h"
@@ -379,11 +382,144 @@ sdcc_pclose (FILE *fp)
   return _pclose (fp);
 }
 #else
-#define sdcc_popen_read(cmd)  popen ((cmd), "r")
+static pid_t childPid = -1;
+
+/*!
+ * split a command line into an argv vector the way /bin/sh would,
+ * return NULL if the command line needs a real shell
+ */
+static char **
+split_argv (const char *cmd)
+{
+  const char *p = cmd;
+  char **argv;
+  int argc = 0;
+  int maxArgs = 1;
+
+  /* anything beyond plain words and quotes is left to the shell */
+  if (strpbrk (cmd, "$`|&;<>()*?[]{}~#\\\n"))
+    return NULL;
+
+  for (p = cmd; *p; p++)
+    if (isspace ((unsigned char)*p))
+      maxArgs++;
+  argv = Safe_calloc (maxArgs + 1, sizeof (char *));
+
+  p = cmd;
+  for (;;)
+    {
+      struct dbuf_s arg;
+
+      while (isspace ((unsigned char)*p))
+        p++;
+      if (*p == '\0')
+        break;
+
+      dbuf_init (&arg, 128);
+      while (*p != '\0' && !isspace ((unsigned char)*p))
+        {
+          if (*p == '"' || *p == '\'')
+            {
+              char delim = *p++;
+              const char *start = p;
+
+              while (*p != '\0' && *p != delim)
+                p++;
+              if (*p == '\0')
+                {
+                  /* unbalanced quote: let the shell complain */
+                  dbuf_destroy (&arg);
+                  while (argc--)
+                    Safe_free (argv[argc]);
+                  Safe_free (argv);
+                  return NULL;
+                }
+              dbuf_append (&arg, start, p - start);
+              p++;
+            }
+          else
+            dbuf_append (&arg, p++, 1);
+        }
+      argv[argc++] = dbuf_detach_c_str (&arg);
+    }
+  argv[argc] = NULL;
+  return argv;
+}
+
+/*
+ * run the command directly instead of through popen(): this spares
+ * the /bin/sh process popen() starts for every compilation
+ */
+static FILE *
+sdcc_popen_read (const char *cmd)
+{
+  int fds[2];
+  char **argv;
+  int argc;
+  pid_t pid;
+
+  assert (childPid == -1);
+
+  if (NULL == (argv = split_argv (cmd)))
+    return popen (cmd, "r");
+
+  if (pipe (fds) != 0)
+    {
+      pid = -1;
+    }
+  else
+    {
+      fflush (stdout);
+      pid = fork ();
+      if (pid == 0)
+        {
+          /* child: stdout goes into the pipe */
+          close (fds[0]);
+          if (fds[1] != STDOUT_FILENO)
+            {
+              dup2 (fds[1], STDOUT_FILENO);
+              close (fds[1]);
+            }
+          execvp (argv[0], argv);
+          perror (argv[0]);
+          _exit (127);
+        }
+      close (fds[1]);
+      if (pid < 0)
+        close (fds[0]);
+    }
+
+  for (argc = 0; argv[argc]; argc++)
+    Safe_free (argv[argc]);
+  Safe_free (argv);
+
+  if (pid < 0)
+    return NULL;
+
+  childPid = pid;
+  return fdopen (fds[0], "r");
+}
+
 int
 sdcc_pclose (FILE *fp)
 {
-  return pclose (fp);
+  int status;
+
+  if (childPid == -1)
+    return pclose (fp);
+
+  fclose (fp);
+  while (waitpid (childPid, &status, 0) < 0)
+    {
+      if (errno != EINTR)
+        {
+          status = -1;
+          break;
+        }
+    }
+  childPid = -1;
+
+  return status;
 }
 #endif
 
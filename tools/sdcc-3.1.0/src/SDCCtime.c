@@ -0,0 +1,625 @@
+/*-------------------------------------------------------------------------
+  SDCCtime.c - compile time profiling of the compiler passes
+
+   Pass timers and counters are summed up for the translation unit and
+   for every function. With --time-passes they are printed as a table,
+   with --time-trace <file> every timed interval is written out as a
+   Chrome trace-event JSON file (chrome://tracing, Perfetto).
+
+   This program is free software; you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by the
+   Free Software Foundation; either version 2, or (at your option) any
+   later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+   In other words, you are welcome to use, share and improve this program.
+   You are forbidden to forbid anyone else to use, share and improve
+   what you give them.   Help stamp out software-hoarding!
+-------------------------------------------------------------------------*/
+
+#ifdef _WIN32
+#include <time.h>
+#else
+#include <sys/time.h>
+#endif
+#include "common.h"
+
+#define MAX_NESTING 32
+
+static const char *passNames[TIME_NPASSES] = {
+  "parse",
+  "ast",
+  "icode",
+  "optimize",
+  "cse",
+  "dataflow",
+  "deadcode",
+  "loop",
+  "liverange",
+  "ralloc+gen",
+  "peephole",
+  "glue",
+  "assemble",
+};
+
+static const char *counterNames[TIME_NCOUNTERS] = {
+  "iCodes created",
+  "CSE blocks",
+  "dataflow iterations",
+  "peephole rules fired",
+  "tree-dec width (max)",
+};
+
+/* counters that keep a maximum instead of a sum */
+#define IS_MAX_COUNTER(c) ((c) == TIME_CNT_TREE_WIDTH)
+
+/* a timed interval, kept for the trace output */
+typedef struct traceEvent
+  {
+    const char *name;
+    int isFunction;             /* a function, else a pass */
+    int tid;                    /* 1, or the worker process + 1 */
+    double ts;                  /* start [us] */
+    double dur;                 /* duration [us] */
+    long counters[TIME_NCOUNTERS];      /* only for functions */
+  }
+traceEvent;
+
+/* the totals of one function */
+typedef struct funcTime
+  {
+    char *name;
+    double start;               /* of the part being timed */
+    double time;                /* of all its parts */
+    double passTime[TIME_NPASSES];
+    long counters[TIME_NCOUNTERS];
+  }
+funcTime;
+
+static double baseTime = -1;
+
+static double passTime[TIME_NPASSES];
+static int passCalls[TIME_NPASSES];
+static long counters[TIME_NCOUNTERS];
+
+static struct
+  {
+    int pass;
+    double start;
+  }
+openPass[MAX_NESTING];
+static int nOpen = 0;
+
+static funcTime *funcs = NULL;
+static int nFuncs = 0;
+static int currFuncTime = -1;
+
+static traceEvent *events = NULL;
+static int nEvents = 0;
+static int maxEvents = 0;
+
+static int nWorkers = 0;        /* worker processes merged in */
+
+/*-----------------------------------------------------------------*/
+/* now - microseconds since the first timer was started            */
+/*-----------------------------------------------------------------*/
+static double
+now (void)
+{
+  double t;
+
+#ifdef _WIN32
+  t = (double) clock () * 1e6 / CLOCKS_PER_SEC;
+#else
+  struct timeval tv;
+
+  gettimeofday (&tv, NULL);
+  t = (double) tv.tv_sec * 1e6 + tv.tv_usec;
+#endif
+
+  if (baseTime < 0)
+    baseTime = t;
+  return t - baseTime;
+}
+
+/*-----------------------------------------------------------------*/
+/* addEvent - records an interval for --time-trace                 */
+/*-----------------------------------------------------------------*/
+static traceEvent *
+addEvent (const char *name, int isFunction, double start, double end)
+{
+  traceEvent *ev;
+
+  if (!options.time_trace)
+    return NULL;
+
+  if (nEvents == maxEvents)
+    {
+      maxEvents = maxEvents ? 2 * maxEvents : 1024;
+      events = Safe_realloc (events, maxEvents * sizeof (traceEvent));
+    }
+  ev = &events[nEvents++];
+  memset (ev, 0, sizeof (traceEvent));
+  ev->name = name;
+  ev->isFunction = isFunction;
+  ev->tid = 1;
+  ev->ts = start;
+  ev->dur = end - start;
+  return ev;
+}
+
+/*-----------------------------------------------------------------*/
+/* findFunc - returns the index of the function, adds it if new    */
+/*-----------------------------------------------------------------*/
+static int
+findFunc (const char *name)
+{
+  int i;
+
+  for (i = 0; i < nFuncs; i++)
+    if (!strcmp (funcs[i].name, name))
+      return i;
+
+  funcs = Safe_realloc (funcs, (nFuncs + 1) * sizeof (funcTime));
+  memset (&funcs[nFuncs], 0, sizeof (funcTime));
+  funcs[nFuncs].name = Safe_strdup (name);
+  return nFuncs++;
+}
+
+/*-----------------------------------------------------------------*/
+/* timePassBegin - starts the timer of a pass                      */
+/*-----------------------------------------------------------------*/
+void
+timePassBegin (int pass)
+{
+  if (!TIMING_ON)
+    return;
+
+  wassert (nOpen < MAX_NESTING);
+  openPass[nOpen].pass = pass;
+  openPass[nOpen].start = now ();
+  nOpen++;
+}
+
+/*-----------------------------------------------------------------*/
+/* timePassEnd - stops the timer of the innermost pass             */
+/*-----------------------------------------------------------------*/
+void
+timePassEnd (int pass)
+{
+  double t, end;
+
+  if (!TIMING_ON)
+    return;
+
+  wassert (nOpen > 0 && openPass[nOpen - 1].pass == pass);
+  nOpen--;
+  end = now ();
+  t = end - openPass[nOpen].start;
+
+  passTime[pass] += t;
+  passCalls[pass]++;
+  if (currFuncTime >= 0)
+    funcs[currFuncTime].passTime[pass] += t;
+
+  addEvent (passNames[pass], 0, openPass[nOpen].start, end);
+}
+
+/*-----------------------------------------------------------------*/
+/* timeFunctionBegin - following times and counts go to function;  */
+/*                     a function can be continued later, e.g. by  */
+/*                     a port which generates the code in its glue */
+/*-----------------------------------------------------------------*/
+void
+timeFunctionBegin (const char *name)
+{
+  if (!TIMING_ON)
+    return;
+
+  currFuncTime = findFunc (name);
+  funcs[currFuncTime].start = now ();
+}
+
+/*-----------------------------------------------------------------*/
+/* timeFunctionEnd - ends the function started by timeFunctionBegin*/
+/*-----------------------------------------------------------------*/
+void
+timeFunctionEnd (void)
+{
+  double end;
+  traceEvent *ev;
+  funcTime *f;
+
+  if (!TIMING_ON || currFuncTime < 0)
+    return;
+
+  f = &funcs[currFuncTime];
+  end = now ();
+  f->time += end - f->start;
+
+  if ((ev = addEvent (f->name, 1, f->start, end)))
+    memcpy (ev->counters, f->counters, sizeof (ev->counters));
+
+  currFuncTime = -1;
+}
+
+/*-----------------------------------------------------------------*/
+/* timeCount - adds n to a counter                                 */
+/*-----------------------------------------------------------------*/
+void
+timeCount (int counter, int n)
+{
+  if (!TIMING_ON)
+    return;
+
+  counters[counter] += n;
+  if (currFuncTime >= 0)
+    funcs[currFuncTime].counters[counter] += n;
+}
+
+/*-----------------------------------------------------------------*/
+/* timeMax - raises a counter to n                                 */
+/*-----------------------------------------------------------------*/
+void
+timeMax (int counter, int n)
+{
+  if (!TIMING_ON)
+    return;
+
+  if (counters[counter] < n)
+    counters[counter] = n;
+  if (currFuncTime >= 0 && funcs[currFuncTime].counters[counter] < n)
+    funcs[currFuncTime].counters[counter] = n;
+}
+
+/*-----------------------------------------------------------------*/
+/* mergeCounters - adds the counters in cnt to c                   */
+/*-----------------------------------------------------------------*/
+static void
+mergeCounters (long *c, const long *cnt)
+{
+  int j;
+
+  for (j = 0; j < TIME_NCOUNTERS; j++)
+    if (!IS_MAX_COUNTER (j))
+      c[j] += cnt[j];
+    else if (c[j] < cnt[j])
+      c[j] = cnt[j];
+}
+
+/*-----------------------------------------------------------------*/
+/* timeChildBegin - a forked worker counts from zero, so that only */
+/*                  its own work is passed back by timeChildSave   */
+/*-----------------------------------------------------------------*/
+void
+timeChildBegin (void)
+{
+  if (!TIMING_ON)
+    return;
+
+  memset (passTime, 0, sizeof (passTime));
+  memset (passCalls, 0, sizeof (passCalls));
+  memset (counters, 0, sizeof (counters));
+  funcs = NULL;
+  nFuncs = 0;
+  currFuncTime = -1;
+  events = NULL;
+  nEvents = maxEvents = 0;
+  addPeepRulesFired (NULL, 0);
+}
+
+static void
+putStr (struct dbuf_s *buf, const char *s)
+{
+  int len = strlen (s);
+
+  dbuf_append (buf, &len, sizeof (len));
+  dbuf_append (buf, s, len);
+}
+
+/*-----------------------------------------------------------------*/
+/* timeChildSave - appends what the worker timed to buf            */
+/*-----------------------------------------------------------------*/
+void
+timeChildSave (struct dbuf_s *buf)
+{
+  int i, n;
+  int *fired;
+
+  if (!TIMING_ON)
+    return;
+
+  dbuf_append (buf, passTime, sizeof (passTime));
+  dbuf_append (buf, passCalls, sizeof (passCalls));
+  dbuf_append (buf, counters, sizeof (counters));
+
+  dbuf_append (buf, &nFuncs, sizeof (nFuncs));
+  for (i = 0; i < nFuncs; i++)
+    {
+      putStr (buf, funcs[i].name);
+      dbuf_append (buf, &funcs[i].time, sizeof (funcs[i].time));
+      dbuf_append (buf, funcs[i].passTime, sizeof (funcs[i].passTime));
+      dbuf_append (buf, funcs[i].counters, sizeof (funcs[i].counters));
+    }
+
+  dbuf_append (buf, &nEvents, sizeof (nEvents));
+  for (i = 0; i < nEvents; i++)
+    {
+      putStr (buf, events[i].name);
+      dbuf_append (buf, &events[i].isFunction, sizeof (events[i].isFunction));
+      dbuf_append (buf, &events[i].ts, sizeof (events[i].ts));
+      dbuf_append (buf, &events[i].dur, sizeof (events[i].dur));
+      dbuf_append (buf, events[i].counters, sizeof (events[i].counters));
+    }
+
+  n = getPeepRulesFired (NULL);
+  fired = Safe_calloc (n + 1, sizeof (int));
+  getPeepRulesFired (fired);
+  dbuf_append (buf, &n, sizeof (n));
+  dbuf_append (buf, fired, n * sizeof (int));
+  Safe_free (fired);
+}
+
+/* reading back what timeChildSave wrote */
+typedef struct childBuf
+  {
+    const char *p;
+    const char *end;
+  }
+childBuf;
+
+static int
+getBytes (childBuf * cb, void *dst, int len)
+{
+  if (len < 0 || cb->end - cb->p < len)
+    {
+      cb->p = cb->end;
+      return 0;
+    }
+  memcpy (dst, cb->p, len);
+  cb->p += len;
+  return 1;
+}
+
+static char *
+getStr (childBuf * cb)
+{
+  int len;
+  char *s;
+
+  if (!getBytes (cb, &len, sizeof (len)) || len < 0 || cb->end - cb->p < len)
+    return NULL;
+  s = Safe_alloc (len + 1);
+  getBytes (cb, s, len);
+  return s;
+}
+
+/*-----------------------------------------------------------------*/
+/* timeChildMerge - adds what worker process number worker timed;  */
+/*                  its functions continue the ones of the parent  */
+/*-----------------------------------------------------------------*/
+void
+timeChildMerge (const char *buf, int len, int worker)
+{
+  childBuf cb;
+  double t[TIME_NPASSES], time;
+  int calls[TIME_NPASSES];
+  long cnt[TIME_NCOUNTERS];
+  int i, j, n, f;
+  int *fired;
+  char *name;
+  traceEvent *e;
+
+  if (!TIMING_ON || len <= 0)
+    return;
+
+  cb.p = buf;
+  cb.end = buf + len;
+
+  if (!getBytes (&cb, t, sizeof (t)) || !getBytes (&cb, calls, sizeof (calls)) ||
+      !getBytes (&cb, cnt, sizeof (cnt)))
+    return;
+  for (j = 0; j < TIME_NPASSES; j++)
+    {
+      passTime[j] += t[j];
+      passCalls[j] += calls[j];
+    }
+  mergeCounters (counters, cnt);
+
+  if (!getBytes (&cb, &n, sizeof (n)))
+    return;
+  for (i = 0; i < n; i++)
+    {
+      if (!(name = getStr (&cb)))
+        return;
+      if (!getBytes (&cb, &time, sizeof (time)) || !getBytes (&cb, t, sizeof (t)) ||
+          !getBytes (&cb, cnt, sizeof (cnt)))
+        {
+          Safe_free (name);
+          return;
+        }
+      f = findFunc (name);
+      Safe_free (name);
+      funcs[f].time += time;
+      for (j = 0; j < TIME_NPASSES; j++)
+        funcs[f].passTime[j] += t[j];
+      mergeCounters (funcs[f].counters, cnt);
+    }
+
+  if (!getBytes (&cb, &n, sizeof (n)))
+    return;
+  for (i = 0; i < n; i++)
+    {
+      traceEvent ev;
+
+      if (!(name = getStr (&cb)))
+        return;
+      if (!getBytes (&cb, &ev.isFunction, sizeof (ev.isFunction)) ||
+          !getBytes (&cb, &ev.ts, sizeof (ev.ts)) || !getBytes (&cb, &ev.dur, sizeof (ev.dur)) ||
+          !getBytes (&cb, ev.counters, sizeof (ev.counters)))
+        {
+          Safe_free (name);
+          return;
+        }
+      /* the names are kept as long as the events */
+      if ((e = addEvent (name, ev.isFunction, ev.ts, ev.ts + ev.dur)))
+        {
+          e->tid = worker + 2;
+          memcpy (e->counters, ev.counters, sizeof (ev.counters));
+        }
+      else
+        Safe_free (name);
+    }
+  if (worker + 1 > nWorkers)
+    nWorkers = worker + 1;
+
+  if (!getBytes (&cb, &n, sizeof (n)) || n < 0 || cb.end - cb.p < n * (int) sizeof (int))
+    return;
+  fired = Safe_calloc (n + 1, sizeof (int));
+  getBytes (&cb, fired, n * sizeof (int));
+  addPeepRulesFired (fired, n);
+  Safe_free (fired);
+}
+
+/*-----------------------------------------------------------------*/
+/* fputJsonStr - writes a JSON string literal                      */
+/*-----------------------------------------------------------------*/
+static void
+fputJsonStr (const char *s, FILE * of)
+{
+  fputc ('"', of);
+  for (; *s; s++)
+    {
+      if (*s == '"' || *s == '\\')
+        fprintf (of, "\\%c", *s);
+      else if ((unsigned char) *s < ' ')
+        fprintf (of, "\\u%04x", (unsigned char) *s);
+      else
+        fputc (*s, of);
+    }
+  fputc ('"', of);
+}
+
+/*-----------------------------------------------------------------*/
+/* writeTrace - writes the recorded intervals as trace-event JSON  */
+/*-----------------------------------------------------------------*/
+static void
+writeTrace (const char *fileName)
+{
+  FILE *of;
+  int i, j;
+
+  if (!(of = fopen (fileName, "w")))
+    {
+      werror (E_FILE_OPEN_ERR, fileName);
+      return;
+    }
+
+  fprintf (of, "{\"traceEvents\":[\n");
+  fprintf (of, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":");
+  fputJsonStr (fullSrcFileName ? fullSrcFileName : "stdin", of);
+  fprintf (of, "}}");
+  for (i = 1; i <= nWorkers; i++)
+    fprintf (of, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"worker %d\"}}",
+             i + 1, i);
+
+  for (i = 0; i < nEvents; i++)
+    {
+      fprintf (of, ",\n{\"name\":");
+      fputJsonStr (events[i].name, of);
+      fprintf (of, ",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.1f,\"dur\":%.1f,\"pid\":1,\"tid\":%d",
+               events[i].isFunction ? "function" : "pass", events[i].ts, events[i].dur, events[i].tid);
+      if (events[i].isFunction)
+        {
+          fprintf (of, ",\"args\":{");
+          for (j = 0; j < TIME_NCOUNTERS; j++)
+            fprintf (of, "%s\"%s\":%ld", j ? "," : "", counterNames[j], events[i].counters[j]);
+          fprintf (of, "}");
+        }
+      fprintf (of, "}");
+    }
+  fprintf (of, "\n]}\n");
+  fclose (of);
+}
+
+/*-----------------------------------------------------------------*/
+/* timePassesReport - prints the table and writes the trace file   */
+/*-----------------------------------------------------------------*/
+void
+timePassesReport (void)
+{
+  int shown[TIME_NPASSES];
+  int nShown = 0;
+  double total;
+  int i, j;
+
+  if (!TIMING_ON)
+    return;
+
+  if (options.time_trace)
+    writeTrace (options.time_trace);
+
+  if (!options.time_passes)
+    return;
+
+  total = now ();
+  if (total <= 0)
+    total = 1;
+
+  fprintf (stderr, "\nCompile time report for %s (times include nested passes)\n",
+           fullSrcFileName ? fullSrcFileName : "stdin");
+  if (nWorkers)
+    fprintf (stderr, "The times of the %d worker processes are summed up.\n", nWorkers);
+  fprintf (stderr, "%-24s %8s %12s %7s\n", "pass", "calls", "time [ms]", "%");
+  for (i = 0; i < TIME_NPASSES; i++)
+    {
+      if (!passCalls[i])
+        continue;
+      fprintf (stderr, "%-24s %8d %12.3f %7.1f\n",
+               passNames[i], passCalls[i], passTime[i] / 1000, 100 * passTime[i] / total);
+    }
+  fprintf (stderr, "%-24s %8s %12.3f\n", "total", "", total / 1000);
+
+  fprintf (stderr, "\n%-24s %12s\n", "counter", "value");
+  for (i = 0; i < TIME_NCOUNTERS; i++)
+    fprintf (stderr, "%-24s %12ld\n", counterNames[i], counters[i]);
+
+  if (nFuncs)
+    {
+      /* the passes run for any of the functions */
+      for (j = 0; j < TIME_NPASSES; j++)
+        {
+          for (i = 0; i < nFuncs && funcs[i].passTime[j] <= 0; i++)
+            ;
+          if (i < nFuncs)
+            shown[nShown++] = j;
+        }
+
+      fprintf (stderr, "\n%-24s %10s", "function [ms]", "total");
+      for (j = 0; j < nShown; j++)
+        fprintf (stderr, " %10s", passNames[shown[j]]);
+      fprintf (stderr, " %10s %10s %10s %10s %10s\n", "#iCodes", "#cse blk", "#df iter", "#peep", "td width");
+      for (i = 0; i < nFuncs; i++)
+        {
+          fprintf (stderr, "%-24s %10.3f", funcs[i].name, funcs[i].time / 1000);
+          for (j = 0; j < nShown; j++)
+            fprintf (stderr, " %10.3f", funcs[i].passTime[shown[j]] / 1000);
+          fprintf (stderr, " %10ld %10ld %10ld %10ld %10ld\n",
+                   funcs[i].counters[TIME_CNT_ICODES],
+                   funcs[i].counters[TIME_CNT_CSE_BLOCKS],
+                   funcs[i].counters[TIME_CNT_DFLOW_ITER],
+                   funcs[i].counters[TIME_CNT_PEEP_FIRED],
+                   funcs[i].counters[TIME_CNT_TREE_WIDTH]);
+        }
+    }
+
+  printPeepRuleStats (stderr);
+}
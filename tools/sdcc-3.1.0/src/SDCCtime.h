@@ -0,0 +1,74 @@
+/*-------------------------------------------------------------------------
+  SDCCtime.h - compile time profiling of the compiler passes
+
+   This program is free software; you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by the
+   Free Software Foundation; either version 2, or (at your option) any
+   later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+   In other words, you are welcome to use, share and improve this program.
+   You are forbidden to forbid anyone else to use, share and improve
+   what you give them.   Help stamp out software-hoarding!
+-------------------------------------------------------------------------*/
+
+#ifndef SDCCTIME_H
+#define SDCCTIME_H
+
+#include "dbuf.h"
+
+/* the timed passes; keep in sync with passNames in SDCCtime.c */
+enum
+  {
+    TIME_PARSE = 0,             /* yyparse, includes everything done per function */
+    TIME_AST,                   /* resolveSymbols & decorateType of a function */
+    TIME_ICODE,                 /* iCodeFromAst */
+    TIME_OPTIMIZE,              /* eBBlockFromiCode, includes the passes below */
+    TIME_CSE,                   /* common subexpression elimination */
+    TIME_DFLOW,                 /* data flow */
+    TIME_DEADCODE,              /* dead code elimination */
+    TIME_LOOP,                  /* loop optimizations */
+    TIME_LRANGE,                /* live range computation */
+    TIME_RALLOC,                /* register allocation and code generation */
+    TIME_PEEPHOLE,              /* peephole optimizer */
+    TIME_GLUE,                  /* port glue, includes the code generation of pblaze */
+    TIME_ASSEMBLE,              /* calling the assembler */
+    TIME_NPASSES
+  };
+
+/* the counted events; keep in sync with counterNames in SDCCtime.c */
+enum
+  {
+    TIME_CNT_ICODES = 0,        /* iCodes created */
+    TIME_CNT_CSE_BLOCKS,        /* blocks run through cseBBlock */
+    TIME_CNT_DFLOW_ITER,        /* data flow iterations */
+    TIME_CNT_PEEP_FIRED,        /* peephole rules applied */
+    TIME_CNT_TREE_WIDTH,        /* width of the register allocator's tree decomposition, a maximum */
+    TIME_NCOUNTERS
+  };
+
+/* TRUE if --time-passes or --time-trace was given */
+#define TIMING_ON (options.time_passes || options.time_trace)
+
+void timePassBegin (int pass);
+void timePassEnd (int pass);
+void timeFunctionBegin (const char *name);
+void timeFunctionEnd (void);
+void timeCount (int counter, int n);
+void timeMax (int counter, int n);
+void timePassesReport (void);
+
+/* worker processes: what a child timed is merged into its parent */
+void timeChildBegin (void);
+void timeChildSave (struct dbuf_s *buf);
+void timeChildMerge (const char *buf, int len, int worker);
+
+#endif
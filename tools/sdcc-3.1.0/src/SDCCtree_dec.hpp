@@ -35,14 +35,21 @@
 // void thorup_tree_decomposition(T_t &tree_decomposition, const G_t &cfg)
 // Creates a tree decomposition T from a graph cfg using Thorup's heuristic.
 //
+// unsigned int narrow_tree_decomposition(T_t &T, const G_t &G)
+// Creates a tree decomposition T of a graph G using the narrowest of several heuristic elimination orderings, returns its width.
+//
 // void tree_decomposition_from_elimination_ordering(T_t &T, std::list<unsigned int>& l, const G_t &G)
 // Creates a tree decomposition T of a graph G from an elimination ordering l.
 //
 // void thorup_elimination_ordering(l_t &l, const J_t &J)
 // Creates an elimination ordering l of a graph J using Thorup's heuristic.
+//
+// void greedy_elimination_ordering(std::list<unsigned int> &l, std::vector<std::set<unsigned int> > A, bool min_fill)
+// Creates an elimination ordering l of a graph A using the minimum fill-in or minimum degree heuristic.
 
 #include <map>
 #include <vector>
+#include <algorithm>
 #include <set>
 #include <stack>
 #include <list>
@@ -53,48 +60,53 @@
 #include <boost/graph/copy.hpp>
 #include <boost/graph/adjacency_list.hpp>
 
+// Lists of vertices indexed by vertex, in the order they were added.
+typedef std::vector<std::vector<unsigned int> > thorup_map_t;
+
 // Thorup algorithm D.
-// The use of the multimap makes the complexity of this O(|I|log|I|), which could be reduced to O(|I|).
+// Complexity: Linear in the number of vertices and the sizes of MJ and MS.
 template <class l_t>
-void thorup_D(l_t &l, const std::multimap<unsigned int, unsigned int> &MJ, const std::multimap<unsigned int, unsigned int> &MS, const unsigned int n)
+void thorup_D(l_t &l, const thorup_map_t &MJ, const thorup_map_t &MS, const unsigned int n)
 {
-  std::map<unsigned int, unsigned int> m;
+  std::vector<unsigned int> v;
+  std::vector<bool> m(n, false);
 
   l.clear();
 
-  unsigned int i = 0;
+  v.reserve(n);
   for (unsigned int j = n; j > 0;)
     {
       j--;
-      if (m.find(j) == m.end())
-        m[j] = i++;
-        
-      std::multimap<unsigned int, unsigned int>::const_iterator k, k_end;
-
-      for (boost::tie(k, k_end) = MS.equal_range(j); k != k_end; ++k)
-        if (m.find(k->second) == m.end())
-          m[k->second] = i++;
-
-      for (boost::tie(k, k_end) = MJ.equal_range(j); k != k_end; ++k)
-        if (m.find(k->second) == m.end())
-          m[k->second] = i++;
-    }
-
-  std::vector<unsigned int> v(n);
-
-  std::map<unsigned int, unsigned int>::iterator mi;
+      if (!m[j])
+        {
+          m[j] = true;
+          v.push_back(j);
+        }
 
-  for (mi = m.begin(); mi != m.end(); ++mi)
-    v[mi->second] = mi->first;
+      std::vector<unsigned int>::const_iterator k;
+
+      for (k = MS[j].begin(); k != MS[j].end(); ++k)
+        if (!m[*k])
+          {
+            m[*k] = true;
+            v.push_back(*k);
+          }
+
+      for (k = MJ[j].begin(); k != MJ[j].end(); ++k)
+        if (!m[*k])
+          {
+            m[*k] = true;
+            v.push_back(*k);
+          }
+    }
 
-  for (i = 0; i < n; i++)
-    l.push_back(v[i]);
+  l.insert(l.end(), v.begin(), v.end());
 }
 
 // Thorup algorithm E.
-// The use of the multimap makes the complexity of this O(|I|log|I|), which could be reduced to O(|I|).
+// Complexity: Linear in the number of vertices and edges of I.
 template <class I_t>
-void thorup_E(std::multimap<unsigned int, unsigned int> &M, const I_t &I)
+void thorup_E(thorup_map_t &M, const I_t &I)
 {
   typedef typename boost::graph_traits<I_t>::adjacency_iterator adjacency_iter_t;
   typedef typename boost::graph_traits<I_t>::vertex_iterator vertex_iter_t;
@@ -104,6 +116,7 @@ void thorup_E(std::multimap<unsigned int, unsigned int> &M, const I_t &I)
   std::stack<std::pair<int, unsigned int> > s;
 
   M.clear();
+  M.resize(boost::num_vertices(I));
 
   s.push(std::pair<int, unsigned int>(-1, boost::num_vertices(I)));
 
@@ -121,7 +134,7 @@ void thorup_E(std::multimap<unsigned int, unsigned int> &M, const I_t &I)
 
       while (s.top().second <= i)
         {
-          M.insert(std::pair<unsigned int, unsigned int>(s.top().second, s.top().first));
+          M[s.top().second].push_back(s.top().first);
           s.pop();
         }
 
@@ -138,7 +151,7 @@ void thorup_E(std::multimap<unsigned int, unsigned int> &M, const I_t &I)
     // Not in Thorup's paper, but without this the algorithm gives incorrect results.
     while(s.size() > 1)
     {
-    	M.insert(std::pair<unsigned int, unsigned int>(s.top().second, s.top().first));
+    	M[s.top().second].push_back(s.top().first);
     	s.pop();
     }
 }
@@ -146,7 +159,7 @@ void thorup_E(std::multimap<unsigned int, unsigned int> &M, const I_t &I)
 // Heuristically give an elimination ordering for a directed graph.
 // For a description of this, including algorithms D and E, see
 // Mikkel Thorup, "All Structured Programs have Small Tree-Width and Good Register Allocation", Appendix A.
-// The use of the multimap makes the complexity of this O(|I|log|I|), could be reduced to O(|I|).
+// Complexity: Linear in the number of vertices and edges of G.
 template <class l_t, class G_t>
 void thorup_elimination_ordering(l_t &l, const G_t &G)
 {
@@ -160,7 +173,7 @@ void thorup_elimination_ordering(l_t &l, const G_t &G)
   boost::adjacency_list<boost::vecS, boost::vecS, boost::undirectedS> S;
   boost::copy_graph(J, S);
 
-  std::multimap<unsigned int, unsigned int> MJ, MS;
+  thorup_map_t MJ, MS;
 
   thorup_E(MJ, J);
 
@@ -273,6 +286,228 @@ void thorup_tree_decomposition(T_t &tree_decomposition, const G_t &cfg)
   tree_decomposition_from_elimination_ordering(tree_decomposition, elimination_ordering, cfg);
 }
 
+// Get the undirected graph underlying G, without self-loops, as adjacency sets.
+template <class G_t>
+void elimination_graph(std::vector<std::set<unsigned int> > &A, const G_t &G)
+{
+  typedef typename boost::graph_traits<G_t>::edge_iterator edge_iter_t;
+  typedef typename boost::property_map<G_t, boost::vertex_index_t>::const_type index_map;
+  index_map index = boost::get(boost::vertex_index, G);
+
+  A.clear();
+  A.resize(boost::num_vertices(G));
+
+  edge_iter_t e, e_end;
+  for (boost::tie(e, e_end) = boost::edges(G); e != e_end; ++e)
+    {
+      unsigned int u = index[boost::source(*e, G)];
+      unsigned int v = index[boost::target(*e, G)];
+      if (u == v)
+        continue;
+      A[u].insert(v);
+      A[v].insert(u);
+    }
+}
+
+// Eliminate vertex v from the graph A: Its neighbours become a clique.
+inline void eliminate_vertex(std::vector<std::set<unsigned int> > &A, unsigned int v)
+{
+  std::set<unsigned int> N;
+  std::set<unsigned int>::const_iterator n1, n2;
+
+  N.swap(A[v]);
+  for (n1 = N.begin(); n1 != N.end(); ++n1)
+    {
+      A[*n1].erase(v);
+      for (n2 = N.begin(); n2 != N.end(); ++n2)
+        if (*n1 != *n2)
+          A[*n1].insert(*n2);
+    }
+}
+
+// Width of the tree decomposition given by eliminating the vertices of A in the order [v, v_end):
+// The maximum number of neighbours a vertex still has when it is eliminated.
+// The number of vertices that attain the maximum is stored in count, the vertices themselves in wide, if not 0.
+template <class v_t>
+unsigned int elimination_ordering_width(v_t v, const v_t v_end, std::vector<std::set<unsigned int> > A, unsigned int &count, std::vector<unsigned int> *wide = 0)
+{
+  unsigned int width = 0;
+
+  count = 0;
+  if (wide)
+    wide->clear();
+
+  for (; v != v_end; ++v)
+    {
+      unsigned int d = A[*v].size();
+      if (d > width)
+        {
+          width = d;
+          count = 0;
+          if (wide)
+            wide->clear();
+        }
+      if (d == width)
+        {
+          count++;
+          if (wide)
+            wide->push_back(*v);
+        }
+      eliminate_vertex(A, *v);
+    }
+
+  return(width);
+}
+
+// Key for the greedy elimination orderings: Number of fill-in edges eliminating v would need (or the degree of v), then the degree of v.
+typedef std::pair<unsigned int, unsigned int> elimination_key_t;
+
+inline elimination_key_t elimination_key(const std::vector<std::set<unsigned int> > &A, unsigned int v, bool min_fill)
+{
+  if (!min_fill)
+    return(elimination_key_t(A[v].size(), 0));
+
+  unsigned int fill = 0;
+  std::set<unsigned int>::const_iterator n1, n2;
+  for (n1 = A[v].begin(); n1 != A[v].end(); ++n1)
+    for (n2 = n1, ++n2; n2 != A[v].end(); ++n2)
+      if (A[*n1].find(*n2) == A[*n1].end())
+        fill++;
+
+  return(elimination_key_t(fill, A[v].size()));
+}
+
+// Heuristically give an elimination ordering for the graph A, eliminating a vertex that needs
+// the fewest fill-in edges (min_fill) or has the fewest neighbours (!min_fill) first. Ties are broken by index.
+// Complexity: O(|V| * d^3 * log|V|) for min_fill, O(|V| * d^2 * log|V|) otherwise, where d is the maximum degree in the resulting chordal graph.
+inline void greedy_elimination_ordering(std::list<unsigned int> &l, std::vector<std::set<unsigned int> > A, bool min_fill)
+{
+  typedef std::set<std::pair<elimination_key_t, unsigned int> > queue_t;
+  const unsigned int n = A.size();
+  std::vector<elimination_key_t> key(n);
+  queue_t queue;
+
+  l.clear();
+
+  for (unsigned int v = 0; v < n; v++)
+    queue.insert(std::make_pair(key[v] = elimination_key(A, v, min_fill), v));
+
+  while (!queue.empty())
+    {
+      const unsigned int v = queue.begin()->second;
+      queue.erase(queue.begin());
+
+      std::set<unsigned int> changed(A[v]);
+      eliminate_vertex(A, v);
+      l.push_front(v);
+
+      // The fill-in of a vertex can change by adding edges between two of its neighbours.
+      std::set<unsigned int>::const_iterator c;
+      if (min_fill)
+        {
+          std::set<unsigned int> N(changed);
+          for (c = N.begin(); c != N.end(); ++c)
+            changed.insert(A[*c].begin(), A[*c].end());
+        }
+
+      for (c = changed.begin(); c != changed.end(); ++c)
+        {
+          queue.erase(std::make_pair(key[*c], *c));
+          queue.insert(std::make_pair(key[*c] = elimination_key(A, *c, min_fill), *c));
+        }
+    }
+}
+
+#define TREE_DEC_REFINE_STEPS 64
+
+// Try to improve an elimination ordering of A by moving the vertices that have the most neighbours when eliminated
+// a few positions; a move is kept if it reduces the width or the number of vertices that attain it.
+// At most TREE_DEC_REFINE_STEPS orderings are tried. Returns the width.
+inline unsigned int refine_elimination_ordering(std::list<unsigned int> &l, const std::vector<std::set<unsigned int> > &A)
+{
+  static const int moves[] = {1, -1, 4, -4, 16, -16};
+  std::vector<unsigned int> o(l.rbegin(), l.rend()), o2, wide, wide2;
+  unsigned int width, count, width2, count2;
+  unsigned int steps = 0;
+  bool improved = true;
+
+  width = elimination_ordering_width(o.begin(), o.end(), A, count, &wide);
+
+  while (improved && steps < TREE_DEC_REFINE_STEPS)
+    {
+      improved = false;
+      for (unsigned int i = 0; i < wide.size() && !improved && steps < TREE_DEC_REFINE_STEPS; i++)
+        {
+          const int p = std::find(o.begin(), o.end(), wide[i]) - o.begin();
+          for (unsigned int m = 0; m < sizeof(moves) / sizeof(moves[0]) && steps < TREE_DEC_REFINE_STEPS; m++)
+            {
+              const int p2 = p + moves[m];
+              if (p2 < 0 || p2 >= int(o.size()))
+                continue;
+
+              o2 = o;
+              o2.erase(o2.begin() + p);
+              o2.insert(o2.begin() + p2, wide[i]);
+              width2 = elimination_ordering_width(o2.begin(), o2.end(), A, count2, &wide2);
+              steps++;
+
+              if (width2 < width || (width2 == width && count2 < count))
+                {
+                  o.swap(o2);
+                  wide.swap(wide2);
+                  width = width2;
+                  count = count2;
+                  improved = true;
+                  break;
+                }
+            }
+        }
+    }
+
+  l.assign(o.rbegin(), o.rend());
+
+  return(width);
+}
+
+// Create a tree decomposition T of a graph G from the narrowest of the elimination orderings given by Thorup's,
+// the minimum fill-in and the minimum degree heuristics, refined by refine_elimination_ordering().
+// Returns the width of T.
+template <class T_t, class G_t>
+unsigned int narrow_tree_decomposition(T_t &T, const G_t &G)
+{
+  std::vector<std::set<unsigned int> > A;
+  std::list<unsigned int> l, l2;
+  unsigned int width, width2, count;
+
+  elimination_graph(A, G);
+
+  thorup_elimination_ordering(l, G);
+  width = elimination_ordering_width(l.rbegin(), l.rend(), A, count);
+
+  for (int i = 0; i < 2; i++)
+    {
+      greedy_elimination_ordering(l2, A, i == 0);
+      width2 = elimination_ordering_width(l2.rbegin(), l2.rend(), A, count);
+      if (width2 < width)
+        {
+          l.swap(l2);
+          width = width2;
+        }
+    }
+
+  l2 = l;
+  width2 = refine_elimination_ordering(l2, A);
+  if (width2 < width)
+    {
+      l.swap(l2);
+      width = width2;
+    }
+
+  tree_decomposition_from_elimination_ordering(T, l, G);
+
+  return(width);
+}
+
 // Ensure that all joins are at proper join nodes: Each node that has two children has the same bag as its children.
 // Complexity: Linear in the number of vertices of T.
 template <class T_t>
@@ -1,4 +1,6 @@
 #include "common.h"
+#include "dbuf_string.h"
+#include "cdbIndex.h"
 
 
 /*************************************************************
@@ -521,3 +523,29 @@ cdbTypeInfo (sym_link * type)
       type = type->next;
     }
 }
+
+
+/******************************************************************
+ * cdbWriteIndex - writes the index (name.cdx) of the debug
+ * information the linker collected in name.cdb
+ *
+ *****************************************************************/
+
+int
+cdbWriteIndex (const char *name)
+{
+  struct dbuf_s cdbName, cdxName;
+  int ret;
+
+  dbuf_init (&cdbName, PATH_MAX);
+  dbuf_init (&cdxName, PATH_MAX);
+  dbuf_printf (&cdbName, "%s.cdb", name);
+  dbuf_printf (&cdxName, "%s.cdx", name);
+
+  if (!(ret = cdbIndexWrite (dbuf_c_str (&cdbName), dbuf_c_str (&cdxName))))
+    werror (E_FILE_OPEN_ERR, dbuf_c_str (&cdxName));
+
+  dbuf_destroy (&cdbName);
+  dbuf_destroy (&cdxName);
+  return ret;
+}
@@ -0,0 +1,475 @@
+/*-------------------------------------------------------------------------
+  cdbIndex - indexed binary form of the .cdb debug information
+
+   This program is free software; you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by the
+   Free Software Foundation; either version 2, or (at your option) any
+   later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+   In other words, you are welcome to use, share and improve this program.
+   You are forbidden to forbid anyone else to use, share and improve
+   what you give them.   Help stamp out software-hoarding!
+-------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+#include "newalloc.h"
+#include "cdbIndex.h"
+
+static unsigned int
+getU32 (const unsigned char *p)
+{
+  return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int) p[3] << 24);
+}
+
+static void
+putU32 (unsigned char *p, unsigned int v)
+{
+  p[0] = v;
+  p[1] = v >> 8;
+  p[2] = v >> 16;
+  p[3] = v >> 24;
+}
+
+/*-----------------------------------------------------------------*/
+/* cdbIndexHash - hash of the first len characters of s            */
+/*-----------------------------------------------------------------*/
+unsigned int
+cdbIndexHash (const char *s, size_t len)
+{
+  unsigned int h = 2166136261u;
+
+  while (len--)
+    {
+      h ^= (unsigned char) *s++;
+      h *= 16777619u;
+    }
+  return h;
+}
+
+/*-----------------------------------------------------------------*/
+/* recordKey - mangled name of a symbol, function or symbol link   */
+/*             record, NULL for other records                      */
+/*-----------------------------------------------------------------*/
+static const char *
+recordKey (const char *rec, size_t *len)
+{
+  const char *end;
+  char term;
+
+  if (rec[1] != ':')
+    return NULL;
+  switch (rec[0])
+    {
+    case 'S':
+    case 'F':
+      term = '(';
+      break;
+    case 'L':
+      if (rec[2] == 'X' || ((rec[2] == 'A' || rec[2] == 'C') && rec[3] == '$'))
+        return NULL;
+      term = ':';
+      break;
+    default:
+      return NULL;
+    }
+  if (!(end = strchr (rec + 2, term)))
+    return NULL;
+  *len = end - (rec + 2);
+  return rec + 2;
+}
+
+/*-----------------------------------------------------------------*/
+/* lineRecordAddr - address of an asm or C line record             */
+/*-----------------------------------------------------------------*/
+static int
+lineRecordAddr (const char *rec, unsigned int *addr)
+{
+  const char *p;
+
+  if (rec[0] != 'L' || rec[1] != ':' || (rec[2] != 'A' && rec[2] != 'C') || rec[3] != '$')
+    return 0;
+  if (!(p = strrchr (rec, ':')) || p == rec + 1)
+    return 0;
+  *addr = strtoul (p + 1, NULL, 16);
+  return 1;
+}
+
+static int
+lineCompare (const void *a, const void *b)
+{
+  unsigned int aa = getU32 (a), ba = getU32 (b);
+
+  if (aa != ba)
+    return aa < ba ? -1 : 1;
+  /* keep the order of the .cdb for the same address */
+  aa = getU32 ((const unsigned char *) a + 4);
+  ba = getU32 ((const unsigned char *) b + 4);
+  return aa < ba ? -1 : aa > ba;
+}
+
+/*-----------------------------------------------------------------*/
+/* setupIndex - points the section pointers into the buffer        */
+/*-----------------------------------------------------------------*/
+static void
+setupIndex (cdbIndex *idx)
+{
+  idx->nrecs = getU32 (idx->base + CDX_NRECS_OFS);
+  idx->nbuckets = getU32 (idx->base + CDX_NBUCKETS_OFS);
+  idx->nlines = getU32 (idx->base + CDX_NLINES_OFS);
+  idx->recs = idx->base + CDX_HEADER_SIZE;
+  idx->buckets = idx->recs + 4 * idx->nrecs;
+  idx->chain = idx->buckets + 4 * idx->nbuckets;
+  idx->lines = idx->chain + 4 * idx->nrecs;
+  idx->strings = (char *) idx->lines + 8 * idx->nlines;
+}
+
+/*-----------------------------------------------------------------*/
+/* buildIndex - makes the index of a .cdb read into text           */
+/*-----------------------------------------------------------------*/
+static cdbIndex *
+buildIndex (char *text, size_t len, const struct stat *st)
+{
+  cdbIndex *idx;
+  unsigned int nrecs = 0, nbuckets, nlines = 0, strsize = 0;
+  unsigned int i, addr, b, line;
+  char *p, *end = text + len, *s;
+  const char *key;
+  size_t klen;
+
+  /* cut the text into records */
+  for (p = text; p < end; p = s + 1)
+    {
+      for (s = p; s < end && *s != '\n'; s++)
+        ;
+      if (s > p && s[-1] == '\r')
+        s[-1] = '\0';
+      if (s < end)
+        *s = '\0';
+      else
+        text[len] = '\0';
+      if (*p)
+        {
+          nrecs++;
+          strsize += strlen (p) + 1;
+          if (lineRecordAddr (p, &addr))
+            nlines++;
+        }
+    }
+  for (nbuckets = 64; nbuckets < nrecs; nbuckets <<= 1)
+    ;
+
+  idx = Safe_calloc (1, sizeof (cdbIndex));
+  idx->size = CDX_HEADER_SIZE + 8 * nrecs + 4 * nbuckets + 8 * nlines + strsize;
+  idx->base = Safe_calloc (1, idx->size);
+  memcpy (idx->base, CDX_MAGIC, 4);
+  putU32 (idx->base + CDX_VERS_OFS, CDX_VERSION);
+  putU32 (idx->base + CDX_SIZE_OFS, (unsigned int) st->st_size);
+  putU32 (idx->base + CDX_MTIME_OFS, (unsigned int) st->st_mtime);
+  putU32 (idx->base + CDX_NRECS_OFS, nrecs);
+  putU32 (idx->base + CDX_NBUCKETS_OFS, nbuckets);
+  putU32 (idx->base + CDX_NLINES_OFS, nlines);
+  putU32 (idx->base + CDX_STRSIZE_OFS, strsize);
+  putU32 (idx->base + CDX_FSIZE_OFS, idx->size);
+  setupIndex (idx);
+
+  i = 0;
+  line = 0;
+  s = idx->strings;
+  for (p = text; p < end; p += strlen (p) + 1)
+    {
+      if (!*p)
+        continue;
+      putU32 (idx->recs + 4 * i, s - idx->strings);
+      strcpy (s, p);
+      s += strlen (p) + 1;
+      if (lineRecordAddr (p, &addr))
+        {
+          putU32 (idx->lines + 8 * line, addr);
+          putU32 (idx->lines + 8 * line + 4, i);
+          line++;
+        }
+      i++;
+    }
+
+  /* chains are built backwards so they list records in file order */
+  for (i = nrecs; i-- > 0;)
+    {
+      if (!(key = recordKey (cdbIndexRecord (idx, i), &klen)))
+        continue;
+      b = cdbIndexHash (key, klen) & (nbuckets - 1);
+      putU32 (idx->chain + 4 * i, getU32 (idx->buckets + 4 * b));
+      putU32 (idx->buckets + 4 * b, i + 1);
+    }
+
+  qsort (idx->lines, nlines, 8, lineCompare);
+  return idx;
+}
+
+/*-----------------------------------------------------------------*/
+/* readText - reads the whole .cdb                                 */
+/*-----------------------------------------------------------------*/
+static char *
+readText (const char *cdbName, const struct stat *st)
+{
+  FILE *f;
+  char *text;
+
+  if (!(f = fopen (cdbName, "rb")))
+    return NULL;
+  text = Safe_malloc (st->st_size + 1);
+  if (fread (text, 1, st->st_size, f) != (size_t) st->st_size)
+    {
+      Safe_free (text);
+      text = NULL;
+    }
+  fclose (f);
+  return text;
+}
+
+/*-----------------------------------------------------------------*/
+/* cdxName - name of the index belonging to a .cdb                 */
+/*-----------------------------------------------------------------*/
+static char *
+cdxName (const char *cdbName)
+{
+  char *name = Safe_malloc (strlen (cdbName) + 5);
+  char *dot, *sep;
+
+  strcpy (name, cdbName);
+  dot = strrchr (name, '.');
+  sep = strrchr (name, '/');
+  if (dot && (!sep || dot > sep))
+    *dot = '\0';
+  strcat (name, ".cdx");
+  return name;
+}
+
+/*-----------------------------------------------------------------*/
+/* saveIndex - writes the index into a file                        */
+/*-----------------------------------------------------------------*/
+static int
+saveIndex (cdbIndex *idx, const char *name)
+{
+  FILE *f;
+  int ok;
+
+  if (!(f = fopen (name, "wb")))
+    return 0;
+  ok = fwrite (idx->base, 1, idx->size, f) == idx->size;
+  if (fclose (f) != 0)
+    ok = 0;
+  if (!ok)
+    remove (name);
+  return ok;
+}
+
+/*-----------------------------------------------------------------*/
+/* makeIndex - indexes a .cdb                                      */
+/*-----------------------------------------------------------------*/
+static cdbIndex *
+makeIndex (const char *cdbName, const struct stat *st)
+{
+  char *text;
+  cdbIndex *idx;
+
+  if (!(text = readText (cdbName, st)))
+    return NULL;
+  idx = buildIndex (text, st->st_size, st);
+  Safe_free (text);
+  return idx;
+}
+
+/*-----------------------------------------------------------------*/
+/* cdbIndexWrite - makes the index of a .cdb, returns 1 if done    */
+/*-----------------------------------------------------------------*/
+int
+cdbIndexWrite (const char *cdbName, const char *cdxFile)
+{
+  struct stat st;
+  cdbIndex *idx;
+  char *name;
+  int ok;
+
+  if (stat (cdbName, &st) != 0 || !(idx = makeIndex (cdbName, &st)))
+    return 0;
+  name = cdxFile ? NULL : cdxName (cdbName);
+  ok = saveIndex (idx, cdxFile ? cdxFile : name);
+  if (name)
+    Safe_free (name);
+  cdbIndexClose (idx);
+  return ok;
+}
+
+/*-----------------------------------------------------------------*/
+/* loadIndex - maps an index if it is up to date                   */
+/*-----------------------------------------------------------------*/
+static cdbIndex *
+loadIndex (const char *name, const struct stat *cdbSt)
+{
+  FILE *f;
+  unsigned char header[CDX_HEADER_SIZE];
+  struct stat st;
+  cdbIndex *idx;
+  size_t size;
+
+  if (!(f = fopen (name, "rb")))
+    return NULL;
+  if (fstat (fileno (f), &st) != 0 ||
+      fread (header, 1, CDX_HEADER_SIZE, f) != CDX_HEADER_SIZE ||
+      memcmp (header, CDX_MAGIC, 4) != 0 ||
+      getU32 (header + CDX_VERS_OFS) != CDX_VERSION ||
+      getU32 (header + CDX_SIZE_OFS) != (unsigned int) cdbSt->st_size ||
+      getU32 (header + CDX_MTIME_OFS) != (unsigned int) cdbSt->st_mtime ||
+      getU32 (header + CDX_FSIZE_OFS) != (unsigned int) st.st_size)
+    {
+      fclose (f);
+      return NULL;
+    }
+  size = st.st_size;
+
+  idx = Safe_calloc (1, sizeof (cdbIndex));
+  idx->size = size;
+#ifndef _WIN32
+  /* private writable mapping: users may cut the record texts in place */
+  idx->base = mmap (NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fileno (f), 0);
+  if (idx->base != MAP_FAILED)
+    idx->mapped = 1;
+  else
+#endif
+    {
+      idx->base = Safe_malloc (size);
+      rewind (f);
+      if (fread (idx->base, 1, size, f) != size)
+        {
+          fclose (f);
+          Safe_free (idx->base);
+          Safe_free (idx);
+          return NULL;
+        }
+    }
+  fclose (f);
+  setupIndex (idx);
+  return idx;
+}
+
+/*-----------------------------------------------------------------*/
+/* cdbIndexOpen - opens the index of a .cdb, the index is made     */
+/*                again if the .cdb changed                        */
+/*-----------------------------------------------------------------*/
+cdbIndex *
+cdbIndexOpen (const char *cdbName, const char *cdxFile)
+{
+  struct stat st;
+  cdbIndex *idx;
+  char *name;
+
+  if (stat (cdbName, &st) != 0)
+    return NULL;
+  name = cdxFile ? NULL : cdxName (cdbName);
+  if (!(idx = loadIndex (cdxFile ? cdxFile : name, &st)) &&
+      (idx = makeIndex (cdbName, &st)))
+    {
+      /* an index which can't be saved is still good for this run */
+      saveIndex (idx, cdxFile ? cdxFile : name);
+    }
+  if (name)
+    Safe_free (name);
+  return idx;
+}
+
+/*-----------------------------------------------------------------*/
+/* cdbIndexClose - releases an index                               */
+/*-----------------------------------------------------------------*/
+void
+cdbIndexClose (cdbIndex *idx)
+{
+  if (!idx)
+    return;
+#ifndef _WIN32
+  if (idx->mapped)
+    munmap (idx->base, idx->size);
+  else
+#endif
+    Safe_free (idx->base);
+  Safe_free (idx);
+}
+
+/*-----------------------------------------------------------------*/
+/* cdbIndexRecord - text of a record                               */
+/*-----------------------------------------------------------------*/
+char *
+cdbIndexRecord (cdbIndex *idx, unsigned int rec)
+{
+  return idx->strings + getU32 (idx->recs + 4 * rec);
+}
+
+/*-----------------------------------------------------------------*/
+/* cdbIndexFind - next record with a mangled name after record     */
+/*                prev, start with prev = -1. Returns -1 at end    */
+/*-----------------------------------------------------------------*/
+int
+cdbIndexFind (cdbIndex *idx, const char *name, int prev)
+{
+  size_t len = strlen (name), klen;
+  unsigned int next;
+  const char *key;
+
+  if (prev < 0)
+    next = getU32 (idx->buckets + 4 * (cdbIndexHash (name, len) & (idx->nbuckets - 1)));
+  else
+    next = getU32 (idx->chain + 4 * prev);
+  for (; next; next = getU32 (idx->chain + 4 * (next - 1)))
+    {
+      key = recordKey (cdbIndexRecord (idx, next - 1), &klen);
+      if (key && klen == len && memcmp (key, name, len) == 0)
+        return next - 1;
+    }
+  return -1;
+}
+
+/*-----------------------------------------------------------------*/
+/* cdbIndexLineAt - first entry of the line table at or above addr */
+/*-----------------------------------------------------------------*/
+int
+cdbIndexLineAt (cdbIndex *idx, unsigned int addr)
+{
+  unsigned int lo = 0, hi = idx->nlines, mid;
+
+  while (lo < hi)
+    {
+      mid = (lo + hi) / 2;
+      if (getU32 (idx->lines + 8 * mid) < addr)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+  return lo;
+}
+
+unsigned int
+cdbIndexLineAddr (cdbIndex *idx, unsigned int i)
+{
+  return getU32 (idx->lines + 8 * i);
+}
+
+unsigned int
+cdbIndexLineRec (cdbIndex *idx, unsigned int i)
+{
+  return getU32 (idx->lines + 8 * i + 4);
+}
@@ -0,0 +1,83 @@
+/*-------------------------------------------------------------------------
+  cdbIndex - indexed binary form of the .cdb debug information
+
+   This program is free software; you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by the
+   Free Software Foundation; either version 2, or (at your option) any
+   later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+   In other words, you are welcome to use, share and improve this program.
+   You are forbidden to forbid anyone else to use, share and improve
+   what you give them.   Help stamp out software-hoarding!
+-------------------------------------------------------------------------*/
+
+#ifndef CDBINDEX_H
+#define CDBINDEX_H
+
+#include <stddef.h>
+
+/* The .cdx file sits next to the .cdb it was made from and holds the
+   same records, so a debugger can map it instead of parsing text:
+
+     header     CDX_HEADER_SIZE bytes, see CDX_* offsets below
+     records    nrecs string offsets, record i is "<type>:<text>"
+     buckets    nbuckets record numbers + 1 (0 is empty), hashed on the
+                mangled name of S:, F: and symbol L: records
+     chain      nrecs record numbers + 1, next record of the same bucket
+     lines      nlines (address, record) pairs of L:A and L:C records,
+                sorted by address
+     strings    NUL terminated record texts
+
+   All numbers are 32 bit little endian. Size and modification time of
+   the .cdb are kept in the header, the index is made again if they
+   don't match. */
+
+#define CDX_MAGIC       "SCDX"
+#define CDX_VERSION     1
+
+#define CDX_HEADER_SIZE 40
+#define CDX_VERS_OFS    4
+#define CDX_SIZE_OFS    8       /* size of the .cdb */
+#define CDX_MTIME_OFS   12      /* modification time of the .cdb */
+#define CDX_NRECS_OFS   16
+#define CDX_NBUCKETS_OFS 20
+#define CDX_NLINES_OFS  24
+#define CDX_STRSIZE_OFS 28
+#define CDX_FSIZE_OFS   32      /* size of the whole .cdx */
+
+typedef struct cdbIndex
+{
+  unsigned char *base;          /* the whole index */
+  size_t size;
+  int mapped;                   /* base is mmap()-ed, not malloc()-ed */
+  unsigned int nrecs;
+  unsigned int nbuckets;
+  unsigned int nlines;
+  unsigned char *recs;
+  unsigned char *buckets;
+  unsigned char *chain;
+  unsigned char *lines;
+  char *strings;
+} cdbIndex;
+
+unsigned int cdbIndexHash (const char *s, size_t len);
+int cdbIndexWrite (const char *cdbName, const char *cdxName);
+cdbIndex *cdbIndexOpen (const char *cdbName, const char *cdxName);
+void cdbIndexClose (cdbIndex *idx);
+
+char *cdbIndexRecord (cdbIndex *idx, unsigned int rec);
+int cdbIndexFind (cdbIndex *idx, const char *name, int prev);
+int cdbIndexLineAt (cdbIndex *idx, unsigned int addr);
+unsigned int cdbIndexLineAddr (cdbIndex *idx, unsigned int i);
+unsigned int cdbIndexLineRec (cdbIndex *idx, unsigned int i);
+
+#endif
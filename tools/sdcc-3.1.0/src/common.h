@@ -52,6 +52,7 @@
 #include "SDCCdebug.h"
 #include "SDCCutil.h"
 #include "SDCCasm.h"
+#include "SDCCtime.h"
 
 #include "port.h"
 
@@ -56,6 +56,8 @@ static struct {
     set *inOutSet;
     bitVect *rUsedVect;
     iCode *current_iCode;
+    int lblKey;                 /* next code label of the function */
+    int lblEnd;
 } _G;
 
 
@@ -97,6 +99,16 @@ static lineNode *lineCurr = NULL;
 static int recvCnt = 0;
 short initGen = 0;
 
+/* helper flags in the bit order of pblaze_usedHelpers() */
+static short *const helperFlags[] = {
+    &_GFunc.mschar, &_GFunc.muschar, &_GFunc.mint, &_GFunc.mlong,
+    &_GFunc.dschar, &_GFunc.duschar, &_GFunc.modschar, &_GFunc.moduschar,
+    &_GFunc.dsint, &_GFunc.dusint, &_GFunc.modsint, &_GFunc.modusint,
+    &_GFunc.dslong, &_GFunc.duslong, &_GFunc.modslong, &_GFunc.moduslong
+};
+
+#define HELPER_COUNT (sizeof(helperFlags) / sizeof(helperFlags[0]))
+
 /*-----------------------------------------------------------------*/
 /* pblaze_emitcode - writes the code into a file                   */
 /*-----------------------------------------------------------------*/
@@ -128,6 +140,50 @@ static void pblaze_emitcode(char *inst, char *fmt, ...)
     va_end(ap);
 }
 
+/*-----------------------------------------------------------------*/
+/* newCodeLabel - returns a new label from the range of the        */
+/*                function, so the keys don't depend on the others */
+/*-----------------------------------------------------------------*/
+static symbol *newCodeLabel(void)
+{
+    symbol *lbl;
+
+    if (_G.lblKey >= _G.lblEnd)
+        werror(E_INTERNAL_ERROR, __FILE__, __LINE__, "out of code labels");
+
+    lbl = newSymbol("", 1);
+    lbl->isitmp = 1;
+    lbl->islbl = 1;
+    lbl->key = _G.lblKey++;
+    return lbl;
+}
+
+/*-----------------------------------------------------------------*/
+/* pblaze_usedHelpers - multiply/divide helpers used so far as bits */
+/*-----------------------------------------------------------------*/
+unsigned long pblaze_usedHelpers(void)
+{
+    unsigned long h = 0;
+    unsigned i;
+
+    for (i = 0; i < HELPER_COUNT; i++)
+        if (*helperFlags[i])
+            h |= 1UL << i;
+    return h;
+}
+
+/*-----------------------------------------------------------------*/
+/* pblaze_addHelpers - marks helpers used by an other process      */
+/*-----------------------------------------------------------------*/
+void pblaze_addHelpers(unsigned long h)
+{
+    unsigned i;
+
+    for (i = 0; i < HELPER_COUNT; i++)
+        if (h & (1UL << i))
+            *helperFlags[i] = 1;
+}
+
 /*-----------------------------------------------------------------*/
 /* dialectNum-convert a number to a string with the correct dialect */
 /*-----------------------------------------------------------------*/
@@ -849,7 +905,7 @@ static void genNot(iCode * ic)
     reg_info *r;
     D(pblaze_emitcode(";", "genNot"));
 
-    symbol *lbl = newiTempLabel(NULL);
+    symbol *lbl = newCodeLabel();
 
     result = IC_RESULT(ic);
     left = IC_LEFT(ic);
@@ -1293,14 +1349,8 @@ static void genFunction(iCode * ic)
       setRegUsed(i);
     }
     
-    /* is an interrupt function */
+    /* is an interrupt function, pblaze_interrupt is set by the caller */
     if (IFFUNC_ISISR(sym->type)) {
-
-        if (!pblaze_interrupt)
-            pblaze_interrupt = sym;
-        else if (FUNC_INTNO(sym->type) > FUNC_INTNO(pblaze_interrupt->type))
-            pblaze_interrupt = sym;
-
         _G.isCalleSaves = 1;
     }
 
@@ -1716,7 +1766,7 @@ static void genSignCmp(iCode * ic, operand * left, operand * right, operand * re
     /* next operation is IFX */
     if (ifx) {
         
-        lble = newiTempLabel(NULL);
+        lble = newCodeLabel();
     
         /* right operand is a literal value */
         if (isOperandLiteral(right)) {
@@ -1819,7 +1869,7 @@ static void genSignCmp(iCode * ic, operand * left, operand * right, operand * re
             reg = getReg(ic);
             lockReg(reg);
             
-            lblo = newiTempLabel(NULL);
+            lblo = newCodeLabel();
             
             /* true label will be generated */
             if (IC_TRUE(ifx)) {
@@ -1886,8 +1936,8 @@ static void genSignCmp(iCode * ic, operand * left, operand * right, operand * re
 
             lit = ulFromVal(aop_lit);
             
-            lblo = newiTempLabel(NULL);
-            lble = newiTempLabel(NULL);
+            lblo = newCodeLabel();
+            lble = newCodeLabel();
             
             /* right side is a literal value */
             if (isOperandLiteral(right)) {
@@ -1955,9 +2005,9 @@ static void genSignCmp(iCode * ic, operand * left, operand * right, operand * re
 
             aopUpdateOpInMem(ic, result, 0);
         } else {;         
-            lblo = newiTempLabel(NULL);
-            lble = newiTempLabel(NULL);
-            lblns = newiTempLabel(NULL);
+            lblo = newCodeLabel();
+            lble = newCodeLabel();
+            lblns = newCodeLabel();
             
             /* right side is a literal value */
             if (isOperandLiteral(right)) {
@@ -2103,7 +2153,7 @@ static void genCmp(iCode * ic, operand * left, operand * right, operand * result
 
             /* false label will be generated */
             else {
-                lble = newiTempLabel(NULL);
+                lble = newCodeLabel();
 
                 while (size--) {
                     pblaze_emitcodeCompare(aopGetRegName(ic, left, size), dialectNum(valueOffset(lit, size)));
@@ -2134,7 +2184,7 @@ static void genCmp(iCode * ic, operand * left, operand * right, operand * result
 
             /* false label will be generated */
             else {
-                lble = newiTempLabel(NULL);
+                lble = newCodeLabel();
 
                 while (size--) {
                     pblaze_emitcode("LOAD", "%s, %s", reg->name, dialectNum(valueOffset(lit, size)));
@@ -2160,7 +2210,7 @@ static void genCmp(iCode * ic, operand * left, operand * right, operand * result
             }
             /* false label will be generated */
             else {
-                lble = newiTempLabel(NULL);
+                lble = newCodeLabel();
 
                 while (size--) {
                     pblaze_emitcodeCompare(aopGetRegName(ic, left, size), aopGetRegName(ic, right, size));
@@ -2210,8 +2260,8 @@ static void genCmp(iCode * ic, operand * left, operand * right, operand * result
             /* right side is a literal value */
             if (isOperandLiteral(right)) {
 
-                lblo = newiTempLabel(NULL);
-                lble = newiTempLabel(NULL);
+                lblo = newCodeLabel();
+                lble = newCodeLabel();
 
                 /* get value and size */
                 lit = ulFromVal(OP_VALUE(right));
@@ -2230,8 +2280,8 @@ static void genCmp(iCode * ic, operand * left, operand * right, operand * result
             /* left side is a literal value */
             else if (isOperandLiteral(left)) {
                 reg_info *reg;
-                lblo = newiTempLabel(NULL);
-                lble = newiTempLabel(NULL);
+                lblo = newCodeLabel();
+                lble = newCodeLabel();
                 aop_lit = OP_VALUE(left);
                 reg = getReg(ic);
                 lockReg(reg);
@@ -2253,8 +2303,8 @@ static void genCmp(iCode * ic, operand * left, operand * right, operand * result
 
 
             } else {
-                lblo = newiTempLabel(NULL);
-                lble = newiTempLabel(NULL);
+                lblo = newCodeLabel();
+                lble = newCodeLabel();
 
                 while (size--) {
                     pblaze_emitcodeCompare(aopGetRegName(ic, left, size), aopGetRegName(ic, right, size));
@@ -2334,7 +2384,7 @@ static void genCmpEq(iCode * ic, iCode * ifx)
         /* true label exists */
         if (IC_TRUE(ifx)) {
 
-            symbol *lblfl = newiTempLabel(NULL);
+            symbol *lblfl = newCodeLabel();
             /* right operand is a literal */
             if (isOperandLiteral(right)) {
                 unsigned long lit = ulFromVal(OP_VALUE(right));
@@ -2392,7 +2442,7 @@ static void genCmpEq(iCode * ic, iCode * ifx)
 
     /* next operation is not IFX */
     else {
-        symbol *lblfl = newiTempLabel(NULL);
+        symbol *lblfl = newCodeLabel();
 
         /* right operand is a literal */
         if (isOperandLiteral(right)) {
@@ -2459,7 +2509,7 @@ static void genAndOp(iCode * ic)
     right = IC_RIGHT(ic);
     result = IC_RESULT(ic);
 
-    tlbl = newiTempLabel(NULL);
+    tlbl = newCodeLabel();
 
     /* only for size == 0 */
     aopPutVal(ic, result, dialectNum(0), 0);
@@ -2493,7 +2543,7 @@ static void genOrOp(iCode * ic)
     result = IC_RESULT(ic);
     /* only size == 0 */
 
-    tlbl = newiTempLabel(NULL);
+    tlbl = newCodeLabel();
 
     pblaze_emitcode("XOR", "%s, %s", aopGetRegName(ic, result, 0), dialectNum(1));
     aopUpdateOpInMem(ic, result, 0);
@@ -3074,8 +3124,8 @@ static void genLeftShift(iCode * ic)
     }
 
 
-    elbl = newiTempLabel(NULL);
-    slbl = newiTempLabel(NULL);
+    elbl = newCodeLabel();
+    slbl = newCodeLabel();
 
     pblaze_emitLabelC(slbl);
 
@@ -3346,8 +3396,8 @@ static void genRightShift(iCode * ic)
     }
 
 
-    elbl = newiTempLabel(NULL);
-    slbl = newiTempLabel(NULL);
+    elbl = newCodeLabel();
+    slbl = newCodeLabel();
 
     pblaze_emitLabelC(slbl);
 
@@ -3384,7 +3434,7 @@ static void genIfx(iCode * ic, iCode * popIc)
 
     D(pblaze_emitcode(";", "genIFX"));
 
-    lbl = newiTempLabel(NULL);
+    lbl = newCodeLabel();
 
     reg = toBoolean(ic, cond);
     pblaze_emitcodeCompare(reg->name, dialectNum(0));
@@ -3802,37 +3852,33 @@ static void genDummyRead(iCode * ic)
 /*-----------------------------------------------------------------*/
 /* genPBLAZECode - generate code for XILINX PicoBlaze controllers  */
 /*-----------------------------------------------------------------*/
-void genPBLAZECode(iCode * lic)
+void genPBLAZECode(pblaze_funcCode * fc)
 {
     iCode *ic;
+    iCode *lic = fc->ic;
     int cln = 0;
+    int i;
     lineHead = lineCurr = NULL;
     deleteSet(&_G.inOutSet);
 
+    /* _GFunc collects the helpers of the whole file, in the workers of
+       pblaze_genCodeLoop() too, so it is not cleared here */
     if (!initGen) {
         _G.rUsedVect = newBitVect(pblaze_nRegs);
-        clearBitVect(_G.rUsedVect);
-        _G.isCalleSaves = 0;
-        _G.onStack = 0;
-        _GFunc.mschar = 0;
-        _GFunc.muschar = 0;
-        _GFunc.mint = 0;
-        _GFunc.mlong = 0;
-        _GFunc.dschar = 0;
-        _GFunc.duschar = 0;
-        _GFunc.modschar = 0;
-        _GFunc.moduschar = 0;
-        _GFunc.dsint = 0;
-        _GFunc.dusint = 0;
-        _GFunc.modsint = 0;
-        _GFunc.modusint = 0;
-        _GFunc.dslong = 0;
-        _GFunc.duslong = 0;
-        _GFunc.modslong = 0;
-        _GFunc.moduslong = 0;
         initGen = 1;
     }
 
+    /* nothing is carried over from the previous function, except the
+       registers it left marked used */
+    clearBitVect(_G.rUsedVect);
+    if (fc->regsUsed)
+        for (i = 0; i <= pblaze_nRegs; i++)
+            setRegUsed(i);
+    _G.isCalleSaves = 0;
+    _G.onStack = 0;
+    _G.sendSet = NULL;
+    _G.lblKey = fc->lblKey;
+    _G.lblEnd = fc->lblEnd;
     recvCnt = 0;
 
     /* print the allocation information */
@@ -4048,6 +4094,6 @@ void genPBLAZECode(iCode * lic)
 
 
     /* now do the actual printing */
-    printLine(lineHead, codeOutBuf);
+    printLine(lineHead, &fc->oBuf);
     return;
 }
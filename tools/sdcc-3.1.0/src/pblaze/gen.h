@@ -96,9 +96,23 @@ typedef struct inOutStruct {
     operand *regOffset;         /* port address given as an indirect operand */
 } inOutStruct_t;
 
+/* code generation state of one function, see pblaze_genCodeLoop() */
+typedef struct pblaze_funcCode {
+    iCode *ic;                  /* iCode chain of the function */
+    int lblKey;                 /* first key of its code labels */
+    int lblEnd;                 /* end of the key range */
+    short regsUsed;             /* registers are marked used on entry */
+    struct dbuf_s oBuf;         /* generated code */
+} pblaze_funcCode;
+
+/* code labels reserved for one iCode */
+#define PBLAZE_LBL_PER_IC 4
+
 void testOp(operand * oper);
 
-void genPBLAZECode(iCode *);
+void genPBLAZECode(pblaze_funcCode * fc);
+unsigned long pblaze_usedHelpers(void);
+void pblaze_addHelpers(unsigned long h);
 void pblaze_emitDebuggerSymbol(const char *);
 bool pblaze_operandsEqu(operand * op1, operand * op2);
 int isOpVolatile(operand * oper);
@@ -42,6 +42,7 @@ static char _defaultRules[] = {
 #define DIALECT_OPT           "--dialect="
 #define PORTKW_OPT           "--portkw="
 #define ACKNOWLEDGEMENT_OPT   "--acknowledgement"
+#define JOBS_OPT             "--jobs"
 
 symbol *pblaze_interrupt;
 pblaze_options_t pblaze_options;
@@ -51,6 +52,8 @@ OPTION pblaze_optionsTable[] = {
      "(kcpsm3 or pblazeide) selects the assembler dialect for the chosen target platform (see argument --target) as there are some minor differences between the PicoBlaze-3 Assembler for HDL/HEX production (KCPSM3) and for the simulation (pBlazeIDE). (Default: pblazeide)"},
     {0, PORTKW_OPT, &pblaze_options.portKw,
      "set proper keyword used for INPUT/OUTPUT operations (default: PBLAZEPORT)"},
+    {0, JOBS_OPT, &pblaze_options.jobs,
+     "<num> generate the code of the functions in <num> parallel processes (default: 1)", CLAT_INTEGER},
     {0, ACKNOWLEDGEMENT_OPT, NULL,
      "The development of this pblaze-port was supported by the Czech Ministry of Education, Youth and Sports grant 2C06008 Virtual Laboratory of Microprocessor Technology Application (visit the website http://www.vlam.cz)."},
     {0, NULL, NULL, NULL}
@@ -170,6 +173,7 @@ static void _pblaze_setDefaultOptions(void)
 {
     pblaze_options.dialect = 1;
     pblaze_options.portKw = "PBLAZEPORT";
+    pblaze_options.jobs = 1;
     options.stackAuto = 1;
 }
 
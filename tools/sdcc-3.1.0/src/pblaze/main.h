@@ -37,6 +37,7 @@ void x_finaliseOptions(void);
 typedef struct {
     int dialect;
     char *portKw;
+    int jobs;
 } pblaze_options_t;
 
 extern symbol *pblaze_interrupt;
@@ -31,6 +31,13 @@ what you give them.   Help stamp out software-hoarding!
 #include "ralloc.h"
 #include "gen.h"
 
+#ifndef _WIN32
+#include <errno.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#endif
+
 //#define SYMBOL_IN_REG(reg)      validateOpType(reg->currOper, "OP_SYMBOL", #op, SYMBOL, __FILE__, __LINE__)->operand.symOperand
 #define SYMBOL_IN_REG(reg)  OP_SYMBOL(reg.currOper)
 #define RCV ic->op == RECEIVE
@@ -58,7 +65,6 @@ what you give them.   Help stamp out software-hoarding!
                         x->op == ENDCRITICAL  ||    \
 			x->op == ENDFUNCTION  )
 
-extern void genPBLAZECode(iCode *);
 extern unsigned fPBLAZEReturnSize;
 extern void emitStore(char *r, int mem);
 extern void emitFetch(char *r, int mem);
@@ -107,6 +113,10 @@ int ctr = 0;
 
 memMap memPBLAZE[MEMSIZE];
 
+/* allocation state every function starts from, see saveAllocState() */
+static memMap memInit[MEMSIZE];
+static reg_info regsInit[PBLAZENREGS];
+
 
 void printRegs(void)
 {
@@ -991,6 +1001,29 @@ int isUsedInCurrentInstr(iCode * ic, operand * op)
     return res;
 }
 
+/*-----------------------------------------------------------------*/
+/* regsUsedAfter - is any register in rUse holding an operand that */
+/*                 may be used after the iCode seq                 */
+/*-----------------------------------------------------------------*/
+static int regsUsedAfter(bitVect * rUse, int seq)
+{
+    operand *op;
+    int i;
+
+    for (i = pblaze_fReg; i < pblaze_nRegs; i++) {
+        if (!bitVectBitValue(rUse, i))
+            continue;
+
+        // only the live intervals of a temporary tell where it is used
+        op = regsPBLAZE[i].currOper;
+        if (!IS_ITEMP(op) || OP_SYMBOL(op)->isspilt || !OP_SYMBOL(op)->liveIntervals ||
+            lrNextLive(OP_SYMBOL(op), seq + 1))
+            return 1;
+    }
+
+    return 0;
+}
+
 /*-----------------------------------------------------------------*/
 /* spillRegsIntoMem - move LRU operand into memory                */
 /*-----------------------------------------------------------------*/
@@ -1050,6 +1083,10 @@ int spillRegsIntoMem(iCode * lic, operand * op, int offset, int free)
 
         if (remainOp == free)
             break;
+
+        // the rest of the function can't pick any other register
+        if (!regsUsedAfter(rUse, ic->seq))
+            break;
     }
 
     // try to move global variable first
@@ -1765,48 +1802,352 @@ static void findIndirectOperands(iCode * lic)
 }
 
 /*-----------------------------------------------------------------*/
-/* pblaze_genCodeLoop                                              */
+/* saveAllocState - remembers the memory and registers once the    */
+/*                  globals are placed                             */
 /*-----------------------------------------------------------------*/
-void pblaze_genCodeLoop(void)
+static void saveAllocState(void)
+{
+    memcpy(memInit, memPBLAZE, sizeof(memInit));
+    memcpy(regsInit, regsPBLAZE, sizeof(regsInit));
+}
+
+/*-----------------------------------------------------------------*/
+/* restoreAllocState - every function starts from the same state,  */
+/*                     so they can be generated in any order       */
+/*-----------------------------------------------------------------*/
+static void restoreAllocState(void)
+{
+    int i, j;
+
+    memcpy(memPBLAZE, memInit, sizeof(memInit));
+    memcpy(regsPBLAZE, regsInit, sizeof(regsInit));
+    ctr = 0;
+
+    /* the globals are in the memory, not in a register of an other function */
+    for (i = 0; i < MEMSIZE; i++)
+        if (memInit[i].currOper && IS_SYMOP(memInit[i].currOper))
+            for (j = 0; j < 4; j++)
+                OP_SYMBOL(memInit[i].currOper)->regs[j] = NULL;
+}
+
+/*-----------------------------------------------------------------*/
+/* selectInterrupt - the interrupt routine with the highest number */
+/*                   becomes the interrupt vector                  */
+/*-----------------------------------------------------------------*/
+static void selectInterrupt(iCode * lic)
 {
-    ebbIndex *ebbi;
-    eBBlock **ebbs;
-    int count;
     iCode *ic;
+    symbol *sym;
 
-    _G_glueCalled = 1;
-    pblaze_interrupt = NULL;
+    for (ic = lic; ic; ic = ic->next) {
+        if (ic->op != FUNCTION)
+            continue;
+
+        sym = OP_SYMBOL(IC_LEFT(ic));
+        if (IFFUNC_ISISR(sym->type) &&
+            (!pblaze_interrupt || FUNC_INTNO(sym->type) > FUNC_INTNO(pblaze_interrupt->type)))
+            pblaze_interrupt = sym;
+        return;
+    }
+}
+
+/*-----------------------------------------------------------------*/
+/* leavesRegsUsed - genEndFunction clears the used registers only  */
+/*                  for interrupt and callee saves functions       */
+/*-----------------------------------------------------------------*/
+static int leavesRegsUsed(iCode * lic, int used)
+{
+    iCode *ic;
+    symbol *sym;
+
+    for (ic = lic; ic; ic = ic->next) {
+        if (ic->op != FUNCTION)
+            continue;
+
+        sym = OP_SYMBOL(IC_LEFT(ic));
+        return !(IFFUNC_ISISR(sym->type) || IFFUNC_CALLEESAVES(sym->type));
+    }
+    return used;
+}
+
+/*-----------------------------------------------------------------*/
+/* funcName - name of the function starting the chain, for timing  */
+/*-----------------------------------------------------------------*/
+static const char *funcName(iCode * lic)
+{
+    iCode *ic;
+
+    for (ic = lic; ic; ic = ic->next) {
+        if (ic->op == FUNCTION)
+            return OP_SYMBOL(IC_LEFT(ic))->name;
+    }
+    return "";
+}
+
+/*-----------------------------------------------------------------*/
+/* genFuncCode - generates one function into its own buffer        */
+/*-----------------------------------------------------------------*/
+static void genFuncCode(pblaze_funcCode * fc)
+{
+    /* the function was left after its iCodes, here it is continued */
+    timeFunctionBegin(funcName(fc->ic));
+    timePassBegin(TIME_RALLOC);
+
+    restoreAllocState();
+    setToNull((void *) &_G.funcrUsed);
+
+    findIndirectOperands(fc->ic);
+
+    genPBLAZECode(fc);
+    resetRegs();
+
+    timePassEnd(TIME_RALLOC);
+    timeFunctionEnd();
+}
 
-    if (_G_codeSet) {
+#ifndef _WIN32
+/*-----------------------------------------------------------------*/
+/* writeAll/readAll - pipe transfers of the worker processes       */
+/*-----------------------------------------------------------------*/
+static int writeAll(int fd, const void *buf, size_t len)
+{
+    const char *p = buf;
+    ssize_t n;
+
+    while (len) {
+        n = write(fd, p, len);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return 0;
+        p += n;
+        len -= n;
+    }
+    return 1;
+}
+
+static int readAll(int fd, void *buf, size_t len)
+{
+    char *p = buf;
+    ssize_t n;
+
+    while (len) {
+        n = read(fd, p, len);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return 0;
+        p += n;
+        len -= n;
+    }
+    return 1;
+}
+
+/*-----------------------------------------------------------------*/
+/* genWorker - child process: generates every jobs-th function     */
+/*             and sends the code back as (index, length, text)    */
+/*             records, then the helpers used, the error count and */
+/*             what was timed for --time-passes                    */
+/*-----------------------------------------------------------------*/
+static void genWorker(pblaze_funcCode * funcs, int nFuncs, int jobs, int w, int fd)
+{
+    int i, len;
+    unsigned long helpers;
+    struct dbuf_s times;
+    int ok = 1;
+
+    timeChildBegin();
+
+    for (i = w; i < nFuncs && ok; i += jobs) {
+        genFuncCode(&funcs[i]);
+        len = dbuf_get_length(&funcs[i].oBuf);
+        ok = writeAll(fd, &i, sizeof(i)) && writeAll(fd, &len, sizeof(len)) &&
+            writeAll(fd, dbuf_get_buf(&funcs[i].oBuf), len);
+    }
+
+    i = -1;
+    helpers = pblaze_usedHelpers();
+    dbuf_init(&times, 1024);
+    timeChildSave(&times);
+    len = dbuf_get_length(&times);
+    ok = ok && writeAll(fd, &i, sizeof(i)) && writeAll(fd, &helpers, sizeof(helpers)) &&
+        writeAll(fd, &fatalError, sizeof(fatalError)) && writeAll(fd, &len, sizeof(len)) &&
+        writeAll(fd, dbuf_get_buf(&times), len);
+
+    fflush(stdout);
+    fflush(stderr);
+    _exit(ok ? 0 : 1);
+}
+
+/*-----------------------------------------------------------------*/
+/* genCodeParallel - generates the functions in worker processes,  */
+/*                   returns 0 if they could not be started        */
+/*-----------------------------------------------------------------*/
+static int genCodeParallel(pblaze_funcCode * funcs, int nFuncs, int jobs)
+{
+    pid_t *pids;
+    int *fds;
+    int p[2];
+    int w, i, len, errors, status;
+    unsigned long helpers;
+    int ok = 1;
+    int exited = -1;
+
+    pids = Safe_calloc(jobs, sizeof(pid_t));
+    fds = Safe_calloc(jobs, sizeof(int));
+
+    fflush(stdout);
+    fflush(stderr);
+
+    for (w = 0; w < jobs; w++) {
+        if (pipe(p) < 0)
+            break;
 
-        // optimalization phase
-        for (ebbi = setFirstItem(_G_codeSet); ebbi; ebbi = setNextItem(_G_codeSet)) {
-            ebbs = ebbi->bbOrder;
-            count = ebbi->count;
+        pids[w] = fork();
+        if (pids[w] == 0) {
+            close(p[0]);
+            genWorker(funcs, nFuncs, jobs, w, p[1]);
+        }
 
-            /* now get back the chain */
-            //ic = iCodeLabelOptimize (iCodeFromeBBlock (ebbs, count));
-            ic = iCodeFromeBBlock(ebbs, count);
-            findAndAllocGlobals(ic);
+        close(p[1]);
+        if (pids[w] < 0) {
+            close(p[0]);
+            break;
         }
+        fds[w] = p[0];
+    }
 
-        // code generation phase
-        for (ebbi = setFirstItem(_G_codeSet); ebbi; ebbi = setNextItem(_G_codeSet)) {
-            ebbs = ebbi->bbOrder;
-            count = ebbi->count;
+    if (w < jobs) {
+        /* no partial runs, the workers started are thrown away */
+        while (w--) {
+            close(fds[w]);
+            waitpid(pids[w], &status, 0);
+        }
+        Safe_free(pids);
+        Safe_free(fds);
+        return 0;
+    }
 
-            setToNull((void *) &_G.funcrUsed);
-            /* now get back the chain */
-            ic = iCodeFromeBBlock(ebbs, count);
+    for (w = 0; w < jobs; w++) {
+        int done = 0;
 
-            findIndirectOperands(ic);
-            //resetRegs ();
+        while (readAll(fds[w], &i, sizeof(i))) {
+            if (i < 0) {
+                if (readAll(fds[w], &helpers, sizeof(helpers)) && readAll(fds[w], &errors, sizeof(errors)) &&
+                    readAll(fds[w], &len, sizeof(len))) {
+                    pblaze_addHelpers(helpers);
+                    fatalError += errors;
+                    done = 1;
+                    if (len > 0) {
+                        char *times = Safe_alloc(len);
 
-            genPBLAZECode(ic);
-            resetRegs();
+                        if (readAll(fds[w], times, len))
+                            timeChildMerge(times, len, w);
+                        Safe_free(times);
+                    }
+                }
+                break;
+            }
+            if (i >= nFuncs || !readAll(fds[w], &len, sizeof(len)))
+                break;
+            dbuf_set_length(&funcs[i].oBuf, 0);
+            if (len > 0) {
+                char *text = Safe_alloc(len);
+                int got = readAll(fds[w], text, len);
+
+                dbuf_append(&funcs[i].oBuf, text, len);
+                Safe_free(text);
+                if (!got)
+                    break;
+            }
         }
+        close(fds[w]);
+        if (waitpid(pids[w], &status, 0) < 0 || !WIFEXITED(status))
+            ok = 0;
+        else if (!done && exited < 0)
+            /* it called exit() itself, see staticMemoryCheck() */
+            exited = WEXITSTATUS(status);
+        else if (WEXITSTATUS(status))
+            ok = 0;
+    }
+
+    Safe_free(pids);
+    Safe_free(fds);
+
+    if (!ok)
+        werror(E_INTERNAL_ERROR, __FILE__, __LINE__, "code generator process failed");
+    /* stop the same way as the serial run would have stopped */
+    if (exited >= 0)
+        exit(exited);
+    return 1;
+}
+#endif
+
+/*-----------------------------------------------------------------*/
+/* pblaze_genCodeLoop - generates all the functions at once, in    */
+/*                      --jobs processes if asked for              */
+/*-----------------------------------------------------------------*/
+void pblaze_genCodeLoop(void)
+{
+    ebbIndex *ebbi;
+    pblaze_funcCode *funcs;
+    iCode *ic;
+    int nFuncs, i, n, jobs;
+    int used = 0;
+    int done = 0;
+
+    _G_glueCalled = 1;
+    pblaze_interrupt = NULL;
+
+    if (!_G_codeSet) {
+        saveAllocState();
+        return;
     }
 
+    nFuncs = elementsInSet(_G_codeSet);
+    funcs = Safe_calloc(nFuncs, sizeof(pblaze_funcCode));
+
+    // optimalization phase
+    for (i = 0, ebbi = setFirstItem(_G_codeSet); ebbi; i++, ebbi = setNextItem(_G_codeSet)) {
+        /* now get back the chain */
+        //ic = iCodeLabelOptimize (iCodeFromeBBlock (ebbs, count));
+        funcs[i].ic = iCodeFromeBBlock(ebbi->bbOrder, ebbi->count);
+        findAndAllocGlobals(funcs[i].ic);
+    }
+    saveAllocState();
+
+    /* everything a function takes from the ones before it is known
+       before the code is generated */
+    for (i = 0; i < nFuncs; i++) {
+        for (n = 0, ic = funcs[i].ic; ic; ic = ic->next)
+            n++;
+        funcs[i].lblKey = labelKey;
+        labelKey += PBLAZE_LBL_PER_IC * n;
+        funcs[i].lblEnd = labelKey;
+        funcs[i].regsUsed = used;
+        used = leavesRegsUsed(funcs[i].ic, used);
+        selectInterrupt(funcs[i].ic);
+        dbuf_init(&funcs[i].oBuf, 4096);
+    }
+
+    // code generation phase
+    jobs = pblaze_options.jobs;
+    if (jobs > nFuncs)
+        jobs = nFuncs;
+#ifndef _WIN32
+    /* the debug records are written as the code is generated */
+    if (jobs > 1 && !options.debug)
+        done = genCodeParallel(funcs, nFuncs, jobs);
+#endif
+    if (!done)
+        for (i = 0; i < nFuncs; i++)
+            genFuncCode(&funcs[i]);
+
+    for (i = 0; i < nFuncs; i++) {
+        dbuf_append(codeOutBuf, dbuf_get_buf(&funcs[i].oBuf), dbuf_get_length(&funcs[i].oBuf));
+        dbuf_destroy(&funcs[i].oBuf);
+    }
+    Safe_free(funcs);
 }
 
 
@@ -1833,6 +2174,10 @@ void pblaze_assignRegisters(ebbIndex * ebbi)
     } else {
 
 
+        pblaze_funcCode fc;
+
+        /* same start as the functions, whichever process made them */
+        restoreAllocState();
         setToNull((void *) &_G.funcrUsed);
 
         /* now get back the chain */
@@ -1841,7 +2186,17 @@ void pblaze_assignRegisters(ebbIndex * ebbi)
 
         //findAndAllocGlobals(ic);
 
-        genPBLAZECode(ic);
+        fc.ic = ic;
+        fc.lblKey = labelKey;
+        for (; ic; ic = ic->next)
+            labelKey += PBLAZE_LBL_PER_IC;
+        fc.lblEnd = labelKey;
+        fc.regsUsed = 0;
+        selectInterrupt(fc.ic);
+        dbuf_init(&fc.oBuf, 4096);
+        genPBLAZECode(&fc);
+        dbuf_append(codeOutBuf, dbuf_get_buf(&fc.oBuf), dbuf_get_length(&fc.oBuf));
+        dbuf_destroy(&fc.oBuf);
     }
     return;
 }
@@ -10154,6 +10154,11 @@ genZ80iCode (iCode *ic)
 unsigned char
 dryZ80iCode (iCode *ic)
 {
+  /* code generation may swap the operands; the dry run leaves ic as it is,
+     so that the costs do not depend on the order they are asked for in */
+  operand *const left = IC_LEFT (ic);
+  operand *const right = IC_RIGHT (ic);
+
   regalloc_dry_run = TRUE;
   regalloc_dry_run_cost = 0;
 
@@ -10172,6 +10177,9 @@ dryZ80iCode (iCode *ic)
   _G.lines.head = _G.lines.current = NULL;
   
   genZ80iCode(ic);
+
+  IC_LEFT (ic) = left;
+  IC_RIGHT (ic) = right;
   
   freeTrace(&_G.lines.trace);
   freeTrace(&_G.trace.aops);
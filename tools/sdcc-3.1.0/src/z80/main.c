@@ -41,6 +41,8 @@
 #define OPTION_DUMP_GRAPHS     "--dump-graphs"
 #define OPTION_MAX_ALLOCS_NODE "--max-allocs-per-node"
 #define OPTION_OLDRALLOC       "--oldralloc"
+#define OPTION_JOBS            "--jobs"
+#define OPTION_RALLOC_CACHE    "--ralloc-cache"
 
 static char _z80_defaultRules[] = {
 #include "peeph.rul"
@@ -68,6 +70,8 @@ static OPTION _z80_options[] = {
   {0, OPTION_NO_STD_CRT0,     &options.no_std_crt0, "For the z80/gbz80 do not link default crt0.rel"},
   {0, OPTION_RESERVE_IY,      &z80_opts.reserveIY, "Do not use IY (incompatible with --fomit-frame-pointer)"},
   {0, OPTION_MAX_ALLOCS_NODE, &options.max_allocs_per_node, "Maximum number of register assignments considered at each node of the tree decomposition", CLAT_INTEGER},
+  {0, OPTION_JOBS,            &z80_opts.jobs, "<num> solve independent parts of the register allocation in <num> parallel processes (default: 1)", CLAT_INTEGER},
+  {0, OPTION_RALLOC_CACHE,    &z80_opts.ralloc_cache, "<dir> keep the results of the register allocation of functions in <dir>, reuse them for unchanged functions", CLAT_STRING},
   {0, OPTION_DUMP_GRAPHS,     &z80_opts.dump_graphs, "Dump control flow graph, conflict graph and tree decomposition in register allocator"},
   {0, OPTION_OLDRALLOC,       &z80_opts.oldralloc, "Use old register allocator"},
   {0, NULL}
@@ -81,6 +85,8 @@ static OPTION _gbz80_options[] = {
   {0, OPTION_CONST_SEG,       &options.const_seg, "<name> use this name for the const segment", CLAT_STRING},
   {0, OPTION_NO_STD_CRT0,     &options.no_std_crt0, "For the z80/gbz80 do not link default crt0.rel"},
   {0, OPTION_MAX_ALLOCS_NODE, &options.max_allocs_per_node, "Maximum number of register assignments considered at each node of the tree decomposition", CLAT_INTEGER},
+  {0, OPTION_JOBS, &z80_opts.jobs, "<num> solve independent parts of the register allocation in <num> parallel processes (default: 1)", CLAT_INTEGER},
+  {0, OPTION_RALLOC_CACHE, &z80_opts.ralloc_cache, "<dir> keep the results of the register allocation of functions in <dir>, reuse them for unchanged functions", CLAT_STRING},
   {0, OPTION_DUMP_GRAPHS, &z80_opts.dump_graphs, "Dump control flow graph, conflict graph and tree decomposition in register allocator"},
   {0, NULL}
 };
@@ -634,6 +640,8 @@ _setDefaultOptions (void)
   optimize.loopInvariant = 1;
   optimize.loopInduction = 1;
   z80_opts.dump_graphs = 0;
+  z80_opts.jobs = 1;
+  z80_opts.ralloc_cache = NULL;
 }
 
 /* Mangling format:
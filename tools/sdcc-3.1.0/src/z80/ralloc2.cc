@@ -1200,6 +1200,107 @@ float rough_cost_estimate(const assignment &a, unsigned short int i, const G_t &
   return(c);
 }
 
+// Give the variables the registers from assignment a.
+template <class G_t, class I_t>
+void apply_assignment(const assignment &a, const G_t &G, const I_t &I)
+{
+  for(unsigned int v = 0; v < boost::num_vertices(I); v++)
+    {
+      symbol *sym = (symbol *)(hTabItemWithKey(liveRanges, I[v].v));
+      if(a.global[v] >= 0)
+        {
+          if((a.global[v] != REG_A || !OPTRALLOC_A) && (a.global[v] != REG_IYL && a.global[v] != REG_IYH || !OPTRALLOC_IY))
+            {
+              sym->regs[I[v].byte] = regsZ80 + a.global[v];
+              sym->accuse = 0;
+              sym->isspilt = false;
+              sym->nRegs = I[v].size;
+            }
+          else if(a.global[v] == REG_A)
+            {
+              sym->accuse = ACCUSE_A;
+              sym->isspilt = false;
+              sym->nRegs = 0;
+              sym->regs[0] = 0;
+            }
+          else
+            {
+              sym->accuse = ACCUSE_IY;
+              sym->isspilt = false;
+              sym->nRegs = 0;
+              sym->regs[I[v].byte] = 0;
+            }
+        }
+      else
+        {
+          for(int i = 0; i < I[v].size; i++)
+            sym->regs[i] = 0;
+          sym->accuse = 0;
+          sym->nRegs = I[v].size;
+          //spillThis(sym); Leave it to regFix, which can do some spillocation compaction. Todo: Use Thorup instead.
+          sym->isspilt = false;
+        }
+    }
+    
+  for(unsigned int i = 0; i < boost::num_vertices(G); i++)
+    set_surviving_regs(a, i, G, I);	// Never freed. Memory leak?
+}
+
+// Check that the registers in a, e.g. from the cache, are a valid assignment for all instructions.
+template <class G_t, class I_t>
+bool assignment_valid(assignment &a, const G_t &G, const I_t &I)
+{
+  if(a.global.size() != boost::num_vertices(I))
+    return(false);
+
+  a.local = varset_t();
+  for(unsigned int v = 0; v < boost::num_vertices(I); v++)
+    {
+      if(a.global[v] < -1 || a.global[v] >= NUM_REGS)
+        return(false);
+      if(a.global[v] >= 0)
+        a.local.insert(v);
+    }
+
+  typename boost::graph_traits<I_t>::edge_iterator e, e_end;
+  for(boost::tie(e, e_end) = boost::edges(I); e != e_end; ++e)
+    if(a.global[boost::source(*e, I)] >= 0 && a.global[boost::source(*e, I)] == a.global[boost::target(*e, I)])
+      return(false);
+
+  for(unsigned int i = 0; i < boost::num_vertices(G); i++)
+    {
+      i_assignment_t ia;
+      std::set<var_t>::const_iterator v, v_end;
+      for(v = G[i].alive.begin(), v_end = G[i].alive.end(); v != v_end; ++v)
+        if(a.global[*v] >= 0)
+          ia.add_var(*v, a.global[*v]);
+      a.i_assignment = ia;
+
+      if(assignment_hopeless(a, i, G, I, -1) || !inst_sane(a, i, G, I) ||
+        OPTRALLOC_HL && !HLinst_ok(a, i, G, I) || OPTRALLOC_IY && !IYinst_ok(a, i, G, I))
+        return(false);
+    }
+
+  return(true);
+}
+
+// The port-specific part of the description of a function for the cache: Everything the allocator depends on besides the function itself.
+static std::string ralloc_cache_prefix(void)
+{
+  std::ostringstream p;
+  struct dbuf_s type;
+
+  dbuf_init(&type, 64);
+  dbuf_printTypeChain(currFunc->type, &type);
+  p << SDCC_VERSION_STR << " #" << getBuildNumber() << " " << port->target << " " << z80_opts.sub << " " << NUM_REGS <<
+    " calleesavesbc " << z80_opts.calleeSavesBC << " reserveiy " << z80_opts.reserveIY <<
+    " allocs " << options.max_allocs_per_node << " opt " << optimize.codeSize << optimize.codeSpeed <<
+    " omitfp " << options.omitFramePtr << " stack " << currFunc->stack << " " << dbuf_c_str(&type);
+  dbuf_destroy(&type);
+
+  return(p.str());
+}
+
 template <class T_t, class G_t, class I_t>
 void tree_dec_ralloc(T_t &T, const G_t &G, const I_t &I)
 {
@@ -1217,7 +1318,7 @@ void tree_dec_ralloc(T_t &T, const G_t &G, const I_t &I)
 
   assignment ac;
   assignment_optimal = true;
-  tree_dec_ralloc_nodes(T, find_root(T), G, I2, ac);
+  tree_dec_ralloc_nodes_parallel(T, find_root(T), G, I2, ac, z80_opts.jobs);
 
   const assignment &winner = *(T[find_root(T)].assignments.begin());
 
@@ -1239,46 +1340,7 @@ void tree_dec_ralloc(T_t &T, const G_t &G, const I_t &I)
       exit(-1);
     }
 
-  for(unsigned int v = 0; v < boost::num_vertices(I); v++)
-    {
-      symbol *sym = (symbol *)(hTabItemWithKey(liveRanges, I[v].v));
-      if(winner.global[v] >= 0)
-        {
-          if((winner.global[v] != REG_A || !OPTRALLOC_A) && (winner.global[v] != REG_IYL && winner.global[v] != REG_IYH || !OPTRALLOC_IY))
-            {
-              sym->regs[I[v].byte] = regsZ80 + winner.global[v];
-              sym->accuse = 0;
-              sym->isspilt = false;
-              sym->nRegs = I[v].size;
-            }
-          else if(winner.global[v] == REG_A)
-            {
-              sym->accuse = ACCUSE_A;
-              sym->isspilt = false;
-              sym->nRegs = 0;
-              sym->regs[0] = 0;
-            }
-          else
-            {
-              sym->accuse = ACCUSE_IY;
-              sym->isspilt = false;
-              sym->nRegs = 0;
-              sym->regs[I[v].byte] = 0;
-            }
-        }
-      else
-        {
-          for(int i = 0; i < I[v].size; i++)
-            sym->regs[i] = 0;
-          sym->accuse = 0;
-          sym->nRegs = I[v].size;
-          //spillThis(sym); Leave it to regFix, which can do some spillocation compaction. Todo: Use Thorup instead.
-          sym->isspilt = false;
-        }
-    }
-    
-  for(unsigned int i = 0; i < boost::num_vertices(G); i++)
-    set_surviving_regs(winner, i, G, I);	// Never freed. Memory leak?
+  apply_assignment(winner, G, I);
 }
 
 iCode *z80_ralloc2_cc(ebbIndex *ebbi)
@@ -1301,9 +1363,32 @@ iCode *z80_ralloc2_cc(ebbIndex *ebbi)
   if(z80_opts.dump_graphs)
     dump_con(conflict_graph);
 
+  // A function that has been allocated before: Use its registers, if they are still valid.
+  std::string cache_key;
+  if(z80_opts.ralloc_cache)
+    {
+      std::vector<reg_t> regs;
+      bool optimal;
+
+      ralloc_cache_key(cache_key, ralloc_cache_prefix(), control_flow_graph, conflict_graph);
+      if(ralloc_cache_load(z80_opts.ralloc_cache, cache_key, boost::num_vertices(conflict_graph), regs, optimal))
+        {
+          assignment a;
+          a.global.resize(regs.size(), -1);
+          for(unsigned int v = 0; v < regs.size(); v++)
+            a.global.set(v, regs[v]);
+          if(assignment_valid(a, control_flow_graph, conflict_graph))
+            {
+              assignment_optimal = optimal;
+              apply_assignment(a, control_flow_graph, conflict_graph);
+              return(ic);
+            }
+        }
+    }
+
   tree_dec_t tree_decomposition;
 
-  thorup_tree_decomposition(tree_decomposition, control_flow_graph);
+  timeMax(TIME_CNT_TREE_WIDTH, narrow_tree_decomposition(tree_decomposition, control_flow_graph));
 
   nicify(tree_decomposition);
 
@@ -1318,6 +1403,15 @@ iCode *z80_ralloc2_cc(ebbIndex *ebbi)
 
   tree_dec_ralloc(tree_decomposition, control_flow_graph, conflict_graph);
 
+  if(z80_opts.ralloc_cache)
+    {
+      const assignment &winner = *(tree_decomposition[find_root(tree_decomposition)].assignments.begin());
+      std::vector<reg_t> regs(boost::num_vertices(conflict_graph));
+      for(unsigned int v = 0; v < regs.size(); v++)
+        regs[v] = winner.global[v];
+      ralloc_cache_store(z80_opts.ralloc_cache, cache_key, regs, assignment_optimal);
+    }
+
   return(ic);
 }
 
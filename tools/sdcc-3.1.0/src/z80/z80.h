@@ -25,6 +25,8 @@ typedef struct
     int reserveIY;
     int dump_graphs;
     int oldralloc;
+    int jobs;
+    char *ralloc_cache;
   }
 Z80_OPTS;
 